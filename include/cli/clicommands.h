@@ -0,0 +1,42 @@
+#ifndef CLICOMMANDS_H
+#define CLICOMMANDS_H
+
+class QCommandLineParser;
+
+// Команды ledgermini-cli. Работают только через ядро (Database,
+// ReportGenerator, ExportManager, TransactionImport, LedgerSnapshot) без виджетов.
+// Возвращают код завершения процесса, сообщения пишут в stderr.
+class CliCommands
+{
+public:
+    enum ExitCode {
+        Success = 0,
+        Failure = 1,
+        UsageError = 2
+    };
+
+    // Оборотно-сальдовая ведомость за период: .csv, .csv.gz или .pdf.
+    // С --snapshot считается по снимку журнала, база не открывается.
+    static int balanceReport(const QCommandLineParser &args);
+
+    // Карточка счета: .csv или .csv.gz
+    static int accountCard(const QCommandLineParser &args);
+
+    // Журнал проводок по фильтру: .csv, .csv.gz, .xlsx или .pdf
+    static int journal(const QCommandLineParser &args);
+
+    // Импорт проводок из CSV в формате выгрузки журнала; с --counterparties -
+    // справочника контрагентов (Наименование;ИНН;КПП)
+    static int importTransactions(const QCommandLineParser &args);
+
+    // Снимок всего журнала в один файл (LedgerSnapshot)
+    static int writeSnapshot(const QCommandLineParser &args);
+
+    // Проводки по наступившим повторяющимся шаблонам (TemplateScheduler)
+    static int runTemplates(const QCommandLineParser &args);
+
+    // Один шаблон по списку строк из CSV: Контрагент;Сумма;Документ
+    static int postTemplate(const QCommandLineParser &args);
+};
+
+#endif // CLICOMMANDS_H
@@ -0,0 +1,127 @@
+#ifndef ACCOUNTCARD_H
+#define ACCOUNTCARD_H
+
+#include <QDataStream>
+#include <QDate>
+#include <QString>
+#include <QVariantList>
+#include <QSqlQuery>
+#include <QVector>
+
+// Строка карточки счета: входящее сальдо, движение или итог за период
+struct AccountCardRow {
+    enum Kind {
+        Opening = 0,
+        Movement = 1,
+        Total = 2
+    };
+
+    Kind kind = Movement;
+    qint64 transactionId = 0;
+    QString account;            // код счета строки (важно в режиме с подсчетами)
+    QDate date;
+    QString documentNumber;
+    QString counterparty;
+    QString oppositeAccount;    // "код - наименование" корреспондирующего счета
+    double debit = 0.0;
+    double credit = 0.0;
+    QString description;
+    double balance = 0.0;       // сальдо после строки, дебет минус кредит
+};
+
+struct AccountCardParams {
+    int accountId = -1;
+    QDate dateFrom;
+    QDate dateTo;
+    // Карточка по всему поддереву: проводки подсчетов сливаются в одну
+    // ленту по дате, сальдо считается по поддереву целиком
+    bool includeSubaccounts = false;
+};
+
+// Компактная строка движения для постраничной карточки: имена счетов
+// и контрагентов не хранятся в каждой строке, только их id
+struct AccountCardEntry {
+    qint64 transactionId = 0;
+    QDate date;
+    qint8 side = 0;             // 0 - счет в дебете, 1 - в кредите
+    int accountId = 0;
+    int oppositeId = 0;
+    int counterpartyId = 0;
+    double amount = 0.0;
+    double balance = 0.0;       // сальдо после строки
+    QString documentNumber;
+    QString description;
+
+    double debit() const { return side == 0 ? amount : 0.0; }
+    double credit() const { return side == 1 ? amount : 0.0; }
+};
+
+// Для кэша отчетов (ReportCache)
+QDataStream &operator<<(QDataStream &stream, const AccountCardEntry &entry);
+QDataStream &operator>>(QDataStream &stream, AccountCardEntry &entry);
+
+// Итоги карточки за период, считаются отдельным агрегатным запросом
+struct AccountCardSummary {
+    double opening = 0.0;
+    qint64 count = 0;
+    double debit = 0.0;
+    double credit = 0.0;
+
+    double closing() const { return opening + debit - credit; }
+};
+
+QDataStream &operator<<(QDataStream &stream, const AccountCardSummary &summary);
+QDataStream &operator>>(QDataStream &stream, AccountCardSummary &summary);
+
+// Запрос карточки счета. Движения берутся двумя диапазонами индексов
+// (account_id, transaction_date) - по дебету и по кредиту - и склеиваются
+// UNION ALL. Входящее сальдо, нарастающий остаток (оконная функция)
+// и итоговая строка считаются в том же запросе, без суммирования в C++.
+// Строки идут в порядке: входящее сальдо, движения по дате и id, итог.
+// Для больших счетов есть постраничный доступ: итоги отдельным запросом
+// и страницы движений по смещению или после последней прочитанной строки.
+class AccountCardQuery
+{
+public:
+    // Шаг ключей страниц; смещения, кратные ему, читаются без пропуска строк
+    static constexpr int KeyStride = 500;
+
+    explicit AccountCardQuery(const AccountCardParams &params);
+
+    const AccountCardParams &params() const { return params_; }
+
+    // Вся карточка одним запросом: входящее сальдо, движения, итог.
+    // Курсор только вперед - для потоковой выгрузки
+    QSqlQuery execute() const;
+
+    static AccountCardRow readRow(const QSqlQuery &query);
+
+    // Постраничный доступ. Движения упорядочены по (дата, id, сторона).
+    // Итоги и ключи страниц берутся из ReportCache, если с момента
+    // их построения не было проводок по конец периода.
+    bool fetchSummary(AccountCardSummary *summary) const;
+    // Страница по смещению. Дальше первых KeyStride строк читается по ключу
+    // ближайшей предшествующей строки с номером, кратным KeyStride: ключи
+    // всей карточки - одна запись кэша на карточку, а не файл на страницу
+    QVector<AccountCardEntry> fetchEntries(qint64 offset, int limit, double opening) const;
+    // Следующая страница после строки after (keyset): остаток продолжается
+    // от after.balance, предшествующие строки не перечитываются
+    QVector<AccountCardEntry> fetchEntriesAfter(const AccountCardEntry &after, int limit) const;
+
+private:
+    QString accountCondition() const;
+    QString movementsSql(const QString &extraCondition = QString()) const;
+    QVariantList movementBindings(const QVariantList &extraParams = {}) const;
+    QVector<AccountCardEntry> readEntries(QSqlQuery &query) const;
+    bool loadSummary(AccountCardSummary *summary) const;
+    // Строки с номерами KeyStride, 2 * KeyStride, ...: только ключ и остаток
+    QVector<AccountCardEntry> fetchKeys(double opening) const;
+    QVariantList cacheKey() const;
+
+    QString sql() const;
+    QVariantList bindings() const;
+
+    AccountCardParams params_;
+};
+
+#endif // ACCOUNTCARD_H
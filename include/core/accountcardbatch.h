@@ -0,0 +1,66 @@
+#ifndef ACCOUNTCARDBATCH_H
+#define ACCOUNTCARDBATCH_H
+
+#include <QDate>
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+#include <QVector>
+#include <memory>
+
+// Пакетная выгрузка карточек счетов в отдельные CSV-файлы.
+// Каждая карточка - отдельная задача собственного пула потоков; задача
+// читает базу через соединение своего потока (Database::threadDatabase)
+// и пишет файл через ExportManager. Ход работы приходит сигналом progress,
+// по окончании - finished со списком ошибок. cancel() прекращает запуск
+// еще не начатых карточек; уже начатые дописываются.
+class AccountCardBatch : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Options {
+        QVector<int> accountIds;        // пусто - все счета плана
+        QDate dateFrom;
+        QDate dateTo;
+        bool includeSubaccounts = false;
+        QString outputDir;
+    };
+
+    struct Failure {
+        int accountId = 0;
+        QString accountCode;
+        QString error;
+    };
+
+    explicit AccountCardBatch(QObject *parent = nullptr);
+    ~AccountCardBatch();
+
+    bool start(const Options &options);
+    void cancel();
+
+    bool isRunning() const { return running_; }
+    int total() const { return total_; }
+
+    // Число одновременно формируемых карточек (по умолчанию - по числу ядер)
+    void setMaxThreadCount(int count);
+
+signals:
+    void progress(int done, int total);
+    void finished(int succeeded, const QVector<AccountCardBatch::Failure> &failures,
+                  bool cancelled);
+
+private:
+    struct Shared;
+
+    static QString fileNameFor(const QString &code, const QString &name);
+    void deliverProgress(int done);
+    void deliverFinished();
+
+    std::shared_ptr<Shared> shared_;
+    QThreadPool pool_;
+    bool running_ = false;
+    int total_ = 0;
+};
+
+#endif // ACCOUNTCARDBATCH_H
@@ -0,0 +1,33 @@
+#ifndef ACCOUNTTREE_H
+#define ACCOUNTTREE_H
+
+#include <QString>
+
+// Таблица замыкания плана счетов account_closure (ancestor, descendant, depth):
+// для каждого счета хранятся все его предки, включая сам счет с depth = 0.
+// Поддерево, путь к корню и уровень вложенности читаются обычным
+// индексным соединением без рекурсивного обхода.
+// Вызывающий код должен менять accounts и account_closure в одной транзакции.
+class AccountTree
+{
+public:
+    // Новый счет: строка на себя плюс все предки родителя (parentId <= 0 - корень)
+    static bool insertAccount(int accountId, int parentId);
+    // Перенос счета вместе с поддеревом под нового родителя
+    static bool moveAccount(int accountId, int newParentId);
+    // Удаление счета и его поддерева из замыкания
+    static bool removeAccount(int accountId);
+
+    // Является ли descendantId потомком ancestorId (или им самим)
+    static bool isInSubtree(int descendantId, int ancestorId);
+
+    // Полная перестройка по accounts.parent_id, если замыкание не совпадает
+    // с таблицей счетов (база создана старой версией)
+    static bool rebuildIfNeeded();
+    static bool rebuild();
+
+    // Подзапрос со списком id поддерева; параметр - id корня поддерева
+    static QString subtreeSql();
+};
+
+#endif // ACCOUNTTREE_H
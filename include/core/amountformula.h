@@ -0,0 +1,100 @@
+#ifndef AMOUNTFORMULA_H
+#define AMOUNTFORMULA_H
+
+#include <QDate>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// Остатки и обороты счетов для формул, прочитанные одним запросом на дату:
+// сколько бы формул и ссылок на счета ни было, к базе - одно обращение.
+// Счет считается вместе с подсчетами (account_closure).
+class FormulaBalances
+{
+public:
+    // Остатки на конец date, обороты - с periodStart по date
+    bool prefetch(const QStringList &accountCodes, const QDate &periodStart,
+                  const QDate &date, QString *error);
+
+    // -1 - счета нет в плане
+    int indexOf(const QString &code) const { return index_.value(code, -1); }
+    // Сальдо по стороне счета: у пассивного - кредит минус дебет
+    double balance(int index) const { return balances_.at(index); }
+    double debit(int index) const { return debits_.at(index); }
+    double credit(int index) const { return credits_.at(index); }
+
+private:
+    QHash<QString, int> index_;
+    QVector<double> balances_;
+    QVector<double> debits_;
+    QVector<double> credits_;
+};
+
+// Формула суммы шаблона проводки, например "balance(70) * 0.13" или
+// "round(credit(70.01) * 0.13, 2)". Разбирается один раз в байт-код
+// стековой машины; вычисление - проход по массиву команд без разбора
+// текста и без запросов.
+//  balance(счет)          сальдо на дату проводки
+//  debit(счет), credit(счет)  обороты с начала месяца по дату проводки
+//  template("Название")   сумма другого шаблона на ту же дату
+//  min(a, b), max(a, b), abs(x), round(x, знаков)
+// Дробная часть чисел - через точку, аргументы - через запятую.
+class AmountFormula
+{
+public:
+    bool compile(const QString &text, QString *error = nullptr);
+
+    bool isValid() const { return !code_.isEmpty(); }
+    QString text() const { return text_; }
+
+    // Счета и шаблоны, на которые ссылается формула
+    const QStringList &accounts() const { return accounts_; }
+    const QStringList &templates() const { return templates_; }
+
+    // templateValues - уже вычисленные суммы шаблонов по названию
+    bool evaluate(const FormulaBalances &balances, const QHash<QString, double> &templateValues,
+                  double *value, QString *error = nullptr) const;
+
+    // Суммы набора шаблонов на одну дату: формулы по названию шаблона и
+    // постоянные суммы остальных. Ссылки template() вычисляются в порядке
+    // зависимостей, цикл - ошибка. Каждая формула вычисляется один раз.
+    static bool evaluateAll(const QHash<QString, AmountFormula> &formulas,
+                            const QHash<QString, double> &fixedAmounts,
+                            const FormulaBalances &balances,
+                            QHash<QString, double> *values, QStringList *errors);
+
+private:
+    enum Op : quint8 {
+        PushConstant,
+        PushBalance,
+        PushDebit,
+        PushCredit,
+        PushTemplate,
+        Add,
+        Subtract,
+        Multiply,
+        Divide,
+        Negate,
+        Min,
+        Max,
+        Abs,
+        Round
+    };
+
+    struct Instruction {
+        Op op;
+        quint16 arg;            // номер константы, счета или шаблона
+    };
+
+    class Parser;
+
+    QString text_;
+    QVector<Instruction> code_;
+    QVector<double> constants_;
+    QStringList accounts_;
+    QStringList templates_;
+    int stackSize_ = 0;
+};
+
+#endif // AMOUNTFORMULA_H
@@ -0,0 +1,88 @@
+#ifndef BATCHVALIDATOR_H
+#define BATCHVALIDATOR_H
+
+#include <QBitArray>
+#include <QDate>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// Проверка пачки проводок или контрагентов целиком, для импорта и
+// массового проведения. Данные - по столбцам, правила готовятся один раз
+// (load): наличие счетов и контрагентов - битовые карты по id, ИНН -
+// контрольная сумма без регулярных выражений. На каждую строку - набор
+// кодов ошибок, а не первая найденная, и проверяются все строки.
+class BatchValidator
+{
+public:
+    // Коды ошибок строки - битовые флаги, строка может иметь несколько
+    enum Error : quint32 {
+        NoError = 0,
+        InvalidDate = 1 << 0,
+        FutureDate = 1 << 1,
+        MissingDebit = 1 << 2,
+        MissingCredit = 1 << 3,
+        UnknownDebit = 1 << 4,
+        UnknownCredit = 1 << 5,
+        SameAccounts = 1 << 6,
+        InvalidAmount = 1 << 7,
+        UnknownCounterparty = 1 << 8,
+        EmptyName = 1 << 9,
+        InvalidInn = 1 << 10,
+        DuplicateInn = 1 << 11
+    };
+    using Errors = quint32;
+
+    // Проводки по столбцам. Счет: 0 - не указан, меньше нуля - код не
+    // найден. Контрагент: 0 - без контрагента. Сумма NaN - не число.
+    struct Postings {
+        QVector<QDate> dates;
+        QVector<int> debitIds;
+        QVector<int> creditIds;
+        QVector<double> amounts;
+        QVector<int> counterpartyIds;
+
+        int size() const { return dates.size(); }
+        void reserve(int rows);
+        void clear();
+        void append(const QDate &date, int debitId, int creditId, double amount,
+                    int counterpartyId = 0);
+    };
+
+    struct Counterparties {
+        QVector<QString> names;
+        QVector<QString> inns;
+
+        int size() const { return names.size(); }
+    };
+
+    // Справочники из базы: счета, контрагенты, занятые ИНН
+    bool load(QString *error = nullptr);
+
+    // Для проверки без базы (снимок, тесты)
+    void setAccounts(const QVector<int> &ids);
+    void setCounterparties(const QVector<int> &ids);
+    void setInns(const QStringList &inns);
+    void setToday(const QDate &today) { today_ = today.toJulianDay(); }
+
+    QVector<Errors> validatePostings(const Postings &postings) const;
+    QVector<Errors> validateCounterparties(const Counterparties &counterparties) const;
+
+    // Сообщения по кодам строки, через "; "
+    static QString describe(Errors errors);
+
+private:
+    static QBitArray bitmap(const QVector<int> &ids);
+    static bool contains(const QBitArray &bits, int id)
+    {
+        return id > 0 && id < bits.size() && bits.testBit(id);
+    }
+
+    QBitArray accounts_;
+    QBitArray counterparties_;
+    QSet<QString> inns_;
+    qint64 today_ = QDate::currentDate().toJulianDay();
+};
+
+#endif // BATCHVALIDATOR_H
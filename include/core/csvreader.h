@@ -0,0 +1,56 @@
+#ifndef CSVREADER_H
+#define CSVREADER_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QStringList>
+#include <memory>
+
+// Потоковое чтение CSV по RFC 4180 - пара к CsvWriter: поля в кавычках
+// могут содержать разделитель, кавычки и переводы строк, строки - через
+// CRLF или LF. Файл *.gz распаковывается на лету. Файл читается блоками,
+// память не зависит от его размера.
+class CsvReader
+{
+public:
+    struct Options {
+        char delimiter = ';';
+        int bufferSize = 1 << 20;
+    };
+
+    CsvReader();
+    ~CsvReader();
+
+    bool open(const QString &fileName, const Options &options);
+    bool open(const QString &fileName) { return open(fileName, Options()); }
+
+    // Следующая запись; false - конец файла или ошибка (см. hasError)
+    bool readRow(QStringList *fields);
+
+    void close();
+
+    // Номер строки файла, с которой началась последняя прочитанная запись
+    qint64 lineNumber() const { return rowLine_; }
+    bool hasError() const { return failed_; }
+    QString errorString() const { return error_; }
+
+private:
+    struct Inflate;
+
+    bool fill();
+    bool readRaw(char *data, qint64 size, qint64 *read);
+
+    QFile file_;
+    Options options_;
+    QByteArray buffer_;
+    int pos_ = 0;
+    bool eof_ = false;
+    std::unique_ptr<Inflate> inflate_;
+    qint64 line_ = 1;
+    qint64 rowLine_ = 0;
+    bool failed_ = false;
+    QString error_;
+};
+
+#endif // CSVREADER_H
@@ -0,0 +1,59 @@
+#ifndef CSVWRITER_H
+#define CSVWRITER_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QStringList>
+#include <memory>
+
+// Потоковая запись CSV по RFC 4180: поле берется в кавычки, только если
+// содержит разделитель, кавычку или перевод строки; строки - через CRLF.
+// Текст копится в буфере и уходит в файл крупными блоками, при gzip -
+// через deflate. Память не зависит от числа строк.
+class CsvWriter
+{
+public:
+    struct Options {
+        char delimiter = ';';
+        bool gzip = false;
+        int bufferSize = 1 << 20;
+    };
+
+    CsvWriter();
+    ~CsvWriter();
+
+    bool open(const QString &fileName, const Options &options);
+    bool open(const QString &fileName) { return open(fileName, Options()); }
+
+    void addField(const QString &value);
+    void addField(const QByteArray &utf8);
+    void endRow();
+    void writeRow(const QStringList &fields);
+
+    // Дописывает буфер и закрывает файл; false - была ошибка записи
+    bool close();
+
+    qint64 rowCount() const { return rows_; }
+    QString errorString() const { return error_; }
+
+    // Выгрузка в *.gz пишется сжатой
+    static bool isGzipFileName(const QString &fileName);
+
+private:
+    struct Deflate;
+
+    bool flush(bool finish);
+    bool writeOut(const char *data, qint64 size);
+
+    QFile file_;
+    Options options_;
+    QByteArray buffer_;
+    std::unique_ptr<Deflate> deflate_;
+    bool rowStarted_ = false;
+    bool failed_ = false;
+    qint64 rows_ = 0;
+    QString error_;
+};
+
+#endif // CSVWRITER_H
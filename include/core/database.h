@@ -7,6 +7,8 @@
 #include <QSqlQuery>
 #include <QSqlError>
 
+class QThread;
+
 class Database
 {
 public:
@@ -16,8 +18,15 @@ public:
     bool isInitialized() const;
     
     bool executeScript(const std::string& scriptPath);
+    
+    // Создает недостающие таблицы, индексы и триггеры, дополняет базы
+    // старых версий. Вызывается после initialize и окном, и ledgermini-cli
+    void ensureSchema();
     QSqlQuery executeQuery(const QString& query, const QVariantList& params = {});
     
+    // То же, но курсор только вперед: для выгрузок, читающих результат один раз
+    QSqlQuery executeCursor(const QString& query, const QVariantList& params = {});
+    
     // Для работы с транзакциями
     bool beginTransaction();
     bool commitTransaction();
@@ -25,6 +34,14 @@ public:
 
     // Добавленный метод для получения базы данных
     QSqlDatabase& database();
+    
+    // Соединение для текущего потока: в главном потоке - основное,
+    // в рабочих - отдельный клон, который закрывается при завершении потока
+    QSqlDatabase threadDatabase();
+    
+    // Версия записи в журнал: растет при каждом изменении проводок,
+    // счетов и контрагентов (триггеры на ledger_state). -1 - таблицы нет.
+    qint64 ledgerVersion();
 
 private:
     Database() = default;
@@ -33,7 +50,10 @@ private:
     Database(const Database&) = delete;
     Database& operator=(const Database&) = delete;
     
+    QSqlQuery runQuery(const QString& query, const QVariantList& params, bool forwardOnly);
+    
     QSqlDatabase db_;
+    QThread *ownerThread_ = nullptr;
     bool initialized_ = false;
 };
 
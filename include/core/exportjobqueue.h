@@ -0,0 +1,84 @@
+#ifndef EXPORTJOBQUEUE_H
+#define EXPORTJOBQUEUE_H
+
+#include "core/exportprogress.h"
+
+#include <QMap>
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+#include <QVector>
+#include <functional>
+#include <memory>
+
+// Очередь фоновых выгрузок. Каждая выгрузка - задача собственного пула
+// потоков; несколько выгрузок идут одновременно. Задача читает базу через
+// соединение своего потока в одной читающей транзакции, то есть видит один
+// снимок данных, даже если пользователь тем временем вносит проводки.
+// Ход и завершение приходят сигналами в главном потоке.
+class ExportJobQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum State {
+        Queued,
+        Running,
+        Finished,
+        Failed,
+        Cancelled
+    };
+    Q_ENUM(State)
+
+    struct JobInfo {
+        int id = 0;
+        QString title;
+        QString fileName;
+        State state = Queued;
+        qint64 done = 0;
+        qint64 total = 0;       // 0 - объем заранее неизвестен
+        QString error;
+    };
+
+    // Выгрузка: пишет файл, сообщая ход через progress; false - ошибка в error
+    using Task = std::function<bool(ExportProgress *progress, QString *error)>;
+
+    static ExportJobQueue& instance();
+
+    int enqueue(const QString &title, const QString &fileName, Task task);
+
+    // Задача в очереди не запустится, идущая остановится при ближайшей
+    // проверке; недописанный файл удаляется
+    void cancel(int id);
+
+    // Убирает из списка завершенные, ошибочные и отмененные
+    void removeFinished();
+
+    QVector<JobInfo> jobs() const;
+    JobInfo job(int id) const;
+    int activeCount() const;
+
+signals:
+    void jobAdded(int id);
+    void jobChanged(int id);
+    void jobFinished(int id, bool ok);
+    void jobsRemoved();
+
+private:
+    struct Job;
+    struct Shared;
+    class JobProgress;
+
+    ExportJobQueue();
+    ~ExportJobQueue();
+
+    static JobInfo infoOf(const Job &job);
+    static void post(const std::shared_ptr<Shared> &shared, int id, bool finished, bool ok);
+
+    std::shared_ptr<Shared> shared_;
+    QMap<int, std::shared_ptr<Job>> jobs_;
+    QThreadPool pool_;
+    int nextId_ = 1;
+};
+
+#endif // EXPORTJOBQUEUE_H
@@ -2,17 +2,16 @@
 #define EXPORTMANAGER_H
 
 #include <QObject>
-#include <QTableView>
+#include <QPageSize>
 #include <QString>
-#include <QTextDocument>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
 
-// Для совместимости Qt5/Qt6
-#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-    #include <QPageSize>
-    #include <QPrinter>
-#else
-    #include <QPrinter>
-#endif
+struct AccountCardParams;
+struct TransactionFilter;
+struct BalanceRecord;
+class ExportProgress;
 
 class ExportManager : public QObject
 {
@@ -20,24 +19,84 @@ class ExportManager : public QObject
 
 public:
     explicit ExportManager(QObject *parent = nullptr);
+
+    // Заголовки столбцов выгрузки журнала и ОСВ
+    static QStringList journalHeaders();
+    static QStringList balanceHeaders();
     
-    // Экспорт таблицы в PDF
-    static bool exportTableToPdf(QTableView *tableView, const QString &title, 
-                                const QString &fileName, QWidget *parent = nullptr);
+    // Экспорт не зависит от QtWidgets: окна с ошибками показывают
+    // вызывающие виджеты, сам ExportManager возвращает текст в error.
+    // Таблицы и отчеты в PDF рисует PdfTableRenderer постранично,
+    // без промежуточного HTML.
     
     // Экспорт отчета (HTML) в PDF
     static bool exportHtmlToPdf(const QString &htmlContent, const QString &title,
-                               const QString &fileName, QWidget *parent = nullptr);
+                               const QString &fileName);
+    
+    // Строки таблицы в PDF; итоговые строки выделяются
+    static bool exportRowsToPdf(const QVector<QVariantList> &data,
+                                const QStringList &headers,
+                                const QString &title,
+                                const QString &fileName,
+                                QString *error = nullptr,
+                                ExportProgress *progress = nullptr);
     
-    // Экспорт балансового отчета в PDF
-    static bool exportBalanceReportToPdf(const QVector<QVariantList> &data,
+    // Журнал проводок по фильтру в PDF: строки читаются курсором
+    // и рисуются по мере чтения
+    static bool exportTransactionsToPdf(const TransactionFilter &filter,
                                         const QStringList &headers,
                                         const QString &title,
                                         const QString &fileName,
-                                        QWidget *parent = nullptr);
+                                        QString *error = nullptr,
+                                        ExportProgress *progress = nullptr);
+    
+    // Выгрузки в CSV читают строки курсором только вперед и пишут их
+    // через CsvWriter по мере чтения: ни модель, ни весь результат в памяти
+    // не собираются. Имя файла *.gz - выгрузка сжимается gzip.
+    // Без виджетов, можно вызывать из рабочего потока.
+    // progress (если задан) получает ход выгрузки; отмененная выгрузка
+    // возвращает false и удаляет недописанный файл.
     
-    // Генерация HTML из таблицы
-    static QString generateTableHtml(QTableView *tableView, const QString &title);
+    // Результат произвольного запроса; числа с плавающей точкой - 2 знака
+    static bool exportQueryToCsv(const QString &sql, const QVariantList &params,
+                                 const QStringList &headers,
+                                 const QString &fileName,
+                                 QString *error = nullptr,
+                                 ExportProgress *progress = nullptr);
+    
+    // Карточка счета (пакетная выгрузка тоже идет через нее)
+    static bool exportAccountCardToCsv(const AccountCardParams &params,
+                                       const QString &fileName,
+                                       QString *error = nullptr,
+                                       ExportProgress *progress = nullptr);
+    
+    // Журнал проводок по фильтру, все строки, а не только загруженные в таблицу
+    static bool exportTransactionsToCsv(const TransactionFilter &filter,
+                                        const QStringList &headers,
+                                        const QString &fileName,
+                                        QString *error = nullptr,
+                                        ExportProgress *progress = nullptr);
+    
+    // Журнал проводок в книгу Excel (.xlsx): даты и суммы - типизированные
+    // ячейки, строки пишутся в архив по мере чтения курсора
+    static bool exportTransactionsToXlsx(const TransactionFilter &filter,
+                                         const QStringList &headers,
+                                         const QString &fileName,
+                                         QString *error = nullptr,
+                                         ExportProgress *progress = nullptr);
+    
+    // Оборотно-сальдовая ведомость
+    static bool exportBalanceReportToCsv(const QVector<BalanceRecord> &records,
+                                         const QStringList &headers,
+                                         const QString &fileName,
+                                         QString *error = nullptr);
+    
+    static bool exportBalanceReportToPdf(const QVector<BalanceRecord> &records,
+                                         const QStringList &headers,
+                                         const QString &title,
+                                         const QString &fileName,
+                                         QString *error = nullptr,
+                                         ExportProgress *progress = nullptr);
     
     // Генерация HTML из данных
     static QString generateDataHtml(const QVector<QVariantList> &data,
@@ -47,14 +106,8 @@ public:
 private:
     static QString getDefaultStyle();
     
-    // Объявление с совместимостью Qt5/Qt6
-#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
     static bool saveToPdf(const QString &htmlContent, const QString &fileName,
                          QPageSize::PageSizeId pageSize = QPageSize::A4);
-#else
-    static bool saveToPdf(const QString &htmlContent, const QString &fileName,
-                         QPrinter::PageSize pageSize = QPrinter::A4);
-#endif
 };
 
 #endif // EXPORTMANAGER_H
\ No newline at end of file
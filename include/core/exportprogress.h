@@ -0,0 +1,18 @@
+#ifndef EXPORTPROGRESS_H
+#define EXPORTPROGRESS_H
+
+#include <QtGlobal>
+
+// Ход выгрузки для ExportManager: сколько строк записано и не отменена ли
+// она. Методы вызываются в потоке, где идет выгрузка.
+class ExportProgress
+{
+public:
+    virtual ~ExportProgress() = default;
+
+    virtual void setTotal(qint64 total) = 0;
+    virtual void setDone(qint64 done) = 0;
+    virtual bool isCancelled() const = 0;
+};
+
+#endif // EXPORTPROGRESS_H
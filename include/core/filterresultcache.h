@@ -0,0 +1,75 @@
+#ifndef FILTERRESULTCACHE_H
+#define FILTERRESULTCACHE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+#include <list>
+#include <memory>
+
+// Кэш результатов фильтра проводок: список id в порядке вывода.
+// Ключ - нормализованный хэш фильтра (TransactionQuery::cacheKey),
+// запись действительна, пока не изменилась версия записи в журнал
+// (Database::ledgerVersion). Размер ограничен числом записей и объемом
+// памяти, при переполнении вытесняются давно не использованные записи.
+// Доступ потокобезопасный: кэш читают рабочие потоки поиска.
+class FilterResultCache
+{
+public:
+    using IdList = QVector<qint64>;
+
+    struct Stats {
+        qint64 hits = 0;
+        qint64 misses = 0;
+        int entries = 0;
+        qint64 bytes = 0;
+    };
+
+    static FilterResultCache& instance();
+
+    // Запись найдена: true. *ids == nullptr означает, что результат
+    // слишком велик для кэша и его нужно читать постранично из базы.
+    bool lookup(const QByteArray &key, qint64 version, std::shared_ptr<const IdList> *ids);
+
+    void insert(const QByteArray &key, qint64 version, std::shared_ptr<const IdList> ids);
+    void insertTooLarge(const QByteArray &key, qint64 version);
+
+    void clear();
+    void setLimits(int maxEntries, qint64 maxBytes, int maxIdsPerEntry);
+
+    // Больше стольких id в одной записи не храним
+    int maxIdsPerEntry() const;
+    Stats stats() const;
+
+private:
+    struct Entry {
+        QByteArray key;
+        qint64 version = 0;
+        std::shared_ptr<const IdList> ids;
+        qint64 bytes = 0;
+    };
+
+    FilterResultCache() = default;
+
+    FilterResultCache(const FilterResultCache&) = delete;
+    FilterResultCache& operator=(const FilterResultCache&) = delete;
+
+    void store(const QByteArray &key, qint64 version, std::shared_ptr<const IdList> ids);
+    void removeEntry(std::list<Entry>::iterator it);
+    void evict();
+
+    mutable QMutex mutex_;
+    std::list<Entry> entries_;      // в начале - последние использованные
+    QHash<QByteArray, std::list<Entry>::iterator> index_;
+
+    int maxEntries_ = 32;
+    qint64 maxBytes_ = 64 * 1024 * 1024;
+    int maxIdsPerEntry_ = 500000;
+
+    qint64 bytes_ = 0;
+    qint64 hits_ = 0;
+    qint64 misses_ = 0;
+};
+
+#endif // FILTERRESULTCACHE_H
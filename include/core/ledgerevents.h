@@ -0,0 +1,41 @@
+#ifndef LEDGEREVENTS_H
+#define LEDGEREVENTS_H
+
+#include <QObject>
+
+// Уведомления об изменениях данных для моделей представлений.
+// Код, который пишет в базу (диалоги, удаление, импорт), сообщает о
+// затронутой строке, а модели перечитывают только ее, не весь список.
+// Сигналы испускаются в главном потоке.
+class LedgerEvents : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Table {
+        Transactions,
+        Accounts,
+        Counterparties
+    };
+    Q_ENUM(Table)
+
+    static LedgerEvents& instance();
+
+    void notifyInserted(Table table, qint64 id) { emit rowInserted(table, id); }
+    void notifyUpdated(Table table, qint64 id) { emit rowUpdated(table, id); }
+    void notifyRemoved(Table table, qint64 id) { emit rowRemoved(table, id); }
+
+    // Массовое изменение (импорт, пакетные проводки): модели перечитывают все
+    void notifyBulkChanged(Table table) { emit bulkChanged(table); }
+
+signals:
+    void rowInserted(LedgerEvents::Table table, qint64 id);
+    void rowUpdated(LedgerEvents::Table table, qint64 id);
+    void rowRemoved(LedgerEvents::Table table, qint64 id);
+    void bulkChanged(LedgerEvents::Table table);
+
+private:
+    LedgerEvents() = default;
+};
+
+#endif // LEDGEREVENTS_H
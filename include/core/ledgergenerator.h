@@ -0,0 +1,60 @@
+#ifndef LEDGERGENERATOR_H
+#define LEDGERGENERATOR_H
+
+#include <QDate>
+#include <QString>
+
+class ExportProgress;
+
+// Синтетический журнал для проверки производительности: план счетов с
+// подсчетами, контрагенты с верными ИНН и проводки с правдоподобным
+// распределением дат (рабочие дни, конец месяца), сумм (логнормальное)
+// и корреспонденций (оплаты, реализация, зарплата, налоги). Результат
+// зависит только от параметров и seed.
+// Пишет в уже открытую базу (Database::initialize и ensureSchema).
+// Проводки вставляются подготовленным запросом по многу строк за раз;
+// на время вставки триггеры и индексы transactions снимаются, а
+// account_balances и ledger_months потом пересчитываются одним запросом.
+class LedgerGenerator
+{
+public:
+    struct Options {
+        int accounts = 200;             // вместе с синтетическими счетами плана
+        int counterparties = 1000;
+        qint64 postings = 100000;
+        quint32 seed = 1;
+        // Период по умолчанию фиксирован, а не от сегодняшней даты:
+        // одни и те же параметры дают одну и ту же базу в любой день
+        QDate from = QDate(2023, 1, 1);
+        QDate to = QDate(2025, 12, 31);
+    };
+
+    struct Result {
+        int accounts = 0;               // добавлено счетов
+        int counterparties = 0;
+        qint64 postings = 0;
+    };
+
+    // Растет при любом изменении того, что получается из тех же параметров
+    static const int Version = 1;
+
+    static bool generate(const Options &options, Result *result, QString *error,
+                         ExportProgress *progress = nullptr);
+
+    // Новая база в файле fileName целиком: генерация идет во временный
+    // fileName.part, который переименовывается только после успеха, а при
+    // сбое удаляется вместе с -wal и -shm. Открывает Database на временном
+    // файле и закрывает ее, поэтому вызывается в процессе, где база еще не
+    // открыта и дальше не нужна (ledgermini-datagen, дочерние процессы замеров)
+    static bool generateFile(const QString &fileName, const Options &options, Result *result,
+                             QString *error, ExportProgress *progress = nullptr);
+
+    // Удаляет файл базы вместе с -wal и -shm
+    static void removeFile(const QString &fileName);
+
+    // Отпечаток версии генератора и параметров: для имени файла готовой
+    // базы, чтобы после изменения генератора или параметров не взять старую
+    static QString fingerprint(const Options &options);
+};
+
+#endif // LEDGERGENERATOR_H
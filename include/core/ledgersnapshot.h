@@ -0,0 +1,122 @@
+#ifndef LEDGERSNAPSHOT_H
+#define LEDGERSNAPSHOT_H
+
+#include <QDate>
+#include <QFile>
+#include <QString>
+
+class ExportProgress;
+
+// Снимок всего журнала в одном двоичном файле (*.lmsnap) - копия для
+// аудитора или рабочего места, где данные только читают.
+// Файл: заголовок с версией формата, версией журнала и CRC32, таблица
+// секций и сами секции, каждая выровнена на 8 байт:
+//  - словарь строк: смещения (quint64) и UTF-8, одинаковые строки хранятся
+//    один раз;
+//  - план счетов в порядке кодов с индексом родителя (дерево счетов);
+//  - контрагенты;
+//  - проводки по столбцам (дата, дебет, кредит, сумма, ...), отсортированные
+//    по дате: период отчета - два двоичных поиска по столбцу дат.
+// Открытие отображает файл в память (QFile::map) и ничего не разбирает:
+// столбцы читаются прямо из отображения. Числа - little-endian.
+class LedgerSnapshot
+{
+public:
+    struct Options {
+        // Проверка CRC32 читает файл целиком; без нее открытие мгновенное
+        bool verifyChecksum = true;
+    };
+
+    // Записи в отображении; строки - номера в словаре
+    struct Account {
+        qint32 id;
+        qint32 parent;          // индекс родителя в accounts(), -1 - корень
+        qint32 type;            // 0=Активный, 1=Пассивный, 2=Активно-пассивный
+        quint32 code;
+        quint32 name;
+    };
+
+    struct Counterparty {
+        qint32 id;
+        quint32 name;
+        quint32 inn;
+    };
+
+    // Текущая база (Database) в файл. Читает в одной транзакции, поэтому
+    // снимок согласован, даже если журнал тем временем правят. Столбцы
+    // проводок копятся во временных файлах рядом с fileName, а не в памяти.
+    static bool write(const QString &fileName, QString *error = nullptr,
+                      ExportProgress *progress = nullptr);
+
+    LedgerSnapshot();
+    ~LedgerSnapshot();
+
+    bool open(const QString &fileName, const Options &options);
+    bool open(const QString &fileName) { return open(fileName, Options()); }
+    void close();
+
+    bool isOpen() const { return map_ != nullptr; }
+    QString errorString() const { return error_; }
+
+    qint64 ledgerVersion() const { return ledgerVersion_; }
+    qint64 createdAt() const { return createdAt_; }     // мс с эпохи, UTC
+
+    QString string(quint32 id) const;
+
+    int accountCount() const { return accountCount_; }
+    const Account *accounts() const { return accounts_; }
+    // Индекс счета по id; -1 - нет такого
+    int accountIndex(int accountId) const;
+
+    int counterpartyCount() const { return counterpartyCount_; }
+    const Counterparty *counterparties() const { return counterparties_; }
+
+    // Столбцы проводок; счета и контрагент - индексы (контрагент -1 - нет)
+    qint64 postingCount() const { return postingCount_; }
+    const qint64 *postingIds() const { return postingIds_; }
+    const qint32 *postingDates() const { return postingDates_; }        // юлианский день
+    const qint32 *postingDebits() const { return postingDebits_; }
+    const qint32 *postingCredits() const { return postingCredits_; }
+    const qint32 *postingCounterparties() const { return postingCounterparties_; }
+    const double *postingAmounts() const { return postingAmounts_; }
+    const quint32 *postingDocuments() const { return postingDocuments_; }
+    const quint32 *postingDescriptions() const { return postingDescriptions_; }
+
+    // Первая проводка с датой >= date (postingCount(), если таких нет)
+    qint64 lowerBound(const QDate &date) const;
+    // Первая проводка с датой > date
+    qint64 upperBound(const QDate &date) const;
+
+private:
+    bool fail(const QString &message);
+
+    QFile file_;
+    uchar *map_ = nullptr;
+    QString error_;
+
+    qint64 ledgerVersion_ = 0;
+    qint64 createdAt_ = 0;
+
+    const void *stringOffsets_ = nullptr;   // quint64, в версии 1 - quint32
+    bool wideOffsets_ = false;
+    const char *stringData_ = nullptr;
+    quint64 stringDataSize_ = 0;
+    quint32 stringCount_ = 0;
+
+    const Account *accounts_ = nullptr;
+    int accountCount_ = 0;
+    const Counterparty *counterparties_ = nullptr;
+    int counterpartyCount_ = 0;
+
+    qint64 postingCount_ = 0;
+    const qint64 *postingIds_ = nullptr;
+    const qint32 *postingDates_ = nullptr;
+    const qint32 *postingDebits_ = nullptr;
+    const qint32 *postingCredits_ = nullptr;
+    const qint32 *postingCounterparties_ = nullptr;
+    const double *postingAmounts_ = nullptr;
+    const quint32 *postingDocuments_ = nullptr;
+    const quint32 *postingDescriptions_ = nullptr;
+};
+
+#endif // LEDGERSNAPSHOT_H
@@ -0,0 +1,61 @@
+#ifndef LOOKUPINDEX_H
+#define LOOKUPINDEX_H
+
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <memory>
+#include <vector>
+
+// Префиксный индекс для поиска счетов и контрагентов по мере ввода.
+// Строится один раз в памяти: отсортированные массивы ключей (код, ИНН,
+// начала слов наименования) позволяют находить первые N совпадений
+// бинарным поиском, не перебирая весь справочник.
+class LookupIndex
+{
+public:
+    struct Item {
+        int id = 0;
+        QString code;   // Код счета (у контрагентов пустой)
+        QString name;   // Наименование
+        QString inn;    // ИНН (у счетов пустой)
+
+        QString displayText() const;
+    };
+
+    LookupIndex() = default;
+    explicit LookupIndex(QVector<Item> items);
+
+    // Загрузка справочников из базы данных
+    static std::shared_ptr<LookupIndex> loadAccounts();
+    static std::shared_ptr<LookupIndex> loadCounterparties();
+
+    // Возвращает позиции элементов (не id), подходящих под префикс, не более limit.
+    // Сначала совпадения по коду, затем по ИНН, затем по словам наименования.
+    // Пустой префикс - первые limit элементов в исходном порядке.
+    QVector<int> search(const QString &prefix, int limit) const;
+
+    int size() const { return items_.size(); }
+    const Item &item(int position) const { return items_[position]; }
+    int positionOf(int id) const;   // -1, если элемент не найден
+
+private:
+    struct Key {
+        QString text;   // Нормализованный ключ
+        int position;   // Позиция элемента в items_
+    };
+    using KeyList = std::vector<Key>;
+
+    static QString normalize(const QString &text);
+    static void sortKeys(KeyList &keys);
+    static void collect(const KeyList &keys, const QString &prefix, int limit,
+                        QVector<int> &result, std::vector<bool> &seen);
+
+    QVector<Item> items_;
+    KeyList codeKeys_;
+    KeyList innKeys_;
+    KeyList wordKeys_;
+    QHash<int, int> positionById_;
+};
+
+#endif // LOOKUPINDEX_H
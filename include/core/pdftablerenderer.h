@@ -0,0 +1,48 @@
+#ifndef PDFTABLERENDERER_H
+#define PDFTABLERENDERER_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <functional>
+
+// Табличный PDF без HTML и QTextDocument: строки рисуются QPainter прямо
+// на страницы QPdfWriter по мере чтения из источника. Ширина столбцов
+// определяется один раз по заголовкам и первым строкам, длинный текст
+// обрезается многоточием - высота строки постоянна, поэтому время растет
+// линейно с числом страниц, а память от числа строк не зависит.
+// Шапка таблицы повторяется на каждой странице.
+class PdfTableRenderer
+{
+public:
+    struct Row {
+        QStringList cells;
+        bool emphasized = false;    // итоговая строка: жирный шрифт и фон
+    };
+
+    // Заполняет очередную строку; false - строки кончились
+    using RowSource = std::function<bool(Row *row)>;
+
+    // title может быть многострочным: первая строка - заголовок,
+    // остальные - подзаголовок мелким шрифтом
+    PdfTableRenderer(const QString &title, const QStringList &headers);
+
+    // Столбцы с числами выравниваются вправо
+    void setRightAligned(const QVector<int> &columns) { rightAligned_ = columns; }
+
+    bool render(const QString &fileName, const RowSource &source, QString *error = nullptr);
+
+    int pageCount() const { return pages_; }
+    qint64 rowCount() const { return rows_; }
+
+private:
+    static QVector<double> fitColumns(const QVector<double> &natural, double width);
+
+    QString title_;
+    QStringList headers_;
+    QVector<int> rightAligned_;
+    int pages_ = 0;
+    qint64 rows_ = 0;
+};
+
+#endif // PDFTABLERENDERER_H
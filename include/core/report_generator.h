@@ -1,6 +1,7 @@
 #ifndef REPORT_GENERATOR_H
 #define REPORT_GENERATOR_H
 #include <QObject>
+#include <QDataStream>
 #include <QDate>
 #include <QVector>
 #include <QString>
@@ -22,13 +23,23 @@ struct BalanceRecord {
     double totalTurnover() const { return turnoverDebit + turnoverCredit; }
 };
 
+// Для кэша отчетов (ReportCache)
+QDataStream &operator<<(QDataStream &stream, const BalanceRecord &record);
+QDataStream &operator>>(QDataStream &stream, BalanceRecord &record);
+
+class LedgerSnapshot;
+
 class ReportGenerator : public QObject {
     Q_OBJECT
 public:
     explicit ReportGenerator(QObject *parent = nullptr);
     
-    // Основные отчеты
+    // Основные отчеты. ОСВ берется из ReportCache, если после ее построения
+    // не было изменений в журнале по конец периода
     QVector<BalanceRecord> generateBalanceReport(const QDate &startDate, const QDate &endDate);
+    // Та же ведомость по снимку журнала (LedgerSnapshot), без базы
+    QVector<BalanceRecord> generateBalanceReport(const LedgerSnapshot &snapshot,
+                                                 const QDate &startDate, const QDate &endDate);
     
     // Дополнительные отчеты
     QVector<QVector<QVariant>> generateAccountAnalysis(int accountId, const QDate &startDate, const QDate &endDate);
@@ -39,6 +50,7 @@ public:
     double calculateAccountTurnover(int accountId, const QDate &startDate, const QDate &endDate, bool isDebit);
     
 private:
+    QVector<BalanceRecord> computeBalanceReport(const QDate &startDate, const QDate &endDate);
     void calculateFinalBalances(QVector<BalanceRecord> &records);
 };
 
@@ -0,0 +1,63 @@
+#ifndef REPORTCACHE_H
+#define REPORTCACHE_H
+
+#include <QByteArray>
+#include <QDate>
+#include <QMutex>
+#include <QString>
+#include <QVariantList>
+#include <atomic>
+
+// Дисковый кэш готовых отчетов (ОСВ, итоги и ключи страниц карточки счета).
+// Ключ - вид отчета и его параметры; запись хранит версию записи в журнал
+// (Database::ledgerVersion), на которой отчет построен. Отчет зависит от
+// проводок по periodEnd включительно: если версия с тех пор выросла,
+// по таблице ledger_months проверяется, были ли изменения в месяцах
+// до конца периода. Не было - запись остается действительной, и отчет
+// за прошлый квартал переживает проводки текущего месяца.
+// Файлы лежат рядом с базой, в каталоге <база>.reports. Доступ
+// потокобезопасный.
+class ReportCache
+{
+public:
+    enum Report : quint8 {
+        BalanceReport = 1,
+        CardSummary,
+        CardKeys
+    };
+
+    struct Stats {
+        qint64 hits = 0;
+        qint64 misses = 0;
+        qint64 stale = 0;       // отброшено из-за изменений в периоде
+    };
+
+    static ReportCache& instance();
+
+    // periodEnd - последняя дата, от проводок по которую зависит отчет;
+    // пустая дата - отчет зависит от всего журнала
+    bool lookup(Report report, const QVariantList &params, const QDate &periodEnd,
+                QByteArray *payload);
+    // version - Database::ledgerVersion(), прочитанная до построения отчета
+    void insert(Report report, const QVariantList &params, qint64 version,
+                const QByteArray &payload);
+
+    void clear();
+    void setEnabled(bool enabled) { enabled_ = enabled; }
+    bool isEnabled() const { return enabled_; }
+    Stats stats() const;
+
+private:
+    ReportCache() = default;
+
+    QString directory() const;
+    QString filePath(Report report, const QByteArray &key) const;
+    void prune(const QString &dir);
+
+    mutable QMutex mutex_;
+    std::atomic<bool> enabled_{true};
+    Stats stats_;                           // защищен mutex_
+    int insertsSincePrune_ = 0;             // защищен mutex_
+};
+
+#endif // REPORTCACHE_H
@@ -0,0 +1,26 @@
+#ifndef SAVEDFILTERSTORE_H
+#define SAVEDFILTERSTORE_H
+
+#include "core/transactionfilter.h"
+
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+// Сохраненные фильтры проводок в таблице saved_filters.
+// Параметры фильтра хранятся в JSON, чтобы новые поля не требовали миграций.
+class SavedFilterStore
+{
+public:
+    static QMap<QString, TransactionFilter> loadAll();
+    static bool save(const QString &name, const TransactionFilter &filter);
+    static bool remove(const QString &name);
+
+    // Однократный перенос фильтров, сохраненных старыми версиями в QSettings
+    static int migrateFromSettings();
+
+    static QByteArray toJson(const TransactionFilter &filter);
+    static TransactionFilter fromJson(const QByteArray &json);
+};
+
+#endif // SAVEDFILTERSTORE_H
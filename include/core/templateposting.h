@@ -0,0 +1,37 @@
+#ifndef TEMPLATEPOSTING_H
+#define TEMPLATEPOSTING_H
+
+#include <QDate>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// Массовое проведение по шаблону: один шаблон (счета, описание, префикс
+// документа) и список строк контрагент - сумма - номер документа, например
+// ведомость на зарплату или реестр платежей поставщикам. Все строки
+// проверяются до записи; если ошибок нет, проводки пишутся в одной
+// транзакции одним подготовленным запросом.
+class TemplatePosting
+{
+public:
+    struct Row {
+        QString counterparty;       // наименование или ИНН; пусто - из шаблона
+        double amount = 0.0;
+        bool hasAmount = false;     // false - сумма шаблона (пустая ячейка)
+        QString documentNumber;     // пусто - префикс шаблона и номер строки
+    };
+
+    struct Result {
+        qint64 posted = 0;
+        QStringList errors;         // "Строка N: ..."
+    };
+
+    // false - есть ошибочные строки или запись не удалась; в базу ничего не записано
+    static bool post(int templateId, const QDate &date, const QVector<Row> &rows,
+                     bool dryRun, Result *result);
+
+    // Строки из CSV: Контрагент;Сумма;Документ (заголовок пропускается)
+    static bool readCsv(const QString &fileName, QVector<Row> *rows, QStringList *errors);
+};
+
+#endif // TEMPLATEPOSTING_H
@@ -0,0 +1,58 @@
+#ifndef TEMPLATESCHEDULER_H
+#define TEMPLATESCHEDULER_H
+
+#include <QDate>
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+
+// Выполнение повторяющихся шаблонов проводок (transaction_templates с
+// frequency daily, weekly, monthly, yearly). Даты шаблона идут от даты его
+// создания; выполняются все наступившие после last_executed (у ни разу не
+// выполненного - начиная с сегодняшней), по проводке на каждую дату.
+// Все проводки всех шаблонов
+// пишутся в одной транзакции одним подготовленным запросом вместе с новым
+// last_executed: пропущенный год по сотням шаблонов - одна пакетная запись.
+// Шаблоны без суммы (сумма вводится вручную) не выполняются.
+class TemplateScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Не больше стольких проводок по одному шаблону за запуск: ежедневный
+    // шаблон с давним last_executed дописывается за несколько запусков
+    static constexpr int MaxOccurrences = 5000;
+
+    struct Result {
+        int templates = 0;          // шаблонов, по которым были проводки
+        qint64 inserted = 0;        // проводок записано
+        QStringList errors;         // "Шаблон ...: ..."
+    };
+
+    explicit TemplateScheduler(QObject *parent = nullptr);
+
+    // Выполнить сразу и затем проверять каждые intervalMs
+    void start(int intervalMs = 60 * 60 * 1000);
+    void stop() { timer_.stop(); }
+
+    // Все проводки по шаблонам, наступившие по today включительно.
+    // false - запись не удалась, в базу ничего не записано
+    static bool runDue(const QDate &today, Result *result);
+
+    // Даты ряда от anchor (включительно) после after и не позже today;
+    // after недействительна - с самого anchor
+    static QVector<QDate> dueDates(const QString &frequency, const QDate &anchor,
+                                   const QDate &after, const QDate &today, int limit);
+
+public slots:
+    void runNow();
+
+signals:
+    void executed(int templates, qint64 inserted);
+    void failed(const QString &error);
+
+private:
+    QTimer timer_;
+};
+
+#endif // TEMPLATESCHEDULER_H
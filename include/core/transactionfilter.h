@@ -0,0 +1,26 @@
+#ifndef TRANSACTIONFILTER_H
+#define TRANSACTIONFILTER_H
+
+#include <QString>
+#include <QDate>
+
+// Параметры фильтрации проводок. Заполняется AdvancedFilterWidget,
+// компилируется в SQL классом TransactionQuery.
+struct TransactionFilter {
+    QString textFilter;
+    QString fieldFilter;
+    QDate dateFrom;
+    QDate dateTo;
+    bool dateFilterEnabled = false;
+    double amountFrom = 0.0;
+    double amountTo = 0.0;
+    bool amountFilterEnabled = false;
+    int debitAccountId = -1;
+    int creditAccountId = -1;
+    bool includeSubaccounts = false;    // счета дебета/кредита вместе с подсчетами
+    int counterpartyId = -1;
+    bool useSavedFilter = false;
+    QString savedFilterName;
+};
+
+#endif // TRANSACTIONFILTER_H
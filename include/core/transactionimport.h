@@ -0,0 +1,40 @@
+#ifndef TRANSACTIONIMPORT_H
+#define TRANSACTIONIMPORT_H
+
+#include <QString>
+#include <QStringList>
+
+// Импорт проводок из CSV в формате выгрузки журнала:
+// Дата;Дебет;Кредит;Сумма;Описание;Документ;Контрагент.
+// Счета ищутся по коду (из "код - наименование" выгрузки берется код),
+// контрагенты - по наименованию; строка заголовков, если есть,
+// пропускается. Файл читается потоком и пишется в одной
+// транзакции одним подготовленным запросом. Строки проверяются пачками
+// (BatchValidator). Ошибка хотя бы в одной строке - транзакция
+// откатывается и в базу не попадает ничего, но проверяется весь файл,
+// и у строки перечисляются все ее ошибки.
+// Так же импортируются контрагенты: Наименование;ИНН;КПП.
+class TransactionImport
+{
+public:
+    struct Options {
+        bool dryRun = false;    // только проверить, ничего не записывая
+        int maxErrors = 100;    // перечисляется не больше стольких ошибочных строк
+    };
+
+    struct Result {
+        qint64 rows = 0;        // строк с проводками (контрагентами) в файле
+        qint64 imported = 0;    // записано в базу
+        QStringList errors;     // "Строка N: ..."
+    };
+
+    // false - файл не прочитан, есть ошибочные строки или запись не удалась
+    static bool importCsv(const QString &fileName, const Options &options, Result *result);
+
+    // Контрагенты: наименование обязательно, ИНН - с верными контрольными
+    // цифрами и не занятый ни в базе, ни выше в файле
+    static bool importCounterpartiesCsv(const QString &fileName, const Options &options,
+                                        Result *result);
+};
+
+#endif // TRANSACTIONIMPORT_H
@@ -0,0 +1,94 @@
+#ifndef TRANSACTIONQUERY_H
+#define TRANSACTIONQUERY_H
+
+#include "core/transactionfilter.h"
+
+#include <QByteArray>
+#include <QDate>
+#include <QString>
+#include <QVariantList>
+#include <QVector>
+#include <QSqlQuery>
+
+// Строка списка проводок в том виде, в котором ее показывают таблицы
+struct TransactionRow {
+    qint64 id = 0;
+    QDate date;
+    QString debit;          // "код - наименование"
+    QString credit;
+    double amount = 0.0;
+    QString description;
+    QString documentNumber;
+    QString counterparty;
+    int debitAccountId = 0;
+    int creditAccountId = 0;
+    int counterpartyId = 0;     // 0 - без контрагента
+};
+
+// Итоги по всем проводкам, подходящим под фильтр
+struct TransactionTotals {
+    qint64 count = 0;
+    double sum = 0.0;
+    double minAmount = 0.0;
+    double maxAmount = 0.0;
+};
+
+// Скомпилированный фильтр проводок: условие WHERE с привязанными параметрами
+// (без подстановки пользовательского текста в SQL) и постраничная выборка
+// по ключу (дата, id) в порядке убывания.
+class TransactionQuery
+{
+public:
+    struct PageKey {
+        QDate date;
+        qint64 id = 0;
+    };
+
+    explicit TransactionQuery(const TransactionFilter &filter = TransactionFilter());
+
+    const TransactionFilter &filter() const { return filter_; }
+    const QString &whereSql() const { return whereSql_; }
+    const QVariantList &whereParams() const { return whereParams_; }
+    bool hasConditions() const { return !whereParams_.isEmpty(); }
+
+    // Нормализованный ключ фильтра: одинаков для фильтров, дающих один и тот же SQL
+    QByteArray cacheKey() const;
+
+    // Страница из limit строк после ключа after (nullptr - с начала)
+    QSqlQuery fetchPage(const PageKey *after, int limit) const;
+
+    // Все подходящие строки в порядке списка курсором только вперед (выгрузки)
+    QSqlQuery fetchAll() const;
+
+    // Только id подходящих проводок в порядке списка, не более limit
+    QSqlQuery fetchIds(int limit) const;
+
+    // Количество, сумма, минимум и максимум одним агрегатным запросом
+    bool fetchTotals(TransactionTotals *totals) const;
+
+    // Не больше стольких id в одном IN (...): предел переменных SQLite
+    static const int MaxIdsPerQuery = 500;
+
+    // Строки с указанными id, которые по-прежнему подходят под фильтр
+    // (не больше MaxIdsPerQuery за раз)
+    QSqlQuery fetchMatching(const QVector<qint64> &ids) const;
+
+    // Строки для ids[from, from + count) в порядке списка
+    static QSqlQuery fetchByIds(const QVector<qint64> &ids, int from, int count);
+
+    static TransactionRow readRow(const QSqlQuery &query);
+
+    // SELECT и FROM с соединениями, общие для всех выборок списка проводок
+    static QString selectSql();
+
+private:
+    void compile();
+    QString fromSql() const;
+
+    TransactionFilter filter_;
+    QString whereSql_;
+    QVariantList whereParams_;
+    bool needsJoins_ = false;   // условие ссылается на d., c. или cp.
+};
+
+#endif // TRANSACTIONQUERY_H
@@ -0,0 +1,69 @@
+#ifndef TRANSACTIONSEARCH_H
+#define TRANSACTIONSEARCH_H
+
+#include "core/transactionquery.h"
+
+#include <QObject>
+#include <QVector>
+#include <memory>
+
+// Асинхронный постраничный поиск проводок.
+// Каждый вызов start() открывает новое поколение поиска и отменяет предыдущее:
+// рабочий поток прекращает чтение, а его результаты отбрасываются.
+// Страницы читаются в пуле потоков через собственное соединение потока
+// и доставляются в поток объекта сигналом pageReady.
+// Список id результата берется из FilterResultCache, если он там есть для
+// текущей версии журнала. Иначе страницы читаются по ключу (дата, id), а
+// список строится и кладется в кэш уже после доставки первой страницы.
+// Слишком большие результаты в кэш не попадают.
+// Итоги по всему результату считаются отдельным агрегатным запросом
+// параллельно с первой страницей и приходят сигналом totalsReady.
+class TransactionSearch : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const int FirstPageSize = 100;
+    static const int PageSize = 500;
+
+    explicit TransactionSearch(QObject *parent = nullptr);
+    ~TransactionSearch();
+
+    // firstPageSize больше FirstPageSize - перечитать сразу столько строк
+    // (обновление списка без потери уже догруженных страниц)
+    quint64 start(const TransactionFilter &filter, int firstPageSize = FirstPageSize);
+    void fetchMore();
+    void cancel();
+
+    // Пересчитать итоги текущего поиска после изменения данных
+    void refreshTotals();
+
+    quint64 generation() const;
+    bool isRunning() const { return running_; }
+    bool hasMore() const { return hasMore_; }
+    const TransactionQuery &query() const { return query_; }
+
+signals:
+    void pageReady(quint64 generation, const QVector<TransactionRow> &rows, bool hasMore);
+    void totalsReady(quint64 generation, const TransactionTotals &totals);
+
+private:
+    struct Shared;
+
+    using IdList = QVector<qint64>;
+
+    void runPage(bool fromStart, int limit);
+    void runTotals();
+    void deliverPage(quint64 generation, const QVector<TransactionRow> &rows, bool hasMore,
+                     std::shared_ptr<const IdList> ids, int nextOffset);
+
+    std::shared_ptr<Shared> shared_;
+    TransactionQuery query_;
+    TransactionQuery::PageKey lastKey_;
+    std::shared_ptr<const IdList> ids_;     // nullptr - постраничное чтение по ключу
+    int offset_ = 0;
+    bool running_ = false;
+    bool hasMore_ = false;
+};
+
+#endif // TRANSACTIONSEARCH_H
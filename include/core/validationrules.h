@@ -38,12 +38,21 @@ public:
     // Проверка суммы
     static bool validateAmount(double amount);
 
+    // Сумма из текста: "1 234,56" и "1234.56" - одно и то же число
+    static double parseAmount(QString text, bool *ok);
+
     // Проверка даты
     static bool validateDate(const QDate &date);
 
-private:
+    // Код счета: цифры и точки, не длиннее 20 знаков
     static bool isValidAccountCode(const QString &code);
+
+    // ИНН: 10 цифр (организация) или 12 (физлицо) с верными контрольными цифрами
     static bool isValidINN(const QString &inn);
+
+    // ИНН с контрольными цифрами по 9 цифрам организации или 10 физлица;
+    // пустая строка - не 9 или 10 цифр
+    static QString completeINN(const QString &body);
 };
 
 #endif // VALIDATIONRULES_H
@@ -0,0 +1,80 @@
+#ifndef XLSXWRITER_H
+#define XLSXWRITER_H
+
+#include "core/zipwriter.h"
+
+#include <QByteArray>
+#include <QDate>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QTemporaryFile>
+#include <QVector>
+
+// Потоковая запись книги Excel (.xlsx) - минимальный SpreadsheetML в zip.
+// Строки листа пишутся в архив по мере добавления; текст идет через таблицу
+// общих строк, которая копится во временном файле и дописывается в архив
+// при закрытии. Суммы - числовые ячейки, даты - ячейки-даты, строка
+// заголовков закреплена. Если строк больше, чем вмещает лист Excel,
+// продолжение уходит на следующий лист с той же шапкой.
+class XlsxWriter
+{
+public:
+    XlsxWriter();
+    ~XlsxWriter();
+
+    // columnWidths - ширина столбцов в символах, можно не задавать
+    bool open(const QString &fileName, const QString &sheetName,
+              const QStringList &headers, const QVector<int> &columnWidths = {});
+
+    void addString(const QString &text);
+    void addNumber(double value);     // формат "# ##0.00"
+    void addDate(const QDate &date);  // формат "ДД.ММ.ГГГГ"
+    void addEmpty();
+    void endRow();
+
+    bool close();
+
+    qint64 rowCount() const { return rows_; }
+    QString errorString() const { return error_; }
+
+private:
+    enum Style {
+        DefaultStyle = 0,
+        HeaderStyle,
+        DateStyle,
+        AmountStyle
+    };
+
+    int sharedString(const QString &text);
+    void addStringCell(const QString &text, Style style);
+    void openRow();
+    void beginSheet();
+    bool finishSheet();
+    bool flushSheet();
+    bool flushStrings();
+    bool writeSharedStrings();
+    bool writeMetadata();
+
+    ZipWriter zip_;
+    QString sheetName_;
+    QStringList headers_;
+    QVector<int> columnWidths_;
+
+    QByteArray sheet_;
+    int sheetCount_ = 0;
+    qint64 sheetRows_ = 0;
+    bool rowOpen_ = false;
+
+    QTemporaryFile strings_;
+    QByteArray stringsBuffer_;
+    QHash<QString, int> stringIndex_;
+    int stringCount_ = 0;
+    qint64 stringRefs_ = 0;
+
+    qint64 rows_ = 0;
+    bool failed_ = false;
+    QString error_;
+};
+
+#endif // XLSXWRITER_H
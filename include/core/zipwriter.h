@@ -0,0 +1,57 @@
+#ifndef ZIPWRITER_H
+#define ZIPWRITER_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include <memory>
+
+// Потоковая запись zip-архива: файлы пишутся по одному, содержимое
+// сжимается deflate по мере поступления, размеры и CRC уходят в
+// дескриптор после данных, поэтому размер файла заранее не нужен.
+// Без ZIP64: каждый файл и весь архив - до 4 ГБ.
+class ZipWriter
+{
+public:
+    ZipWriter();
+    ~ZipWriter();
+
+    bool open(const QString &fileName);
+
+    bool beginEntry(const QString &name);
+    bool write(const char *data, qint64 size);
+    bool write(const QByteArray &data) { return write(data.constData(), data.size()); }
+    bool endEntry();
+
+    // Пишет центральный каталог и закрывает файл
+    bool close();
+
+    QString errorString() const { return error_; }
+
+private:
+    struct Entry {
+        QByteArray name;
+        quint32 crc = 0;
+        quint32 compressedSize = 0;
+        quint32 size = 0;
+        quint32 offset = 0;
+    };
+    struct Deflate;
+
+    bool deflateInput(const char *data, qint64 size, bool finish);
+    bool writeRaw(const QByteArray &data);
+    bool fail(const QString &message);
+
+    QFile file_;
+    QVector<Entry> entries_;
+    Entry current_;
+    std::unique_ptr<Deflate> deflate_;
+    quint16 dosTime_ = 0;
+    quint16 dosDate_ = 0;
+    bool inEntry_ = false;
+    bool failed_ = false;
+    QString error_;
+};
+
+#endif // ZIPWRITER_H
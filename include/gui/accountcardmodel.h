@@ -0,0 +1,80 @@
+#ifndef ACCOUNTCARDMODEL_H
+#define ACCOUNTCARDMODEL_H
+
+#include "core/accountcard.h"
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+// Модель карточки счета для периодов любой длины. Число строк и итоги
+// известны сразу из агрегатного запроса; сами движения читаются страницами
+// при обращении к строкам и хранятся компактно (AccountCardEntry).
+// В памяти держится не больше MaxCachedPages страниц - давно не
+// использованные выгружаются, поэтому расход памяти не зависит от периода.
+// Строка 0 - входящее сальдо, последняя строка - обороты и сальдо на конец.
+class AccountCardModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column {
+        DateColumn = 0,
+        AccountColumn,
+        DocumentColumn,
+        CounterpartyColumn,
+        OppositeColumn,
+        DebitColumn,
+        CreditColumn,
+        BalanceColumn,
+        DescriptionColumn,
+        ColumnCount
+    };
+
+    static constexpr int PageSize = 500;
+    static constexpr int MaxCachedPages = 20;
+
+    explicit AccountCardModel(QObject *parent = nullptr);
+
+    // Новый отчет: итоги читаются сразу, страницы - по мере просмотра
+    bool setParams(const AccountCardParams &params);
+    void clear();
+
+    const AccountCardParams &params() const { return params_; }
+    const AccountCardSummary &summary() const { return summary_; }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+
+private:
+    const AccountCardEntry *entryAt(qint64 position) const;
+    void loadPage(int page) const;
+    void resolveCounterparties(const QVector<AccountCardEntry> &entries) const;
+    QVariant displayValue(int row, int column) const;
+
+    static QString amountText(double value);
+    static QString balanceText(double value);
+
+    AccountCardParams params_;
+    AccountCardSummary summary_;
+    bool loaded_ = false;
+
+    // Кэш страниц с вытеснением давно не использованных.
+    // Последняя строка каждой прочитанной страницы запоминается отдельно:
+    // следующая страница тогда читается по ключу, а не по смещению.
+    mutable QHash<int, QVector<AccountCardEntry>> pages_;
+    mutable QList<int> pageOrder_;                  // от давних к свежим
+    mutable QHash<int, AccountCardEntry> pageEnds_;
+
+    // Справочники имен: строки хранят только id
+    mutable QHash<int, QString> accountNames_;      // "код - наименование"
+    mutable QHash<int, QString> accountCodes_;
+    mutable QHash<int, QString> counterpartyNames_;
+};
+
+#endif // ACCOUNTCARDMODEL_H
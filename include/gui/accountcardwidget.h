@@ -7,7 +7,8 @@ class QComboBox;
 class QDateEdit;
 class QTableView;
 class QPushButton;
-class QStandardItemModel;
+class QCheckBox;
+class AccountCardModel;
 
 class AccountCardWidget : public QWidget
 {
@@ -19,6 +20,7 @@ public:
 private slots:
     void updateReport();
     void exportToCsv();
+    void openBatchExport();
     void loadAccounts();
 
 private:
@@ -29,12 +31,14 @@ private:
     QComboBox *accountCombo;
     QDateEdit *dateStartEdit;
     QDateEdit *dateEndEdit;
+    QCheckBox *subaccountsCheck;
     QTableView *tableView;
     QPushButton *updateButton;
     QPushButton *exportButton;
+    QPushButton *batchButton;
     
     // Модель данных
-    QStandardItemModel *model;
+    AccountCardModel *model;
 };
 
 #endif // ACCOUNTCARDWIDGET_H
\ No newline at end of file
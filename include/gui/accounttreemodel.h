@@ -0,0 +1,88 @@
+#ifndef ACCOUNTTREEMODEL_H
+#define ACCOUNTTREEMODEL_H
+
+#include "core/ledgerevents.h"
+
+#include <QAbstractItemModel>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+// Дерево плана счетов. Дочерние счета читаются только при раскрытии узла
+// (canFetchMore/fetchMore), одним запросом на уровень по таблице замыкания.
+// Сальдо узла - сальдо всего его поддерева по агрегату account_balances,
+// который поддерживается триггерами на transactions.
+// id счета доступен через Qt::UserRole любого столбца.
+class AccountTreeModel : public QAbstractItemModel
+{
+    Q_OBJECT
+
+public:
+    enum Column {
+        CodeColumn = 0,
+        NameColumn,
+        TypeColumn,
+        BalanceColumn,
+        ColumnCount
+    };
+
+    explicit AccountTreeModel(QObject *parent = nullptr);
+    ~AccountTreeModel() override;
+
+    // Сброс дерева: заново читаются только корневые счета
+    void reload();
+    // Перечитать сальдо всех загруженных узлов одним запросом
+    void refreshBalances();
+
+    QModelIndex indexOf(int accountId) const;
+
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+
+private slots:
+    void onRowInserted(LedgerEvents::Table table, qint64 id);
+    void onRowUpdated(LedgerEvents::Table table, qint64 id);
+    void onRowRemoved(LedgerEvents::Table table, qint64 id);
+    void onBulkChanged(LedgerEvents::Table table);
+
+private:
+    struct Node {
+        int id = 0;
+        int parentId = 0;
+        QString code;
+        QString name;
+        int type = 0;
+        double balance = 0.0;       // дебет минус кредит по поддереву
+        int childCount = 0;         // число прямых подсчетов по данным базы
+        bool fetched = false;
+        Node *parent = nullptr;
+        QVector<Node*> children;
+    };
+
+    Node *nodeFor(const QModelIndex &index) const;
+    QModelIndex indexFor(Node *node, int column = 0) const;
+
+    QVector<Node*> loadChildren(int parentId) const;
+    bool loadNode(int accountId, Node *target) const;
+    void insertNode(Node *node);
+    void removeNode(Node *node);
+    void clearNode(Node *node);
+    void scheduleBalanceRefresh();
+
+    static QString nodeSql();
+    static QString balanceText(double balance);
+
+    Node root_;
+    QHash<int, Node*> nodes_;       // все загруженные узлы по id
+    bool balanceRefreshPending_ = false;
+};
+
+#endif // ACCOUNTTREEMODEL_H
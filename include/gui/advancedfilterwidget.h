@@ -1,8 +1,11 @@
 #ifndef ADVANCEDFILTERWIDGET_H
 #define ADVANCEDFILTERWIDGET_H
 
+#include "core/transactionfilter.h"
+
 #include <QWidget>
 #include <QDate>
+#include <QMap>
 
 class QLineEdit;
 class QComboBox;
@@ -11,6 +14,8 @@ class QDoubleSpinBox;
 class QPushButton;
 class QGroupBox;
 class QCheckBox;
+class QTimer;
+class LookupComboBox;
 
 class AdvancedFilterWidget : public QWidget
 {
@@ -19,21 +24,10 @@ class AdvancedFilterWidget : public QWidget
 public:
     explicit AdvancedFilterWidget(QWidget *parent = nullptr);
     
-    struct FilterOptions {
-        QString textFilter;
-        QString fieldFilter;
-        QDate dateFrom;
-        QDate dateTo;
-        bool dateFilterEnabled;
-        double amountFrom;
-        double amountTo;
-        bool amountFilterEnabled;
-        int debitAccountId;
-        int creditAccountId;
-        int counterpartyId;
-        bool useSavedFilter;
-        QString savedFilterName;
-    };
+    using FilterOptions = TransactionFilter;
+    
+    // Задержка перед автоматическим применением фильтра при вводе
+    static const int DebounceInterval = 300;
     
     FilterOptions getFilterOptions() const;
     void setFilterOptions(const FilterOptions &options);
@@ -53,6 +47,7 @@ private slots:
     void onClearClicked();
     void onSaveClicked();
     void onLoadClicked();
+    void onDebounceTimeout();
 
 private:
     void setupUI();
@@ -60,6 +55,8 @@ private:
     void loadCounterparties();
     void loadSavedFiltersList();
     void initConnections();  
+    void scheduleApply();
+    bool validateFilters(bool showErrors);
     
     // Элементы фильтрации
     QLineEdit *searchEdit;
@@ -73,9 +70,10 @@ private:
     QDoubleSpinBox *amountFromSpin;
     QDoubleSpinBox *amountToSpin;
     
-    QComboBox *debitAccountCombo;
-    QComboBox *creditAccountCombo;
-    QComboBox *counterpartyCombo;
+    LookupComboBox *debitAccountCombo;
+    LookupComboBox *creditAccountCombo;
+    QCheckBox *subaccountsCheck;
+    LookupComboBox *counterpartyCombo;
     
     QGroupBox *savedFilterGroup;
     QComboBox *savedFilterCombo;
@@ -86,7 +84,10 @@ private:
     QPushButton *applyButton;
     QPushButton *clearButton;
     
-    // Хранилище фильтров (в реальном приложении - в базе данных)
+    // Откладывает применение фильтра, пока пользователь печатает
+    QTimer *debounceTimer;
+    
+    // Сохраненные фильтры, загруженные из таблицы saved_filters
     QMap<QString, FilterOptions> savedFilters;
 };
 
@@ -8,6 +8,7 @@ class QDateEdit;
 class QLineEdit;
 class QDoubleSpinBox;
 class QPushButton;
+class LookupComboBox;
 
 class AddTransactionDialog : public QDialog
 {
@@ -27,10 +28,10 @@ protected:  // Меняем private на protected для доступа в на
 
     // Элементы формы - делаем protected для доступа в наследниках
     QDateEdit *dateEdit;
-    QComboBox *debitAccountCombo;
-    QComboBox *creditAccountCombo;
+    LookupComboBox *debitAccountCombo;
+    LookupComboBox *creditAccountCombo;
     QDoubleSpinBox *amountSpin;
-    QComboBox *counterpartyCombo;
+    LookupComboBox *counterpartyCombo;
     QLineEdit *descriptionEdit;
     QLineEdit *documentNumberEdit;
     QDateEdit *documentDateEdit;
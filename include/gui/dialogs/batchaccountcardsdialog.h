@@ -0,0 +1,60 @@
+#ifndef BATCHACCOUNTCARDSDIALOG_H
+#define BATCHACCOUNTCARDSDIALOG_H
+
+#include "core/accountcardbatch.h"
+
+#include <QDialog>
+#include <QDate>
+
+class QRadioButton;
+class QListWidget;
+class QDateEdit;
+class QCheckBox;
+class QLineEdit;
+class QPushButton;
+class QProgressBar;
+class QLabel;
+class QPlainTextEdit;
+
+// Выгрузка карточек по набору счетов или по всему плану в отдельные файлы
+class BatchAccountCardsDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    BatchAccountCardsDialog(const QDate &dateFrom, const QDate &dateTo,
+                            QWidget *parent = nullptr);
+
+protected:
+    void reject() override;
+
+private slots:
+    void chooseDirectory();
+    void startBatch();
+    void onProgress(int done, int total);
+    void onFinished(int succeeded, const QVector<AccountCardBatch::Failure> &failures,
+                    bool cancelled);
+
+private:
+    void setupUI();
+    void loadAccounts();
+    void setRunning(bool running);
+
+    AccountCardBatch *batch;
+
+    QRadioButton *allAccountsRadio;
+    QRadioButton *selectedAccountsRadio;
+    QListWidget *accountList;
+    QDateEdit *dateFromEdit;
+    QDateEdit *dateToEdit;
+    QCheckBox *subaccountsCheck;
+    QLineEdit *directoryEdit;
+    QPushButton *browseButton;
+    QProgressBar *progressBar;
+    QLabel *statusLabel;
+    QPlainTextEdit *reportEdit;
+    QPushButton *startButton;
+    QPushButton *closeButton;
+};
+
+#endif // BATCHACCOUNTCARDSDIALOG_H
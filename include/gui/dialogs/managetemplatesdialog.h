@@ -20,6 +20,8 @@ private slots:
     void editTemplate();
     void deleteTemplate();
     void useTemplate();
+    void postList();
+    void editFormula();
     void refreshTable();
     void onDoubleClick(const QModelIndex &index);
 
@@ -34,6 +36,8 @@ private:
     QPushButton *editButton;
     QPushButton *deleteButton;
     QPushButton *useButton;
+    QPushButton *postListButton;
+    QPushButton *formulaButton;
     QPushButton *refreshButton;
     QPushButton *closeButton;
 };
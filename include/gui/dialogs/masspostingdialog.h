@@ -0,0 +1,53 @@
+#ifndef MASSPOSTINGDIALOG_H
+#define MASSPOSTINGDIALOG_H
+
+#include "core/templateposting.h"
+
+#include <QDialog>
+
+class QComboBox;
+class QDateEdit;
+class QTableWidget;
+class QPushButton;
+class QLabel;
+class QPlainTextEdit;
+
+// Проведение одного шаблона по списку строк (контрагент, сумма, документ):
+// строки вводятся в таблицу или загружаются из CSV, проверяются все сразу
+// и записываются одной транзакцией (TemplatePosting)
+class MassPostingDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit MassPostingDialog(int templateId = -1, QWidget *parent = nullptr);
+
+private slots:
+    void loadCsv();
+    void addRow();
+    void removeRows();
+    void check();
+    void post();
+    void updateTotals();
+
+private:
+    void setupUI();
+    void loadTemplates(int templateId);
+    // Строки таблицы; нечисловые суммы - в errors ("Строка N: ...")
+    QVector<TemplatePosting::Row> rows(QStringList *errors) const;
+    void showResult(const TemplatePosting::Result &result);
+
+    QComboBox *templateCombo;
+    QDateEdit *dateEdit;
+    QTableWidget *rowsTable;
+    QLabel *totalsLabel;
+    QPlainTextEdit *reportEdit;
+    QPushButton *loadButton;
+    QPushButton *addButton;
+    QPushButton *removeButton;
+    QPushButton *checkButton;
+    QPushButton *postButton;
+    QPushButton *closeButton;
+};
+
+#endif // MASSPOSTINGDIALOG_H
@@ -0,0 +1,44 @@
+#ifndef EXPORTJOBSPANEL_H
+#define EXPORTJOBSPANEL_H
+
+#include <QWidget>
+
+class QTableWidget;
+class QPushButton;
+
+// Список фоновых выгрузок из ExportJobQueue: ход каждой, отмена,
+// переход к папке с готовым файлом
+class ExportJobsPanel : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit ExportJobsPanel(QWidget *parent = nullptr);
+
+private slots:
+    void addJob(int id);
+    void updateJob(int id);
+    void reloadJobs();
+    void cancelSelected();
+    void openFolder();
+    void updateButtons();
+
+private:
+    enum Column {
+        TitleColumn,
+        FileColumn,
+        ProgressColumn,
+        StateColumn,
+        ColumnCount
+    };
+
+    int rowOf(int id) const;
+    int selectedJob() const;
+
+    QTableWidget *table;
+    QPushButton *cancelButton;
+    QPushButton *openFolderButton;
+    QPushButton *clearButton;
+};
+
+#endif // EXPORTJOBSPANEL_H
@@ -0,0 +1,49 @@
+#ifndef LOOKUPCOMBOBOX_H
+#define LOOKUPCOMBOBOX_H
+
+#include <QComboBox>
+#include <memory>
+
+class QCompleter;
+class QModelIndex;
+class LookupIndex;
+class LookupResultModel;
+
+// Комбобокс с поиском по мере ввода для больших справочников.
+// Список не заполняется целиком: на каждое нажатие клавиши из LookupIndex
+// берутся первые N совпадений, а строки во всплывающий список подгружаются
+// порциями. В самом комбобоксе хранятся только заглушка и выбранный элемент,
+// поэтому currentData()/currentIndexChanged работают как у обычного QComboBox.
+class LookupComboBox : public QComboBox
+{
+    Q_OBJECT
+
+public:
+    explicit LookupComboBox(QWidget *parent = nullptr);
+
+    void setLookupIndex(std::shared_ptr<const LookupIndex> index);
+    void setPlaceholderItem(const QString &text, const QVariant &data = QVariant());
+    void setMaxResults(int count);
+
+    // Выбор элемента по id; если id нет в справочнике - выбирается заглушка
+    bool setCurrentId(int id);
+    int currentId() const;
+
+    void showPopup() override;
+
+private slots:
+    void onTextEdited(const QString &text);
+    void onCompletionActivated(const QModelIndex &index);
+    void onEditingFinished();
+
+private:
+    void selectPosition(int position);
+    void updateMatches(const QString &prefix);
+
+    std::shared_ptr<const LookupIndex> index_;
+    LookupResultModel *resultModel_;
+    QCompleter *completer_;
+    int maxResults_ = 50;
+};
+
+#endif // LOOKUPCOMBOBOX_H
@@ -5,12 +5,17 @@
 
 class QTabWidget;
 class QTableView;
-class QSqlTableModel;
+class QTreeView;
+class QDockWidget;
 class ReportWidget;
 class TableActions;
 class AccountCardWidget;
 class AdvancedFilterWidget;
 class OperationsJournalWidget;
+class TransactionTableModel;
+class SqlRowModel;
+class AccountTreeModel;
+class TemplateScheduler;
 
 class MainWindow : public QMainWindow
 {
@@ -44,7 +49,11 @@ private slots:
     void exportTransactionsToPdf();
     void exportAccountsToPdf();
     void exportCounterpartiesToPdf();
+    void exportLedgerSnapshot();
     void onSearchTransactions();
+    void onTransactionsPageLoaded(int loadedRows, bool hasMore);
+    void onExportFinished(int id, bool ok);
+    void onTemplatesExecuted(int templates, qint64 inserted);
 
 private:
     void setupUi();
@@ -61,17 +70,19 @@ private:
     // Виджеты
     QTabWidget *tabWidget;
     QTableView *transactionsTable;
-    QTableView *accountsTable;
+    QTreeView *accountsTree;
     QTableView *counterpartiesTable;
     ReportWidget *reportWidget;
     AccountCardWidget *accountCardWidget;
     AdvancedFilterWidget *transactionsSearchWidget;
     OperationsJournalWidget *operationsJournalWidget;
+    QDockWidget *exportsDock;
+    TemplateScheduler *templateScheduler;
 
     // Модели данных
-    QSqlTableModel *transactionsModel;
-    QSqlTableModel *accountsModel;
-    QSqlTableModel *counterpartiesModel;
+    TransactionTableModel *transactionsModel;
+    AccountTreeModel *accountsModel;
+    SqlRowModel *counterpartiesModel;
 
     // Действия для контекстных меню
     TableActions *transactionsActions;
@@ -83,6 +94,7 @@ private:
     QAction *actionAddTransaction;
     QAction *actionAddCounterparty;
     QAction *actionBalanceReport;
+    QAction *actionLedgerSnapshot;
     QAction *actionExit;
     QAction *actionAbout;
 };
@@ -4,10 +4,12 @@
 #include <QWidget>
 #include <QLabel>
 #include "gui/advancedfilterwidget.h"
+#include "core/transactionquery.h"
 
 class QTableView;
-class QStandardItemModel;
 class QPushButton;
+class TransactionTableModel;
+class TotalsFooterWidget;
 
 class OperationsJournalWidget : public QWidget
 {
@@ -28,11 +30,15 @@ private:
     void setupUI();
     void loadData();
     void initConnections();
-    QString buildQuery(const AdvancedFilterWidget::FilterOptions &options);
+    
+    // Заголовки столбцов для экспорта; сами строки экспорт читает запросом,
+    // так как модель хранит только загруженные
+    QStringList exportHeaders() const;
     
     AdvancedFilterWidget *filterWidget;
     QTableView *tableView;
-    QStandardItemModel *model;
+    TransactionTableModel *model;
+    TotalsFooterWidget *totalsFooter;
     QPushButton *refreshButton;
     QPushButton *pdfButton;
     QPushButton *excelButton;
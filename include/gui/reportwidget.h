@@ -3,6 +3,8 @@
 #include <QWidget>
 #include <QDate>
 #include <QTableView>
+#include <QVector>
+#include "core/report_generator.h"
 
 class QPushButton;
 class QDateEdit;
@@ -33,6 +35,9 @@ private:
     
     // Модель данных для таблицы
     QStandardItemModel *model;
+    
+    // Последняя сформированная ведомость - источник для выгрузки в CSV
+    QVector<BalanceRecord> currentReport;
 };
 
 #endif // REPORTWIDGET_H
\ No newline at end of file
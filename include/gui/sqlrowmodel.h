@@ -0,0 +1,67 @@
+#ifndef SQLROWMODEL_H
+#define SQLROWMODEL_H
+
+#include "core/ledgerevents.h"
+
+#include <QAbstractTableModel>
+#include <QMap>
+#include <QVariant>
+#include <QVector>
+
+// Табличная модель справочника (счета, контрагенты) с построчным обновлением.
+// Список читается один раз запросом selectSql; при изменении строки
+// (LedgerEvents) перечитываются только затронутые строки запросом rowsSql,
+// в котором %1 заменяется списком параметров id. rowsSql может вернуть
+// и другие зависимые строки (например, дочерние счета) - они тоже обновятся.
+// Строки упорядочены по столбцу sortColumn, который должен совпадать
+// с ORDER BY в selectSql; столбец 0 - id.
+class SqlRowModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    SqlRowModel(LedgerEvents::Table table, const QString &selectSql, const QString &rowsSql,
+                int sortColumn, QObject *parent = nullptr);
+
+    // Полная перезагрузка списка
+    bool select();
+    // Перечитать строки с указанными id (вставка, изменение, удаление)
+    void refreshRows(const QVector<qint64> &ids);
+
+    int rowOf(qint64 id) const;
+    qint64 idAt(int row) const;
+    QVariant valueAt(int row, int column) const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+    bool setHeaderData(int section, Qt::Orientation orientation, const QVariant &value,
+                       int role = Qt::EditRole) override;
+
+private slots:
+    void onRowInserted(LedgerEvents::Table table, qint64 id);
+    void onRowUpdated(LedgerEvents::Table table, qint64 id);
+    void onRowRemoved(LedgerEvents::Table table, qint64 id);
+    void onBulkChanged(LedgerEvents::Table table);
+
+private:
+    using Row = QVector<QVariant>;
+
+    bool comesBefore(const Row &a, const Row &b) const;
+    int insertPosition(const Row &row) const;
+    void removeRowAt(int row);
+    void insertRowAt(int row, const Row &value);
+
+    LedgerEvents::Table table_;
+    QString selectSql_;
+    QString rowsSql_;
+    int sortColumn_;
+    int columnCount_ = 0;
+
+    QVector<Row> rows_;
+    QMap<int, QVariant> headers_;
+};
+
+#endif // SQLROWMODEL_H
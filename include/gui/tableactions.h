@@ -2,7 +2,7 @@
 #define TABLEACTIONS_H
 
 #include <QObject>
-#include <QTableView>
+#include <QAbstractItemView>
 #include <QMenu>
 
 class TableActions : public QObject
@@ -10,7 +10,9 @@ class TableActions : public QObject
     Q_OBJECT
 
 public:
-    explicit TableActions(QTableView *tableView, QObject *parent = nullptr);
+    // Подходит и для таблиц, и для деревьев: id берется из Qt::UserRole
+    // первого столбца, а если его нет - из текста скрытого столбца id
+    explicit TableActions(QAbstractItemView *tableView, QObject *parent = nullptr);
     
     void setupContextMenu();
     void setAddEnabled(bool enabled);
@@ -34,7 +36,7 @@ private slots:
 
 
 private:
-    QTableView *tableView_;
+    QAbstractItemView *tableView_;
     QMenu *contextMenu_;
     QAction *addAction_;
     QAction *editAction_;
@@ -0,0 +1,33 @@
+#ifndef TOTALSFOOTERWIDGET_H
+#define TOTALSFOOTERWIDGET_H
+
+#include "core/transactionquery.h"
+
+#include <QWidget>
+
+class QLabel;
+class TransactionTableModel;
+
+// Строка итогов под списком проводок: количество, сумма, минимум и максимум.
+// Значения приходят из агрегатного запроса модели, а не из загруженных строк.
+class TotalsFooterWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit TotalsFooterWidget(QWidget *parent = nullptr);
+
+    void setModel(TransactionTableModel *model);
+
+public slots:
+    void setTotals(const TransactionTotals &totals);
+    void setLoading();
+
+private:
+    QLabel *countLabel;
+    QLabel *sumLabel;
+    QLabel *minLabel;
+    QLabel *maxLabel;
+};
+
+#endif // TOTALSFOOTERWIDGET_H
@@ -0,0 +1,86 @@
+#ifndef TRANSACTIONTABLEMODEL_H
+#define TRANSACTIONTABLEMODEL_H
+
+#include "core/transactionquery.h"
+#include "core/ledgerevents.h"
+
+#include <QAbstractTableModel>
+#include <QVector>
+
+class TransactionSearch;
+
+// Список проводок, который догружается страницами по мере прокрутки.
+// Поиск выполняется в фоне; новый фильтр отменяет незавершенный поиск.
+// Изменения из LedgerEvents применяются построчно: перечитывается только
+// затронутая проводка, позиция прокрутки сохраняется.
+class TransactionTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column {
+        IdColumn = 0,
+        DateColumn,
+        DebitColumn,
+        CreditColumn,
+        AmountColumn,
+        DescriptionColumn,
+        DocumentColumn,
+        CounterpartyColumn,
+        ColumnCount
+    };
+
+    explicit TransactionTableModel(QObject *parent = nullptr);
+
+    void setFilter(const TransactionFilter &filter);
+    const TransactionFilter &filter() const { return filter_; }
+    void refresh();
+
+    bool isLoading() const;
+    bool hasTotals() const { return hasTotals_; }
+    const TransactionTotals &totals() const { return totals_; }
+    const TransactionRow &rowAt(int row) const { return rows_.at(row); }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+signals:
+    // Пришла очередная страница: сколько строк загружено и есть ли еще
+    void pageLoaded(int loadedRows, bool hasMore);
+    // Итоги по всему результату (не только по загруженным строкам)
+    void totalsChanged(const TransactionTotals &totals);
+    // Начат новый поиск, прежние итоги недействительны
+    void searchStarted();
+
+private slots:
+    void onPageReady(quint64 generation, const QVector<TransactionRow> &rows, bool hasMore);
+    void onTotalsReady(quint64 generation, const TransactionTotals &totals);
+
+    void onRowInserted(LedgerEvents::Table table, qint64 id);
+    void onRowUpdated(LedgerEvents::Table table, qint64 id);
+    void onRowRemoved(LedgerEvents::Table table, qint64 id);
+    void onBulkChanged(LedgerEvents::Table table);
+
+private:
+    void startSearch(int keepRows);
+    int rowOf(qint64 id) const;
+    int insertPosition(const TransactionRow &row) const;
+    void reloadRows(const QVector<qint64> &ids);
+    void removeRowAt(int row);
+    void insertRowAt(int row, const TransactionRow &value);
+
+    TransactionSearch *search_;
+    TransactionFilter filter_;
+    QVector<TransactionRow> rows_;
+    bool replacePending_ = false;
+    TransactionTotals totals_;
+    bool hasTotals_ = false;
+};
+
+#endif // TRANSACTIONTABLEMODEL_H
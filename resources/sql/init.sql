@@ -44,8 +44,100 @@ CREATE TABLE IF NOT EXISTS transactions (
 
 -- Индексы для ускорения поиска
 CREATE INDEX IF NOT EXISTS idx_transactions_date ON transactions(transaction_date);
-CREATE INDEX IF NOT EXISTS idx_transactions_debit ON transactions(debit_account_id);
-CREATE INDEX IF NOT EXISTS idx_transactions_credit ON transactions(credit_account_id);
+CREATE INDEX IF NOT EXISTS idx_transactions_debit_date ON transactions(debit_account_id, transaction_date);
+CREATE INDEX IF NOT EXISTS idx_transactions_credit_date ON transactions(credit_account_id, transaction_date);
+
+-- Версия записи в журнал (для инвалидации кэшей результатов)
+CREATE TABLE IF NOT EXISTS ledger_state (
+    id INTEGER PRIMARY KEY CHECK (id = 1),
+    write_version INTEGER NOT NULL DEFAULT 0
+);
+INSERT OR IGNORE INTO ledger_state (id, write_version) VALUES (1, 0);
+
+CREATE TRIGGER IF NOT EXISTS trg_version_transactions_ai AFTER INSERT ON transactions
+BEGIN UPDATE ledger_state SET write_version = write_version + 1 WHERE id = 1; END;
+CREATE TRIGGER IF NOT EXISTS trg_version_transactions_au AFTER UPDATE ON transactions
+BEGIN UPDATE ledger_state SET write_version = write_version + 1 WHERE id = 1; END;
+CREATE TRIGGER IF NOT EXISTS trg_version_transactions_ad AFTER DELETE ON transactions
+BEGIN UPDATE ledger_state SET write_version = write_version + 1 WHERE id = 1; END;
+CREATE TRIGGER IF NOT EXISTS trg_version_accounts_ai AFTER INSERT ON accounts
+BEGIN UPDATE ledger_state SET write_version = write_version + 1 WHERE id = 1; END;
+CREATE TRIGGER IF NOT EXISTS trg_version_accounts_au AFTER UPDATE ON accounts
+BEGIN UPDATE ledger_state SET write_version = write_version + 1 WHERE id = 1; END;
+CREATE TRIGGER IF NOT EXISTS trg_version_accounts_ad AFTER DELETE ON accounts
+BEGIN UPDATE ledger_state SET write_version = write_version + 1 WHERE id = 1; END;
+CREATE TRIGGER IF NOT EXISTS trg_version_counterparties_au AFTER UPDATE ON counterparties
+BEGIN UPDATE ledger_state SET write_version = write_version + 1 WHERE id = 1; END;
+CREATE TRIGGER IF NOT EXISTS trg_version_counterparties_ad AFTER DELETE ON counterparties
+BEGIN UPDATE ledger_state SET write_version = write_version + 1 WHERE id = 1; END;
+
+-- Месяцы журнала с версией последнего изменения (для кэша отчетов);
+-- правка справочников записывается месяцем '0000-00'
+CREATE TABLE IF NOT EXISTS ledger_months (
+    month TEXT PRIMARY KEY,
+    version INTEGER NOT NULL
+) WITHOUT ROWID;
+
+CREATE TRIGGER IF NOT EXISTS trg_months_transactions_ai AFTER INSERT ON transactions
+BEGIN INSERT INTO ledger_months (month, version) VALUES (COALESCE(strftime('%Y-%m', NEW.transaction_date), '0000-00'), (SELECT write_version FROM ledger_state WHERE id = 1)) ON CONFLICT(month) DO UPDATE SET version = excluded.version; END;
+CREATE TRIGGER IF NOT EXISTS trg_months_transactions_au AFTER UPDATE ON transactions
+BEGIN INSERT INTO ledger_months (month, version) VALUES (COALESCE(strftime('%Y-%m', OLD.transaction_date), '0000-00'), (SELECT write_version FROM ledger_state WHERE id = 1)) ON CONFLICT(month) DO UPDATE SET version = excluded.version; INSERT INTO ledger_months (month, version) VALUES (COALESCE(strftime('%Y-%m', NEW.transaction_date), '0000-00'), (SELECT write_version FROM ledger_state WHERE id = 1)) ON CONFLICT(month) DO UPDATE SET version = excluded.version; END;
+CREATE TRIGGER IF NOT EXISTS trg_months_transactions_ad AFTER DELETE ON transactions
+BEGIN INSERT INTO ledger_months (month, version) VALUES (COALESCE(strftime('%Y-%m', OLD.transaction_date), '0000-00'), (SELECT write_version FROM ledger_state WHERE id = 1)) ON CONFLICT(month) DO UPDATE SET version = excluded.version; END;
+CREATE TRIGGER IF NOT EXISTS trg_months_accounts_ai AFTER INSERT ON accounts
+BEGIN INSERT INTO ledger_months (month, version) VALUES (COALESCE(strftime('%Y-%m', NULL), '0000-00'), (SELECT write_version FROM ledger_state WHERE id = 1)) ON CONFLICT(month) DO UPDATE SET version = excluded.version; END;
+CREATE TRIGGER IF NOT EXISTS trg_months_accounts_au AFTER UPDATE ON accounts
+BEGIN INSERT INTO ledger_months (month, version) VALUES (COALESCE(strftime('%Y-%m', NULL), '0000-00'), (SELECT write_version FROM ledger_state WHERE id = 1)) ON CONFLICT(month) DO UPDATE SET version = excluded.version; END;
+CREATE TRIGGER IF NOT EXISTS trg_months_accounts_ad AFTER DELETE ON accounts
+BEGIN INSERT INTO ledger_months (month, version) VALUES (COALESCE(strftime('%Y-%m', NULL), '0000-00'), (SELECT write_version FROM ledger_state WHERE id = 1)) ON CONFLICT(month) DO UPDATE SET version = excluded.version; END;
+CREATE TRIGGER IF NOT EXISTS trg_months_counterparties_au AFTER UPDATE ON counterparties
+BEGIN INSERT INTO ledger_months (month, version) VALUES (COALESCE(strftime('%Y-%m', NULL), '0000-00'), (SELECT write_version FROM ledger_state WHERE id = 1)) ON CONFLICT(month) DO UPDATE SET version = excluded.version; END;
+CREATE TRIGGER IF NOT EXISTS trg_months_counterparties_ad AFTER DELETE ON counterparties
+BEGIN INSERT INTO ledger_months (month, version) VALUES (COALESCE(strftime('%Y-%m', NULL), '0000-00'), (SELECT write_version FROM ledger_state WHERE id = 1)) ON CONFLICT(month) DO UPDATE SET version = excluded.version; END;
+
+-- Сохраненные фильтры проводок (options - JSON)
+CREATE TABLE IF NOT EXISTS saved_filters (
+    id INTEGER PRIMARY KEY AUTOINCREMENT,
+    name TEXT NOT NULL UNIQUE,
+    options TEXT NOT NULL,
+    updated_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP
+);
+
+-- Таблица замыкания плана счетов: все пары (предок, потомок), depth = 0 - сам счет
+CREATE TABLE IF NOT EXISTS account_closure (
+    ancestor INTEGER NOT NULL,
+    descendant INTEGER NOT NULL,
+    depth INTEGER NOT NULL,
+    PRIMARY KEY (ancestor, descendant)
+) WITHOUT ROWID;
+CREATE INDEX IF NOT EXISTS idx_account_closure_descendant ON account_closure(descendant, depth);
+
+-- Обороты по каждому счету (сальдо узлов плана счетов), поддерживаются триггерами
+CREATE TABLE IF NOT EXISTS account_balances (
+    account_id INTEGER PRIMARY KEY,
+    debit_total REAL NOT NULL DEFAULT 0,
+    credit_total REAL NOT NULL DEFAULT 0
+);
+
+CREATE TRIGGER IF NOT EXISTS trg_balances_ai AFTER INSERT ON transactions BEGIN
+    INSERT INTO account_balances (account_id, debit_total) VALUES (NEW.debit_account_id, NEW.amount)
+    ON CONFLICT(account_id) DO UPDATE SET debit_total = debit_total + excluded.debit_total;
+    INSERT INTO account_balances (account_id, credit_total) VALUES (NEW.credit_account_id, NEW.amount)
+    ON CONFLICT(account_id) DO UPDATE SET credit_total = credit_total + excluded.credit_total;
+END;
+CREATE TRIGGER IF NOT EXISTS trg_balances_ad AFTER DELETE ON transactions BEGIN
+    UPDATE account_balances SET debit_total = debit_total - OLD.amount WHERE account_id = OLD.debit_account_id;
+    UPDATE account_balances SET credit_total = credit_total - OLD.amount WHERE account_id = OLD.credit_account_id;
+END;
+CREATE TRIGGER IF NOT EXISTS trg_balances_au
+AFTER UPDATE OF debit_account_id, credit_account_id, amount ON transactions BEGIN
+    UPDATE account_balances SET debit_total = debit_total - OLD.amount WHERE account_id = OLD.debit_account_id;
+    UPDATE account_balances SET credit_total = credit_total - OLD.amount WHERE account_id = OLD.credit_account_id;
+    INSERT INTO account_balances (account_id, debit_total) VALUES (NEW.debit_account_id, NEW.amount)
+    ON CONFLICT(account_id) DO UPDATE SET debit_total = debit_total + excluded.debit_total;
+    INSERT INTO account_balances (account_id, credit_total) VALUES (NEW.credit_account_id, NEW.amount)
+    ON CONFLICT(account_id) DO UPDATE SET credit_total = credit_total + excluded.credit_total;
+END;
 
 -- Вставка базовых счетов РСБУ
 INSERT OR IGNORE INTO accounts (code, name, type) VALUES
@@ -59,6 +151,10 @@ INSERT OR IGNORE INTO accounts (code, name, type) VALUES
 ('90', 'Продажи', 1),
 ('91', 'Прочие доходы и расходы', 2);
 
+-- Базовые счета - корни дерева
+INSERT OR IGNORE INTO account_closure (ancestor, descendant, depth)
+SELECT id, id, 0 FROM accounts;
+
 -- Таблица шаблонов проводок
 CREATE TABLE IF NOT EXISTS transaction_templates (
     id INTEGER PRIMARY KEY AUTOINCREMENT,
@@ -72,6 +168,7 @@ CREATE TABLE IF NOT EXISTS transaction_templates (
     counterparty_id INTEGER,               -- Контрагент по умолчанию
     frequency TEXT,                        -- Частота: once, daily, weekly, monthly, yearly
     last_executed DATE,                    -- Когда последний раз выполнялся
+    amount_formula TEXT,                   -- Формула суммы, например balance(70) * 0.13
     created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
     
     FOREIGN KEY (debit_account_id) REFERENCES accounts(id),
@@ -0,0 +1,306 @@
+#include "cli/clicommands.h"
+#include "core/accountcard.h"
+#include "core/database.h"
+#include "core/exportmanager.h"
+#include "core/ledgersnapshot.h"
+#include "core/report_generator.h"
+#include "core/templateposting.h"
+#include "core/templatescheduler.h"
+#include "core/transactionfilter.h"
+#include "core/transactionimport.h"
+
+#include <QCommandLineParser>
+#include <QDate>
+#include <QDateTime>
+#include <QSqlQuery>
+#include <cstdio>
+
+namespace {
+
+void printMessage(const QString &message)
+{
+    std::fprintf(stderr, "%s\n", message.toLocal8Bit().constData());
+}
+
+// Дата в формате ДД.ММ.ГГГГ или ГГГГ-ММ-ДД; пустая - значение по умолчанию
+bool readDate(const QCommandLineParser &args, const QString &name,
+              const QDate &defaultDate, QDate *date)
+{
+    const QString text = args.value(name);
+    if (text.isEmpty()) {
+        *date = defaultDate;
+        return true;
+    }
+
+    *date = QDate::fromString(text, "dd.MM.yyyy");
+    if (!date->isValid()) {
+        *date = QDate::fromString(text, Qt::ISODate);
+    }
+    if (!date->isValid()) {
+        printMessage(QString("Неверная дата --%1: %2").arg(name, text));
+        return false;
+    }
+    return true;
+}
+
+// Период: по умолчанию, как в окне ОСВ, - с начала текущего месяца по сегодня
+bool readPeriod(const QCommandLineParser &args, QDate *from, QDate *to)
+{
+    const QDate today = QDate::currentDate();
+    if (!readDate(args, "from", QDate(today.year(), today.month(), 1), from)
+        || !readDate(args, "to", today, to)) {
+        return false;
+    }
+    if (*from > *to) {
+        printMessage("Дата начала позже даты окончания");
+        return false;
+    }
+    return true;
+}
+
+// id счета по коду; -1 - нет такого счета
+int accountId(const QString &code)
+{
+    QSqlQuery query = Database::instance().executeQuery(
+        "SELECT id FROM accounts WHERE code = ?", {code});
+    return query.next() ? query.value(0).toInt() : -1;
+}
+
+bool readAccount(const QCommandLineParser &args, const QString &name, int *id)
+{
+    const QString code = args.value(name);
+    if (code.isEmpty()) {
+        *id = -1;
+        return true;
+    }
+
+    *id = accountId(code);
+    if (*id < 0) {
+        printMessage("Нет счета " + code);
+        return false;
+    }
+    return true;
+}
+
+bool requireOption(const QCommandLineParser &args, const QString &name)
+{
+    if (args.value(name).isEmpty()) {
+        printMessage(QString("Не задан параметр --%1").arg(name));
+        return false;
+    }
+    return true;
+}
+
+bool isCsvFileName(const QString &fileName)
+{
+    return fileName.endsWith(".csv", Qt::CaseInsensitive)
+        || fileName.endsWith(".csv.gz", Qt::CaseInsensitive);
+}
+
+QString periodTitle(const QString &report, const QDate &from, const QDate &to)
+{
+    return QString("%1\nЗа период с %2 по %3")
+        .arg(report, from.toString("dd.MM.yyyy"), to.toString("dd.MM.yyyy"));
+}
+
+int finish(bool ok, const QString &error, const QString &fileName)
+{
+    if (!ok) {
+        printMessage("Ошибка: " + error);
+        return CliCommands::Failure;
+    }
+    printMessage("Записан файл " + fileName);
+    return CliCommands::Success;
+}
+
+}
+
+int CliCommands::balanceReport(const QCommandLineParser &args)
+{
+    QDate from, to;
+    if (!requireOption(args, "out") || !readPeriod(args, &from, &to)) return UsageError;
+
+    const QString fileName = args.value("out");
+    const bool pdf = fileName.endsWith(".pdf", Qt::CaseInsensitive);
+    if (!pdf && !isCsvFileName(fileName)) {
+        printMessage("ОСВ выгружается в .csv, .csv.gz или .pdf");
+        return UsageError;
+    }
+
+    ReportGenerator generator;
+    QVector<BalanceRecord> records;
+    if (args.isSet("snapshot")) {
+        LedgerSnapshot snapshot;
+        if (!snapshot.open(args.value("snapshot"))) {
+            printMessage("Ошибка: " + snapshot.errorString());
+            return Failure;
+        }
+        records = generator.generateBalanceReport(snapshot, from, to);
+    } else {
+        records = generator.generateBalanceReport(from, to);
+    }
+
+    QString error;
+    bool ok = pdf
+        ? ExportManager::exportBalanceReportToPdf(records, ExportManager::balanceHeaders(),
+              periodTitle("Оборотно-сальдовая ведомость", from, to), fileName, &error)
+        : ExportManager::exportBalanceReportToCsv(records, ExportManager::balanceHeaders(), fileName, &error);
+    return finish(ok, error, fileName);
+}
+
+int CliCommands::accountCard(const QCommandLineParser &args)
+{
+    AccountCardParams params;
+    if (!requireOption(args, "out") || !requireOption(args, "account")
+        || !readPeriod(args, &params.dateFrom, &params.dateTo)
+        || !readAccount(args, "account", &params.accountId)) {
+        return UsageError;
+    }
+    params.includeSubaccounts = args.isSet("subaccounts");
+
+    const QString fileName = args.value("out");
+    if (!isCsvFileName(fileName)) {
+        printMessage("Карточка счета выгружается в .csv или .csv.gz");
+        return UsageError;
+    }
+
+    QString error;
+    bool ok = ExportManager::exportAccountCardToCsv(params, fileName, &error);
+    return finish(ok, error, fileName);
+}
+
+int CliCommands::journal(const QCommandLineParser &args)
+{
+    TransactionFilter filter;
+    if (!requireOption(args, "out")
+        || !readAccount(args, "debit", &filter.debitAccountId)
+        || !readAccount(args, "credit", &filter.creditAccountId)) {
+        return UsageError;
+    }
+
+    // Без периода - весь журнал
+    if (args.isSet("from") || args.isSet("to")) {
+        if (!readPeriod(args, &filter.dateFrom, &filter.dateTo)) return UsageError;
+        filter.dateFilterEnabled = true;
+    }
+    filter.includeSubaccounts = args.isSet("subaccounts");
+    filter.textFilter = args.value("text");
+
+    const QString fileName = args.value("out");
+    QString error;
+    bool ok = false;
+    if (isCsvFileName(fileName)) {
+        ok = ExportManager::exportTransactionsToCsv(filter, ExportManager::journalHeaders(), fileName, &error);
+    } else if (fileName.endsWith(".xlsx", Qt::CaseInsensitive)) {
+        ok = ExportManager::exportTransactionsToXlsx(filter, ExportManager::journalHeaders(), fileName, &error);
+    } else if (fileName.endsWith(".pdf", Qt::CaseInsensitive)) {
+        QString title = "Журнал проводок\nСформировано: "
+                      + QDateTime::currentDateTime().toString("dd.MM.yyyy HH:mm");
+        ok = ExportManager::exportTransactionsToPdf(filter, ExportManager::journalHeaders(), title,
+                                                    fileName, &error);
+    } else {
+        printMessage("Журнал выгружается в .csv, .csv.gz, .xlsx или .pdf");
+        return UsageError;
+    }
+    return finish(ok, error, fileName);
+}
+
+int CliCommands::importTransactions(const QCommandLineParser &args)
+{
+    if (!requireOption(args, "in")) return UsageError;
+
+    TransactionImport::Options options;
+    options.dryRun = args.isSet("dry-run");
+
+    TransactionImport::Result result;
+    const bool counterparties = args.isSet("counterparties");
+    bool ok = counterparties
+        ? TransactionImport::importCounterpartiesCsv(args.value("in"), options, &result)
+        : TransactionImport::importCsv(args.value("in"), options, &result);
+
+    for (const QString &error : result.errors) {
+        printMessage(error);
+    }
+    if (!ok) {
+        printMessage(QString("Импорт не выполнен: ошибок %1, в базу ничего не записано")
+                     .arg(result.errors.size()));
+        return Failure;
+    }
+
+    const QString rows = counterparties ? "контрагентов" : "проводок";
+    printMessage(options.dryRun
+        ? QString("Проверено %1: %2, ошибок нет").arg(rows).arg(result.rows)
+        : QString("Импортировано %1: %2").arg(rows).arg(result.imported));
+    return Success;
+}
+
+int CliCommands::writeSnapshot(const QCommandLineParser &args)
+{
+    if (!requireOption(args, "out")) return UsageError;
+
+    const QString fileName = args.value("out");
+    QString error;
+    bool ok = LedgerSnapshot::write(fileName, &error);
+    return finish(ok, error, fileName);
+}
+
+int CliCommands::runTemplates(const QCommandLineParser &)
+{
+    TemplateScheduler::Result result;
+    bool ok = TemplateScheduler::runDue(QDate::currentDate(), &result);
+
+    for (const QString &error : result.errors) {
+        printMessage(error);
+    }
+    if (!ok) {
+        printMessage("Шаблоны не выполнены, в базу ничего не записано");
+        return Failure;
+    }
+
+    printMessage(QString("По шаблонам (%1) создано проводок: %2")
+                 .arg(result.templates).arg(result.inserted));
+    return Success;
+}
+
+int CliCommands::postTemplate(const QCommandLineParser &args)
+{
+    QDate date;
+    if (!requireOption(args, "template") || !requireOption(args, "in")
+        || !readDate(args, "date", QDate::currentDate(), &date)) {
+        return UsageError;
+    }
+
+    QSqlQuery query = Database::instance().executeQuery(
+        "SELECT id FROM transaction_templates WHERE name = ?", {args.value("template")});
+    if (!query.next()) {
+        printMessage("Нет шаблона " + args.value("template"));
+        return UsageError;
+    }
+    const int templateId = query.value(0).toInt();
+
+    QVector<TemplatePosting::Row> rows;
+    QStringList errors;
+    if (!TemplatePosting::readCsv(args.value("in"), &rows, &errors)) {
+        for (const QString &error : errors) {
+            printMessage(error);
+        }
+        return Failure;
+    }
+
+    TemplatePosting::Result result;
+    const bool dryRun = args.isSet("dry-run");
+    bool ok = TemplatePosting::post(templateId, date, rows, dryRun, &result);
+
+    for (const QString &error : result.errors) {
+        printMessage(error);
+    }
+    if (!ok) {
+        printMessage(QString("Проводки не записаны: ошибок %1").arg(result.errors.size()));
+        return Failure;
+    }
+
+    printMessage(dryRun
+        ? QString("Проверено строк: %1, ошибок нет").arg(rows.size())
+        : QString("Проведено: %1").arg(result.posted));
+    return Success;
+}
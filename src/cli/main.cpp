@@ -0,0 +1,112 @@
+#include "cli/clicommands.h"
+#include "core/database.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QGuiApplication>
+#include <QDir>
+#include <QLoggingCategory>
+#include <cstdio>
+#include <memory>
+
+namespace {
+
+// Отчеты в PDF рисуются шрифтами, а шрифтам нужен QGuiApplication.
+// Дисплей при этом не нужен: платформа offscreen рисует в память.
+bool needsGui(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (QByteArray(argv[i]).toLower().endsWith(".pdf")) return true;
+    }
+    return false;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    std::unique_ptr<QCoreApplication> app;
+    if (needsGui(argc, argv)) {
+        if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+        }
+        app = std::make_unique<QGuiApplication>(argc, argv);
+    } else {
+        app = std::make_unique<QCoreApplication>(argc, argv);
+    }
+
+    app->setApplicationName("ledgermini-cli");
+    app->setApplicationVersion("0.1.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "LedgerMini без окон: отчеты, выгрузки и импорт.\n\n"
+        "Команды:\n"
+        "  osv      оборотно-сальдовая ведомость (--from, --to, --out)\n"
+        "  card     карточка счета (--account, --from, --to, --subaccounts, --out)\n"
+        "  journal  журнал проводок (--from, --to, --debit, --credit, --subaccounts, --text, --out)\n"
+        "  import   импорт проводок из CSV (--in, --dry-run);\n"
+        "           с --counterparties - контрагентов (Наименование;ИНН;КПП)\n"
+        "  snapshot снимок журнала для аудитора (--out *.lmsnap)\n"
+        "  templates провести наступившие повторяющиеся шаблоны\n"
+        "  post     провести шаблон по списку из CSV (--template, --in, --date, --dry-run)\n\n"
+        "osv с --snapshot строит ведомость по снимку, без базы.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addPositionalArgument("command", "osv, card, journal, import, snapshot, templates или post");
+    parser.addOptions({
+        {"db", "Файл базы (по умолчанию ~/ledgermini/ledgermini.db).", "file"},
+        {"from", "Начало периода, ДД.ММ.ГГГГ или ГГГГ-ММ-ДД.", "date"},
+        {"to", "Конец периода.", "date"},
+        {"account", "Код счета карточки.", "code"},
+        {"debit", "Фильтр журнала по счету дебета.", "code"},
+        {"credit", "Фильтр журнала по счету кредита.", "code"},
+        {"subaccounts", "Вместе с подсчетами."},
+        {"text", "Фильтр журнала по тексту.", "text"},
+        {"out", "Файл выгрузки; формат - по расширению.", "file"},
+        {"in", "Файл импорта (CSV, можно .csv.gz).", "file"},
+        {"dry-run", "Импорт и post: только проверить файл."},
+        {"counterparties", "Импорт: файл контрагентов, а не проводок."},
+        {"template", "Наименование шаблона проводки.", "name"},
+        {"date", "Дата проводок (по умолчанию сегодня).", "date"},
+        {"snapshot", "Снимок журнала (*.lmsnap) вместо базы.", "file"},
+        {"verbose", "Отладочный вывод (запросы к базе)."}
+    });
+    parser.process(*app);
+
+    // Ядро подробно пишет каждый запрос в qDebug; в ночных заданиях это шум
+    if (!parser.isSet("verbose")) {
+        QLoggingCategory::setFilterRules("*.debug=false");
+    }
+
+    const QStringList positional = parser.positionalArguments();
+    if (positional.size() != 1) {
+        std::fprintf(stderr, "%s\n", parser.helpText().toLocal8Bit().constData());
+        return CliCommands::UsageError;
+    }
+
+    const QString command = positional.first();
+    if (command == "osv" && parser.isSet("snapshot")) {
+        return CliCommands::balanceReport(parser);
+    }
+
+    const QString dbPath = parser.isSet("db")
+        ? parser.value("db")
+        : QDir::homePath() + "/ledgermini/ledgermini.db";
+    if (!Database::instance().initialize(dbPath.toStdString())) {
+        std::fprintf(stderr, "Не удалось открыть базу %s\n", dbPath.toLocal8Bit().constData());
+        return CliCommands::Failure;
+    }
+    Database::instance().ensureSchema();
+
+    if (command == "osv") return CliCommands::balanceReport(parser);
+    if (command == "card") return CliCommands::accountCard(parser);
+    if (command == "journal") return CliCommands::journal(parser);
+    if (command == "import") return CliCommands::importTransactions(parser);
+    if (command == "snapshot") return CliCommands::writeSnapshot(parser);
+    if (command == "templates") return CliCommands::runTemplates(parser);
+    if (command == "post") return CliCommands::postTemplate(parser);
+
+    std::fprintf(stderr, "Неизвестная команда: %s\n", command.toLocal8Bit().constData());
+    return CliCommands::UsageError;
+}
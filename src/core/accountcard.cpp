@@ -0,0 +1,336 @@
+#include "core/accountcard.h"
+#include "core/database.h"
+#include "core/accounttree.h"
+#include "core/reportcache.h"
+
+#include <QDebug>
+
+AccountCardQuery::AccountCardQuery(const AccountCardParams &params)
+    : params_(params)
+{
+}
+
+QString AccountCardQuery::accountCondition() const
+{
+    // Для счета с подсчетами условие раскрывается в поддерево по таблице
+    // замыкания: один набор строк на все поддерево, без цикла по подсчетам
+    return params_.includeSubaccounts
+        ? QString(" IN (%1)").arg(AccountTree::subtreeSql())
+        : QString(" = ?");
+}
+
+QString AccountCardQuery::movementsSql(const QString &extraCondition) const
+{
+    const QString account = accountCondition();
+
+    // Каждая ветка UNION ALL идет по своему составному индексу
+    // idx_transactions_debit_date / idx_transactions_credit_date.
+    // Условие OR по двум столбцам индекс не использует.
+    // extraCondition - дополнительное условие на (t.transaction_date, t.id, side),
+    // в нем %1 заменяется стороной ветки
+    return
+        "movements AS ("
+        "  SELECT t.id, t.transaction_date, 0 AS side, t.document_number, t.counterparty_id, "
+        "         t.description, t.amount, t.amount AS debit, 0 AS credit, "
+        "         t.debit_account_id AS account_id, t.credit_account_id AS opposite_id "
+        "  FROM transactions t "
+        "  WHERE t.debit_account_id" + account + " AND t.transaction_date BETWEEN ? AND ? "
+        + QString(extraCondition).replace("%1", "0") +
+        "  UNION ALL "
+        "  SELECT t.id, t.transaction_date, 1 AS side, t.document_number, t.counterparty_id, "
+        "         t.description, t.amount, 0 AS debit, t.amount AS credit, "
+        "         t.credit_account_id AS account_id, t.debit_account_id AS opposite_id "
+        "  FROM transactions t "
+        "  WHERE t.credit_account_id" + account + " AND t.transaction_date BETWEEN ? AND ? "
+        + QString(extraCondition).replace("%1", "1") +
+        ")";
+}
+
+QVariantList AccountCardQuery::movementBindings(const QVariantList &extraParams) const
+{
+    const int id = params_.accountId;
+    const QDate &from = params_.dateFrom;
+    const QDate &to = params_.dateTo;
+
+    QVariantList params;
+    params << id << from << to << extraParams;     // movements: дебет
+    params << id << from << to << extraParams;     // movements: кредит
+    return params;
+}
+
+QString AccountCardQuery::sql() const
+{
+    const QString account = accountCondition();
+
+    return
+        "WITH " + movementsSql() + ", "
+        "opening AS ("
+        "  SELECT COALESCE((SELECT SUM(amount) FROM transactions "
+        "                   WHERE debit_account_id" + account + " AND transaction_date < ?), 0) "
+        "       - COALESCE((SELECT SUM(amount) FROM transactions "
+        "                   WHERE credit_account_id" + account + " AND transaction_date < ?), 0) AS balance"
+        ") "
+        "SELECT 0 AS kind, NULL AS id, NULL AS transaction_date, NULL AS document_number, "
+        "       NULL AS counterparty, NULL AS opposite, 0 AS debit, 0 AS credit, "
+        "       NULL AS description, o.balance, NULL AS account, NULL AS side "
+        "FROM opening o "
+        "UNION ALL "
+        "SELECT 1, m.id, m.transaction_date, m.document_number, "
+        "       COALESCE(cp.name, ''), a.code || ' - ' || a.name, m.debit, m.credit, "
+        "       m.description, "
+        "       o.balance + SUM(m.debit - m.credit) OVER ("
+        "           ORDER BY m.transaction_date, m.id, m.side "
+        "           ROWS UNBOUNDED PRECEDING), "
+        "       own.code, m.side "
+        "FROM movements m "
+        "CROSS JOIN opening o "
+        "LEFT JOIN accounts a ON a.id = m.opposite_id "
+        "LEFT JOIN accounts own ON own.id = m.account_id "
+        "LEFT JOIN counterparties cp ON cp.id = m.counterparty_id "
+        "UNION ALL "
+        "SELECT 2, NULL, NULL, NULL, NULL, NULL, "
+        "       COALESCE(SUM(m.debit), 0), COALESCE(SUM(m.credit), 0), NULL, "
+        "       o.balance + COALESCE(SUM(m.debit - m.credit), 0), NULL, NULL "
+        "FROM opening o "
+        "LEFT JOIN movements m ON 1 = 1 "
+        "ORDER BY 1, 3, 2, 12";
+}
+
+QVariantList AccountCardQuery::bindings() const
+{
+    const int id = params_.accountId;
+    const QDate &from = params_.dateFrom;
+
+    QVariantList params = movementBindings();
+    params << id << from;       // opening: дебет
+    params << id << from;       // opening: кредит
+    return params;
+}
+
+QSqlQuery AccountCardQuery::execute() const
+{
+    return Database::instance().executeCursor(sql(), bindings());
+}
+
+AccountCardRow AccountCardQuery::readRow(const QSqlQuery &query)
+{
+    AccountCardRow row;
+    row.kind = static_cast<AccountCardRow::Kind>(query.value(0).toInt());
+    row.transactionId = query.value(1).toLongLong();
+    row.date = query.value(2).toDate();
+    row.documentNumber = query.value(3).toString();
+    row.counterparty = query.value(4).toString();
+    row.oppositeAccount = query.value(5).toString();
+    row.debit = query.value(6).toDouble();
+    row.credit = query.value(7).toDouble();
+    row.description = query.value(8).toString();
+    row.balance = query.value(9).toDouble();
+    row.account = query.value(10).toString();
+    return row;
+}
+
+QVariantList AccountCardQuery::cacheKey() const
+{
+    return {params_.accountId, params_.dateFrom, params_.dateTo, params_.includeSubaccounts};
+}
+
+bool AccountCardQuery::fetchSummary(AccountCardSummary *summary) const
+{
+    QByteArray cached;
+    if (ReportCache::instance().lookup(ReportCache::CardSummary, cacheKey(),
+                                       params_.dateTo, &cached)) {
+        QDataStream stream(cached);
+        stream.setVersion(QDataStream::Qt_6_0);
+        stream >> *summary;
+        if (stream.status() == QDataStream::Ok) return true;
+    }
+
+    const qint64 version = Database::instance().ledgerVersion();
+    if (!loadSummary(summary)) return false;
+
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << *summary;
+    ReportCache::instance().insert(ReportCache::CardSummary, cacheKey(), version, payload);
+    return true;
+}
+
+bool AccountCardQuery::loadSummary(AccountCardSummary *summary) const
+{
+    const QString account = accountCondition();
+    const int id = params_.accountId;
+    const QDate &from = params_.dateFrom;
+
+    // Итоги - чистые агрегаты по индексам, строки движений не выбираются
+    QSqlQuery query = Database::instance().executeQuery(
+        "WITH " + movementsSql() + " "
+        "SELECT COALESCE((SELECT SUM(amount) FROM transactions "
+        "                 WHERE debit_account_id" + account + " AND transaction_date < ?), 0) "
+        "     - COALESCE((SELECT SUM(amount) FROM transactions "
+        "                 WHERE credit_account_id" + account + " AND transaction_date < ?), 0), "
+        "       COUNT(*), COALESCE(SUM(debit), 0), COALESCE(SUM(credit), 0) "
+        "FROM movements",
+        movementBindings() << id << from << id << from);
+
+    if (query.lastError().isValid() || !query.next()) {
+        qWarning() << "Failed to load account card totals:" << query.lastError().text();
+        return false;
+    }
+
+    summary->opening = query.value(0).toDouble();
+    summary->count = query.value(1).toLongLong();
+    summary->debit = query.value(2).toDouble();
+    summary->credit = query.value(3).toDouble();
+    return true;
+}
+
+QVector<AccountCardEntry> AccountCardQuery::fetchEntries(qint64 offset, int limit,
+                                                         double opening) const
+{
+    // Дальше первого шага - по ключу: OFFSET перебирал бы все строки до offset
+    const qint64 step = offset / KeyStride;
+    if (step > 0) {
+        const QVector<AccountCardEntry> keys = fetchKeys(opening);
+        if (!keys.isEmpty()) {
+            if (step > keys.size()) return {};
+
+            const int skip = int(offset - step * KeyStride);
+            QVector<AccountCardEntry> entries = fetchEntriesAfter(keys.at(int(step - 1)), skip + limit);
+            entries.remove(0, qMin(skip, int(entries.size())));
+            return entries;
+        }
+    }
+
+    QSqlQuery query = Database::instance().executeQuery(
+        "WITH " + movementsSql() + " "
+        "SELECT id, transaction_date, side, account_id, opposite_id, counterparty_id, amount, "
+        "       ? + SUM(debit - credit) OVER (ORDER BY transaction_date, id, side "
+        "                                     ROWS UNBOUNDED PRECEDING), "
+        "       document_number, description "
+        "FROM movements "
+        "ORDER BY transaction_date, id, side "
+        "LIMIT ? OFFSET ?",
+        movementBindings() << opening << limit << offset);
+
+    return readEntries(query);
+}
+
+QVector<AccountCardEntry> AccountCardQuery::fetchKeys(double opening) const
+{
+    const QVariantList key = cacheKey() << KeyStride << opening;
+    QVector<AccountCardEntry> keys;
+    QByteArray cached;
+    if (ReportCache::instance().lookup(ReportCache::CardKeys, key, params_.dateTo, &cached)) {
+        QDataStream stream(cached);
+        stream.setVersion(QDataStream::Qt_6_0);
+        stream >> keys;
+        if (stream.status() == QDataStream::Ok) return keys;
+        keys.clear();
+    }
+
+    // Один проход по движениям карточки; наружу - каждая KeyStride-я строка
+    const qint64 version = Database::instance().ledgerVersion();
+    QSqlQuery query = Database::instance().executeQuery(
+        "WITH " + movementsSql() + " "
+        "SELECT transaction_date, id, side, balance FROM ("
+        "  SELECT transaction_date, id, side, "
+        "         ROW_NUMBER() OVER (ORDER BY transaction_date, id, side) AS n, "
+        "         ? + SUM(debit - credit) OVER (ORDER BY transaction_date, id, side "
+        "                                       ROWS UNBOUNDED PRECEDING) AS balance "
+        "  FROM movements"
+        ") WHERE n % ? = 0 "
+        "ORDER BY n",
+        movementBindings() << opening << KeyStride);
+    if (query.lastError().isValid()) {
+        qWarning() << "Failed to load account card keys:" << query.lastError().text();
+        return keys;
+    }
+
+    while (query.next()) {
+        AccountCardEntry entry;
+        entry.date = query.value(0).toDate();
+        entry.transactionId = query.value(1).toLongLong();
+        entry.side = qint8(query.value(2).toInt());
+        entry.balance = query.value(3).toDouble();
+        keys.append(entry);
+    }
+
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << keys;
+    ReportCache::instance().insert(ReportCache::CardKeys, key, version, payload);
+    return keys;
+}
+
+QVector<AccountCardEntry> AccountCardQuery::fetchEntriesAfter(const AccountCardEntry &after,
+                                                              int limit) const
+{
+    // Нижняя граница по дате держит выборку в диапазоне индекса (счет, дата)
+    const QString afterKey =
+        "AND t.transaction_date >= ? AND (t.transaction_date, t.id, %1) > (?, ?, ?) ";
+
+    QSqlQuery query = Database::instance().executeQuery(
+        "WITH " + movementsSql(afterKey) + " "
+        "SELECT id, transaction_date, side, account_id, opposite_id, counterparty_id, amount, "
+        "       ? + SUM(debit - credit) OVER (ORDER BY transaction_date, id, side "
+        "                                     ROWS UNBOUNDED PRECEDING), "
+        "       document_number, description "
+        "FROM movements "
+        "ORDER BY transaction_date, id, side "
+        "LIMIT ?",
+        movementBindings({after.date, after.date, after.transactionId, int(after.side)})
+            << after.balance << limit);
+
+    return readEntries(query);
+}
+
+QVector<AccountCardEntry> AccountCardQuery::readEntries(QSqlQuery &query) const
+{
+    QVector<AccountCardEntry> entries;
+    if (query.lastError().isValid()) {
+        qWarning() << "Failed to load account card page:" << query.lastError().text();
+        return entries;
+    }
+
+    while (query.next()) {
+        AccountCardEntry entry;
+        entry.transactionId = query.value(0).toLongLong();
+        entry.date = query.value(1).toDate();
+        entry.side = qint8(query.value(2).toInt());
+        entry.accountId = query.value(3).toInt();
+        entry.oppositeId = query.value(4).toInt();
+        entry.counterpartyId = query.value(5).toInt();
+        entry.amount = query.value(6).toDouble();
+        entry.balance = query.value(7).toDouble();
+        entry.documentNumber = query.value(8).toString();
+        entry.description = query.value(9).toString();
+        entries.append(entry);
+    }
+    return entries;
+}
+
+QDataStream &operator<<(QDataStream &stream, const AccountCardEntry &entry)
+{
+    return stream << entry.transactionId << entry.date << entry.side << entry.accountId
+                  << entry.oppositeId << entry.counterpartyId << entry.amount
+                  << entry.balance << entry.documentNumber << entry.description;
+}
+
+QDataStream &operator>>(QDataStream &stream, AccountCardEntry &entry)
+{
+    return stream >> entry.transactionId >> entry.date >> entry.side >> entry.accountId
+                  >> entry.oppositeId >> entry.counterpartyId >> entry.amount
+                  >> entry.balance >> entry.documentNumber >> entry.description;
+}
+
+QDataStream &operator<<(QDataStream &stream, const AccountCardSummary &summary)
+{
+    return stream << summary.opening << summary.count << summary.debit << summary.credit;
+}
+
+QDataStream &operator>>(QDataStream &stream, AccountCardSummary &summary)
+{
+    return stream >> summary.opening >> summary.count >> summary.debit >> summary.credit;
+}
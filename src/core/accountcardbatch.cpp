@@ -0,0 +1,172 @@
+#include "core/accountcardbatch.h"
+#include "core/accountcard.h"
+#include "core/exportmanager.h"
+#include "core/database.h"
+
+#include <QDir>
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QMetaObject>
+#include <QRegularExpression>
+#include <QStringList>
+#include <QDebug>
+#include <atomic>
+
+// Состояние, разделяемое с задачами пула. Переживает сам объект,
+// поэтому задача, закончившая работу после его удаления, ничего не доставит.
+struct AccountCardBatch::Shared {
+    std::atomic<bool> cancelled{false};
+    std::atomic<int> done{0};
+    std::atomic<int> succeeded{0};
+    int total = 0;
+    QMutex mutex;
+    QVector<Failure> failures;          // защищен mutex
+    AccountCardBatch *owner = nullptr;  // защищен mutex
+};
+
+AccountCardBatch::AccountCardBatch(QObject *parent)
+    : QObject(parent)
+{
+}
+
+AccountCardBatch::~AccountCardBatch()
+{
+    if (shared_) {
+        QMutexLocker locker(&shared_->mutex);
+        shared_->owner = nullptr;
+        shared_->cancelled = true;
+    }
+    pool_.waitForDone();
+}
+
+void AccountCardBatch::setMaxThreadCount(int count)
+{
+    pool_.setMaxThreadCount(qMax(1, count));
+}
+
+QString AccountCardBatch::fileNameFor(const QString &code, const QString &name)
+{
+    static const QRegularExpression unsafe("[^\\w.\\-]+");
+
+    QString safeName = name.left(60);
+    safeName.replace(unsafe, "_");
+    return QString("Карточка_%1_%2.csv").arg(code, safeName);
+}
+
+bool AccountCardBatch::start(const Options &options)
+{
+    if (running_) return false;
+
+    if (!QDir().mkpath(options.outputDir)) {
+        qWarning() << "Cannot create output directory" << options.outputDir;
+        return false;
+    }
+
+    // Список счетов читается заранее в потоке вызова
+    QString sql = "SELECT id, code, name FROM accounts";
+    QVariantList params;
+    if (!options.accountIds.isEmpty()) {
+        QStringList placeholders;
+        for (int id : options.accountIds) {
+            placeholders << "?";
+            params << id;
+        }
+        sql += " WHERE id IN (" + placeholders.join(",") + ")";
+    }
+    sql += " ORDER BY code";
+
+    QSqlQuery query = Database::instance().executeQuery(sql, params);
+    if (query.lastError().isValid()) {
+        qWarning() << "Failed to load accounts for batch:" << query.lastError().text();
+        return false;
+    }
+
+    struct Job {
+        int id;
+        QString code;
+        QString fileName;
+    };
+    QVector<Job> jobs;
+    QDir dir(options.outputDir);
+    while (query.next()) {
+        QString code = query.value(1).toString();
+        jobs.append({query.value(0).toInt(), code,
+                     dir.filePath(fileNameFor(code, query.value(2).toString()))});
+    }
+
+    shared_ = std::make_shared<Shared>();
+    shared_->owner = this;
+    shared_->total = jobs.size();
+    total_ = jobs.size();
+    running_ = true;
+
+    if (jobs.isEmpty()) {
+        deliverFinished();
+        return true;
+    }
+
+    emit progress(0, total_);
+
+    for (const Job &job : jobs) {
+        std::shared_ptr<Shared> shared = shared_;
+        AccountCardParams params;
+        params.accountId = job.id;
+        params.dateFrom = options.dateFrom;
+        params.dateTo = options.dateTo;
+        params.includeSubaccounts = options.includeSubaccounts;
+
+        pool_.start([shared, job, params]() {
+            // Отмененные карточки просто пропускаются: они не ошибки
+            if (!shared->cancelled.load()) {
+                QString error;
+                if (ExportManager::exportAccountCardToCsv(params, job.fileName, &error)) {
+                    ++shared->succeeded;
+                } else {
+                    QFile::remove(job.fileName);
+                    QMutexLocker locker(&shared->mutex);
+                    shared->failures.append({job.id, job.code, error});
+                }
+            }
+
+            // Счетчик растет под mutex, чтобы события хода шли по порядку
+            QMutexLocker locker(&shared->mutex);
+            int done = ++shared->done;
+            AccountCardBatch *owner = shared->owner;
+            if (!owner) return;
+
+            QMetaObject::invokeMethod(owner, [owner, shared, done]() {
+                if (owner->shared_ != shared) return;
+                owner->deliverProgress(done);
+            }, Qt::QueuedConnection);
+        });
+    }
+    return true;
+}
+
+void AccountCardBatch::cancel()
+{
+    if (shared_) {
+        shared_->cancelled = true;
+    }
+}
+
+void AccountCardBatch::deliverProgress(int done)
+{
+    emit progress(done, total_);
+    if (done == total_) {
+        deliverFinished();
+    }
+}
+
+void AccountCardBatch::deliverFinished()
+{
+    QVector<Failure> failures;
+    {
+        QMutexLocker locker(&shared_->mutex);
+        failures = shared_->failures;
+    }
+
+    running_ = false;
+    emit finished(shared_->succeeded.load(), failures, shared_->cancelled.load());
+}
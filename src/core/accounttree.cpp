@@ -0,0 +1,129 @@
+#include "core/accounttree.h"
+#include "core/database.h"
+
+#include <QDebug>
+
+namespace {
+
+bool exec(const QString &sql, const QVariantList &params, const char *what)
+{
+    QSqlQuery query = Database::instance().executeQuery(sql, params);
+    if (query.lastError().isValid()) {
+        qWarning() << "Account closure:" << what << "failed:" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+}
+
+bool AccountTree::insertAccount(int accountId, int parentId)
+{
+    if (!exec("INSERT INTO account_closure (ancestor, descendant, depth) VALUES (?, ?, 0)",
+              {accountId, accountId}, "insert self")) {
+        return false;
+    }
+
+    if (parentId <= 0) return true;
+
+    return exec("INSERT INTO account_closure (ancestor, descendant, depth) "
+                "SELECT ancestor, ?, depth + 1 FROM account_closure WHERE descendant = ?",
+                {accountId, parentId}, "insert ancestors");
+}
+
+bool AccountTree::moveAccount(int accountId, int newParentId)
+{
+    // Отрываем поддерево от старых предков: удаляем пути, которые начинаются
+    // вне поддерева и заканчиваются внутри него
+    if (!exec("DELETE FROM account_closure "
+              "WHERE descendant IN (SELECT descendant FROM account_closure WHERE ancestor = ?) "
+              "  AND ancestor NOT IN (SELECT descendant FROM account_closure WHERE ancestor = ?)",
+              {accountId, accountId}, "detach subtree")) {
+        return false;
+    }
+
+    if (newParentId <= 0) return true;
+
+    // Каждый предок нового родителя становится предком каждого узла поддерева
+    return exec("INSERT INTO account_closure (ancestor, descendant, depth) "
+                "SELECT p.ancestor, s.descendant, p.depth + s.depth + 1 "
+                "FROM account_closure p, account_closure s "
+                "WHERE p.descendant = ? AND s.ancestor = ?",
+                {newParentId, accountId}, "attach subtree");
+}
+
+bool AccountTree::removeAccount(int accountId)
+{
+    return exec("DELETE FROM account_closure "
+                "WHERE descendant IN (SELECT descendant FROM account_closure WHERE ancestor = ?)",
+                {accountId}, "remove subtree");
+}
+
+bool AccountTree::isInSubtree(int descendantId, int ancestorId)
+{
+    QSqlQuery query = Database::instance().executeQuery(
+        "SELECT 1 FROM account_closure WHERE ancestor = ? AND descendant = ?",
+        {ancestorId, descendantId});
+    return query.next();
+}
+
+bool AccountTree::rebuildIfNeeded()
+{
+    // Замыкание согласовано, если у каждого счета есть строка на себя
+    // и строка depth = 1 на его родителя, и лишних строк нет
+    QSqlQuery query = Database::instance().executeQuery(
+        "SELECT (SELECT COUNT(*) FROM accounts) "
+        "         = (SELECT COUNT(*) FROM account_closure WHERE depth = 0) "
+        "   AND (SELECT COUNT(*) FROM accounts WHERE parent_id IS NOT NULL) "
+        "         = (SELECT COUNT(*) FROM account_closure WHERE depth = 1) "
+        "   AND NOT EXISTS ("
+        "     SELECT 1 FROM accounts a "
+        "     WHERE NOT EXISTS (SELECT 1 FROM account_closure c "
+        "                       WHERE c.ancestor = a.id AND c.descendant = a.id) "
+        "        OR (a.parent_id IS NOT NULL AND NOT EXISTS ("
+        "              SELECT 1 FROM account_closure c "
+        "              WHERE c.ancestor = a.parent_id AND c.descendant = a.id AND c.depth = 1)))");
+
+    if (query.lastError().isValid()) {
+        qWarning() << "Account closure: consistency check failed:" << query.lastError().text();
+        return false;
+    }
+
+    if (query.next() && query.value(0).toBool()) {
+        return true;
+    }
+
+    qInfo() << "Account closure is out of date, rebuilding";
+    return rebuild();
+}
+
+bool AccountTree::rebuild()
+{
+    Database &db = Database::instance();
+    if (!db.beginTransaction()) {
+        qWarning() << "Account closure: failed to start transaction";
+        return false;
+    }
+
+    bool ok = exec("DELETE FROM account_closure", {}, "clear")
+        && exec("WITH RECURSIVE paths(ancestor, descendant, depth) AS ("
+                "  SELECT id, id, 0 FROM accounts "
+                "  UNION ALL "
+                "  SELECT p.ancestor, a.id, p.depth + 1 "
+                "  FROM paths p JOIN accounts a ON a.parent_id = p.descendant"
+                ") "
+                "INSERT INTO account_closure (ancestor, descendant, depth) "
+                "SELECT ancestor, descendant, depth FROM paths",
+                {}, "rebuild");
+
+    if (!ok) {
+        db.rollbackTransaction();
+        return false;
+    }
+    return db.commitTransaction();
+}
+
+QString AccountTree::subtreeSql()
+{
+    return "SELECT descendant FROM account_closure WHERE ancestor = ?";
+}
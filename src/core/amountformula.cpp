@@ -0,0 +1,490 @@
+#include "core/amountformula.h"
+#include "core/database.h"
+
+#include <QSet>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QVarLengthArray>
+#include <QDebug>
+#include <cmath>
+#include <functional>
+
+bool FormulaBalances::prefetch(const QStringList &accountCodes, const QDate &periodStart,
+                               const QDate &date, QString *error)
+{
+    index_.clear();
+    balances_.clear();
+    debits_.clear();
+    credits_.clear();
+    if (accountCodes.isEmpty()) return true;
+
+    // Счета формул и все их подсчета
+    QStringList placeholders;
+    QVariantList codes;
+    for (const QString &code : accountCodes) {
+        placeholders << "?";
+        codes << code;
+    }
+    QSqlQuery accounts = Database::instance().executeQuery(
+        "SELECT a.code, a.type, cl.descendant FROM accounts a "
+        "JOIN account_closure cl ON cl.ancestor = a.id "
+        "WHERE a.code IN (" + placeholders.join(", ") + ")", codes);
+    if (accounts.lastError().isValid()) {
+        if (error) *error = "Ошибка запроса: " + accounts.lastError().text();
+        return false;
+    }
+
+    QHash<int, QVector<int>> owners;       // подсчет -> счета формул
+    QVector<int> types;
+    QStringList ids;
+    while (accounts.next()) {
+        const QString code = accounts.value(0).toString();
+        int index = index_.value(code, -1);
+        if (index < 0) {
+            index = types.size();
+            index_.insert(code, index);
+            types.append(accounts.value(1).toInt());
+        }
+        const int descendant = accounts.value(2).toInt();
+        if (!owners.contains(descendant)) ids << QString::number(descendant);
+        owners[descendant].append(index);
+    }
+
+    balances_.fill(0.0, types.size());
+    debits_.fill(0.0, types.size());
+    credits_.fill(0.0, types.size());
+    if (ids.isEmpty()) return true;
+
+    // Один проход по проводкам до даты: сальдо по всем, обороты - с начала периода
+    const QString idList = ids.join(", ");
+    QSqlQuery sums = Database::instance().executeCursor(
+        "SELECT account_id, SUM(balance), SUM(debit), SUM(credit) FROM ("
+        "  SELECT debit_account_id AS account_id, amount AS balance, "
+        "         CASE WHEN transaction_date >= ? THEN amount ELSE 0 END AS debit, 0 AS credit "
+        "  FROM transactions WHERE transaction_date <= ? AND debit_account_id IN (" + idList + ") "
+        "  UNION ALL "
+        "  SELECT credit_account_id, -amount, 0, "
+        "         CASE WHEN transaction_date >= ? THEN amount ELSE 0 END "
+        "  FROM transactions WHERE transaction_date <= ? AND credit_account_id IN (" + idList + ")"
+        ") GROUP BY account_id",
+        {periodStart, date, periodStart, date});
+    if (sums.lastError().isValid()) {
+        if (error) *error = "Ошибка запроса: " + sums.lastError().text();
+        return false;
+    }
+
+    while (sums.next()) {
+        const double balance = sums.value(1).toDouble();
+        const double debit = sums.value(2).toDouble();
+        const double credit = sums.value(3).toDouble();
+        for (int index : owners.value(sums.value(0).toInt())) {
+            balances_[index] += balance;
+            debits_[index] += debit;
+            credits_[index] += credit;
+        }
+    }
+
+    // Пассивные счета - сальдо по кредиту
+    for (int i = 0; i < types.size(); ++i) {
+        if (types.at(i) == 1) balances_[i] = -balances_.at(i);
+    }
+    return true;
+}
+
+// Рекурсивный спуск по грамматике
+//   expression := term (('+' | '-') term)*
+//   term       := unary (('*' | '/') unary)*
+//   unary      := '-' unary | primary
+//   primary    := число | '(' expression ')' | функция '(' аргументы ')'
+// Команды пишутся сразу в обратной польской записи. Вложенность скобок,
+// аргументов и унарных минусов ограничена: формула из настроек шаблона
+// не должна переполнять стек разбора.
+class AmountFormula::Parser
+{
+public:
+    Parser(const QString &text, AmountFormula *formula)
+        : text_(text), formula_(formula) {}
+
+    bool parse(QString *error)
+    {
+        if (!expression()) {
+            if (error) *error = error_;
+            return false;
+        }
+        skipSpaces();
+        if (pos_ < text_.size()) {
+            if (error) *error = QString("Лишний символ \"%1\" в позиции %2").arg(text_.at(pos_)).arg(pos_ + 1);
+            return false;
+        }
+        formula_->stackSize_ = maxDepth_;
+        return true;
+    }
+
+private:
+    bool fail(const QString &message)
+    {
+        if (error_.isEmpty()) error_ = QString("%1 (позиция %2)").arg(message).arg(pos_ + 1);
+        return false;
+    }
+
+    void skipSpaces()
+    {
+        while (pos_ < text_.size() && text_.at(pos_).isSpace()) ++pos_;
+    }
+
+    bool accept(QChar c)
+    {
+        skipSpaces();
+        if (pos_ < text_.size() && text_.at(pos_) == c) {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+
+    bool expect(QChar c)
+    {
+        return accept(c) || fail(QString("Ожидается \"%1\"").arg(c));
+    }
+
+    // depth - изменение глубины стека после команды
+    void push(Op op, int arg, int depth)
+    {
+        formula_->code_.append({op, quint16(arg)});
+        depth_ += depth;
+        maxDepth_ = qMax(maxDepth_, depth_);
+    }
+
+    bool pushIndexed(Op op, QStringList &names, const QString &name)
+    {
+        int index = names.indexOf(name);
+        if (index < 0) {
+            index = names.size();
+            names << name;
+        }
+        if (index > 0xFFFF) return fail("Слишком длинная формула");
+        push(op, index, 1);
+        return true;
+    }
+
+    static const int MaxNesting = 64;
+
+    // Вход во вложенное правило; false - вложенность больше MaxNesting
+    bool enter()
+    {
+        if (nesting_ >= MaxNesting) return fail("Слишком глубокая вложенность");
+        ++nesting_;
+        return true;
+    }
+
+    bool expression()
+    {
+        if (!enter()) return false;
+        const bool ok = sum();
+        --nesting_;
+        return ok;
+    }
+
+    bool sum()
+    {
+        if (!term()) return false;
+        for (;;) {
+            if (accept('+')) {
+                if (!term()) return false;
+                push(Add, 0, -1);
+            } else if (accept('-')) {
+                if (!term()) return false;
+                push(Subtract, 0, -1);
+            } else {
+                return true;
+            }
+        }
+    }
+
+    bool term()
+    {
+        if (!unary()) return false;
+        for (;;) {
+            if (accept('*')) {
+                if (!unary()) return false;
+                push(Multiply, 0, -1);
+            } else if (accept('/')) {
+                if (!unary()) return false;
+                push(Divide, 0, -1);
+            } else {
+                return true;
+            }
+        }
+    }
+
+    bool unary()
+    {
+        if (accept('-')) {
+            if (!enter()) return false;
+            const bool ok = unary();
+            --nesting_;
+            if (!ok) return false;
+            push(Negate, 0, 0);
+            return true;
+        }
+        accept('+');
+        return primary();
+    }
+
+    bool primary()
+    {
+        skipSpaces();
+        if (pos_ >= text_.size()) return fail("Формула оборвана");
+
+        const QChar c = text_.at(pos_);
+        if (c.isDigit() || c == '.') return number();
+        if (accept('(')) {
+            return expression() && expect(')');
+        }
+        if (c.isLetter()) return function();
+        return fail(QString("Неожиданный символ \"%1\"").arg(c));
+    }
+
+    bool number()
+    {
+        const int start = pos_;
+        while (pos_ < text_.size() && (text_.at(pos_).isDigit() || text_.at(pos_) == '.')) ++pos_;
+
+        bool ok = false;
+        const double value = text_.mid(start, pos_ - start).toDouble(&ok);
+        if (!ok) return fail("Неверное число");
+        if (formula_->constants_.size() > 0xFFFF) return fail("Слишком длинная формула");
+
+        push(PushConstant, formula_->constants_.size(), 1);
+        formula_->constants_.append(value);
+        return true;
+    }
+
+    // Код счета: 70, 70.01 или в кавычках
+    bool accountArgument(QString *code)
+    {
+        skipSpaces();
+        if (pos_ < text_.size() && text_.at(pos_) == '"') return stringArgument(code);
+
+        const int start = pos_;
+        while (pos_ < text_.size() && text_.at(pos_) != ')' && text_.at(pos_) != ','
+               && !text_.at(pos_).isSpace()) {
+            ++pos_;
+        }
+        *code = text_.mid(start, pos_ - start);
+        return !code->isEmpty() || fail("Не указан счет");
+    }
+
+    bool stringArgument(QString *value)
+    {
+        if (!expect('"')) return false;
+        const int end = text_.indexOf('"', pos_);
+        if (end < 0) return fail("Не закрыта кавычка");
+        *value = text_.mid(pos_, end - pos_);
+        pos_ = end + 1;
+        return !value->isEmpty() || fail("Пустое название");
+    }
+
+    bool function()
+    {
+        const int start = pos_;
+        while (pos_ < text_.size() && (text_.at(pos_).isLetterOrNumber() || text_.at(pos_) == '_')) ++pos_;
+        const QString name = text_.mid(start, pos_ - start).toLower();
+        if (!expect('(')) return false;
+
+        if (name == "balance" || name == "debit" || name == "credit") {
+            QString code;
+            if (!accountArgument(&code)) return false;
+            const Op op = name == "balance" ? PushBalance : name == "debit" ? PushDebit : PushCredit;
+            return pushIndexed(op, formula_->accounts_, code) && expect(')');
+        }
+        if (name == "template") {
+            QString title;
+            if (!stringArgument(&title)) return false;
+            return pushIndexed(PushTemplate, formula_->templates_, title) && expect(')');
+        }
+        if (name == "abs") {
+            if (!expression() || !expect(')')) return false;
+            push(Abs, 0, 0);
+            return true;
+        }
+        if (name == "min" || name == "max" || name == "round") {
+            if (!expression() || !expect(',') || !expression() || !expect(')')) return false;
+            push(name == "min" ? Min : name == "max" ? Max : Round, 0, -1);
+            return true;
+        }
+
+        pos_ = start;
+        return fail("Неизвестная функция " + name);
+    }
+
+    const QString &text_;
+    AmountFormula *formula_;
+    int pos_ = 0;
+    int nesting_ = 0;
+    int depth_ = 0;
+    int maxDepth_ = 0;
+    QString error_;
+};
+
+bool AmountFormula::compile(const QString &text, QString *error)
+{
+    text_ = text.trimmed();
+    code_.clear();
+    constants_.clear();
+    accounts_.clear();
+    templates_.clear();
+    stackSize_ = 0;
+
+    if (text_.isEmpty()) {
+        if (error) *error = "Пустая формула";
+        return false;
+    }
+
+    Parser parser(text_, this);
+    if (!parser.parse(error)) {
+        code_.clear();
+        return false;
+    }
+    return true;
+}
+
+bool AmountFormula::evaluate(const FormulaBalances &balances,
+                             const QHash<QString, double> &templateValues,
+                             double *value, QString *error) const
+{
+    if (code_.isEmpty()) {
+        if (error) *error = "Формула не разобрана";
+        return false;
+    }
+
+    auto fail = [error](const QString &message) {
+        if (error) *error = message;
+        return false;
+    };
+
+    QVarLengthArray<double, 16> stack(stackSize_);
+    int top = 0;
+    for (const Instruction &instruction : code_) {
+        switch (instruction.op) {
+        case PushConstant:
+            stack[top++] = constants_.at(instruction.arg);
+            break;
+        case PushBalance:
+        case PushDebit:
+        case PushCredit: {
+            const QString &code = accounts_.at(instruction.arg);
+            const int index = balances.indexOf(code);
+            if (index < 0) return fail("Нет счета " + code);
+            stack[top++] = instruction.op == PushBalance ? balances.balance(index)
+                         : instruction.op == PushDebit ? balances.debit(index)
+                         : balances.credit(index);
+            break;
+        }
+        case PushTemplate: {
+            const QString &name = templates_.at(instruction.arg);
+            auto it = templateValues.constFind(name);
+            if (it == templateValues.constEnd()) return fail("Нет шаблона \"" + name + "\"");
+            stack[top++] = it.value();
+            break;
+        }
+        case Add:
+            --top;
+            stack[top - 1] += stack[top];
+            break;
+        case Subtract:
+            --top;
+            stack[top - 1] -= stack[top];
+            break;
+        case Multiply:
+            --top;
+            stack[top - 1] *= stack[top];
+            break;
+        case Divide:
+            --top;
+            if (stack[top] == 0.0) return fail("Деление на ноль");
+            stack[top - 1] /= stack[top];
+            break;
+        case Negate:
+            stack[top - 1] = -stack[top - 1];
+            break;
+        case Min:
+            --top;
+            stack[top - 1] = qMin(stack[top - 1], stack[top]);
+            break;
+        case Max:
+            --top;
+            stack[top - 1] = qMax(stack[top - 1], stack[top]);
+            break;
+        case Abs:
+            stack[top - 1] = std::fabs(stack[top - 1]);
+            break;
+        case Round: {
+            --top;
+            const double scale = std::pow(10.0, qBound(0, int(stack[top]), 6));
+            stack[top - 1] = std::round(stack[top - 1] * scale) / scale;
+            break;
+        }
+        }
+    }
+
+    *value = stack[0];
+    return true;
+}
+
+bool AmountFormula::evaluateAll(const QHash<QString, AmountFormula> &formulas,
+                                const QHash<QString, double> &fixedAmounts,
+                                const FormulaBalances &balances,
+                                QHash<QString, double> *values, QStringList *errors)
+{
+    *values = fixedAmounts;
+
+    // Обход в глубину по ссылкам template(): сначала то, от чего зависит формула
+    QSet<QString> done;
+    QSet<QString> visiting;
+    QSet<QString> failed;
+    std::function<bool(const QString &)> visit = [&](const QString &name) -> bool {
+        if (done.contains(name)) return true;
+        if (failed.contains(name)) return false;
+
+        auto it = formulas.constFind(name);
+        if (it == formulas.constEnd()) {
+            if (fixedAmounts.contains(name)) return true;
+            *errors << QString("Нет шаблона \"%1\"").arg(name);
+            failed.insert(name);
+            return false;
+        }
+        if (visiting.contains(name)) {
+            *errors << QString("Шаблон \"%1\": формулы ссылаются друг на друга").arg(name);
+            failed.insert(name);
+            return false;
+        }
+
+        visiting.insert(name);
+        bool ok = true;
+        for (const QString &dependency : it->templates()) {
+            ok = visit(dependency) && ok;
+        }
+        visiting.remove(name);
+
+        double value = 0.0;
+        QString error;
+        if (ok && !it->evaluate(balances, *values, &value, &error)) {
+            *errors << QString("Шаблон \"%1\": %2").arg(name, error);
+            ok = false;
+        }
+        if (!ok) {
+            failed.insert(name);
+            return false;
+        }
+        values->insert(name, value);
+        done.insert(name);
+        return true;
+    };
+
+    bool ok = true;
+    for (auto it = formulas.constBegin(); it != formulas.constEnd(); ++it) {
+        ok = visit(it.key()) && ok;
+    }
+    return ok;
+}
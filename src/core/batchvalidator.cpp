@@ -0,0 +1,190 @@
+#include "core/batchvalidator.h"
+#include "core/database.h"
+#include "core/validationrules.h"
+
+#include <QSqlQuery>
+#include <QSqlError>
+#include <algorithm>
+
+void BatchValidator::Postings::reserve(int rows)
+{
+    dates.reserve(rows);
+    debitIds.reserve(rows);
+    creditIds.reserve(rows);
+    amounts.reserve(rows);
+    counterpartyIds.reserve(rows);
+}
+
+void BatchValidator::Postings::clear()
+{
+    // Память остается за пачкой: следующая пачка того же размера без выделений
+    dates.resize(0);
+    debitIds.resize(0);
+    creditIds.resize(0);
+    amounts.resize(0);
+    counterpartyIds.resize(0);
+}
+
+void BatchValidator::Postings::append(const QDate &date, int debitId, int creditId,
+                                      double amount, int counterpartyId)
+{
+    dates.append(date);
+    debitIds.append(debitId);
+    creditIds.append(creditId);
+    amounts.append(amount);
+    counterpartyIds.append(counterpartyId);
+}
+
+bool BatchValidator::load(QString *error)
+{
+    Database &db = Database::instance();
+
+    QVector<int> ids;
+    QSqlQuery accounts = db.executeCursor("SELECT id FROM accounts");
+    while (accounts.next()) {
+        ids.append(accounts.value(0).toInt());
+    }
+    if (accounts.lastError().isValid()) {
+        if (error) *error = "Ошибка запроса: " + accounts.lastError().text();
+        return false;
+    }
+    setAccounts(ids);
+
+    ids.clear();
+    inns_.clear();
+    QSqlQuery counterparties = db.executeCursor("SELECT id, inn FROM counterparties");
+    while (counterparties.next()) {
+        ids.append(counterparties.value(0).toInt());
+        const QString inn = counterparties.value(1).toString().trimmed();
+        if (!inn.isEmpty()) inns_.insert(inn);
+    }
+    if (counterparties.lastError().isValid()) {
+        if (error) *error = "Ошибка запроса: " + counterparties.lastError().text();
+        return false;
+    }
+    setCounterparties(ids);
+
+    today_ = QDate::currentDate().toJulianDay();
+    return true;
+}
+
+void BatchValidator::setAccounts(const QVector<int> &ids)
+{
+    accounts_ = bitmap(ids);
+}
+
+void BatchValidator::setCounterparties(const QVector<int> &ids)
+{
+    counterparties_ = bitmap(ids);
+}
+
+void BatchValidator::setInns(const QStringList &inns)
+{
+    inns_.clear();
+    for (const QString &inn : inns) {
+        if (!inn.trimmed().isEmpty()) inns_.insert(inn.trimmed());
+    }
+}
+
+QBitArray BatchValidator::bitmap(const QVector<int> &ids)
+{
+    int size = 0;
+    for (int id : ids) size = std::max(size, id + 1);
+
+    QBitArray bits(size);
+    for (int id : ids) {
+        if (id > 0) bits.setBit(id);
+    }
+    return bits;
+}
+
+QVector<BatchValidator::Errors> BatchValidator::validatePostings(const Postings &postings) const
+{
+    const int rows = postings.size();
+    QVector<Errors> result(rows, NoError);
+
+    // Столбец за столбцом: в каждом цикле одна проверка по непрерывному массиву
+    const QDate *dates = postings.dates.constData();
+    for (int i = 0; i < rows; ++i) {
+        if (!dates[i].isValid()) result[i] |= InvalidDate;
+        else if (dates[i].toJulianDay() > today_) result[i] |= FutureDate;
+    }
+
+    const int *debits = postings.debitIds.constData();
+    const int *credits = postings.creditIds.constData();
+    for (int i = 0; i < rows; ++i) {
+        if (debits[i] == 0) result[i] |= MissingDebit;
+        else if (!contains(accounts_, debits[i])) result[i] |= UnknownDebit;
+
+        if (credits[i] == 0) result[i] |= MissingCredit;
+        else if (!contains(accounts_, credits[i])) result[i] |= UnknownCredit;
+
+        if (debits[i] > 0 && debits[i] == credits[i]) result[i] |= SameAccounts;
+    }
+
+    const double *amounts = postings.amounts.constData();
+    for (int i = 0; i < rows; ++i) {
+        if (!ValidationRules::validateAmount(amounts[i])) result[i] |= InvalidAmount;
+    }
+
+    const int *counterparties = postings.counterpartyIds.constData();
+    for (int i = 0; i < rows; ++i) {
+        if (counterparties[i] != 0 && !contains(counterparties_, counterparties[i])) {
+            result[i] |= UnknownCounterparty;
+        }
+    }
+
+    return result;
+}
+
+QVector<BatchValidator::Errors> BatchValidator::validateCounterparties(
+    const Counterparties &counterparties) const
+{
+    const int rows = counterparties.size();
+    QVector<Errors> result(rows, NoError);
+
+    // ИНН уникален и среди уже записанных, и внутри пачки
+    QSet<QString> seen;
+    seen.reserve(rows);
+    for (int i = 0; i < rows; ++i) {
+        if (counterparties.names.at(i).trimmed().isEmpty()) result[i] |= EmptyName;
+
+        const QString inn = counterparties.inns.value(i).trimmed();
+        if (inn.isEmpty()) continue;
+        if (!ValidationRules::isValidINN(inn)) {
+            result[i] |= InvalidInn;
+        } else if (inns_.contains(inn) || seen.contains(inn)) {
+            result[i] |= DuplicateInn;
+        }
+        seen.insert(inn);
+    }
+
+    return result;
+}
+
+QString BatchValidator::describe(Errors errors)
+{
+    static const struct {
+        Error error;
+        const char *message;
+    } messages[] = {
+        {InvalidDate, "неверная дата"},
+        {FutureDate, "дата в будущем"},
+        {MissingDebit, "не указан счет дебета"},
+        {MissingCredit, "не указан счет кредита"},
+        {UnknownDebit, "нет счета дебета"},
+        {UnknownCredit, "нет счета кредита"},
+        {SameAccounts, "счета дебета и кредита совпадают"},
+        {InvalidAmount, "неверная сумма"},
+        {UnknownCounterparty, "нет контрагента"},
+        {EmptyName, "не указано наименование"},
+        {InvalidInn, "неверный ИНН"},
+        {DuplicateInn, "ИНН уже есть"}
+    };
+
+    QStringList result;
+    for (const auto &entry : messages) {
+        if (errors & entry.error) result << QString::fromUtf8(entry.message);
+    }
+    return result.join("; ");
+}
@@ -0,0 +1,223 @@
+#include "core/csvreader.h"
+#include "core/csvwriter.h"
+
+#include <QDebug>
+#include <zlib.h>
+
+namespace {
+
+const int InflateChunk = 256 * 1024;
+
+}
+
+struct CsvReader::Inflate {
+    z_stream stream;
+    QByteArray in;
+    bool finished = false;
+};
+
+CsvReader::CsvReader() = default;
+
+CsvReader::~CsvReader()
+{
+    close();
+}
+
+bool CsvReader::open(const QString &fileName, const Options &options)
+{
+    close();
+    options_ = options;
+    buffer_.resize(0);
+    pos_ = 0;
+    eof_ = false;
+    line_ = 1;
+    rowLine_ = 0;
+    failed_ = false;
+    error_.clear();
+
+    file_.setFileName(fileName);
+    if (!file_.open(QIODevice::ReadOnly)) {
+        failed_ = true;
+        error_ = file_.errorString();
+        return false;
+    }
+
+    if (CsvWriter::isGzipFileName(fileName)) {
+        inflate_ = std::make_unique<Inflate>();
+        inflate_->stream = z_stream();
+        inflate_->in.resize(InflateChunk);
+
+        // 15 + 16 - поток gzip, как его пишет CsvWriter
+        if (inflateInit2(&inflate_->stream, 15 + 16) != Z_OK) {
+            failed_ = true;
+            error_ = "Не удалось инициализировать распаковку gzip";
+            inflate_.reset();
+            file_.close();
+            return false;
+        }
+    }
+
+    // Метка порядка байтов UTF-8, если файл сохранен в Excel
+    if (fill() && buffer_.startsWith("\xEF\xBB\xBF")) {
+        pos_ = 3;
+    }
+    return !failed_;
+}
+
+void CsvReader::close()
+{
+    if (inflate_) {
+        inflateEnd(&inflate_->stream);
+        inflate_.reset();
+    }
+    if (file_.isOpen()) {
+        file_.close();
+    }
+}
+
+bool CsvReader::readRaw(char *data, qint64 size, qint64 *read)
+{
+    if (!inflate_) {
+        *read = file_.read(data, size);
+        if (*read < 0) {
+            failed_ = true;
+            error_ = file_.errorString();
+            return false;
+        }
+        return true;
+    }
+
+    z_stream &stream = inflate_->stream;
+    stream.next_out = reinterpret_cast<Bytef *>(data);
+    stream.avail_out = uInt(size);
+
+    while (stream.avail_out > 0 && !inflate_->finished) {
+        if (stream.avail_in == 0) {
+            qint64 got = file_.read(inflate_->in.data(), inflate_->in.size());
+            if (got < 0) {
+                failed_ = true;
+                error_ = file_.errorString();
+                return false;
+            }
+            if (got == 0) {
+                failed_ = true;
+                error_ = "Архив gzip поврежден или обрезан";
+                return false;
+            }
+            stream.next_in = reinterpret_cast<Bytef *>(inflate_->in.data());
+            stream.avail_in = uInt(got);
+        }
+
+        int ret = inflate(&stream, Z_NO_FLUSH);
+        if (ret == Z_STREAM_END) {
+            inflate_->finished = true;
+        } else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+            failed_ = true;
+            error_ = "Ошибка распаковки gzip";
+            return false;
+        }
+    }
+
+    *read = size - stream.avail_out;
+    return true;
+}
+
+bool CsvReader::fill()
+{
+    if (eof_ || failed_) return false;
+
+    // Непрочитанный хвост - в начало буфера, за ним следующий блок
+    buffer_.remove(0, pos_);
+    pos_ = 0;
+
+    const int tail = buffer_.size();
+    buffer_.resize(tail + options_.bufferSize);
+
+    qint64 read = 0;
+    if (!readRaw(buffer_.data() + tail, options_.bufferSize, &read)) {
+        buffer_.resize(tail);
+        return false;
+    }
+
+    buffer_.resize(tail + int(read));
+    if (read == 0) {
+        eof_ = true;
+        return false;
+    }
+    return true;
+}
+
+bool CsvReader::readRow(QStringList *fields)
+{
+    fields->clear();
+    if (pos_ >= buffer_.size() && !fill()) return false;
+
+    rowLine_ = line_;
+    QByteArray field;
+    bool inQuotes = false;
+    const char delimiter = options_.delimiter;
+
+    while (true) {
+        if (pos_ >= buffer_.size() && !fill()) {
+            if (failed_) return false;
+            if (inQuotes) {
+                failed_ = true;
+                error_ = QString("Строка %1: не закрыта кавычка").arg(rowLine_);
+                return false;
+            }
+            // Последняя строка без перевода строки
+            fields->append(QString::fromUtf8(field));
+            return true;
+        }
+
+        const char *data = buffer_.constData();
+        const int size = buffer_.size();
+
+        if (inQuotes) {
+            char c = data[pos_++];
+            if (c != '"') {
+                if (c == '\n') ++line_;
+                field += c;
+                continue;
+            }
+            // "" внутри кавычек - сама кавычка
+            if (pos_ >= buffer_.size() && !fill()) {
+                inQuotes = false;
+                continue;
+            }
+            if (buffer_.at(pos_) == '"') {
+                field += '"';
+                ++pos_;
+            } else {
+                inQuotes = false;
+            }
+            continue;
+        }
+
+        // Обычные символы добавляются к полю одним куском
+        int end = pos_;
+        while (end < size) {
+            char c = data[end];
+            if (c == delimiter || c == '\n' || c == '\r' || c == '"') break;
+            ++end;
+        }
+        if (end > pos_) {
+            field.append(data + pos_, end - pos_);
+            pos_ = end;
+            continue;
+        }
+
+        char c = data[pos_++];
+        if (c == '"') {
+            inQuotes = true;
+        } else if (c == delimiter) {
+            fields->append(QString::fromUtf8(field));
+            field.clear();
+        } else if (c == '\n') {
+            ++line_;
+            fields->append(QString::fromUtf8(field));
+            return true;
+        }
+        // '\r' перед '\n' пропускается
+    }
+}
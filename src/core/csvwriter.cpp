@@ -0,0 +1,177 @@
+#include "core/csvwriter.h"
+
+#include <QDebug>
+#include <zlib.h>
+
+namespace {
+
+const int DeflateChunk = 256 * 1024;
+
+}
+
+struct CsvWriter::Deflate {
+    z_stream stream;
+    QByteArray out;
+};
+
+CsvWriter::CsvWriter() = default;
+
+CsvWriter::~CsvWriter()
+{
+    if (file_.isOpen()) {
+        close();
+    }
+}
+
+bool CsvWriter::isGzipFileName(const QString &fileName)
+{
+    return fileName.endsWith(".gz", Qt::CaseInsensitive);
+}
+
+bool CsvWriter::open(const QString &fileName, const Options &options)
+{
+    options_ = options;
+    rows_ = 0;
+    rowStarted_ = false;
+    failed_ = false;
+    error_.clear();
+
+    // Переводы строк пишутся сами (CRLF), поэтому без QIODevice::Text
+    file_.setFileName(fileName);
+    if (!file_.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        error_ = file_.errorString();
+        return false;
+    }
+
+    buffer_.resize(0);
+    buffer_.reserve(options_.bufferSize + 4096);
+
+    if (options_.gzip) {
+        deflate_ = std::make_unique<Deflate>();
+        deflate_->stream = z_stream();
+        deflate_->out.resize(DeflateChunk);
+
+        // 15 + 16 - заголовок gzip вместо zlib. Самое быстрое сжатие:
+        // выгрузка должна упираться в диск, а не в процессор
+        if (deflateInit2(&deflate_->stream, Z_BEST_SPEED, Z_DEFLATED, 15 + 16, 8,
+                         Z_DEFAULT_STRATEGY) != Z_OK) {
+            error_ = "Не удалось инициализировать сжатие gzip";
+            deflate_.reset();
+            file_.close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void CsvWriter::addField(const QString &value)
+{
+    addField(value.toUtf8());
+}
+
+void CsvWriter::addField(const QByteArray &utf8)
+{
+    if (rowStarted_) {
+        buffer_.append(options_.delimiter);
+    }
+    rowStarted_ = true;
+
+    bool needsQuotes = false;
+    for (char ch : utf8) {
+        if (ch == options_.delimiter || ch == '"' || ch == '\n' || ch == '\r') {
+            needsQuotes = true;
+            break;
+        }
+    }
+
+    if (!needsQuotes) {
+        buffer_.append(utf8);
+        return;
+    }
+
+    buffer_.append('"');
+    for (char ch : utf8) {
+        if (ch == '"') buffer_.append('"');
+        buffer_.append(ch);
+    }
+    buffer_.append('"');
+}
+
+void CsvWriter::endRow()
+{
+    buffer_.append("\r\n", 2);
+    rowStarted_ = false;
+    ++rows_;
+
+    if (buffer_.size() >= options_.bufferSize) {
+        flush(false);
+    }
+}
+
+void CsvWriter::writeRow(const QStringList &fields)
+{
+    for (const QString &field : fields) {
+        addField(field);
+    }
+    endRow();
+}
+
+bool CsvWriter::writeOut(const char *data, qint64 size)
+{
+    if (failed_) return false;
+
+    if (file_.write(data, size) != size) {
+        failed_ = true;
+        error_ = file_.errorString();
+        qWarning() << "CSV write failed:" << error_;
+        return false;
+    }
+    return true;
+}
+
+bool CsvWriter::flush(bool finish)
+{
+    if (!deflate_) {
+        bool ok = buffer_.isEmpty() || writeOut(buffer_.constData(), buffer_.size());
+        buffer_.resize(0);
+        return ok;
+    }
+
+    z_stream &stream = deflate_->stream;
+    stream.next_in = reinterpret_cast<Bytef *>(buffer_.data());
+    stream.avail_in = uInt(buffer_.size());
+
+    // Стандартный цикл zlib: пока deflate заполняет выходной блок целиком,
+    // у него есть еще данные
+    do {
+        stream.next_out = reinterpret_cast<Bytef *>(deflate_->out.data());
+        stream.avail_out = uInt(deflate_->out.size());
+        deflate(&stream, finish ? Z_FINISH : Z_NO_FLUSH);
+
+        qint64 produced = deflate_->out.size() - stream.avail_out;
+        if (produced > 0 && !writeOut(deflate_->out.constData(), produced)) {
+            break;
+        }
+    } while (stream.avail_out == 0);
+
+    buffer_.resize(0);
+    return !failed_;
+}
+
+bool CsvWriter::close()
+{
+    if (!file_.isOpen()) return !failed_;
+
+    flush(true);
+    if (deflate_) {
+        deflateEnd(&deflate_->stream);
+        deflate_.reset();
+    }
+
+    file_.close();
+    if (!failed_ && file_.error() != QFileDevice::NoError) {
+        failed_ = true;
+        error_ = file_.errorString();
+    }
+    return !failed_;
+}
@@ -1,7 +1,32 @@
 #include "core/database.h"
+#include "core/accounttree.h"
 #include <QFile>
 #include <QTextStream>
 #include <QDebug>
+#include <QThread>
+#include <QThreadStorage>
+#include <QAtomicInt>
+
+namespace {
+
+// Соединение рабочего потока; удаляется QThreadStorage при завершении потока
+struct ThreadConnection {
+    QString name;
+    
+    ~ThreadConnection()
+    {
+        {
+            QSqlDatabase db = QSqlDatabase::database(name, false);
+            if (db.isOpen()) db.close();
+        }
+        QSqlDatabase::removeDatabase(name);
+    }
+};
+
+QThreadStorage<ThreadConnection *> threadConnections;
+QAtomicInt threadConnectionCounter;
+
+}
 
 Database& Database::instance()
 {
@@ -29,6 +54,12 @@ bool Database::initialize(const std::string& dbPath)
         qWarning() << "Failed to enable foreign keys:" << query.lastError().text();
     }
     
+    // WAL позволяет фоновым потокам читать, пока главный поток пишет
+    if (!query.exec("PRAGMA journal_mode = WAL;")) {
+        qWarning() << "Failed to enable WAL journal:" << query.lastError().text();
+    }
+    
+    ownerThread_ = QThread::currentThread();
     initialized_ = true;
     qInfo() << "Database initialized successfully:" << QString::fromStdString(dbPath);
     return true;
@@ -73,9 +104,346 @@ bool Database::executeScript(const std::string& scriptPath)
     return true;
 }
 
+void Database::ensureSchema()
+{
+    qDebug() << "=== Создание таблиц ===";
+    
+    // Создаем таблицу контрагентов
+    QString createCounterparties = 
+        "CREATE TABLE IF NOT EXISTS counterparties ("
+        "    id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "    name TEXT NOT NULL,"
+        "    inn TEXT UNIQUE,"
+        "    kpp TEXT DEFAULT '',"
+        "    address TEXT DEFAULT '',"
+        "    phone TEXT DEFAULT '',"
+        "    email TEXT DEFAULT '',"
+        "    created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP"
+        ")";
+    
+    QSqlQuery query1 = executeQuery(createCounterparties);
+    if (query1.lastError().isValid()) {
+        qCritical() << "Ошибка создания таблицы counterparties:" << query1.lastError().text();
+    } else {
+        qDebug() << "✓ Таблица counterparties проверена/создана";
+    }
+    
+    // Создаем таблицу счетов
+    QString createAccounts = 
+        "CREATE TABLE IF NOT EXISTS accounts ("
+        "    id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "    code TEXT NOT NULL UNIQUE,"
+        "    name TEXT NOT NULL,"
+        "    type INTEGER NOT NULL,"
+        "    parent_id INTEGER,"
+        "    created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,"
+        "    FOREIGN KEY (parent_id) REFERENCES accounts(id) ON DELETE CASCADE"
+        ")";
+    
+    QSqlQuery query2 = executeQuery(createAccounts);
+    if (query2.lastError().isValid()) {
+        qCritical() << "Ошибка создания таблицы accounts:" << query2.lastError().text();
+    } else {
+        qDebug() << "✓ Таблица accounts проверена/создана";
+        
+        // Вставляем базовые счета, если их нет
+        QString insertAccounts = 
+            "INSERT OR IGNORE INTO accounts (code, name, type) VALUES "
+            "('50', 'Касса', 0),"
+            "('51', 'Расчетные счета', 0),"
+            "('52', 'Валютные счета', 0),"
+            "('60', 'Расчеты с поставщиками и подрядчиками', 2),"
+            "('62', 'Расчеты с покупателями и заказчиками', 2),"
+            "('70', 'Расчеты с персоналом по оплате труда', 2),"
+            "('80', 'Уставный капитал', 1),"
+            "('90', 'Продажи', 1),"
+            "('91', 'Прочие доходы и расходы', 2)";
+        
+        QSqlQuery query3 = executeQuery(insertAccounts);
+        if (query3.lastError().isValid()) {
+            qWarning() << "Ошибка вставки базовых счетов:" << query3.lastError().text();
+        } else {
+            qDebug() << "✓ Базовые счета проверены/добавлены";
+        }
+    }
+    
+    // Создаем таблицу проводок
+    QString createTransactions = 
+        "CREATE TABLE IF NOT EXISTS transactions ("
+        "    id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "    transaction_date DATE NOT NULL,"
+        "    debit_account_id INTEGER NOT NULL,"
+        "    credit_account_id INTEGER NOT NULL,"
+        "    amount DECIMAL(15,2) NOT NULL,"
+        "    description TEXT,"
+        "    document_number TEXT,"
+        "    document_date DATE,"
+        "    counterparty_id INTEGER,"
+        "    created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,"
+        "    FOREIGN KEY (debit_account_id) REFERENCES accounts(id),"
+        "    FOREIGN KEY (credit_account_id) REFERENCES accounts(id),"
+        "    FOREIGN KEY (counterparty_id) REFERENCES counterparties(id),"
+        "    CHECK (amount > 0)"
+        ")";
+    
+    QSqlQuery query4 = executeQuery(createTransactions);
+    if (query4.lastError().isValid()) {
+        qCritical() << "Ошибка создания таблицы transactions:" << query4.lastError().text();
+    } else {
+        qDebug() << "✓ Таблица transactions проверена/создана";
+    }
+    
+    // Создаем индексы, если не существуют
+    // Составные индексы (счет, дата) обслуживают и выборку по счету,
+    // и диапазон дат по счету, поэтому одиночные индексы по счетам не нужны
+    QStringList indexes = {
+        "CREATE INDEX IF NOT EXISTS idx_transactions_date ON transactions(transaction_date)",
+        "CREATE INDEX IF NOT EXISTS idx_transactions_debit_date ON transactions(debit_account_id, transaction_date)",
+        "CREATE INDEX IF NOT EXISTS idx_transactions_credit_date ON transactions(credit_account_id, transaction_date)",
+        "DROP INDEX IF EXISTS idx_transactions_debit",
+        "DROP INDEX IF EXISTS idx_transactions_credit"
+    };
+    
+    for (const QString &index : indexes) {
+        QSqlQuery query = executeQuery(index);
+        if (query.lastError().isValid()) {
+            qWarning() << "Ошибка создания индекса:" << query.lastError().text();
+        }
+    }
+    
+    // Версия записи в журнал: по ней кэши результатов узнают об изменениях
+    QStringList ledgerState = {
+        "CREATE TABLE IF NOT EXISTS ledger_state ("
+        "    id INTEGER PRIMARY KEY CHECK (id = 1),"
+        "    write_version INTEGER NOT NULL DEFAULT 0"
+        ")",
+        "INSERT OR IGNORE INTO ledger_state (id, write_version) VALUES (1, 0)"
+    };
+    
+    // Новый счет попадает в ОСВ даже без проводок, поэтому версия растет
+    // и при его добавлении; новый контрагент без проводок результатов не меняет
+    QStringList versionedEvents = {
+        "transactions_ai AFTER INSERT ON transactions",
+        "transactions_au AFTER UPDATE ON transactions",
+        "transactions_ad AFTER DELETE ON transactions",
+        "accounts_ai AFTER INSERT ON accounts",
+        "accounts_au AFTER UPDATE ON accounts",
+        "accounts_ad AFTER DELETE ON accounts",
+        "counterparties_au AFTER UPDATE ON counterparties",
+        "counterparties_ad AFTER DELETE ON counterparties"
+    };
+    for (const QString &event : versionedEvents) {
+        ledgerState << "CREATE TRIGGER IF NOT EXISTS trg_version_" + event + " "
+                       "BEGIN UPDATE ledger_state SET write_version = write_version + 1 WHERE id = 1; END";
+    }
+    
+    for (const QString &statement : ledgerState) {
+        QSqlQuery query = executeQuery(statement);
+        if (query.lastError().isValid()) {
+            qWarning() << "Ошибка создания ledger_state:" << query.lastError().text();
+        }
+    }
+    
+    // Месяцы журнала с версией их последнего изменения: по ним кэш отчетов
+    // (ReportCache) отличает правки внутри периода отчета от более поздних.
+    // Правка справочников меняет названия во всех отчетах - месяц "0000-00"
+    const QString touchMonth =
+        "INSERT INTO ledger_months (month, version) "
+        "VALUES (COALESCE(strftime('%Y-%m', %1), '0000-00'), "
+        "        (SELECT write_version FROM ledger_state WHERE id = 1)) "
+        "ON CONFLICT(month) DO UPDATE SET version = excluded.version; ";
+    const QString touchAll = QString(touchMonth).arg("NULL");
+    
+    QStringList ledgerMonths = {
+        "CREATE TABLE IF NOT EXISTS ledger_months ("
+        "    month TEXT PRIMARY KEY,"
+        "    version INTEGER NOT NULL"
+        ") WITHOUT ROWID",
+        "CREATE TRIGGER IF NOT EXISTS trg_months_transactions_ai AFTER INSERT ON transactions "
+        "BEGIN " + QString(touchMonth).arg("NEW.transaction_date") + "END",
+        "CREATE TRIGGER IF NOT EXISTS trg_months_transactions_au AFTER UPDATE ON transactions "
+        "BEGIN " + QString(touchMonth).arg("OLD.transaction_date")
+                 + QString(touchMonth).arg("NEW.transaction_date") + "END",
+        "CREATE TRIGGER IF NOT EXISTS trg_months_transactions_ad AFTER DELETE ON transactions "
+        "BEGIN " + QString(touchMonth).arg("OLD.transaction_date") + "END"
+    };
+    for (const QString &event : {QString("accounts_ai AFTER INSERT ON accounts"),
+                                 QString("accounts_au AFTER UPDATE ON accounts"),
+                                 QString("accounts_ad AFTER DELETE ON accounts"),
+                                 QString("counterparties_au AFTER UPDATE ON counterparties"),
+                                 QString("counterparties_ad AFTER DELETE ON counterparties")}) {
+        ledgerMonths << "CREATE TRIGGER IF NOT EXISTS trg_months_" + event + " "
+                        "BEGIN " + touchAll + "END";
+    }
+    
+    for (const QString &statement : ledgerMonths) {
+        QSqlQuery query = executeQuery(statement);
+        if (query.lastError().isValid()) {
+            qWarning() << "Ошибка создания ledger_months:" << query.lastError().text();
+        }
+    }
+    
+    // Сохраненные фильтры проводок (раньше хранились в QSettings)
+    QString createSavedFilters = 
+        "CREATE TABLE IF NOT EXISTS saved_filters ("
+        "    id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "    name TEXT NOT NULL UNIQUE,"
+        "    options TEXT NOT NULL,"
+        "    updated_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP"
+        ")";
+    
+    QSqlQuery query5 = executeQuery(createSavedFilters);
+    if (query5.lastError().isValid()) {
+        qCritical() << "Ошибка создания таблицы saved_filters:" << query5.lastError().text();
+    } else {
+        qDebug() << "✓ Таблица saved_filters проверена/создана";
+    }
+    
+    // Шаблоны проводок; amount_formula - формула суммы (AmountFormula),
+    // в базах старых версий колонка добавляется здесь
+    QString createTemplates = 
+        "CREATE TABLE IF NOT EXISTS transaction_templates ("
+        "    id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "    name TEXT NOT NULL,"
+        "    description TEXT,"
+        "    debit_account_id INTEGER NOT NULL,"
+        "    credit_account_id INTEGER NOT NULL,"
+        "    amount DECIMAL(15,2),"
+        "    is_amount_fixed BOOLEAN DEFAULT 0,"
+        "    document_prefix TEXT,"
+        "    counterparty_id INTEGER,"
+        "    frequency TEXT,"
+        "    last_executed DATE,"
+        "    amount_formula TEXT,"
+        "    created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,"
+        "    FOREIGN KEY (debit_account_id) REFERENCES accounts(id),"
+        "    FOREIGN KEY (credit_account_id) REFERENCES accounts(id),"
+        "    FOREIGN KEY (counterparty_id) REFERENCES counterparties(id)"
+        ")";
+    
+    QSqlQuery query6 = executeQuery(createTemplates);
+    if (query6.lastError().isValid()) {
+        qCritical() << "Ошибка создания таблицы transaction_templates:" << query6.lastError().text();
+    } else {
+        qDebug() << "✓ Таблица transaction_templates проверена/создана";
+        
+        bool hasFormula = false;
+        QSqlQuery columns = executeQuery("PRAGMA table_info(transaction_templates)");
+        while (columns.next()) {
+            if (columns.value(1).toString() == "amount_formula") hasFormula = true;
+        }
+        if (!hasFormula) {
+            QSqlQuery alter = executeQuery(
+                "ALTER TABLE transaction_templates ADD COLUMN amount_formula TEXT");
+            if (alter.lastError().isValid()) {
+                qCritical() << "Ошибка добавления amount_formula:" << alter.lastError().text();
+            }
+        }
+    }
+    
+    // Таблица замыкания плана счетов: все пары (предок, потомок) с глубиной.
+    // Поддерживается диалогом счета и deleteAccount вместе с accounts.
+    QStringList accountClosure = {
+        "CREATE TABLE IF NOT EXISTS account_closure ("
+        "    ancestor INTEGER NOT NULL,"
+        "    descendant INTEGER NOT NULL,"
+        "    depth INTEGER NOT NULL,"
+        "    PRIMARY KEY (ancestor, descendant)"
+        ") WITHOUT ROWID",
+        "CREATE INDEX IF NOT EXISTS idx_account_closure_descendant "
+        "ON account_closure(descendant, depth)"
+    };
+    
+    for (const QString &statement : accountClosure) {
+        QSqlQuery query = executeQuery(statement);
+        if (query.lastError().isValid()) {
+            qCritical() << "Ошибка создания account_closure:" << query.lastError().text();
+        }
+    }
+    
+    // Базы старых версий и базовые счета выше заполняют замыкание здесь
+    if (!AccountTree::rebuildIfNeeded()) {
+        qWarning() << "Не удалось построить таблицу замыкания плана счетов";
+    }
+    
+    // Обороты по каждому счету, поддерживаемые триггерами на transactions.
+    // Сальдо узлов дерева счетов суммируется из них по замыканию.
+    QSqlQuery balancesExist = executeQuery(
+        "SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'account_balances'");
+    bool fillBalances = !balancesExist.next();
+    
+    QStringList accountBalances = {
+        "CREATE TABLE IF NOT EXISTS account_balances ("
+        "    account_id INTEGER PRIMARY KEY,"
+        "    debit_total REAL NOT NULL DEFAULT 0,"
+        "    credit_total REAL NOT NULL DEFAULT 0"
+        ")",
+        "CREATE TRIGGER IF NOT EXISTS trg_balances_ai AFTER INSERT ON transactions BEGIN "
+        "  INSERT INTO account_balances (account_id, debit_total) "
+        "  VALUES (NEW.debit_account_id, NEW.amount) "
+        "  ON CONFLICT(account_id) DO UPDATE SET debit_total = debit_total + excluded.debit_total; "
+        "  INSERT INTO account_balances (account_id, credit_total) "
+        "  VALUES (NEW.credit_account_id, NEW.amount) "
+        "  ON CONFLICT(account_id) DO UPDATE SET credit_total = credit_total + excluded.credit_total; "
+        "END",
+        "CREATE TRIGGER IF NOT EXISTS trg_balances_ad AFTER DELETE ON transactions BEGIN "
+        "  UPDATE account_balances SET debit_total = debit_total - OLD.amount "
+        "  WHERE account_id = OLD.debit_account_id; "
+        "  UPDATE account_balances SET credit_total = credit_total - OLD.amount "
+        "  WHERE account_id = OLD.credit_account_id; "
+        "END",
+        "CREATE TRIGGER IF NOT EXISTS trg_balances_au "
+        "AFTER UPDATE OF debit_account_id, credit_account_id, amount ON transactions BEGIN "
+        "  UPDATE account_balances SET debit_total = debit_total - OLD.amount "
+        "  WHERE account_id = OLD.debit_account_id; "
+        "  UPDATE account_balances SET credit_total = credit_total - OLD.amount "
+        "  WHERE account_id = OLD.credit_account_id; "
+        "  INSERT INTO account_balances (account_id, debit_total) "
+        "  VALUES (NEW.debit_account_id, NEW.amount) "
+        "  ON CONFLICT(account_id) DO UPDATE SET debit_total = debit_total + excluded.debit_total; "
+        "  INSERT INTO account_balances (account_id, credit_total) "
+        "  VALUES (NEW.credit_account_id, NEW.amount) "
+        "  ON CONFLICT(account_id) DO UPDATE SET credit_total = credit_total + excluded.credit_total; "
+        "END"
+    };
+    
+    // Таблица появилась только что - заполняем по уже накопленным проводкам
+    if (fillBalances) {
+        accountBalances <<
+            "INSERT INTO account_balances (account_id, debit_total, credit_total) "
+            "SELECT account_id, SUM(debit), SUM(credit) FROM ("
+            "  SELECT debit_account_id AS account_id, amount AS debit, 0 AS credit FROM transactions "
+            "  UNION ALL "
+            "  SELECT credit_account_id, 0, amount FROM transactions"
+            ") GROUP BY account_id";
+    }
+    
+    for (const QString &statement : accountBalances) {
+        QSqlQuery query = executeQuery(statement);
+        if (query.lastError().isValid()) {
+            qCritical() << "Ошибка создания account_balances:" << query.lastError().text();
+        }
+    }
+    
+    qDebug() << "=== Все таблицы проверены/созданы ===";
+}
+
 QSqlQuery Database::executeQuery(const QString& queryStr, const QVariantList& params)
 {
-    QSqlQuery sqlQuery(db_);
+    return runQuery(queryStr, params, false);
+}
+
+QSqlQuery Database::executeCursor(const QString& queryStr, const QVariantList& params)
+{
+    return runQuery(queryStr, params, true);
+}
+
+QSqlQuery Database::runQuery(const QString& queryStr, const QVariantList& params, bool forwardOnly)
+{
+    QSqlQuery sqlQuery(threadDatabase());
+    
+    // Без кэша драйвера уже прочитанные строки не копятся в памяти
+    sqlQuery.setForwardOnly(forwardOnly);
     
     // Отладочный вывод
     qDebug() << "\n=== Database::executeQuery ===";
@@ -125,4 +493,39 @@ bool Database::rollbackTransaction()
 QSqlDatabase& Database::database()
 {
     return db_;
-}
\ No newline at end of file
+}
+
+QSqlDatabase Database::threadDatabase()
+{
+    if (!initialized_ || QThread::currentThread() == ownerThread_) {
+        return db_;
+    }
+    
+    if (!threadConnections.hasLocalData()) {
+        ThreadConnection *connection = new ThreadConnection;
+        connection->name = QString("ledgermini_thread_%1")
+                               .arg(threadConnectionCounter.fetchAndAddRelaxed(1));
+        threadConnections.setLocalData(connection);
+        
+        QSqlDatabase db = QSqlDatabase::cloneDatabase(db_.connectionName(), connection->name);
+        if (!db.open()) {
+            qCritical() << "Failed to open thread connection:" << db.lastError().text();
+            return db;
+        }
+        
+        QSqlQuery query(db);
+        query.exec("PRAGMA foreign_keys = ON;");
+        query.exec("PRAGMA busy_timeout = 5000;");
+    }
+    
+    return QSqlDatabase::database(threadConnections.localData()->name);
+}
+
+qint64 Database::ledgerVersion()
+{
+    QSqlQuery query(threadDatabase());
+    if (!query.exec("SELECT write_version FROM ledger_state WHERE id = 1") || !query.next()) {
+        return -1;
+    }
+    return query.value(0).toLongLong();
+}
@@ -0,0 +1,237 @@
+#include "core/exportjobqueue.h"
+#include "core/database.h"
+
+#include <QElapsedTimer>
+#include <QThread>
+#include <QFile>
+#include <QMetaObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QDebug>
+#include <atomic>
+
+namespace {
+
+// Не чаще, чем раз в столько миллисекунд, ход задачи уходит в интерфейс
+const int ProgressIntervalMs = 200;
+
+}
+
+struct ExportJobQueue::Job {
+    int id = 0;
+    QString title;
+    QString fileName;
+    Task task;
+    std::atomic<int> state{Queued};
+    std::atomic<qint64> done{0};
+    std::atomic<qint64> total{0};
+    std::atomic<bool> cancelled{false};
+    mutable QMutex mutex;
+    QString error;                      // защищен mutex
+};
+
+// Переживает очередь: задачи, закончившие работу после ее удаления,
+// ничего не доставят
+struct ExportJobQueue::Shared {
+    QMutex mutex;
+    ExportJobQueue *owner = nullptr;    // защищен mutex
+};
+
+class ExportJobQueue::JobProgress : public ExportProgress
+{
+public:
+    JobProgress(const std::shared_ptr<Shared> &shared, const std::shared_ptr<Job> &job)
+        : shared_(shared)
+        , job_(job)
+    {
+        timer_.start();
+    }
+
+    void setTotal(qint64 total) override
+    {
+        job_->total = total;
+        ExportJobQueue::post(shared_, job_->id, false, false);
+    }
+
+    void setDone(qint64 done) override
+    {
+        job_->done = done;
+        if (timer_.elapsed() >= ProgressIntervalMs) {
+            timer_.restart();
+            ExportJobQueue::post(shared_, job_->id, false, false);
+        }
+    }
+
+    bool isCancelled() const override { return job_->cancelled.load(); }
+
+private:
+    std::shared_ptr<Shared> shared_;
+    std::shared_ptr<Job> job_;
+    QElapsedTimer timer_;
+};
+
+ExportJobQueue& ExportJobQueue::instance()
+{
+    static ExportJobQueue queue;
+    return queue;
+}
+
+ExportJobQueue::ExportJobQueue()
+    : shared_(std::make_shared<Shared>())
+{
+    shared_->owner = this;
+
+    // Выгрузки упираются в диск, больше двух-трех одновременно не нужно
+    pool_.setMaxThreadCount(qBound(2, QThread::idealThreadCount() / 2, 4));
+}
+
+ExportJobQueue::~ExportJobQueue()
+{
+    {
+        QMutexLocker locker(&shared_->mutex);
+        shared_->owner = nullptr;
+    }
+    for (const std::shared_ptr<Job> &job : jobs_) {
+        job->cancelled = true;
+    }
+    pool_.waitForDone();
+}
+
+void ExportJobQueue::post(const std::shared_ptr<Shared> &shared, int id, bool finished, bool ok)
+{
+    QMutexLocker locker(&shared->mutex);
+    ExportJobQueue *owner = shared->owner;
+    if (!owner) return;
+
+    QMetaObject::invokeMethod(owner, [owner, id, finished, ok]() {
+        if (!owner->jobs_.contains(id)) return;
+        emit owner->jobChanged(id);
+        if (finished) {
+            emit owner->jobFinished(id, ok);
+        }
+    }, Qt::QueuedConnection);
+}
+
+int ExportJobQueue::enqueue(const QString &title, const QString &fileName, Task task)
+{
+    std::shared_ptr<Job> job = std::make_shared<Job>();
+    job->id = nextId_++;
+    job->title = title;
+    job->fileName = fileName;
+    job->task = std::move(task);
+    jobs_.insert(job->id, job);
+
+    std::shared_ptr<Shared> shared = shared_;
+    pool_.start([shared, job]() {
+        if (job->cancelled.load()) {
+            job->state = Cancelled;
+            post(shared, job->id, true, false);
+            return;
+        }
+
+        job->state = Running;
+        post(shared, job->id, false, false);
+
+        // Все чтения выгрузки - в одной транзакции соединения этого потока:
+        // в режиме WAL она видит один снимок базы до своего завершения
+        QSqlDatabase db = Database::instance().threadDatabase();
+        const bool snapshot = db.isOpen() && db.transaction();
+
+        QString error;
+        JobProgress progress(shared, job);
+        bool ok = job->task(&progress, &error);
+
+        if (snapshot) {
+            db.rollback();
+        }
+
+        // Захваченные задачей данные больше не нужны
+        job->task = nullptr;
+
+        State state = ok ? Finished : Failed;
+        if (job->cancelled.load()) {
+            QFile::remove(job->fileName);
+            state = Cancelled;
+            ok = false;
+        } else if (!ok) {
+            qWarning() << "Export failed:" << job->title << error;
+        }
+
+        {
+            QMutexLocker locker(&job->mutex);
+            job->error = error;
+        }
+        job->state = state;
+        post(shared, job->id, true, ok);
+    });
+
+    emit jobAdded(job->id);
+    return job->id;
+}
+
+void ExportJobQueue::cancel(int id)
+{
+    std::shared_ptr<Job> job = jobs_.value(id);
+    if (!job) return;
+
+    job->cancelled = true;
+    emit jobChanged(id);
+}
+
+void ExportJobQueue::removeFinished()
+{
+    bool removed = false;
+    for (auto it = jobs_.begin(); it != jobs_.end(); ) {
+        State state = State(it.value()->state.load());
+        if (state == Finished || state == Failed || state == Cancelled) {
+            it = jobs_.erase(it);
+            removed = true;
+        } else {
+            ++it;
+        }
+    }
+
+    if (removed) {
+        emit jobsRemoved();
+    }
+}
+
+ExportJobQueue::JobInfo ExportJobQueue::infoOf(const Job &job)
+{
+    JobInfo info;
+    info.id = job.id;
+    info.title = job.title;
+    info.fileName = job.fileName;
+    info.state = State(job.state.load());
+    info.done = job.done.load();
+    info.total = job.total.load();
+
+    QMutexLocker locker(&job.mutex);
+    info.error = job.error;
+    return info;
+}
+
+QVector<ExportJobQueue::JobInfo> ExportJobQueue::jobs() const
+{
+    QVector<JobInfo> result;
+    for (const std::shared_ptr<Job> &job : jobs_) {
+        result.append(infoOf(*job));
+    }
+    return result;
+}
+
+ExportJobQueue::JobInfo ExportJobQueue::job(int id) const
+{
+    std::shared_ptr<Job> job = jobs_.value(id);
+    return job ? infoOf(*job) : JobInfo();
+}
+
+int ExportJobQueue::activeCount() const
+{
+    int count = 0;
+    for (const std::shared_ptr<Job> &job : jobs_) {
+        State state = State(job->state.load());
+        if (state == Queued || state == Running) ++count;
+    }
+    return count;
+}
@@ -1,34 +1,93 @@
 #include "core/exportmanager.h"
-#include <QTableView>
-#include <QHeaderView>
-#include <QPrinter>
+#include "core/accountcard.h"
+#include "core/csvwriter.h"
+#include "core/pdftablerenderer.h"
+#include "core/xlsxwriter.h"
+#include "core/exportprogress.h"
+#include "core/database.h"
+#include "core/report_generator.h"
+#include "core/transactionquery.h"
+#include <QPdfWriter>
 #include <QTextDocument>
-#include <QFileDialog>
-#include <QMessageBox>
 #include <QDebug>
 #include <QTextStream>
-#include <QTextTable>
-#include <QTextCursor>
-#include <QTextTableFormat>
-#include <QTextCharFormat>
-#include <QTextBlockFormat>
+#include <QFile>
+#include <QSqlRecord>
 
 ExportManager::ExportManager(QObject *parent) : QObject(parent) {}
 
-bool ExportManager::exportTableToPdf(QTableView *tableView, const QString &title,
-                                   const QString &fileName, QWidget *parent)
+QStringList ExportManager::journalHeaders()
 {
-    if (!tableView || !tableView->model()) {
-        QMessageBox::warning(parent, "Ошибка", "Нет данных для экспорта");
-        return false;
+    return {"Дата", "Дебет", "Кредит", "Сумма", "Описание", "Документ", "Контрагент"};
+}
+
+QStringList ExportManager::balanceHeaders()
+{
+    return {"Счет", "Наименование", "Начальное Дт", "Начальное Кт",
+            "Оборот Дт", "Оборот Кт", "Конечное Дт", "Конечное Кт"};
+}
+
+namespace {
+
+// Итоговые строки в таблицах и отчетах - с пустой первой ячейкой или "ИТОГО"
+bool isTotalRow(const QString &firstCell)
+{
+    return firstCell.isEmpty() || firstCell.contains("ИТОГО");
+}
+
+// Числовые данные - с третьего столбца (код и наименование слева)
+QVector<int> numericColumns(int count)
+{
+    QVector<int> columns;
+    for (int col = 2; col < count; ++col) {
+        columns.append(col);
     }
+    return columns;
+}
+
+const qint64 ProgressStep = 1000;
+
+// Раз в ProgressStep строк сообщает ход выгрузки; false - выгрузку отменили
+bool reportProgress(ExportProgress *progress, qint64 done)
+{
+    if (!progress || done % ProgressStep != 0) return true;
+    progress->setDone(done);
+    return !progress->isCancelled();
+}
+
+void reportTotal(ExportProgress *progress, qint64 total)
+{
+    if (progress) progress->setTotal(total);
+}
+
+void reportDone(ExportProgress *progress, qint64 done)
+{
+    if (progress) progress->setDone(done);
+}
+
+// Объем журнала для индикатора хода - одним агрегатным запросом
+void reportTransactionTotal(ExportProgress *progress, const TransactionQuery &query)
+{
+    if (!progress) return;
     
-    QString html = generateTableHtml(tableView, title);
-    return saveToPdf(html, fileName);
+    TransactionTotals totals;
+    if (query.fetchTotals(&totals)) {
+        progress->setTotal(totals.count);
+    }
+}
+
+// Отмененная выгрузка не оставляет недописанный файл
+bool cancelled(const QString &fileName, QString *error)
+{
+    QFile::remove(fileName);
+    if (error) *error = "Выгрузка отменена";
+    return false;
+}
+
 }
 
 bool ExportManager::exportHtmlToPdf(const QString &htmlContent, const QString &title,
-                                  const QString &fileName, QWidget *parent)
+                                  const QString &fileName)
 {
     QString fullHtml = "<html><head><meta charset='UTF-8'>"
                       "<style>" + getDefaultStyle() + "</style></head><body>";
@@ -39,85 +98,351 @@ bool ExportManager::exportHtmlToPdf(const QString &htmlContent, const QString &t
     return saveToPdf(fullHtml, fileName);
 }
 
-bool ExportManager::exportBalanceReportToPdf(const QVector<QVariantList> &data,
-                                           const QStringList &headers,
-                                           const QString &title,
-                                           const QString &fileName,
-                                           QWidget *parent)
+bool ExportManager::exportRowsToPdf(const QVector<QVariantList> &data,
+                                    const QStringList &headers,
+                                    const QString &title,
+                                    const QString &fileName,
+                                    QString *error, ExportProgress *progress)
 {
-    QString html = generateDataHtml(data, headers, title);
-    return saveToPdf(html, fileName);
+    int row = 0;
+    bool stopped = false;
+    PdfTableRenderer renderer(title, headers);
+    renderer.setRightAligned(numericColumns(headers.size()));
+    reportTotal(progress, data.size());
+    
+    bool ok = renderer.render(fileName, [&](PdfTableRenderer::Row *out) {
+        if (row >= data.size()) return false;
+        if (!reportProgress(progress, row)) {
+            stopped = true;
+            return false;
+        }
+        
+        const QVariantList &values = data.at(row++);
+        out->cells.clear();
+        for (const QVariant &value : values) {
+            out->cells << value.toString();
+        }
+        out->emphasized = !values.isEmpty() && isTotalRow(values.first().toString());
+        return true;
+    }, error);
+    
+    if (stopped) return cancelled(fileName, error);
+    reportDone(progress, row);
+    return ok;
 }
 
-QString ExportManager::generateTableHtml(QTableView *tableView, const QString &title)
+bool ExportManager::exportTransactionsToPdf(const TransactionFilter &filter,
+                                            const QStringList &headers,
+                                            const QString &title,
+                                            const QString &fileName,
+                                            QString *error, ExportProgress *progress)
 {
-    QString html;
-    QTextStream stream(&html);
+    TransactionQuery transactions(filter);
+    reportTransactionTotal(progress, transactions);
     
-    stream << "<div class='report'>";
-    stream << "<h1>" << title << "</h1>";
+    QSqlQuery query = transactions.fetchAll();
+    if (query.lastError().isValid()) {
+        if (error) *error = "Ошибка запроса: " + query.lastError().text();
+        return false;
+    }
     
-    QAbstractItemModel *model = tableView->model();
-    if (!model) return "";
+    // Столбцы как в журнале: дата, дебет, кредит, сумма, описание, документ, контрагент
+    PdfTableRenderer renderer(title, headers);
+    renderer.setRightAligned({3});
     
-    int rowCount = model->rowCount();
-    int colCount = model->columnCount();
+    qint64 written = 0;
+    bool stopped = false;
+    bool ok = renderer.render(fileName, [&](PdfTableRenderer::Row *out) {
+        if (!reportProgress(progress, written)) {
+            stopped = true;
+            return false;
+        }
+        if (!query.next()) return false;
+        
+        TransactionRow row = TransactionQuery::readRow(query);
+        out->cells = {row.date.toString("dd.MM.yyyy"), row.debit, row.credit,
+                      QString::number(row.amount, 'f', 2), row.description,
+                      row.documentNumber, row.counterparty};
+        ++written;
+        return true;
+    }, error);
+    
+    if (stopped) return cancelled(fileName, error);
+    if (ok && query.lastError().isValid()) {
+        if (error) *error = "Ошибка запроса: " + query.lastError().text();
+        return false;
+    }
+    reportDone(progress, written);
+    return ok;
+}
+
+namespace {
+
+QString balanceText(double value)
+{
+    if (qFuzzyIsNull(value)) return QString("0.00");
+    return QString("%1 %2").arg(value > 0 ? "Д" : "К")
+                           .arg(QString::number(qAbs(value), 'f', 2));
+}
+
+QString amountText(double value)
+{
+    return qFuzzyIsNull(value) ? QString() : QString::number(value, 'f', 2);
+}
+
+bool openCsv(CsvWriter &writer, const QString &fileName, const QStringList &headers,
+             QString *error)
+{
+    CsvWriter::Options options;
+    options.gzip = CsvWriter::isGzipFileName(fileName);
+    if (!writer.open(fileName, options)) {
+        if (error) *error = "Не удалось создать файл: " + writer.errorString();
+        return false;
+    }
+    
+    writer.writeRow(headers);
+    return true;
+}
+
+bool finishCsv(CsvWriter &writer, const QSqlQuery &query, QString *error)
+{
+    // Ошибка курсора посреди выборки - выгрузка неполная
+    if (query.lastError().isValid()) {
+        writer.close();
+        if (error) *error = "Ошибка запроса: " + query.lastError().text();
+        return false;
+    }
     
-    // Определяем видимые столбцы
-    QVector<int> visibleColumns;
-    for (int col = 0; col < colCount; ++col) {
-        if (!tableView->isColumnHidden(col)) {
-            visibleColumns.append(col);
+    if (!writer.close()) {
+        if (error) *error = "Ошибка записи: " + writer.errorString();
+        return false;
+    }
+    return true;
+}
+
+}
+
+bool ExportManager::exportQueryToCsv(const QString &sql, const QVariantList &params,
+                                     const QStringList &headers,
+                                     const QString &fileName,
+                                     QString *error, ExportProgress *progress)
+{
+    QSqlQuery query = Database::instance().executeCursor(sql, params);
+    if (query.lastError().isValid()) {
+        if (error) *error = "Ошибка запроса: " + query.lastError().text();
+        return false;
+    }
+    
+    CsvWriter writer;
+    if (!openCsv(writer, fileName, headers, error)) return false;
+    
+    const int columns = query.record().count();
+    qint64 written = 0;
+    while (query.next()) {
+        for (int col = 0; col < columns; ++col) {
+            QVariant value = query.value(col);
+            if (value.typeId() == QMetaType::Double) {
+                writer.addField(QString::number(value.toDouble(), 'f', 2));
+            } else {
+                writer.addField(value.toString());
+            }
+        }
+        writer.endRow();
+        
+        if (!reportProgress(progress, ++written)) {
+            writer.close();
+            return cancelled(fileName, error);
         }
     }
     
-    if (visibleColumns.isEmpty()) return "";
+    reportDone(progress, written);
+    return finishCsv(writer, query, error);
+}
+
+bool ExportManager::exportAccountCardToCsv(const AccountCardParams &params,
+                                           const QString &fileName,
+                                           QString *error, ExportProgress *progress)
+{
+    AccountCardQuery card(params);
+    if (progress) {
+        AccountCardSummary summary;
+        if (card.fetchSummary(&summary)) {
+            progress->setTotal(summary.count + 2);
+        }
+    }
     
-    stream << "<table class='data-table'>";
+    QSqlQuery query = card.execute();
+    if (query.lastError().isValid()) {
+        if (error) *error = "Ошибка запроса: " + query.lastError().text();
+        return false;
+    }
     
-    // Заголовки
-    stream << "<thead><tr>";
-    for (int col : visibleColumns) {
-        QString header = model->headerData(col, Qt::Horizontal).toString();
-        stream << "<th>" << header << "</th>";
+    CsvWriter writer;
+    QStringList headers = {"Дата", "Счет", "Документ", "Контрагент", "Корр. счет",
+                           "Дебет", "Кредит", "Сальдо", "Описание"};
+    if (!openCsv(writer, fileName, headers, error)) return false;
+    
+    qint64 written = 0;
+    while (query.next()) {
+        AccountCardRow row = AccountCardQuery::readRow(query);
+        
+        switch (row.kind) {
+        case AccountCardRow::Opening:
+            writer.writeRow({params.dateFrom.toString("dd.MM.yyyy"), "", "", "",
+                             "Сальдо на начало", "", "", balanceText(row.balance), ""});
+            break;
+        case AccountCardRow::Movement:
+            writer.writeRow({row.date.toString("dd.MM.yyyy"), row.account, row.documentNumber,
+                             row.counterparty, row.oppositeAccount, amountText(row.debit),
+                             amountText(row.credit), balanceText(row.balance), row.description});
+            break;
+        case AccountCardRow::Total:
+            writer.writeRow({"ИТОГО:", "", "", "", "Обороты / сальдо на конец",
+                             QString::number(row.debit, 'f', 2),
+                             QString::number(row.credit, 'f', 2),
+                             balanceText(row.balance), ""});
+            break;
+        }
+        
+        if (!reportProgress(progress, ++written)) {
+            writer.close();
+            return cancelled(fileName, error);
+        }
     }
-    stream << "</tr></thead>";
     
-    // Данные
-    stream << "<tbody>";
-    for (int row = 0; row < rowCount; ++row) {
-        QString rowClass = (row % 2 == 0) ? "even" : "odd";
+    reportDone(progress, written);
+    return finishCsv(writer, query, error);
+}
+
+bool ExportManager::exportTransactionsToCsv(const TransactionFilter &filter,
+                                            const QStringList &headers,
+                                            const QString &fileName,
+                                            QString *error, ExportProgress *progress)
+{
+    TransactionQuery transactions(filter);
+    reportTransactionTotal(progress, transactions);
+    
+    QSqlQuery query = transactions.fetchAll();
+    if (query.lastError().isValid()) {
+        if (error) *error = "Ошибка запроса: " + query.lastError().text();
+        return false;
+    }
+    
+    CsvWriter writer;
+    if (!openCsv(writer, fileName, headers, error)) return false;
+    
+    qint64 written = 0;
+    while (query.next()) {
+        TransactionRow row = TransactionQuery::readRow(query);
+        writer.writeRow({row.date.toString("dd.MM.yyyy"), row.debit, row.credit,
+                         QString::number(row.amount, 'f', 2), row.description,
+                         row.documentNumber, row.counterparty});
         
-        // Проверяем, является ли строка итоговой
-        QModelIndex firstIndex = model->index(row, 0);
-        if (firstIndex.isValid()) {
-            QString firstCell = model->data(firstIndex).toString();
-            if (firstCell.isEmpty() || firstCell.contains("ИТОГО")) {
-                rowClass = "total";
-            }
+        if (!reportProgress(progress, ++written)) {
+            writer.close();
+            return cancelled(fileName, error);
         }
+    }
+    
+    reportDone(progress, written);
+    return finishCsv(writer, query, error);
+}
+
+bool ExportManager::exportTransactionsToXlsx(const TransactionFilter &filter,
+                                             const QStringList &headers,
+                                             const QString &fileName,
+                                             QString *error, ExportProgress *progress)
+{
+    TransactionQuery transactions(filter);
+    reportTransactionTotal(progress, transactions);
+    
+    QSqlQuery query = transactions.fetchAll();
+    if (query.lastError().isValid()) {
+        if (error) *error = "Ошибка запроса: " + query.lastError().text();
+        return false;
+    }
+    
+    // Ширина в символах: дата, дебет, кредит, сумма, описание, документ, контрагент
+    XlsxWriter writer;
+    if (!writer.open(fileName, "Журнал проводок", headers, {12, 40, 40, 16, 50, 16, 30})) {
+        if (error) *error = writer.errorString();
+        return false;
+    }
+    
+    while (query.next()) {
+        TransactionRow row = TransactionQuery::readRow(query);
+        writer.addDate(row.date);
+        writer.addString(row.debit);
+        writer.addString(row.credit);
+        writer.addNumber(row.amount);
+        writer.addString(row.description);
+        writer.addString(row.documentNumber);
+        writer.addString(row.counterparty);
+        writer.endRow();
         
-        stream << "<tr class='" << rowClass << "'>";
-        for (int col : visibleColumns) {
-            QModelIndex index = model->index(row, col);
-            QString value = model->data(index).toString();
-            
-            // Выравнивание для числовых значений
-            QString align = "left";
-            if (col >= 2) { // Предполагаем, что числовые данные с третьего столбца
-                align = "right";
-            }
-            
-            stream << "<td style='text-align:" << align << "'>" << value << "</td>";
+        if (!reportProgress(progress, writer.rowCount())) {
+            writer.close();
+            return cancelled(fileName, error);
         }
-        stream << "</tr>";
     }
-    stream << "</tbody>";
     
-    stream << "</table>";
-    stream << "</div>";
+    reportDone(progress, writer.rowCount());
     
-    return html;
+    if (query.lastError().isValid()) {
+        writer.close();
+        if (error) *error = "Ошибка запроса: " + query.lastError().text();
+        return false;
+    }
+    
+    if (!writer.close()) {
+        if (error) *error = writer.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool ExportManager::exportBalanceReportToCsv(const QVector<BalanceRecord> &records,
+                                             const QStringList &headers,
+                                             const QString &fileName, QString *error)
+{
+    CsvWriter writer;
+    if (!openCsv(writer, fileName, headers, error)) return false;
+    
+    for (const BalanceRecord &record : records) {
+        writer.writeRow({record.accountCode, record.accountName,
+                         QString::number(record.openingDebit, 'f', 2),
+                         QString::number(record.openingCredit, 'f', 2),
+                         QString::number(record.turnoverDebit, 'f', 2),
+                         QString::number(record.turnoverCredit, 'f', 2),
+                         QString::number(record.closingDebit, 'f', 2),
+                         QString::number(record.closingCredit, 'f', 2)});
+    }
+    
+    if (!writer.close()) {
+        if (error) *error = "Ошибка записи: " + writer.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool ExportManager::exportBalanceReportToPdf(const QVector<BalanceRecord> &records,
+                                             const QStringList &headers,
+                                             const QString &title,
+                                             const QString &fileName,
+                                             QString *error, ExportProgress *progress)
+{
+    QVector<QVariantList> data;
+    data.reserve(records.size());
+    for (const BalanceRecord &record : records) {
+        data.append({record.accountCode, record.accountName,
+                     QString::number(record.openingDebit, 'f', 2),
+                     QString::number(record.openingCredit, 'f', 2),
+                     QString::number(record.turnoverDebit, 'f', 2),
+                     QString::number(record.turnoverCredit, 'f', 2),
+                     QString::number(record.closingDebit, 'f', 2),
+                     QString::number(record.closingCredit, 'f', 2)});
+    }
+    return exportRowsToPdf(data, headers, title, fileName, error, progress);
 }
 
 QString ExportManager::generateDataHtml(const QVector<QVariantList> &data,
@@ -231,50 +556,24 @@ QString ExportManager::getDefaultStyle()
     )";
 }
 
-#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
 bool ExportManager::saveToPdf(const QString &htmlContent, const QString &fileName,
                             QPageSize::PageSizeId pageSize)
 {
     if (fileName.isEmpty()) return false;
     
-    QPrinter printer(QPrinter::HighResolution);
-    printer.setOutputFormat(QPrinter::PdfFormat);
-    printer.setOutputFileName(fileName);
-    printer.setPageSize(QPageSize(pageSize));  // Для Qt6
-    printer.setPageOrientation(QPageLayout::Landscape);
-    
-    QTextDocument document;
-    document.setHtml(htmlContent);
-    
-    // Вычисляем оптимальный размер
-    document.setPageSize(printer.pageRect(QPrinter::Point).size());
-    
-    // Печатаем
-    document.print(&printer);
-    
-    return true;
-}
-#else
-bool ExportManager::saveToPdf(const QString &htmlContent, const QString &fileName,
-                            QPrinter::PageSize pageSize)
-{
-    if (fileName.isEmpty()) return false;
-    
-    QPrinter printer(QPrinter::HighResolution);
-    printer.setOutputFormat(QPrinter::PdfFormat);
-    printer.setOutputFileName(fileName);
-    printer.setPageSize(pageSize);  // Для Qt5
-    printer.setPageOrientation(QPrinter::Landscape);
+    QPdfWriter writer(fileName);
+    writer.setResolution(1200);
+    writer.setPageSize(QPageSize(pageSize));
+    writer.setPageOrientation(QPageLayout::Landscape);
     
     QTextDocument document;
     document.setHtml(htmlContent);
     
     // Вычисляем оптимальный размер
-    document.setPageSize(printer.pageRect(QPrinter::Point).size());
+    document.setPageSize(writer.pageLayout().paintRect(QPageLayout::Point).size());
     
     // Печатаем
-    document.print(&printer);
+    document.print(&writer);
     
     return true;
 }
-#endif
@@ -0,0 +1,134 @@
+#include "core/filterresultcache.h"
+
+#include <QMutexLocker>
+
+namespace {
+
+// Накладные расходы на запись помимо самих id
+const qint64 EntryOverhead = 128;
+
+}
+
+FilterResultCache& FilterResultCache::instance()
+{
+    static FilterResultCache cache;
+    return cache;
+}
+
+bool FilterResultCache::lookup(const QByteArray &key, qint64 version,
+                               std::shared_ptr<const IdList> *ids)
+{
+    QMutexLocker locker(&mutex_);
+
+    auto found = index_.find(key);
+    if (found == index_.end()) {
+        ++misses_;
+        return false;
+    }
+
+    std::list<Entry>::iterator it = found.value();
+    if (it->version != version) {
+        // Журнал изменился - запись устарела
+        removeEntry(it);
+        ++misses_;
+        return false;
+    }
+
+    entries_.splice(entries_.begin(), entries_, it);
+    ++hits_;
+    *ids = it->ids;
+    return true;
+}
+
+void FilterResultCache::insert(const QByteArray &key, qint64 version,
+                               std::shared_ptr<const IdList> ids)
+{
+    if (!ids || ids->size() > maxIdsPerEntry()) {
+        insertTooLarge(key, version);
+        return;
+    }
+
+    QMutexLocker locker(&mutex_);
+    store(key, version, ids);
+}
+
+void FilterResultCache::insertTooLarge(const QByteArray &key, qint64 version)
+{
+    // Запоминаем, чтобы не строить список id заново при каждом поиске
+    QMutexLocker locker(&mutex_);
+    store(key, version, nullptr);
+}
+
+void FilterResultCache::clear()
+{
+    QMutexLocker locker(&mutex_);
+    entries_.clear();
+    index_.clear();
+    bytes_ = 0;
+}
+
+void FilterResultCache::setLimits(int maxEntries, qint64 maxBytes, int maxIdsPerEntry)
+{
+    QMutexLocker locker(&mutex_);
+    maxEntries_ = qMax(1, maxEntries);
+    maxBytes_ = qMax<qint64>(0, maxBytes);
+    maxIdsPerEntry_ = qMax(0, maxIdsPerEntry);
+    evict();
+}
+
+int FilterResultCache::maxIdsPerEntry() const
+{
+    QMutexLocker locker(&mutex_);
+    return maxIdsPerEntry_;
+}
+
+FilterResultCache::Stats FilterResultCache::stats() const
+{
+    QMutexLocker locker(&mutex_);
+
+    Stats stats;
+    stats.hits = hits_;
+    stats.misses = misses_;
+    stats.entries = int(entries_.size());
+    stats.bytes = bytes_;
+    return stats;
+}
+
+void FilterResultCache::store(const QByteArray &key, qint64 version,
+                              std::shared_ptr<const IdList> ids)
+{
+    auto found = index_.find(key);
+    if (found != index_.end()) {
+        removeEntry(found.value());
+    }
+
+    Entry entry;
+    entry.key = key;
+    entry.version = version;
+    entry.ids = ids;
+    entry.bytes = EntryOverhead + key.size()
+                  + (ids ? qint64(ids->size()) * qint64(sizeof(qint64)) : 0);
+
+    if (entry.bytes > maxBytes_) return;
+
+    entries_.push_front(entry);
+    index_.insert(key, entries_.begin());
+    bytes_ += entry.bytes;
+
+    evict();
+}
+
+void FilterResultCache::removeEntry(std::list<Entry>::iterator it)
+{
+    bytes_ -= it->bytes;
+    index_.remove(it->key);
+    entries_.erase(it);
+}
+
+void FilterResultCache::evict()
+{
+    while (!entries_.empty()
+           && (int(entries_.size()) > maxEntries_ || bytes_ > maxBytes_)) {
+        removeEntry(std::prev(entries_.end()));
+    }
+}
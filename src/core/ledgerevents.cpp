@@ -0,0 +1,7 @@
+#include "core/ledgerevents.h"
+
+LedgerEvents& LedgerEvents::instance()
+{
+    static LedgerEvents events;
+    return events;
+}
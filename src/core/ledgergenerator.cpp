@@ -0,0 +1,630 @@
+#include "core/ledgergenerator.h"
+#include "core/accounttree.h"
+#include "core/database.h"
+#include "core/exportprogress.h"
+#include "core/ledgerevents.h"
+#include "core/validationrules.h"
+
+#include <QCryptographicHash>
+#include <QFile>
+#include <QHash>
+#include <QRandomGenerator>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QVector>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+struct ChartAccount {
+    const char *code;
+    const char *name;
+    int type;
+};
+
+// Синтетические счета плана, на которые идут проводки; подсчета
+// добавляются к ним по кругу
+const ChartAccount Chart[] = {
+    {"01", "Основные средства", 0},
+    {"02", "Амортизация основных средств", 1},
+    {"08", "Вложения во внеоборотные активы", 0},
+    {"10", "Материалы", 0},
+    {"19", "НДС по приобретенным ценностям", 0},
+    {"20", "Основное производство", 0},
+    {"26", "Общехозяйственные расходы", 0},
+    {"41", "Товары", 0},
+    {"44", "Расходы на продажу", 0},
+    {"50", "Касса", 0},
+    {"51", "Расчетные счета", 0},
+    {"60", "Расчеты с поставщиками и подрядчиками", 2},
+    {"62", "Расчеты с покупателями и заказчиками", 2},
+    {"66", "Расчеты по краткосрочным кредитам и займам", 1},
+    {"68", "Расчеты по налогам и сборам", 2},
+    {"69", "Расчеты по социальному страхованию", 2},
+    {"70", "Расчеты с персоналом по оплате труда", 2},
+    {"71", "Расчеты с подотчетными лицами", 2},
+    {"76", "Расчеты с разными дебиторами и кредиторами", 2},
+    {"90", "Продажи", 1},
+    {"91", "Прочие доходы и расходы", 2}
+};
+const int ChartSize = sizeof(Chart) / sizeof(Chart[0]);
+
+// Типовая корреспонденция: доля в журнале, медиана суммы, текст
+struct Flow {
+    const char *debit;
+    const char *credit;
+    double weight;
+    double median;
+    const char *text;
+    const char *document;       // префикс номера документа или nullptr
+    bool counterparty;
+};
+
+const Flow Flows[] = {
+    {"60", "51", 14, 50000, "Оплата поставщику", "ПП", true},
+    {"51", "62", 14, 70000, "Поступление от покупателя", "ПП", true},
+    {"62", "90", 12, 70000, "Реализация товаров и услуг", "РН", true},
+    {"90", "41", 8, 45000, "Списание себестоимости", nullptr, false},
+    {"41", "60", 9, 45000, "Поступление товаров", "ТН", true},
+    {"19", "60", 6, 8000, "НДС по поступлению", "СФ", true},
+    {"90", "68", 6, 12000, "НДС с реализации", nullptr, false},
+    {"68", "19", 4, 8000, "Вычет НДС", nullptr, false},
+    {"10", "60", 5, 20000, "Поступление материалов", "ТН", true},
+    {"20", "10", 5, 15000, "Списание материалов в производство", "ТР", false},
+    {"26", "60", 4, 10000, "Общехозяйственные расходы", "АКТ", true},
+    {"44", "60", 3, 8000, "Расходы на продажу", "АКТ", true},
+    {"20", "70", 3, 60000, "Начисление зарплаты", nullptr, false},
+    {"70", "68", 2, 8000, "НДФЛ с зарплаты", nullptr, false},
+    {"70", "51", 3, 50000, "Выплата зарплаты", "ПП", false},
+    {"20", "69", 2, 18000, "Страховые взносы", nullptr, false},
+    {"69", "51", 1.5, 18000, "Уплата страховых взносов", "ПП", false},
+    {"68", "51", 1.5, 20000, "Уплата налогов", "ПП", false},
+    {"50", "51", 1.5, 30000, "Получение наличных в банке", "ЧК", false},
+    {"71", "50", 1.5, 5000, "Выдача под отчет", "РКО", false},
+    {"26", "71", 1.5, 4500, "Авансовый отчет", "АО", false},
+    {"51", "66", 0.3, 500000, "Получение кредита", "ПП", true},
+    {"91", "76", 1, 3000, "Прочие расходы", nullptr, true},
+    {"08", "60", 0.5, 150000, "Приобретение основных средств", "ТН", true},
+    {"01", "08", 0.3, 150000, "Ввод в эксплуатацию", "ОС", false},
+    {"26", "02", 1, 5000, "Амортизация", nullptr, false}
+};
+const int FlowCount = sizeof(Flows) / sizeof(Flows[0]);
+
+// Строк в одном INSERT: 8 параметров на строку, до лимита SQLite далеко
+const int RowsPerStatement = 64;
+const int ColumnCount = 8;
+// Фиксация каждые столько проводок: WAL не растет до размера базы
+const qint64 CommitRows = 1000000;
+const qint64 ProgressStep = 65536;
+
+// Выбор по весам: накопленные веса и двоичный поиск
+class WeightedChoice
+{
+public:
+    void add(double weight)
+    {
+        total_ += weight;
+        cumulative_.append(total_);
+    }
+
+    int pick(QRandomGenerator &rng) const
+    {
+        const double x = rng.generateDouble() * total_;
+        const int index = int(std::upper_bound(cumulative_.begin(), cumulative_.end(), x)
+                              - cumulative_.begin());
+        return std::min(index, int(cumulative_.size()) - 1);
+    }
+
+private:
+    QVector<double> cumulative_;
+    double total_ = 0.0;
+};
+
+// Стандартное нормальное (Бокс - Мюллер)
+double normal(QRandomGenerator &rng)
+{
+    const double u1 = 1.0 - rng.generateDouble();
+    const double u2 = rng.generateDouble();
+    const double pi = 3.14159265358979323846;
+    return std::sqrt(-2.0 * std::log(u1)) * std::cos(2.0 * pi * u2);
+}
+
+bool exec(const QString &sql, QString *error)
+{
+    QSqlQuery query = Database::instance().executeQuery(sql);
+    if (query.lastError().isValid()) {
+        if (error) *error = "Ошибка запроса: " + query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+class Generator
+{
+public:
+    Generator(const LedgerGenerator::Options &options, LedgerGenerator::Result *result,
+              QString *error, ExportProgress *progress)
+        : options_(options), result_(result), error_(error), progress_(progress),
+          rng_(options.seed)
+    {
+    }
+
+    bool run();
+
+private:
+    bool createAccounts();
+    bool createCounterparties();
+    bool loadLeaves();
+    bool insertPostings(const QDate &from, const QDate &to);
+    bool detachTransactionSchema();
+    bool restoreTransactionSchema();
+    bool fail(const QString &message)
+    {
+        if (error_) *error_ = message;
+        return false;
+    }
+
+    const LedgerGenerator::Options &options_;
+    LedgerGenerator::Result *result_;
+    QString *error_;
+    ExportProgress *progress_;
+    QRandomGenerator rng_;
+
+    QHash<QString, QVector<int>> leaves_;       // код счета плана -> id листьев
+    QVector<int> counterpartyIds_;
+    QStringList detached_;                      // DDL снятых триггеров и индексов
+};
+
+bool Generator::run()
+{
+    Database &db = Database::instance();
+
+    const QDate from = options_.from;
+    const QDate to = options_.to;
+    if (!from.isValid() || !to.isValid()) return fail("Не задан период проводок");
+    if (from > to) return fail("Начало периода позже конца");
+
+    // Справочники - одной транзакцией, замыкание счетов - как в диалоге счета
+    if (!db.beginTransaction()) return fail("Не удалось начать транзакцию");
+    if (!createAccounts() || !createCounterparties()) {
+        db.rollbackTransaction();
+        return false;
+    }
+    if (!db.commitTransaction()) {
+        db.rollbackTransaction();
+        return fail("Не удалось завершить транзакцию");
+    }
+    if (!loadLeaves()) return false;
+
+    // Внешние ключи не проверяются: id берутся из только что прочитанных
+    // справочников. Прагмы меняются только вне транзакции
+    exec("PRAGMA foreign_keys = OFF", nullptr);
+    exec("PRAGMA synchronous = OFF", nullptr);
+
+    bool ok = detachTransactionSchema() && insertPostings(from, to);
+    // Триггеры и индексы возвращаются и после ошибки
+    ok = restoreTransactionSchema() && ok;
+
+    exec("PRAGMA synchronous = FULL", nullptr);
+    exec("PRAGMA foreign_keys = ON", nullptr);
+
+    if (ok && result_->postings > 0) {
+        LedgerEvents::instance().notifyBulkChanged(LedgerEvents::Transactions);
+    }
+    return ok;
+}
+
+bool Generator::createAccounts()
+{
+    Database &db = Database::instance();
+
+    QHash<QString, int> ids;
+    QSqlQuery existing = db.executeCursor("SELECT code, id FROM accounts");
+    while (existing.next()) {
+        ids.insert(existing.value(0).toString(), existing.value(1).toInt());
+    }
+
+    QSqlQuery insert(db.threadDatabase());
+    if (!insert.prepare("INSERT INTO accounts (code, name, type, parent_id) VALUES (?, ?, ?, ?)")) {
+        return fail("Ошибка запроса: " + insert.lastError().text());
+    }
+
+    auto add = [&](const QString &code, const QString &name, int type, int parentId) {
+        if (ids.contains(code)) return true;
+        insert.bindValue(0, code);
+        insert.bindValue(1, name);
+        insert.bindValue(2, type);
+        insert.bindValue(3, parentId > 0 ? QVariant(parentId) : QVariant(QMetaType(QMetaType::Int)));
+        if (!insert.exec()) {
+            return fail("Счет " + code + ": " + insert.lastError().text());
+        }
+        const int id = insert.lastInsertId().toInt();
+        if (!AccountTree::insertAccount(id, parentId)) {
+            return fail("Счет " + code + ": не удалось обновить замыкание плана счетов");
+        }
+        ids.insert(code, id);
+        ++result_->accounts;
+        return true;
+    };
+
+    for (const ChartAccount &account : Chart) {
+        if (!add(account.code, QString::fromUtf8(account.name), account.type, 0)) return false;
+    }
+
+    // Подсчета по кругу: сначала XX.NN, после 99-го - третий уровень XX.NN.NNN
+    QHash<QString, int> children;
+    const int subaccounts = std::max(0, options_.accounts - ChartSize);
+    for (int j = 0; j < subaccounts; ++j) {
+        const ChartAccount &top = Chart[j % ChartSize];
+        const QString topCode = top.code;
+        const int k = ++children[topCode];
+
+        QString parentCode = topCode;
+        QString code;
+        if (k <= 99) {
+            code = QString("%1.%2").arg(topCode).arg(k, 2, 10, QChar('0'));
+        } else {
+            parentCode = QString("%1.%2").arg(topCode).arg((k - 100) % 99 + 1, 2, 10, QChar('0'));
+            code = QString("%1.%2").arg(parentCode).arg(++children[parentCode], 3, 10, QChar('0'));
+        }
+        const QString name = QString("%1, субсчет %2")
+                             .arg(QString::fromUtf8(top.name), code.mid(topCode.size() + 1));
+        if (!add(code, name, top.type, ids.value(parentCode))) return false;
+    }
+    return true;
+}
+
+bool Generator::createCounterparties()
+{
+    static const char *const forms[] = {"ООО", "ООО", "АО", "ПАО"};
+    static const char *const words[] = {"Альфа", "Вектор", "Гранит", "Дельта", "Интеграл",
+                                        "Континент", "Меридиан", "Орион", "Прогресс", "Сигма",
+                                        "Спектр", "Техно", "Форвард", "Эталон"};
+    static const char *const suffixes[] = {"Трейд", "Снаб", "Строй", "Логистик", "Сервис",
+                                           "Пром", "Инвест"};
+    static const int regions[] = {77, 78, 50, 66, 54, 16, 52, 23, 63, 74};
+
+    // Семь цифр ИНН - взаимно однозначная перестановка номера, ИНН не повторяются
+    const int count = std::min(options_.counterparties, 9000000);
+
+    QSqlQuery insert(Database::instance().threadDatabase());
+    if (!insert.prepare("INSERT OR IGNORE INTO counterparties (name, inn, kpp) VALUES (?, ?, ?)")) {
+        return fail("Ошибка запроса: " + insert.lastError().text());
+    }
+
+    for (int i = 0; i < count; ++i) {
+        const int region = regions[rng_.bounded(int(sizeof(regions) / sizeof(regions[0])))];
+        const qint64 serial = 1000000 + (qint64(i) * 7919 + options_.seed) % 9000000;
+        const QString name = QString("%1 \"%2%3-%4\"")
+            .arg(QString::fromUtf8(forms[rng_.bounded(4)]),
+                 QString::fromUtf8(words[rng_.bounded(int(sizeof(words) / sizeof(words[0])))]),
+                 QString::fromUtf8(suffixes[rng_.bounded(int(sizeof(suffixes) / sizeof(suffixes[0])))]))
+            .arg(i + 1);
+
+        insert.bindValue(0, name);
+        // ИНН организации: 9 цифр и контрольная
+        const QString innBody = QString("%1").arg(region * 10000000LL + serial, 9, 10, QChar('0'));
+        insert.bindValue(1, ValidationRules::completeINN(innBody));
+        insert.bindValue(2, QString("%1%2").arg(region).arg("0101001"));
+        if (!insert.exec()) {
+            return fail("Контрагент " + name + ": " + insert.lastError().text());
+        }
+        result_->counterparties += insert.numRowsAffected();
+    }
+    return true;
+}
+
+bool Generator::loadLeaves()
+{
+    // Проводки идут только на листья: счет плана или его подсчета без детей
+    QStringList codes;
+    for (const ChartAccount &account : Chart) codes << QString("'%1'").arg(account.code);
+
+    QSqlQuery query = Database::instance().executeCursor(
+        "SELECT top.code, a.id FROM accounts top "
+        "JOIN account_closure cl ON cl.ancestor = top.id "
+        "JOIN accounts a ON a.id = cl.descendant "
+        "WHERE top.code IN (" + codes.join(", ") + ") "
+        "  AND NOT EXISTS (SELECT 1 FROM accounts c WHERE c.parent_id = a.id) "
+        "ORDER BY a.id");
+    if (query.lastError().isValid()) {
+        return fail("Ошибка запроса: " + query.lastError().text());
+    }
+    while (query.next()) {
+        leaves_[query.value(0).toString()].append(query.value(1).toInt());
+    }
+
+    QSqlQuery counterparties = Database::instance().executeCursor(
+        "SELECT id FROM counterparties ORDER BY id");
+    while (counterparties.next()) {
+        counterpartyIds_.append(counterparties.value(0).toInt());
+    }
+    return true;
+}
+
+bool Generator::detachTransactionSchema()
+{
+    // Построчные триггеры (account_balances, ledger_state, ledger_months) и
+    // индексы на вставке десятков миллионов строк стоят дороже самой
+    // вставки; их DDL сохраняется и выполняется заново после загрузки
+    QSqlQuery schema = Database::instance().executeQuery(
+        "SELECT type, name, sql FROM sqlite_master "
+        "WHERE tbl_name = 'transactions' AND type IN ('trigger', 'index') AND sql IS NOT NULL");
+    QStringList drops;
+    QStringList definitions;
+    while (schema.next()) {
+        drops << QString("DROP %1 %2").arg(schema.value(0).toString().toUpper(),
+                                           schema.value(1).toString());
+        definitions << schema.value(2).toString();
+    }
+
+    // Восстанавливается только то, что действительно снято
+    for (int i = 0; i < drops.size(); ++i) {
+        if (!exec(drops.at(i), error_)) return false;
+        detached_ << definitions.at(i);
+    }
+    return true;
+}
+
+bool Generator::restoreTransactionSchema()
+{
+    Database &db = Database::instance();
+    if (!db.beginTransaction()) return fail("Не удалось начать транзакцию");
+
+    // Сначала пересчет того, что вели бы снятые триггеры, затем сами триггеры
+    QStringList statements = {
+        "DELETE FROM account_balances",
+        "INSERT INTO account_balances (account_id, debit_total, credit_total) "
+        "SELECT account_id, SUM(debit), SUM(credit) FROM ("
+        "  SELECT debit_account_id AS account_id, amount AS debit, 0 AS credit FROM transactions "
+        "  UNION ALL "
+        "  SELECT credit_account_id, 0, amount FROM transactions"
+        ") GROUP BY account_id",
+        "UPDATE ledger_state SET write_version = write_version + 1 WHERE id = 1",
+        "INSERT INTO ledger_months (month, version) "
+        "SELECT strftime('%Y-%m', transaction_date), "
+        "       (SELECT write_version FROM ledger_state WHERE id = 1) "
+        "FROM transactions WHERE true GROUP BY 1 "
+        "ON CONFLICT(month) DO UPDATE SET version = excluded.version"
+    };
+    statements << detached_;
+
+    for (const QString &statement : statements) {
+        if (!exec(statement, error_)) {
+            db.rollbackTransaction();
+            qCritical() << "Ledger generator: failed to restore schema:" << statement;
+            return false;
+        }
+    }
+    detached_.clear();
+    return db.commitTransaction() || fail("Не удалось завершить транзакцию");
+}
+
+bool Generator::insertPostings(const QDate &from, const QDate &to)
+{
+    Database &db = Database::instance();
+
+    // Вес дня: выходные почти пустые, в конце месяца - закрытие периода
+    QVector<QString> dates;
+    QVector<double> cumulative;
+    double total = 0.0;
+    for (QDate date = from; date <= to; date = date.addDays(1)) {
+        double weight = date.dayOfWeek() >= 6 ? 0.1 : 1.0;
+        if (date.day() > date.daysInMonth() - 3) weight *= 2.5;
+        else if (date.day() <= 5) weight *= 1.3;
+        total += weight;
+        dates.append(date.toString(Qt::ISODate));
+        cumulative.append(total);
+    }
+
+    // Корреспонденции, у которых есть счета в плане
+    WeightedChoice choice;
+    QVector<const QVector<int> *> debits;
+    QVector<const QVector<int> *> credits;
+    QVector<QString> texts;
+    QVector<QString> prefixes;
+    for (const Flow &flow : Flows) {
+        const QVector<int> *debit = &leaves_[flow.debit];
+        const QVector<int> *credit = &leaves_[flow.credit];
+        choice.add(debit->isEmpty() || credit->isEmpty() ? 0.0 : flow.weight);
+        debits.append(debit);
+        credits.append(credit);
+        texts.append(QString::fromUtf8(flow.text));
+        prefixes.append(flow.document ? QString::fromUtf8(flow.document) : QString());
+    }
+    QVector<qint64> documentNumbers(FlowCount, 0);
+
+    QString values = "(?, ?, ?, ?, ?, ?, ?, ?)";
+    QStringList rows;
+    for (int i = 0; i < RowsPerStatement; ++i) rows << values;
+    const QString insertSql = "INSERT INTO transactions ("
+                              "transaction_date, debit_account_id, credit_account_id, "
+                              "amount, description, document_number, document_date, "
+                              "counterparty_id) VALUES ";
+
+    QSqlQuery bulk(db.threadDatabase());
+    QSqlQuery single(db.threadDatabase());
+    if (!bulk.prepare(insertSql + rows.join(", ")) || !single.prepare(insertSql + values)) {
+        return fail("Ошибка запроса: " + bulk.lastError().text() + single.lastError().text());
+    }
+
+    if (progress_) progress_->setTotal(options_.postings);
+    if (!db.beginTransaction()) return fail("Не удалось начать транзакцию");
+
+    const QVariant noDate(QMetaType(QMetaType::QDate));
+    const QVariant noCounterparty(QMetaType(QMetaType::Int));
+    QVariantList pending;
+    pending.reserve(RowsPerStatement * ColumnCount);
+    qint64 committed = 0;
+
+    auto flush = [&](bool full) {
+        if (full) {
+            for (int i = 0; i < pending.size(); ++i) bulk.bindValue(i, pending.at(i));
+            if (!bulk.exec()) return fail("Ошибка записи: " + bulk.lastError().text());
+        } else {
+            for (int row = 0; row < pending.size(); row += ColumnCount) {
+                for (int i = 0; i < ColumnCount; ++i) single.bindValue(i, pending.at(row + i));
+                if (!single.exec()) return fail("Ошибка записи: " + single.lastError().text());
+            }
+        }
+        result_->postings += pending.size() / ColumnCount;
+        pending.clear();
+        return true;
+    };
+
+    // Число проводок дня - по доле его веса, с переносом остатка: ровно K
+    // проводок, в порядке дат, как в настоящем журнале
+    qint64 written = 0;
+    for (int day = 0; day < dates.size() && written < options_.postings; ++day) {
+        const qint64 upTo = qint64(std::floor(double(options_.postings) * cumulative.at(day) / total));
+        const qint64 dayEnd = day == dates.size() - 1 ? options_.postings : std::min(upTo, options_.postings);
+        for (; written < dayEnd; ++written) {
+            const int f = choice.pick(rng_);
+            const Flow &flow = Flows[f];
+            const QVector<int> &debit = *debits.at(f);
+            const QVector<int> &credit = *credits.at(f);
+
+            // Логнормальная сумма; треть - круглые суммы
+            double amount = flow.median * std::exp(0.9 * normal(rng_));
+            amount = std::clamp(amount, 1.0, 1e8);
+            amount = rng_.bounded(3) == 0 ? std::max(100.0, std::round(amount / 100.0) * 100.0)
+                                          : std::round(amount * 100.0) / 100.0;
+
+            // Крупные контрагенты встречаются чаще: u^3 сгущает выбор к началу
+            QVariant counterparty = noCounterparty;
+            if (flow.counterparty && !counterpartyIds_.isEmpty()) {
+                const double u = rng_.generateDouble();
+                const int index = std::min(int(counterpartyIds_.size() * u * u * u),
+                                           int(counterpartyIds_.size()) - 1);
+                counterparty = counterpartyIds_.at(index);
+            }
+
+            const QString &prefix = prefixes.at(f);
+            pending << dates.at(day)
+                    << debit.at(rng_.bounded(int(debit.size())))
+                    << credit.at(rng_.bounded(int(credit.size())))
+                    << amount
+                    << texts.at(f);
+            if (prefix.isEmpty()) {
+                pending << QString() << noDate;
+            } else {
+                pending << QString("%1-%2").arg(prefix).arg(++documentNumbers[f], 6, 10, QChar('0'))
+                        << dates.at(day);
+            }
+            pending << counterparty;
+
+            if (pending.size() == RowsPerStatement * ColumnCount) {
+                if (!flush(true)) {
+                    db.rollbackTransaction();
+                    return false;
+                }
+                if (result_->postings - committed >= CommitRows) {
+                    if (!db.commitTransaction() || !db.beginTransaction()) {
+                        db.rollbackTransaction();
+                        return fail("Не удалось зафиксировать проводки");
+                    }
+                    committed = result_->postings;
+                }
+            }
+
+            if (progress_ && (written + 1) % ProgressStep == 0) {
+                progress_->setDone(written + 1);
+                if (progress_->isCancelled()) {
+                    db.rollbackTransaction();
+                    result_->postings = committed;
+                    return fail("Отменено");
+                }
+            }
+        }
+    }
+
+    if (!flush(false)) {
+        db.rollbackTransaction();
+        result_->postings = committed;
+        return false;
+    }
+    if (!db.commitTransaction()) {
+        db.rollbackTransaction();
+        result_->postings = committed;
+        return fail("Не удалось завершить транзакцию");
+    }
+    if (progress_) progress_->setDone(result_->postings);
+    return true;
+}
+
+}
+
+bool LedgerGenerator::generate(const Options &options, Result *result, QString *error,
+                               ExportProgress *progress)
+{
+    *result = Result();
+    if (!Database::instance().isInitialized()) {
+        if (error) *error = "База не открыта";
+        return false;
+    }
+
+    Generator generator(options, result, error, progress);
+    const bool ok = generator.run();
+    if (ok) {
+        qInfo() << "Generated" << result->accounts << "accounts," << result->counterparties
+                << "counterparties," << result->postings << "postings";
+    }
+    return ok;
+}
+
+bool LedgerGenerator::generateFile(const QString &fileName, const Options &options, Result *result,
+                                   QString *error, ExportProgress *progress)
+{
+    *result = Result();
+    Database &db = Database::instance();
+    if (db.isInitialized()) {
+        if (error) *error = "База уже открыта в этом процессе";
+        return false;
+    }
+
+    const QString partName = fileName + ".part";
+    removeFile(partName);
+    if (!db.initialize(partName.toStdString())) {
+        if (error) *error = "Не удалось создать базу " + partName;
+        removeFile(partName);
+        return false;
+    }
+    db.ensureSchema();
+
+    bool ok = generate(options, result, error, progress);
+    if (ok) {
+        // WAL сливается в основной файл: переименовывается один файл
+        QSqlQuery checkpoint = db.executeQuery("PRAGMA wal_checkpoint(TRUNCATE)");
+        if (checkpoint.lastError().isValid()) {
+            if (error) *error = "Ошибка контрольной точки: " + checkpoint.lastError().text();
+            ok = false;
+        }
+    }
+    db.database().close();
+
+    if (ok && !QFile::rename(partName, fileName)) {
+        if (error) *error = "Не удалось переименовать " + partName + " в " + fileName;
+        ok = false;
+    }
+    removeFile(partName);
+    return ok;
+}
+
+void LedgerGenerator::removeFile(const QString &fileName)
+{
+    for (const QString &suffix : {QString(), QString("-wal"), QString("-shm")}) {
+        QFile::remove(fileName + suffix);
+    }
+}
+
+QString LedgerGenerator::fingerprint(const Options &options)
+{
+    const QString canonical = QString("%1;%2;%3;%4;%5;%6;%7")
+        .arg(Version).arg(options.accounts).arg(options.counterparties)
+        .arg(options.postings).arg(options.seed)
+        .arg(options.from.toString(Qt::ISODate), options.to.toString(Qt::ISODate));
+    return QString::fromLatin1(QCryptographicHash::hash(canonical.toUtf8(), QCryptographicHash::Sha1)
+                               .toHex().left(10));
+}
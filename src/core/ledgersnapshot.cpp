@@ -0,0 +1,588 @@
+#include "core/ledgersnapshot.h"
+#include "core/database.h"
+#include "core/exportprogress.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTemporaryFile>
+#include <QVector>
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+#include <zlib.h>
+
+namespace {
+
+const char Magic[8] = {'L', 'M', 'S', 'N', 'A', 'P', '0', '1'};
+// 2: смещения строк - quint64, словарь строк больше 4 ГБ
+const quint32 FormatVersion = 2;
+const quint32 MaxSections = 64;
+const qint64 ProgressStep = 1000;
+
+enum SectionId : quint32 {
+    StringOffsets = 1,
+    StringData,
+    Accounts,
+    Counterparties,
+    PostingIds,
+    PostingDates,
+    PostingDebits,
+    PostingCredits,
+    PostingCounterparties,
+    PostingAmounts,
+    PostingDocuments,
+    PostingDescriptions,
+    LastSection = PostingDescriptions
+};
+
+struct Header {
+    char magic[8];
+    quint32 format;
+    quint32 headerSize;
+    qint64 ledgerVersion;
+    qint64 createdAt;
+    quint64 fileSize;
+    quint32 sectionCount;
+    quint32 checksum;       // CRC32 всего, что после заголовка
+    quint64 reserved[2];
+};
+
+struct Section {
+    quint32 id;
+    quint32 itemSize;
+    quint64 count;
+    quint64 offset;
+    quint64 size;
+};
+
+static_assert(sizeof(Header) == 64, "snapshot header layout");
+static_assert(sizeof(Section) == 32, "snapshot section layout");
+static_assert(sizeof(LedgerSnapshot::Account) == 20, "snapshot account layout");
+static_assert(sizeof(LedgerSnapshot::Counterparty) == 12, "snapshot counterparty layout");
+
+quint64 align8(quint64 value)
+{
+    return (value + 7) & ~quint64(7);
+}
+
+quint32 crc32Of(quint32 crc, const char *data, quint64 size)
+{
+    // crc32 принимает uInt: большие секции - частями
+    while (size > 0) {
+        const uInt chunk = uInt(qMin<quint64>(size, 1u << 30));
+        crc = quint32(crc32(crc, reinterpret_cast<const Bytef *>(data), chunk));
+        data += chunk;
+        size -= chunk;
+    }
+    return crc;
+}
+
+// Содержимое секции во временном файле рядом со снимком: столбцы проводок
+// и байты строк дописываются по мере чтения, в памяти - только буфер
+class Spill
+{
+public:
+    bool open(const QString &directory)
+    {
+        file_.setFileTemplate(QDir(directory).filePath(".lmsnap-XXXXXX"));
+        buffer_.reserve(BufferSize);
+        return file_.open();
+    }
+
+    template <typename T>
+    bool append(const T &value)
+    {
+        return write(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    bool write(const char *data, qint64 size)
+    {
+        buffer_.append(data, size);
+        size_ += quint64(size);
+        return buffer_.size() < BufferSize || flush();
+    }
+
+    bool flush()
+    {
+        const bool ok = buffer_.isEmpty() || file_.write(buffer_) == buffer_.size();
+        buffer_.resize(0);
+        return ok;
+    }
+
+    // Перед чтением всего содержимого с начала
+    bool rewind() { return flush() && file_.seek(0); }
+
+    quint64 size() const { return size_; }
+    QTemporaryFile &file() { return file_; }
+
+private:
+    static const int BufferSize = 1 << 20;
+
+    QTemporaryFile file_;
+    QByteArray buffer_;
+    quint64 size_ = 0;
+};
+
+// Словарь строк: номер 0 - пустая строка. Байты строк уходят в data,
+// в памяти - смещения и поиск одинаковых строк
+class StringDictionary
+{
+public:
+    explicit StringDictionary(Spill *data) : data_(data) { add(QString()); }
+
+    quint32 add(const QString &text)
+    {
+        auto it = ids_.constFind(text);
+        if (it != ids_.constEnd()) return it.value();
+
+        // Номер строки в столбцах проводок - quint32
+        if (quint64(offsets_.size()) > 0xFFFFFFFFull) {
+            failed_ = true;
+            return 0;
+        }
+        const quint32 id = quint32(offsets_.size() - 1);
+        const QByteArray utf8 = text.toUtf8();
+        if (!data_->write(utf8.constData(), utf8.size())) failed_ = true;
+        offsets_.append(data_->size());
+        ids_.insert(text, id);
+        return id;
+    }
+
+    bool failed() const { return failed_; }
+    const QVector<quint64> &offsets() const { return offsets_; }
+
+private:
+    Spill *data_;
+    QHash<QString, quint32> ids_;
+    QVector<quint64> offsets_{0};
+    bool failed_ = false;
+};
+
+// Секция перед записью: байты в памяти (data) или во временном файле (spill)
+struct Chunk {
+    Section section;
+    const char *data;
+    Spill *spill;
+};
+
+template <typename T>
+Chunk chunk(SectionId id, const QVector<T> &values)
+{
+    return {{id, quint32(sizeof(T)), quint64(values.size()), 0, quint64(values.size()) * sizeof(T)},
+            reinterpret_cast<const char *>(values.constData()), nullptr};
+}
+
+Chunk chunk(SectionId id, quint32 itemSize, Spill *spill)
+{
+    return {{id, itemSize, spill->size() / itemSize, 0, spill->size()}, nullptr, spill};
+}
+
+bool setError(QString *error, const QString &message)
+{
+    if (error) *error = message;
+    qWarning() << "Ledger snapshot failed:" << message;
+    return false;
+}
+
+}
+
+bool LedgerSnapshot::write(const QString &fileName, QString *error, ExportProgress *progress)
+{
+#if Q_BYTE_ORDER != Q_LITTLE_ENDIAN
+    return setError(error, "Снимок журнала пишется только на little-endian");
+#endif
+
+    Database &database = Database::instance();
+
+    // Свое чтение - в одной транзакции (в фоновой выгрузке она уже открыта)
+    QSqlDatabase db = database.threadDatabase();
+    const bool ownTransaction = db.isOpen() && db.transaction();
+    struct Rollback {
+        QSqlDatabase &db;
+        bool active;
+        ~Rollback() { if (active) db.rollback(); }
+    } rollback{db, ownTransaction};
+
+    // Столбцы проводок и байты строк копятся во временных файлах рядом со
+    // снимком: память не зависит от размера журнала
+    const QString directory = QFileInfo(fileName).absolutePath();
+    Spill spills[LastSection + 1];
+    for (SectionId id : {StringData, PostingIds, PostingDates, PostingDebits, PostingCredits,
+                         PostingCounterparties, PostingAmounts, PostingDocuments, PostingDescriptions}) {
+        if (!spills[id].open(directory)) {
+            return setError(error, spills[id].file().errorString());
+        }
+    }
+
+    const qint64 ledgerVersion = database.ledgerVersion();
+    StringDictionary strings(&spills[StringData]);
+
+    QVector<Account> accounts;
+    QHash<int, int> accountIndex;
+    QVector<int> accountParentIds;
+    QSqlQuery accountsQuery = database.executeCursor(
+        "SELECT id, code, name, type, parent_id FROM accounts ORDER BY code");
+    if (accountsQuery.lastError().isValid()) {
+        return setError(error, "Ошибка запроса: " + accountsQuery.lastError().text());
+    }
+    while (accountsQuery.next()) {
+        Account account;
+        account.id = accountsQuery.value(0).toInt();
+        account.parent = -1;
+        account.type = accountsQuery.value(3).toInt();
+        account.code = strings.add(accountsQuery.value(1).toString());
+        account.name = strings.add(accountsQuery.value(2).toString());
+        accountIndex.insert(account.id, accounts.size());
+        accountParentIds.append(accountsQuery.value(4).isNull() ? -1 : accountsQuery.value(4).toInt());
+        accounts.append(account);
+    }
+    for (int i = 0; i < accounts.size(); ++i) {
+        accounts[i].parent = accountIndex.value(accountParentIds.at(i), -1);
+    }
+
+    QVector<Counterparty> counterparties;
+    QHash<int, int> counterpartyIndex;
+    QSqlQuery counterpartiesQuery = database.executeCursor(
+        "SELECT id, name, inn FROM counterparties ORDER BY id");
+    if (counterpartiesQuery.lastError().isValid()) {
+        return setError(error, "Ошибка запроса: " + counterpartiesQuery.lastError().text());
+    }
+    while (counterpartiesQuery.next()) {
+        Counterparty counterparty;
+        counterparty.id = counterpartiesQuery.value(0).toInt();
+        counterparty.name = strings.add(counterpartiesQuery.value(1).toString());
+        counterparty.inn = strings.add(counterpartiesQuery.value(2).toString());
+        counterpartyIndex.insert(counterparty.id, counterparties.size());
+        counterparties.append(counterparty);
+    }
+
+    if (progress) {
+        QSqlQuery count = database.executeQuery("SELECT COUNT(*) FROM transactions");
+        if (count.next()) progress->setTotal(count.value(0).toLongLong());
+    }
+
+    // Даты в базе - текст ГГГГ-ММ-ДД, поэтому порядок строк совпадает
+    // с порядком дат и столбец дат получается отсортированным
+    QSqlQuery postings = database.executeCursor(
+        "SELECT id, transaction_date, debit_account_id, credit_account_id, "
+        "       counterparty_id, amount, document_number, description "
+        "FROM transactions ORDER BY transaction_date, id");
+    if (postings.lastError().isValid()) {
+        return setError(error, "Ошибка запроса: " + postings.lastError().text());
+    }
+    qint64 rows = 0;
+    while (postings.next()) {
+        const QDate date = postings.value(1).toDate();
+        if (!date.isValid()) {
+            return setError(error, QString("Проводка %1: неверная дата %2")
+                            .arg(postings.value(0).toLongLong())
+                            .arg(postings.value(1).toString()));
+        }
+
+        const qint32 counterparty = postings.value(4).isNull()
+            ? -1 : counterpartyIndex.value(postings.value(4).toInt(), -1);
+        const bool ok = spills[PostingIds].append(postings.value(0).toLongLong())
+            && spills[PostingDates].append(qint32(date.toJulianDay()))
+            && spills[PostingDebits].append(qint32(accountIndex.value(postings.value(2).toInt(), -1)))
+            && spills[PostingCredits].append(qint32(accountIndex.value(postings.value(3).toInt(), -1)))
+            && spills[PostingCounterparties].append(counterparty)
+            && spills[PostingAmounts].append(postings.value(5).toDouble())
+            && spills[PostingDocuments].append(strings.add(postings.value(6).toString()))
+            && spills[PostingDescriptions].append(strings.add(postings.value(7).toString()));
+        if (!ok) {
+            return setError(error, "Не удалось записать временный файл снимка");
+        }
+        ++rows;
+
+        if (progress && rows % ProgressStep == 0) {
+            progress->setDone(rows);
+            if (progress->isCancelled()) {
+                return setError(error, "Выгрузка отменена");
+            }
+        }
+    }
+    if (postings.lastError().isValid()) {
+        return setError(error, "Ошибка чтения проводок: " + postings.lastError().text());
+    }
+    if (strings.failed()) {
+        return setError(error, "Не удалось записать словарь строк снимка");
+    }
+
+    QVector<Chunk> chunks = {
+        chunk(Accounts, accounts),
+        chunk(Counterparties, counterparties),
+        chunk(PostingIds, sizeof(qint64), &spills[PostingIds]),
+        chunk(PostingDates, sizeof(qint32), &spills[PostingDates]),
+        chunk(PostingDebits, sizeof(qint32), &spills[PostingDebits]),
+        chunk(PostingCredits, sizeof(qint32), &spills[PostingCredits]),
+        chunk(PostingCounterparties, sizeof(qint32), &spills[PostingCounterparties]),
+        chunk(PostingAmounts, sizeof(double), &spills[PostingAmounts]),
+        chunk(PostingDocuments, sizeof(quint32), &spills[PostingDocuments]),
+        chunk(PostingDescriptions, sizeof(quint32), &spills[PostingDescriptions]),
+        chunk(StringData, 1, &spills[StringData]),
+        chunk(StringOffsets, strings.offsets())
+    };
+
+    // Раскладка: заголовок, таблица секций, секции с выравниванием на 8
+    QVector<Section> table;
+    quint64 offset = align8(sizeof(Header) + chunks.size() * sizeof(Section));
+    for (Chunk &c : chunks) {
+        c.section.offset = offset;
+        offset = align8(offset + c.section.size);
+        table.append(c.section);
+    }
+    const quint64 fileSize = offset;
+
+    Header header = {};
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.format = FormatVersion;
+    header.headerSize = sizeof(Header);
+    header.ledgerVersion = ledgerVersion;
+    header.createdAt = QDateTime::currentMSecsSinceEpoch();
+    header.fileSize = fileSize;
+    header.sectionCount = quint32(table.size());
+
+    // QSaveFile: до commit() старый снимок с тем же именем остается целым.
+    // CRC считается по ходу записи, заголовок с ним пишется последним
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return setError(error, file.errorString());
+    }
+
+    quint32 crc = quint32(crc32(0, nullptr, 0));
+    auto put = [&](const char *data, quint64 size) {
+        crc = crc32Of(crc, data, size);
+        return file.write(data, qint64(size)) == qint64(size);
+    };
+
+    const char zeros[8] = {};
+    const quint64 tableSize = quint64(table.size()) * sizeof(Section);
+    const quint64 tablePadding = chunks.first().section.offset - sizeof(Header) - tableSize;
+    bool ok = file.write(reinterpret_cast<const char *>(&header), sizeof(Header)) == qint64(sizeof(Header))
+           && put(reinterpret_cast<const char *>(table.constData()), tableSize)
+           && put(zeros, tablePadding);
+
+    QByteArray block;
+    for (const Chunk &c : chunks) {
+        if (!ok) break;
+        if (c.spill) {
+            QTemporaryFile &spill = c.spill->file();
+            ok = c.spill->rewind();
+            for (quint64 left = c.section.size; ok && left > 0; left -= quint64(block.size())) {
+                block = spill.read(qint64(qMin<quint64>(left, 1 << 20)));
+                ok = !block.isEmpty() && put(block.constData(), quint64(block.size()));
+            }
+            spill.resize(0);
+        } else {
+            ok = put(c.data, c.section.size);
+        }
+        ok = ok && put(zeros, align8(c.section.size) - c.section.size);
+    }
+
+    header.checksum = crc;
+    ok = ok && file.seek(0)
+         && file.write(reinterpret_cast<const char *>(&header), sizeof(Header)) == qint64(sizeof(Header));
+    if (!ok || !file.commit()) {
+        return setError(error, file.errorString());
+    }
+
+    if (progress) progress->setDone(rows);
+    return true;
+}
+
+LedgerSnapshot::LedgerSnapshot() = default;
+
+LedgerSnapshot::~LedgerSnapshot()
+{
+    close();
+}
+
+bool LedgerSnapshot::fail(const QString &message)
+{
+    qWarning() << "Ledger snapshot open failed:" << file_.fileName() << message;
+    close();
+    error_ = message;
+    return false;
+}
+
+bool LedgerSnapshot::open(const QString &fileName, const Options &options)
+{
+    close();
+    error_.clear();
+
+#if Q_BYTE_ORDER != Q_LITTLE_ENDIAN
+    return fail("Снимок журнала читается только на little-endian");
+#endif
+
+    file_.setFileName(fileName);
+    if (!file_.open(QIODevice::ReadOnly)) {
+        return fail(file_.errorString());
+    }
+
+    const qint64 size = file_.size();
+    if (size < qint64(sizeof(Header))) {
+        return fail("Файл не является снимком журнала");
+    }
+    map_ = file_.map(0, size);
+    if (!map_) {
+        return fail(file_.errorString());
+    }
+
+    Header header;
+    std::memcpy(&header, map_, sizeof(Header));
+    if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0) {
+        return fail("Файл не является снимком журнала");
+    }
+    if (header.format != FormatVersion && header.format != 1) {
+        return fail(QString("Неподдерживаемая версия снимка: %1").arg(header.format));
+    }
+    if (header.headerSize < sizeof(Header) || header.fileSize != quint64(size)
+        || header.sectionCount > MaxSections
+        || header.headerSize + quint64(header.sectionCount) * sizeof(Section) > quint64(size)) {
+        return fail("Снимок поврежден или обрезан");
+    }
+
+    if (options.verifyChecksum) {
+        const quint32 crc = crc32Of(quint32(crc32(0, nullptr, 0)),
+                                    reinterpret_cast<const char *>(map_) + header.headerSize,
+                                    quint64(size) - header.headerSize);
+        if (crc != header.checksum) {
+            return fail("Контрольная сумма снимка не совпадает");
+        }
+    }
+
+    // Размер элемента каждой известной секции; неизвестные пропускаются.
+    // В версии 1 смещения строк - quint32
+    const quint32 itemSizes[LastSection + 1] = {
+        0, header.format == 1 ? quint32(sizeof(quint32)) : quint32(sizeof(quint64)), 1,
+        sizeof(Account), sizeof(Counterparty),
+        sizeof(qint64), sizeof(qint32), sizeof(qint32), sizeof(qint32), sizeof(qint32),
+        sizeof(double), sizeof(quint32), sizeof(quint32)
+    };
+    const void *sections[LastSection + 1] = {};
+    quint64 counts[LastSection + 1] = {};
+
+    const uchar *tableData = map_ + header.headerSize;
+    for (quint32 i = 0; i < header.sectionCount; ++i) {
+        Section section;
+        std::memcpy(&section, tableData + i * sizeof(Section), sizeof(Section));
+        if (section.id == 0 || section.id > LastSection) continue;
+
+        if (section.itemSize != itemSizes[section.id] || section.offset % 8 != 0
+            || section.size != section.count * section.itemSize
+            || section.offset > quint64(size) || section.size > quint64(size) - section.offset) {
+            return fail(QString("Снимок поврежден: секция %1").arg(section.id));
+        }
+        sections[section.id] = map_ + section.offset;
+        counts[section.id] = section.count;
+    }
+
+    for (quint32 id = StringOffsets; id <= LastSection; ++id) {
+        if (!sections[id]) {
+            return fail(QString("В снимке нет секции %1").arg(id));
+        }
+    }
+
+    stringOffsets_ = sections[StringOffsets];
+    wideOffsets_ = header.format != 1;
+    stringData_ = static_cast<const char *>(sections[StringData]);
+    stringDataSize_ = counts[StringData];
+    stringCount_ = counts[StringOffsets] > 0 ? quint32(counts[StringOffsets] - 1) : 0;
+
+    accounts_ = static_cast<const Account *>(sections[Accounts]);
+    accountCount_ = int(counts[Accounts]);
+    counterparties_ = static_cast<const Counterparty *>(sections[Counterparties]);
+    counterpartyCount_ = int(counts[Counterparties]);
+
+    postingCount_ = qint64(counts[PostingIds]);
+    for (quint32 id = PostingDates; id <= PostingDescriptions; ++id) {
+        if (counts[id] != counts[PostingIds]) {
+            return fail("Снимок поврежден: столбцы проводок разной длины");
+        }
+    }
+    postingIds_ = static_cast<const qint64 *>(sections[PostingIds]);
+    postingDates_ = static_cast<const qint32 *>(sections[PostingDates]);
+    postingDebits_ = static_cast<const qint32 *>(sections[PostingDebits]);
+    postingCredits_ = static_cast<const qint32 *>(sections[PostingCredits]);
+    postingCounterparties_ = static_cast<const qint32 *>(sections[PostingCounterparties]);
+    postingAmounts_ = static_cast<const double *>(sections[PostingAmounts]);
+    postingDocuments_ = static_cast<const quint32 *>(sections[PostingDocuments]);
+    postingDescriptions_ = static_cast<const quint32 *>(sections[PostingDescriptions]);
+
+    ledgerVersion_ = header.ledgerVersion;
+    createdAt_ = header.createdAt;
+    return true;
+}
+
+void LedgerSnapshot::close()
+{
+    if (map_) {
+        file_.unmap(map_);
+        map_ = nullptr;
+    }
+    file_.close();
+
+    stringOffsets_ = nullptr;
+    wideOffsets_ = false;
+    stringData_ = nullptr;
+    stringDataSize_ = 0;
+    stringCount_ = 0;
+    accounts_ = nullptr;
+    accountCount_ = 0;
+    counterparties_ = nullptr;
+    counterpartyCount_ = 0;
+    postingCount_ = 0;
+    postingIds_ = nullptr;
+    postingDates_ = nullptr;
+    postingDebits_ = nullptr;
+    postingCredits_ = nullptr;
+    postingCounterparties_ = nullptr;
+    postingAmounts_ = nullptr;
+    postingDocuments_ = nullptr;
+    postingDescriptions_ = nullptr;
+    ledgerVersion_ = 0;
+    createdAt_ = 0;
+}
+
+QString LedgerSnapshot::string(quint32 id) const
+{
+    if (id >= stringCount_) return QString();
+
+    // Смещения не проверяются при открытии - проверка здесь
+    quint64 begin = 0;
+    quint64 end = 0;
+    if (wideOffsets_) {
+        begin = static_cast<const quint64 *>(stringOffsets_)[id];
+        end = static_cast<const quint64 *>(stringOffsets_)[id + 1];
+    } else {
+        begin = static_cast<const quint32 *>(stringOffsets_)[id];
+        end = static_cast<const quint32 *>(stringOffsets_)[id + 1];
+    }
+    if (begin > end || end > stringDataSize_) return QString();
+    return QString::fromUtf8(stringData_ + begin, qsizetype(end - begin));
+}
+
+int LedgerSnapshot::accountIndex(int accountId) const
+{
+    for (int i = 0; i < accountCount_; ++i) {
+        if (accounts_[i].id == accountId) return i;
+    }
+    return -1;
+}
+
+qint64 LedgerSnapshot::lowerBound(const QDate &date) const
+{
+    const qint32 day = qint32(date.toJulianDay());
+    return std::lower_bound(postingDates_, postingDates_ + postingCount_, day) - postingDates_;
+}
+
+qint64 LedgerSnapshot::upperBound(const QDate &date) const
+{
+    const qint32 day = qint32(date.toJulianDay());
+    return std::upper_bound(postingDates_, postingDates_ + postingCount_, day) - postingDates_;
+}
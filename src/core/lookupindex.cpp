@@ -0,0 +1,148 @@
+#include "core/lookupindex.h"
+#include "core/database.h"
+
+#include <QSqlQuery>
+#include <algorithm>
+
+QString LookupIndex::Item::displayText() const
+{
+    if (!code.isEmpty()) {
+        return QString("%1 - %2").arg(code, name);
+    }
+    return inn.isEmpty() ? name : QString("%1 (ИНН: %2)").arg(name, inn);
+}
+
+LookupIndex::LookupIndex(QVector<Item> items)
+    : items_(std::move(items))
+{
+    positionById_.reserve(items_.size());
+    codeKeys_.reserve(items_.size());
+    wordKeys_.reserve(items_.size() * 3);
+
+    for (int pos = 0; pos < items_.size(); ++pos) {
+        const Item &item = items_[pos];
+        positionById_.insert(item.id, pos);
+
+        if (!item.code.isEmpty()) {
+            codeKeys_.push_back({normalize(item.code), pos});
+        }
+        if (!item.inn.isEmpty()) {
+            innKeys_.push_back({item.inn.trimmed(), pos});
+        }
+
+        // Первый ключ - наименование целиком (чтобы искать по нескольким словам
+        // с начала), остальные - отдельные слова
+        QString name = normalize(item.name);
+        bool first = true;
+        int start = -1;
+        for (int i = 0; i <= name.size(); ++i) {
+            bool isWordChar = i < name.size() && name.at(i).isLetterOrNumber();
+            if (isWordChar && start < 0) {
+                start = i;
+            } else if (!isWordChar && start >= 0) {
+                wordKeys_.push_back({first ? name.mid(start) : name.mid(start, i - start), pos});
+                first = false;
+                start = -1;
+            }
+        }
+    }
+
+    sortKeys(codeKeys_);
+    sortKeys(innKeys_);
+    sortKeys(wordKeys_);
+}
+
+std::shared_ptr<LookupIndex> LookupIndex::loadAccounts()
+{
+    QVector<Item> items;
+    if (Database::instance().isInitialized()) {
+        QSqlQuery query = Database::instance().executeQuery(
+            "SELECT id, code, name FROM accounts ORDER BY code"
+        );
+        while (query.next()) {
+            Item item;
+            item.id = query.value(0).toInt();
+            item.code = query.value(1).toString();
+            item.name = query.value(2).toString();
+            items.append(item);
+        }
+    }
+    return std::make_shared<LookupIndex>(std::move(items));
+}
+
+std::shared_ptr<LookupIndex> LookupIndex::loadCounterparties()
+{
+    QVector<Item> items;
+    if (Database::instance().isInitialized()) {
+        QSqlQuery query = Database::instance().executeQuery(
+            "SELECT id, name, inn FROM counterparties ORDER BY name"
+        );
+        while (query.next()) {
+            Item item;
+            item.id = query.value(0).toInt();
+            item.name = query.value(1).toString();
+            item.inn = query.value(2).toString();
+            items.append(item);
+        }
+    }
+    return std::make_shared<LookupIndex>(std::move(items));
+}
+
+QVector<int> LookupIndex::search(const QString &prefix, int limit) const
+{
+    QVector<int> result;
+    if (limit <= 0) return result;
+
+    QString key = normalize(prefix.trimmed());
+    if (key.isEmpty()) {
+        int count = qMin(limit, items_.size());
+        result.reserve(count);
+        for (int pos = 0; pos < count; ++pos) {
+            result.append(pos);
+        }
+        return result;
+    }
+
+    // Один элемент может совпасть по нескольким ключам - выдаем его один раз
+    std::vector<bool> seen(items_.size(), false);
+    collect(codeKeys_, key, limit, result, seen);
+    collect(innKeys_, key, limit, result, seen);
+    collect(wordKeys_, key, limit, result, seen);
+    return result;
+}
+
+int LookupIndex::positionOf(int id) const
+{
+    return positionById_.value(id, -1);
+}
+
+QString LookupIndex::normalize(const QString &text)
+{
+    QString result = text.toCaseFolded();
+    result.replace(QChar(0x0451), QChar(0x0435)); // ё -> е
+    return result;
+}
+
+void LookupIndex::sortKeys(KeyList &keys)
+{
+    std::sort(keys.begin(), keys.end(), [](const Key &a, const Key &b) {
+        int cmp = QString::compare(a.text, b.text);
+        return cmp != 0 ? cmp < 0 : a.position < b.position;
+    });
+}
+
+void LookupIndex::collect(const KeyList &keys, const QString &prefix, int limit,
+                          QVector<int> &result, std::vector<bool> &seen)
+{
+    auto it = std::lower_bound(keys.begin(), keys.end(), prefix,
+        [](const Key &key, const QString &value) {
+            return QString::compare(key.text, value) < 0;
+        });
+
+    for (; it != keys.end() && result.size() < limit; ++it) {
+        if (!it->text.startsWith(prefix)) break;
+        if (seen[it->position]) continue;
+        seen[it->position] = true;
+        result.append(it->position);
+    }
+}
@@ -0,0 +1,230 @@
+#include "core/pdftablerenderer.h"
+
+#include <QPdfWriter>
+#include <QPainter>
+#include <QPageLayout>
+#include <QPageSize>
+#include <QFont>
+#include <QFontMetricsF>
+#include <QColor>
+#include <QPen>
+#include <QDebug>
+
+namespace {
+
+// Сколько первых строк учитывается при подборе ширины столбцов
+const int SampleRows = 200;
+
+}
+
+PdfTableRenderer::PdfTableRenderer(const QString &title, const QStringList &headers)
+    : title_(title)
+    , headers_(headers)
+{
+}
+
+QVector<double> PdfTableRenderer::fitColumns(const QVector<double> &natural, double width)
+{
+    // Узкие столбцы получают свою ширину целиком, остаток поровну делят
+    // широкие - так длинное описание не сжимает дату и суммы
+    QVector<double> widths(natural.size(), 0.0);
+    QVector<int> open;
+    for (int col = 0; col < natural.size(); ++col) {
+        open.append(col);
+    }
+
+    double remaining = width;
+    bool fixed = true;
+    while (fixed && !open.isEmpty()) {
+        fixed = false;
+        const double share = remaining / open.size();
+        for (int i = open.size() - 1; i >= 0; --i) {
+            int col = open.at(i);
+            if (natural.at(col) <= share) {
+                widths[col] = natural.at(col);
+                remaining -= natural.at(col);
+                open.removeAt(i);
+                fixed = true;
+            }
+        }
+    }
+
+    for (int col : open) {
+        widths[col] = remaining / open.size();
+    }
+
+    // Если все поместилось с запасом, растягиваем таблицу на всю ширину
+    double total = 0.0;
+    for (double w : widths) total += w;
+    if (open.isEmpty() && total > 0.0 && total < width) {
+        for (double &w : widths) w *= width / total;
+    }
+    return widths;
+}
+
+bool PdfTableRenderer::render(const QString &fileName, const RowSource &source, QString *error)
+{
+    pages_ = 0;
+    rows_ = 0;
+
+    if (fileName.isEmpty() || headers_.isEmpty()) {
+        if (error) *error = "Нет данных для экспорта";
+        return false;
+    }
+
+    const QStringList titleLines = title_.split('\n');
+
+    // QPdfWriter, а не QPrinter: рисованию не нужен ни QtWidgets,
+    // ни подсистема печати, отчет строится и без дисплея
+    QPdfWriter printer(fileName);
+    printer.setResolution(1200);
+    printer.setPageSize(QPageSize(QPageSize::A4));
+    printer.setPageOrientation(QPageLayout::Landscape);
+    printer.setPageMargins(QMarginsF(10, 10, 10, 10), QPageLayout::Millimeter);
+    printer.setCreator("LedgerMini");
+    printer.setTitle(titleLines.first());
+
+    QPainter painter;
+    if (!painter.begin(&printer)) {
+        if (error) *error = "Не удалось создать PDF файл: " + fileName;
+        return false;
+    }
+
+    const QRectF page(QPointF(0, 0),
+                      printer.pageLayout().paintRectPixels(printer.resolution()).size());
+
+    QFont bodyFont = painter.font();
+    bodyFont.setPointSizeF(8);
+    QFont boldFont = bodyFont;
+    boldFont.setBold(true);
+    QFont titleFont = bodyFont;
+    titleFont.setPointSizeF(14);
+    titleFont.setBold(true);
+    QFont subtitleFont = bodyFont;
+    subtitleFont.setPointSizeF(9);
+    subtitleFont.setItalic(true);
+
+    const QFontMetricsF metrics(boldFont, &printer);
+    const QFontMetricsF bodyMetrics(bodyFont, &printer);
+    const double padding = metrics.averageCharWidth() * 0.6;
+    const double rowHeight = metrics.height() * 1.5;
+    const double footerHeight = metrics.height() * 2;
+    const double bottom = page.height() - footerHeight;
+    const QPen gridPen(QColor(190, 190, 190), qMax(1.0, metrics.lineWidth()));
+
+    // Первые строки читаются заранее: по ним и шапке подбирается ширина
+    QVector<Row> sample;
+    Row row;
+    while (sample.size() < SampleRows && source(&row)) {
+        sample.append(row);
+    }
+
+    const int columns = headers_.size();
+    QVector<double> natural(columns, 0.0);
+    for (int col = 0; col < columns; ++col) {
+        natural[col] = metrics.horizontalAdvance(headers_.at(col));
+    }
+    for (const Row &sampleRow : sample) {
+        for (int col = 0; col < columns && col < sampleRow.cells.size(); ++col) {
+            natural[col] = qMax(natural[col], metrics.horizontalAdvance(sampleRow.cells.at(col)));
+        }
+    }
+    for (double &w : natural) w += 2 * padding;
+
+    const QVector<double> widths = fitColumns(natural, page.width());
+
+    auto drawCells = [&](const QStringList &cells, double y, bool header, bool emphasized) {
+        const QFontMetricsF &cellMetrics = header || emphasized ? metrics : bodyMetrics;
+        painter.setFont(header || emphasized ? boldFont : bodyFont);
+
+        double x = 0.0;
+        for (int col = 0; col < columns; ++col) {
+            QRectF cell(x, y, widths.at(col), rowHeight);
+            if (header) {
+                painter.fillRect(cell, QColor(230, 230, 230));
+            } else if (emphasized) {
+                painter.fillRect(cell, QColor(240, 240, 240));
+            }
+            painter.setPen(gridPen);
+            painter.drawRect(cell);
+
+            QString text = col < cells.size() ? cells.at(col) : QString();
+            QRectF textRect = cell.adjusted(padding, 0, -padding, 0);
+            Qt::Alignment align = !header && rightAligned_.contains(col)
+                ? Qt::AlignRight : Qt::AlignLeft;
+
+            painter.setPen(Qt::black);
+            painter.drawText(textRect, align | Qt::AlignVCenter,
+                             cellMetrics.elidedText(text, Qt::ElideRight, textRect.width()));
+            x += widths.at(col);
+        }
+    };
+
+    auto finishPage = [&]() {
+        painter.setFont(bodyFont);
+        painter.setPen(Qt::black);
+        painter.drawText(QRectF(0, bottom, page.width(), footerHeight),
+                         Qt::AlignRight | Qt::AlignBottom,
+                         QString("Страница %1").arg(pages_));
+    };
+
+    // Заголовок отчета - только на первой странице, шапка таблицы - на каждой
+    auto startPage = [&]() -> double {
+        if (pages_ > 0) {
+            finishPage();
+            printer.newPage();
+        }
+        ++pages_;
+
+        double y = 0.0;
+        if (pages_ == 1) {
+            for (int i = 0; i < titleLines.size(); ++i) {
+                const QFont &font = i == 0 ? titleFont : subtitleFont;
+                const double height = QFontMetricsF(font, &printer).height() * 1.4;
+                painter.setFont(font);
+                painter.setPen(Qt::black);
+                painter.drawText(QRectF(0, y, page.width(), height), Qt::AlignCenter,
+                                 titleLines.at(i));
+                y += height;
+            }
+            y += rowHeight * 0.5;
+        }
+
+        drawCells(headers_, y, true, false);
+        return y + rowHeight;
+    };
+
+    double y = startPage();
+    int sampleIndex = 0;
+    while (true) {
+        if (sampleIndex < sample.size()) {
+            row = sample.at(sampleIndex++);
+        } else {
+            if (!sample.isEmpty()) sample.clear();
+            if (!source(&row)) break;
+        }
+
+        if (y + rowHeight > bottom) {
+            y = startPage();
+        }
+        drawCells(row.cells, y, false, row.emphasized);
+        y += rowHeight;
+        ++rows_;
+    }
+
+    if (y + rowHeight > bottom) {
+        y = startPage();
+    }
+    painter.setFont(bodyFont);
+    painter.setPen(Qt::black);
+    painter.drawText(QRectF(0, y + rowHeight * 0.3, page.width(), rowHeight),
+                     Qt::AlignLeft | Qt::AlignVCenter,
+                     QString("Всего строк: %1").arg(rows_));
+    finishPage();
+
+    if (!painter.end()) {
+        if (error) *error = "Ошибка записи PDF файла: " + fileName;
+        return false;
+    }
+    return true;
+}
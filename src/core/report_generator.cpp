@@ -1,29 +1,124 @@
-#include "gui/reportwidget.h"
 #include "core/report_generator.h"
 #include "core/database.h"
+#include "core/ledgersnapshot.h"
+#include "core/reportcache.h"
 
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QDate>
 #include <QDebug>
-#include <QVBoxLayout>
-#include <QHBoxLayout>
-#include <QDateEdit>
-#include <QPushButton>
-#include <QTableView>
-#include <QStandardItemModel>
-#include <QLabel>
-#include <QHeaderView>
-#include <QMessageBox>
-#include <QFileDialog>
-#include <QTextStream>
-#include <QBrush>
-#include <QFont>
-#include <QDebug>
+
+namespace {
+
+// Начальное сальдо по виду счета; balance = дебет - кредит
+void setOpeningBalance(BalanceRecord &record, double openingBalance)
+{
+    // Для активных счетов: сальдо начальное по дебету
+    // Для пассивных: по кредиту
+    // Для активно-пассивных: зависит от разницы
+    if (record.accountType == 0) { // Активный
+        if (openingBalance >= 0) {
+            record.openingDebit = openingBalance;
+        } else {
+            record.openingCredit = -openingBalance;
+        }
+    } else if (record.accountType == 1) { // Пассивный
+        if (openingBalance <= 0) {
+            record.openingCredit = -openingBalance;
+        } else {
+            record.openingDebit = openingBalance;
+        }
+    } else { // Активно-пассивный
+        if (openingBalance >= 0) {
+            record.openingDebit = openingBalance;
+        } else {
+            record.openingCredit = -openingBalance;
+        }
+    }
+}
+
+void setClosingBalance(BalanceRecord &record)
+{
+    // Для активных счетов: Конечное = НачальноеДебет + ОборотДебет - ОборотКредит
+    // Для пассивных: Конечное = НачальноеКредит + ОборотКредит - ОборотДебет
+    if (record.accountType == 0) { // Активный
+        double closingBalance = record.openingDebit + record.turnoverDebit - record.turnoverCredit;
+        if (closingBalance >= 0) {
+            record.closingDebit = closingBalance;
+        } else {
+            record.closingCredit = -closingBalance;
+        }
+    } else if (record.accountType == 1) { // Пассивный
+        double closingBalance = record.openingCredit + record.turnoverCredit - record.turnoverDebit;
+        if (closingBalance >= 0) {
+            record.closingCredit = closingBalance;
+        } else {
+            record.closingDebit = -closingBalance;
+        }
+    } else { // Активно-пассивный
+        double closingBalance = (record.openingDebit - record.openingCredit) + 
+                               (record.turnoverDebit - record.turnoverCredit);
+        if (closingBalance >= 0) {
+            record.closingDebit = closingBalance;
+        } else {
+            record.closingCredit = -closingBalance;
+        }
+    }
+}
+
+// Итоговая строка ведомости
+void appendTotalRow(QVector<BalanceRecord> &report)
+{
+    if (report.isEmpty()) return;
+    
+    BalanceRecord totalRecord;
+    totalRecord.accountCode = "";
+    totalRecord.accountName = "ИТОГО:";
+    for (const BalanceRecord &record : report) {
+        totalRecord.openingDebit += record.openingDebit;
+        totalRecord.openingCredit += record.openingCredit;
+        totalRecord.turnoverDebit += record.turnoverDebit;
+        totalRecord.turnoverCredit += record.turnoverCredit;
+        totalRecord.closingDebit += record.closingDebit;
+        totalRecord.closingCredit += record.closingCredit;
+    }
+    
+    report.append(totalRecord);
+}
+
+}
 
 ReportGenerator::ReportGenerator(QObject *parent) : QObject(parent) {}
 
 QVector<BalanceRecord> ReportGenerator::generateBalanceReport(const QDate &startDate, const QDate &endDate)
+{
+    // Повторное открытие той же ведомости - чтение одного файла кэша
+    const QVariantList key = {startDate, endDate};
+    QByteArray cached;
+    if (ReportCache::instance().lookup(ReportCache::BalanceReport, key, endDate, &cached)) {
+        QVector<BalanceRecord> report;
+        QDataStream stream(cached);
+        stream.setVersion(QDataStream::Qt_6_0);
+        stream >> report;
+        if (stream.status() == QDataStream::Ok) return report;
+    }
+    
+    // Версия читается до расчета: запись, попавшая между ними, только
+    // заставит перепроверить кэш, но не оставит в нем устаревший отчет
+    const qint64 version = Database::instance().ledgerVersion();
+    QVector<BalanceRecord> report = computeBalanceReport(startDate, endDate);
+    
+    if (!report.isEmpty()) {
+        QByteArray payload;
+        QDataStream stream(&payload, QIODevice::WriteOnly);
+        stream.setVersion(QDataStream::Qt_6_0);
+        stream << report;
+        ReportCache::instance().insert(ReportCache::BalanceReport, key, version, payload);
+    }
+    return report;
+}
+
+QVector<BalanceRecord> ReportGenerator::computeBalanceReport(const QDate &startDate, const QDate &endDate)
 {
     QVector<BalanceRecord> report;
     
@@ -43,13 +138,6 @@ QVector<BalanceRecord> ReportGenerator::generateBalanceReport(const QDate &start
         return report;
     }
     
-    double totalOpeningDebit = 0.0;
-    double totalOpeningCredit = 0.0;
-    double totalTurnoverDebit = 0.0;
-    double totalTurnoverCredit = 0.0;
-    double totalClosingDebit = 0.0;
-    double totalClosingCredit = 0.0;
-    
     while (accountsQuery.next()) {
         int accountId = accountsQuery.value(0).toInt();
         BalanceRecord record;
@@ -74,30 +162,7 @@ QVector<BalanceRecord> ReportGenerator::generateBalanceReport(const QDate &start
             double totalDebit = openingQuery.value(0).toDouble();
             double totalCredit = openingQuery.value(1).toDouble();
             
-            // Для активных счетов: сальдо начальное по дебету
-            // Для пассивных: по кредиту
-            // Для активно-пассивных: зависит от разницы
-            double openingBalance = totalDebit - totalCredit;
-            
-            if (record.accountType == 0) { // Активный
-                if (openingBalance >= 0) {
-                    record.openingDebit = openingBalance;
-                } else {
-                    record.openingCredit = -openingBalance;
-                }
-            } else if (record.accountType == 1) { // Пассивный
-                if (openingBalance <= 0) {
-                    record.openingCredit = -openingBalance;
-                } else {
-                    record.openingDebit = openingBalance;
-                }
-            } else { // Активно-пассивный
-                if (openingBalance >= 0) {
-                    record.openingDebit = openingBalance;
-                } else {
-                    record.openingCredit = -openingBalance;
-                }
-            }
+            setOpeningBalance(record, totalDebit - totalCredit);
         }
         
         // 2. Рассчитываем обороты за период
@@ -116,58 +181,71 @@ QVector<BalanceRecord> ReportGenerator::generateBalanceReport(const QDate &start
         }
         
         // 3. Рассчитываем конечное сальдо
-        // Для активных счетов: Конечное = НачальноеДебет + ОборотДебет - ОборотКредит
-        // Для пассивных: Конечное = НачальноеКредит + ОборотКредит - ОборотДебет
-        if (record.accountType == 0) { // Активный
-            double closingBalance = record.openingDebit + record.turnoverDebit - record.turnoverCredit;
-            if (closingBalance >= 0) {
-                record.closingDebit = closingBalance;
-            } else {
-                record.closingCredit = -closingBalance;
-            }
-        } else if (record.accountType == 1) { // Пассивный
-            double closingBalance = record.openingCredit + record.turnoverCredit - record.turnoverDebit;
-            if (closingBalance >= 0) {
-                record.closingCredit = closingBalance;
-            } else {
-                record.closingDebit = -closingBalance;
-            }
-        } else { // Активно-пассивный
-            double closingBalance = (record.openingDebit - record.openingCredit) + 
-                                   (record.turnoverDebit - record.turnoverCredit);
-            if (closingBalance >= 0) {
-                record.closingDebit = closingBalance;
-            } else {
-                record.closingCredit = -closingBalance;
-            }
-        }
-        
-        // Суммируем для итоговой строки
-        totalOpeningDebit += record.openingDebit;
-        totalOpeningCredit += record.openingCredit;
-        totalTurnoverDebit += record.turnoverDebit;
-        totalTurnoverCredit += record.turnoverCredit;
-        totalClosingDebit += record.closingDebit;
-        totalClosingCredit += record.closingCredit;
+        setClosingBalance(record);
         
         report.append(record);
     }
     
-    // Добавляем итоговую строку
-    if (!report.isEmpty()) {
-        BalanceRecord totalRecord;
-        totalRecord.accountCode = "";
-        totalRecord.accountName = "ИТОГО:";
-        totalRecord.openingDebit = totalOpeningDebit;
-        totalRecord.openingCredit = totalOpeningCredit;
-        totalRecord.turnoverDebit = totalTurnoverDebit;
-        totalRecord.turnoverCredit = totalTurnoverCredit;
-        totalRecord.closingDebit = totalClosingDebit;
-        totalRecord.closingCredit = totalClosingCredit;
+    appendTotalRow(report);
+    
+    return report;
+}
+
+QVector<BalanceRecord> ReportGenerator::generateBalanceReport(const LedgerSnapshot &snapshot,
+                                                              const QDate &startDate,
+                                                              const QDate &endDate)
+{
+    QVector<BalanceRecord> report;
+    
+    if (!snapshot.isOpen()) return report;
+    if (startDate > endDate) {
+        qWarning() << "Дата начала позже даты окончания";
+        return report;
+    }
+    
+    // Один проход по столбцам проводок вместо двух запросов на каждый счет:
+    // проводки до startDate идут в начальное сальдо, [startDate, endDate] - в обороты
+    const int accountCount = snapshot.accountCount();
+    QVector<double> openingDebit(accountCount), openingCredit(accountCount);
+    QVector<double> turnoverDebit(accountCount), turnoverCredit(accountCount);
+    
+    const qint64 first = snapshot.lowerBound(startDate);
+    const qint64 last = snapshot.upperBound(endDate);
+    const qint32 *debits = snapshot.postingDebits();
+    const qint32 *credits = snapshot.postingCredits();
+    const double *amounts = snapshot.postingAmounts();
+    
+    auto accumulate = [&](qint64 from, qint64 to, QVector<double> &debit, QVector<double> &credit) {
+        for (qint64 i = from; i < to; ++i) {
+            // Индексы из файла: проверка дешевле, чем разбор при открытии
+            const quint32 d = quint32(debits[i]);
+            const quint32 c = quint32(credits[i]);
+            if (d < quint32(accountCount)) debit[d] += amounts[i];
+            if (c < quint32(accountCount)) credit[c] += amounts[i];
+        }
+    };
+    accumulate(0, first, openingDebit, openingCredit);
+    accumulate(first, last, turnoverDebit, turnoverCredit);
+    
+    // Счета в снимке уже в порядке кодов, как в запросе ORDER BY code
+    report.reserve(accountCount + 1);
+    const LedgerSnapshot::Account *accounts = snapshot.accounts();
+    for (int i = 0; i < accountCount; ++i) {
+        BalanceRecord record;
+        record.accountCode = snapshot.string(accounts[i].code);
+        record.accountName = snapshot.string(accounts[i].name);
+        record.accountType = accounts[i].type;
         
-        report.append(totalRecord);
+        setOpeningBalance(record, openingDebit.at(i) - openingCredit.at(i));
+        record.turnoverDebit = turnoverDebit.at(i);
+        record.turnoverCredit = turnoverCredit.at(i);
+        setClosingBalance(record);
+        
+        report.append(record);
     }
     
+    appendTotalRow(report);
+    
     return report;
 }
 
@@ -205,4 +283,23 @@ double ReportGenerator::calculateAccountTurnover(int accountId, const QDate &sta
     }
     
     return 0.0;
-}
\ No newline at end of file
+}
+
+QDataStream &operator<<(QDataStream &stream, const BalanceRecord &record)
+{
+    return stream << record.accountCode << record.accountName << qint32(record.accountType)
+                  << record.openingDebit << record.openingCredit
+                  << record.turnoverDebit << record.turnoverCredit
+                  << record.closingDebit << record.closingCredit;
+}
+
+QDataStream &operator>>(QDataStream &stream, BalanceRecord &record)
+{
+    qint32 type = 0;
+    stream >> record.accountCode >> record.accountName >> type
+           >> record.openingDebit >> record.openingCredit
+           >> record.turnoverDebit >> record.turnoverCredit
+           >> record.closingDebit >> record.closingCredit;
+    record.accountType = type;
+    return stream;
+}
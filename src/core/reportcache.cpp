@@ -0,0 +1,200 @@
+#include "core/reportcache.h"
+#include "core/database.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QSqlQuery>
+#include <QDebug>
+
+namespace {
+
+const quint32 Magic = 0x4C4D5243;   // "LMRC"
+const quint16 FormatVersion = 1;
+const qint64 VersionOffset = 8;     // magic, формат, вид отчета, флаги
+
+const quint8 CompressedFlag = 0x01;
+const int CompressThreshold = 4096;
+
+// Не больше стольких файлов в каталоге кэша, лишние - самые старые
+const int MaxFiles = 512;
+const int PruneEvery = 64;
+
+QByteArray makeKey(ReportCache::Report report, const QVariantList &params)
+{
+    QByteArray key;
+    QDataStream stream(&key, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << quint8(report) << params;
+    return key;
+}
+
+// Месяц "ГГГГ-ММ" как в ledger_months; для всего журнала - после любого
+QString monthOf(const QDate &date)
+{
+    return date.isValid() ? date.toString("yyyy-MM") : QString("9999-12");
+}
+
+}
+
+ReportCache& ReportCache::instance()
+{
+    static ReportCache cache;
+    return cache;
+}
+
+QString ReportCache::directory() const
+{
+    const QString dbName = Database::instance().threadDatabase().databaseName();
+    if (dbName.isEmpty() || dbName == ":memory:") return QString();
+    return dbName + ".reports";
+}
+
+QString ReportCache::filePath(Report report, const QByteArray &key) const
+{
+    const QString dir = directory();
+    if (dir.isEmpty()) return QString();
+
+    const QByteArray hash = QCryptographicHash::hash(key, QCryptographicHash::Sha1).toHex();
+    return QString("%1/%2-%3.bin").arg(dir).arg(int(report)).arg(QString::fromLatin1(hash));
+}
+
+bool ReportCache::lookup(Report report, const QVariantList &params, const QDate &periodEnd,
+                         QByteArray *payload)
+{
+    if (!enabled_) return false;
+
+    const qint64 current = Database::instance().ledgerVersion();
+    const QByteArray key = makeKey(report, params);
+    const QString path = filePath(report, key);
+    if (current < 0 || path.isEmpty()) return false;
+
+    QMutexLocker locker(&mutex_);
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        ++stats_.misses;
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0;
+    quint16 format = 0;
+    quint8 storedReport = 0, flags = 0;
+    qint64 version = -1;
+    QByteArray storedKey, data;
+    stream >> magic >> format >> storedReport >> flags >> version >> storedKey >> data;
+    file.close();
+
+    // Чужой или поврежденный файл, совпадение хэша у разных ключей
+    if (stream.status() != QDataStream::Ok || magic != Magic || format != FormatVersion
+        || storedReport != report || storedKey != key) {
+        QFile::remove(path);
+        ++stats_.misses;
+        return false;
+    }
+
+    if (version != current) {
+        // Журнал менялся: отчет устарел, только если менялись месяцы периода
+        // (или справочники - они записаны месяцем "0000-00")
+        QSqlQuery changed = Database::instance().executeQuery(
+            "SELECT 1 FROM ledger_months WHERE month <= ? AND version >= ? LIMIT 1",
+            {monthOf(periodEnd), version});
+        if (!changed.isActive() || changed.next()) {
+            QFile::remove(path);
+            ++stats_.stale;
+            return false;
+        }
+
+        // Запись переносится на текущую версию, чтобы дальше не проверять
+        // изменения заново; меняются только 8 байт заголовка
+        if (file.open(QIODevice::ReadWrite)) {
+            QDataStream header(&file);
+            header.setVersion(QDataStream::Qt_6_0);
+            file.seek(VersionOffset);
+            header << current;
+            file.close();
+        }
+    }
+
+    *payload = (flags & CompressedFlag) ? qUncompress(data) : data;
+    if (payload->isEmpty() && !data.isEmpty()) {
+        QFile::remove(path);
+        ++stats_.misses;
+        return false;
+    }
+
+    ++stats_.hits;
+    return true;
+}
+
+void ReportCache::insert(Report report, const QVariantList &params, qint64 version,
+                         const QByteArray &payload)
+{
+    if (!enabled_ || version < 0) return;
+
+    const QByteArray key = makeKey(report, params);
+    const QString path = filePath(report, key);
+    if (path.isEmpty()) return;
+
+    const QString dir = QFileInfo(path).absolutePath();
+    QMutexLocker locker(&mutex_);
+    if (!QDir().mkpath(dir)) return;
+
+    // Крупные отчеты сжимаются: распаковка быстрее чтения с диска
+    quint8 flags = 0;
+    QByteArray data = payload;
+    if (payload.size() > CompressThreshold) {
+        data = qCompress(payload, 1);
+        flags |= CompressedFlag;
+    }
+
+    // QSaveFile пишет во временный файл и подменяет им старый целиком:
+    // читатель не увидит недописанную запись
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) return;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << Magic << FormatVersion << quint8(report) << flags << version << key << data;
+    if (stream.status() != QDataStream::Ok || !file.commit()) {
+        qWarning() << "Failed to write report cache:" << path;
+        return;
+    }
+
+    if (++insertsSincePrune_ >= PruneEvery) {
+        insertsSincePrune_ = 0;
+        prune(dir);
+    }
+}
+
+void ReportCache::prune(const QString &dir)
+{
+    QFileInfoList files = QDir(dir).entryInfoList({"*.bin"}, QDir::Files, QDir::Time);
+    for (int i = MaxFiles; i < files.size(); ++i) {
+        QFile::remove(files.at(i).absoluteFilePath());
+    }
+}
+
+void ReportCache::clear()
+{
+    const QString dir = directory();
+    if (dir.isEmpty()) return;
+
+    QMutexLocker locker(&mutex_);
+    for (const QFileInfo &info : QDir(dir).entryInfoList({"*.bin"}, QDir::Files)) {
+        QFile::remove(info.absoluteFilePath());
+    }
+    stats_ = Stats();
+}
+
+ReportCache::Stats ReportCache::stats() const
+{
+    QMutexLocker locker(&mutex_);
+    return stats_;
+}
@@ -0,0 +1,133 @@
+#include "core/savedfilterstore.h"
+#include "core/database.h"
+
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSettings>
+#include <QDebug>
+
+QMap<QString, TransactionFilter> SavedFilterStore::loadAll()
+{
+    QMap<QString, TransactionFilter> filters;
+
+    QSqlQuery query = Database::instance().executeQuery(
+        "SELECT name, options FROM saved_filters ORDER BY name");
+
+    while (query.next()) {
+        QString name = query.value(0).toString();
+        TransactionFilter filter = fromJson(query.value(1).toByteArray());
+        filter.savedFilterName = name;
+        filters.insert(name, filter);
+    }
+
+    return filters;
+}
+
+bool SavedFilterStore::save(const QString &name, const TransactionFilter &filter)
+{
+    QSqlQuery query = Database::instance().executeQuery(
+        "INSERT INTO saved_filters (name, options) VALUES (?, ?) "
+        "ON CONFLICT(name) DO UPDATE SET options = excluded.options, "
+        "updated_at = CURRENT_TIMESTAMP",
+        {name, QString::fromUtf8(toJson(filter))});
+
+    if (query.lastError().isValid()) {
+        qWarning() << "Failed to save filter" << name << ":" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+bool SavedFilterStore::remove(const QString &name)
+{
+    QSqlQuery query = Database::instance().executeQuery(
+        "DELETE FROM saved_filters WHERE name = ?", {name});
+
+    if (query.lastError().isValid()) {
+        qWarning() << "Failed to remove filter" << name << ":" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+int SavedFilterStore::migrateFromSettings()
+{
+    QSettings settings;
+    settings.beginGroup("SavedFilters");
+    QStringList names = settings.childGroups();
+
+    int migrated = 0;
+    for (const QString &name : names) {
+        TransactionFilter filter;
+        filter.textFilter = settings.value(name + "/textFilter").toString();
+        filter.fieldFilter = settings.value(name + "/fieldFilter").toString();
+        filter.dateFrom = settings.value(name + "/dateFrom").toDate();
+        filter.dateTo = settings.value(name + "/dateTo").toDate();
+        filter.amountFrom = settings.value(name + "/amountFrom").toDouble();
+        filter.amountTo = settings.value(name + "/amountTo").toDouble();
+        filter.debitAccountId = settings.value(name + "/debitAccountId", -1).toInt();
+        filter.creditAccountId = settings.value(name + "/creditAccountId", -1).toInt();
+        filter.counterpartyId = settings.value(name + "/counterpartyId", -1).toInt();
+
+        // Уже существующий в базе фильтр с тем же именем не перезаписываем
+        QSqlQuery query = Database::instance().executeQuery(
+            "INSERT OR IGNORE INTO saved_filters (name, options) VALUES (?, ?)",
+            {name, QString::fromUtf8(toJson(filter))});
+
+        if (query.lastError().isValid()) {
+            qWarning() << "Failed to migrate filter" << name << ":" << query.lastError().text();
+            continue;
+        }
+
+        settings.remove(name);
+        ++migrated;
+    }
+
+    settings.endGroup();
+
+    if (migrated > 0) {
+        qInfo() << "Migrated saved filters from settings:" << migrated;
+    }
+    return migrated;
+}
+
+QByteArray SavedFilterStore::toJson(const TransactionFilter &filter)
+{
+    QJsonObject object;
+    object["textFilter"] = filter.textFilter;
+    object["fieldFilter"] = filter.fieldFilter;
+    object["dateFrom"] = filter.dateFrom.toString(Qt::ISODate);
+    object["dateTo"] = filter.dateTo.toString(Qt::ISODate);
+    object["dateFilterEnabled"] = filter.dateFilterEnabled;
+    object["amountFrom"] = filter.amountFrom;
+    object["amountTo"] = filter.amountTo;
+    object["amountFilterEnabled"] = filter.amountFilterEnabled;
+    object["debitAccountId"] = filter.debitAccountId;
+    object["creditAccountId"] = filter.creditAccountId;
+    object["includeSubaccounts"] = filter.includeSubaccounts;
+    object["counterpartyId"] = filter.counterpartyId;
+
+    return QJsonDocument(object).toJson(QJsonDocument::Compact);
+}
+
+TransactionFilter SavedFilterStore::fromJson(const QByteArray &json)
+{
+    QJsonObject object = QJsonDocument::fromJson(json).object();
+
+    TransactionFilter filter;
+    filter.textFilter = object["textFilter"].toString();
+    filter.fieldFilter = object["fieldFilter"].toString();
+    filter.dateFrom = QDate::fromString(object["dateFrom"].toString(), Qt::ISODate);
+    filter.dateTo = QDate::fromString(object["dateTo"].toString(), Qt::ISODate);
+    filter.dateFilterEnabled = object["dateFilterEnabled"].toBool();
+    filter.amountFrom = object["amountFrom"].toDouble();
+    filter.amountTo = object["amountTo"].toDouble();
+    filter.amountFilterEnabled = object["amountFilterEnabled"].toBool();
+    filter.debitAccountId = object["debitAccountId"].toInt(-1);
+    filter.creditAccountId = object["creditAccountId"].toInt(-1);
+    filter.includeSubaccounts = object["includeSubaccounts"].toBool();
+    filter.counterpartyId = object["counterpartyId"].toInt(-1);
+    filter.useSavedFilter = true;
+
+    return filter;
+}
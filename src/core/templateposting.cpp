@@ -0,0 +1,215 @@
+#include "core/templateposting.h"
+#include "core/batchvalidator.h"
+#include "core/csvreader.h"
+#include "core/database.h"
+#include "core/ledgerevents.h"
+#include "core/validationrules.h"
+
+#include <QHash>
+#include <QSet>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QDebug>
+
+namespace {
+
+enum Column {
+    CounterpartyField,
+    AmountField,
+    DocumentField
+};
+
+// Проводка, прошедшая проверку
+struct Posting {
+    QVariant counterpartyId;
+    double amount = 0.0;
+    QString document;
+};
+
+}
+
+bool TemplatePosting::post(int templateId, const QDate &date, const QVector<Row> &rows,
+                           bool dryRun, Result *result)
+{
+    *result = Result();
+
+    Database &db = Database::instance();
+    QSqlQuery templateQuery = db.executeQuery(
+        "SELECT name, description, debit_account_id, credit_account_id, amount, "
+        "       document_prefix, counterparty_id "
+        "FROM transaction_templates WHERE id = ?", {templateId});
+    if (!templateQuery.next()) {
+        result->errors << "Шаблон не найден";
+        return false;
+    }
+    const QString name = templateQuery.value(0).toString();
+    QString description = templateQuery.value(1).toString();
+    if (description.trimmed().isEmpty()) description = name;
+    const int debitId = templateQuery.value(2).toInt();
+    const int creditId = templateQuery.value(3).toInt();
+    const double templateAmount = templateQuery.value(4).toDouble();
+    const QString prefix = templateQuery.value(5).toString();
+    const QVariant templateCounterparty = templateQuery.value(6);
+
+    // Контрагенты читаются один раз: по ИНН и по наименованию
+    QHash<QString, int> byInn;
+    QHash<QString, int> byName;
+    QSet<QString> ambiguousNames;
+    QSqlQuery counterparties = db.executeCursor("SELECT id, name, inn FROM counterparties");
+    while (counterparties.next()) {
+        const int id = counterparties.value(0).toInt();
+        const QString counterpartyName = counterparties.value(1).toString().trimmed();
+        const QString inn = counterparties.value(2).toString().trimmed();
+        if (!inn.isEmpty()) byInn.insert(inn, id);
+        if (byName.contains(counterpartyName)) ambiguousNames.insert(counterpartyName);
+        byName.insert(counterpartyName, id);
+    }
+
+    // Сначала проверяются все строки (BatchValidator, пачкой по столбцам):
+    // запись начинается, только если ошибок нет ни в одной
+    BatchValidator validator;
+    QString loadError;
+    if (!validator.load(&loadError)) {
+        result->errors << loadError;
+        return false;
+    }
+
+    QVector<Posting> postings;
+    QVector<QString> counterpartyErrors(rows.size());
+    BatchValidator::Postings batch;
+    postings.reserve(rows.size());
+    batch.reserve(rows.size());
+    for (int i = 0; i < rows.size(); ++i) {
+        const Row &row = rows.at(i);
+
+        Posting posting;
+        // Указанная сумма берется как есть: ноль или минус отметит BatchValidator
+        posting.amount = row.hasAmount ? row.amount : templateAmount;
+
+        const QString counterparty = row.counterparty.trimmed();
+        if (counterparty.isEmpty()) {
+            posting.counterpartyId = templateCounterparty;
+        } else if (byInn.contains(counterparty)) {
+            posting.counterpartyId = byInn.value(counterparty);
+        } else if (ambiguousNames.contains(counterparty)) {
+            counterpartyErrors[i] = "несколько контрагентов \"" + counterparty + "\", укажите ИНН";
+        } else if (byName.contains(counterparty)) {
+            posting.counterpartyId = byName.value(counterparty);
+        } else {
+            counterpartyErrors[i] = "нет контрагента \"" + counterparty + "\"";
+        }
+
+        posting.document = row.documentNumber.trimmed();
+        if (posting.document.isEmpty() && !prefix.isEmpty()) {
+            posting.document = QString("%1-%2-%3").arg(prefix, date.toString("yyyyMMdd")).arg(i + 1);
+        }
+        postings.append(posting);
+        batch.append(date, debitId, creditId, posting.amount, posting.counterpartyId.toInt());
+    }
+
+    const QVector<BatchValidator::Errors> errors = validator.validatePostings(batch);
+    for (int i = 0; i < rows.size(); ++i) {
+        QStringList messages;
+        if (!counterpartyErrors.at(i).isEmpty()) messages << counterpartyErrors.at(i);
+        if (errors.at(i) != BatchValidator::NoError) messages << BatchValidator::describe(errors.at(i));
+        if (!messages.isEmpty()) {
+            result->errors << QString("Строка %1: %2").arg(i + 1).arg(messages.join("; "));
+        }
+    }
+
+    if (!result->errors.isEmpty() || dryRun) {
+        return result->errors.isEmpty();
+    }
+
+    if (!db.beginTransaction()) {
+        result->errors << "Не удалось начать транзакцию";
+        return false;
+    }
+
+    QSqlQuery insert(db.threadDatabase());
+    if (!insert.prepare("INSERT INTO transactions ("
+                        "transaction_date, debit_account_id, credit_account_id, "
+                        "amount, description, document_number, document_date, "
+                        "counterparty_id) VALUES (?, ?, ?, ?, ?, ?, ?, ?)")) {
+        db.rollbackTransaction();
+        result->errors << "Ошибка запроса: " + insert.lastError().text();
+        return false;
+    }
+
+    // Неизменные поля привязываются один раз
+    insert.bindValue(0, date);
+    insert.bindValue(1, debitId);
+    insert.bindValue(2, creditId);
+    insert.bindValue(4, description);
+    for (int i = 0; i < postings.size(); ++i) {
+        const Posting &posting = postings.at(i);
+        insert.bindValue(3, posting.amount);
+        insert.bindValue(5, posting.document);
+        insert.bindValue(6, posting.document.isEmpty() ? QVariant(QMetaType(QMetaType::QDate)) : QVariant(date));
+        insert.bindValue(7, posting.counterpartyId);
+        if (!insert.exec()) {
+            db.rollbackTransaction();
+            result->errors << QString("Строка %1: ошибка записи: %2")
+                              .arg(i + 1).arg(insert.lastError().text());
+            return false;
+        }
+    }
+
+    if (!db.commitTransaction()) {
+        db.rollbackTransaction();
+        result->errors << "Не удалось завершить транзакцию";
+        return false;
+    }
+
+    result->posted = postings.size();
+    qInfo() << "Posted" << result->posted << "transactions by template" << name;
+    if (result->posted > 0) {
+        LedgerEvents::instance().notifyBulkChanged(LedgerEvents::Transactions);
+    }
+    return true;
+}
+
+bool TemplatePosting::readCsv(const QString &fileName, QVector<Row> *rows, QStringList *errors)
+{
+    rows->clear();
+
+    CsvReader reader;
+    if (!reader.open(fileName)) {
+        *errors << "Не удалось открыть файл: " + reader.errorString();
+        return false;
+    }
+
+    QStringList fields;
+    bool first = true;
+    const int errorsBefore = errors->size();
+    while (reader.readRow(&fields)) {
+        if (fields.join(QString()).trimmed().isEmpty()) continue;
+
+        bool amountOk = false;
+        const QString amountText = fields.value(AmountField).trimmed();
+        const double amount = amountText.isEmpty() ? 0.0 : ValidationRules::parseAmount(amountText, &amountOk);
+
+        // Первая строка с нечисловой суммой - заголовки
+        if (first) {
+            first = false;
+            if (!amountText.isEmpty() && !amountOk) continue;
+        }
+        if (!amountText.isEmpty() && !amountOk) {
+            *errors << QString("Строка %1: неверная сумма \"%2\"")
+                       .arg(reader.lineNumber()).arg(amountText);
+            continue;
+        }
+
+        Row row;
+        row.counterparty = fields.value(CounterpartyField).trimmed();
+        row.amount = amount;
+        row.hasAmount = !amountText.isEmpty();
+        row.documentNumber = fields.value(DocumentField).trimmed();
+        rows->append(row);
+    }
+
+    if (reader.hasError()) {
+        *errors << reader.errorString();
+    }
+    return errors->size() == errorsBefore;
+}
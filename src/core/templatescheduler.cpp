@@ -0,0 +1,329 @@
+#include "core/templatescheduler.h"
+#include "core/amountformula.h"
+#include "core/database.h"
+#include "core/ledgerevents.h"
+#include "core/validationrules.h"
+
+#include <QMap>
+#include <QSet>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QVector>
+#include <QDebug>
+#include <cmath>
+
+namespace {
+
+struct DueTemplate {
+    int id = 0;
+    QString name;
+    QString description;
+    int debitId = 0;
+    int creditId = 0;
+    double amount = 0.0;
+    QString documentPrefix;
+    QVariant counterpartyId;
+    QVariant lastExecuted;          // как в базе: для сравнения при обновлении
+    bool hasFormula = false;
+    QVector<QDate> dates;
+    QVector<double> amounts;        // по датам; 0 - проводки нет
+};
+
+}
+
+TemplateScheduler::TemplateScheduler(QObject *parent)
+    : QObject(parent)
+{
+    connect(&timer_, &QTimer::timeout, this, &TemplateScheduler::runNow);
+}
+
+void TemplateScheduler::start(int intervalMs)
+{
+    timer_.start(intervalMs);
+    // Первый запуск - после возврата в цикл событий, когда окно уже открыто
+    QTimer::singleShot(0, this, &TemplateScheduler::runNow);
+}
+
+void TemplateScheduler::runNow()
+{
+    if (!Database::instance().isInitialized()) return;
+
+    Result result;
+    const bool ok = runDue(QDate::currentDate(), &result);
+    for (const QString &error : result.errors) {
+        qWarning() << "Template scheduler:" << error;
+    }
+    if (!ok) {
+        emit failed(result.errors.value(0));
+        return;
+    }
+    if (result.inserted > 0) {
+        emit executed(result.templates, result.inserted);
+    }
+}
+
+QVector<QDate> TemplateScheduler::dueDates(const QString &frequency, const QDate &anchor,
+                                           const QDate &after, const QDate &today, int limit)
+{
+    QVector<QDate> dates;
+    if (!anchor.isValid() || !today.isValid()) return dates;
+
+    // Каждая дата считается от anchor, а не от предыдущей или от
+    // last_executed: ежемесячный шаблон от 31-го после февраля снова идет 31-го
+    for (int k = 0; dates.size() < limit; ++k) {
+        QDate date;
+        if (frequency == "daily") date = anchor.addDays(k);
+        else if (frequency == "weekly") date = anchor.addDays(7 * k);
+        else if (frequency == "monthly") date = anchor.addMonths(k);
+        else if (frequency == "yearly") date = anchor.addYears(k);
+        else break;
+
+        if (!date.isValid() || date > today) break;
+        if (after.isValid() && date <= after) continue;
+        dates.append(date);
+    }
+    return dates;
+}
+
+bool TemplateScheduler::runDue(const QDate &today, Result *result)
+{
+    *result = Result();
+
+    Database &db = Database::instance();
+    if (!db.beginTransaction()) {
+        result->errors << "Не удалось начать транзакцию";
+        return false;
+    }
+
+    // Шаблоны читаются внутри транзакции: last_executed, от которого
+    // считаются даты, обновляется в ней же. Читаются все шаблоны, а не
+    // только наступившие: на их суммы могут ссылаться формулы
+    QSqlQuery templates = db.executeQuery(
+        "SELECT id, name, description, debit_account_id, credit_account_id, amount, "
+        "       document_prefix, counterparty_id, frequency, last_executed, date(created_at), "
+        "       amount_formula "
+        "FROM transaction_templates");
+    if (templates.lastError().isValid()) {
+        db.rollbackTransaction();
+        result->errors << "Ошибка запроса: " + templates.lastError().text();
+        return false;
+    }
+
+    const QStringList frequencies = {"daily", "weekly", "monthly", "yearly"};
+    QVector<DueTemplate> due;
+    QHash<QString, AmountFormula> formulas;
+    QHash<QString, double> fixedAmounts;
+    while (templates.next()) {
+        DueTemplate t;
+        t.id = templates.value(0).toInt();
+        t.name = templates.value(1).toString();
+        t.description = templates.value(2).toString();
+        t.debitId = templates.value(3).toInt();
+        t.creditId = templates.value(4).toInt();
+        t.amount = templates.value(5).toDouble();
+        t.documentPrefix = templates.value(6).toString();
+        t.counterpartyId = templates.value(7);
+        t.lastExecuted = templates.value(9);
+
+        const QString formulaText = templates.value(11).toString().trimmed();
+        QString formulaError;
+        if (formulaText.isEmpty()) {
+            fixedAmounts.insert(t.name, t.amount);
+        } else {
+            AmountFormula formula;
+            t.hasFormula = true;
+            if (formula.compile(formulaText, &formulaError)) {
+                formulas.insert(t.name, formula);
+            }
+        }
+
+        const QString frequency = templates.value(8).toString();
+        if (!frequencies.contains(frequency) || (!t.hasFormula && t.amount <= 0)) continue;
+
+        // Ряд дат привязан к дате создания шаблона; last_executed только
+        // отсекает уже выполненные. Ни разу не выполненный шаблон начинается
+        // с сегодняшней даты ряда: прошлое с даты создания не дописывается
+        const QDate last = t.lastExecuted.toDate();
+        const QDate created = templates.value(10).toDate();
+        if (last.isValid() && last >= today) continue;
+        const QDate anchor = created.isValid() ? created : (last.isValid() ? last : today);
+        const QDate after = last.isValid() ? last : today.addDays(-1);
+        t.dates = dueDates(frequency, anchor, after, today, MaxOccurrences);
+        if (t.dates.isEmpty()) continue;
+
+        if (!formulaError.isEmpty()) {
+            // Ошибочный шаблон не мешает остальным
+            result->errors << QString("Шаблон \"%1\": %2").arg(t.name, formulaError);
+            continue;
+        }
+        if (t.description.trimmed().isEmpty()) t.description = t.name;
+        t.amounts.fill(t.amount, t.dates.size());
+        if (t.dates.size() == MaxOccurrences) {
+            qInfo() << "Template" << t.name << "has more than" << MaxOccurrences
+                    << "due dates, the rest is left for the next run";
+        }
+        due.append(t);
+    }
+
+    // Суммы по формулам: на каждую дату выполнения - одна выборка остатков
+    // по всем счетам всех формул, дальше только вычисление байт-кода.
+    // Формулы видят журнал до этого пакета; суммы других шаблонов на ту же
+    // дату берутся через template()
+    if (!formulas.isEmpty()) {
+        QStringList accounts;
+        for (const AmountFormula &formula : formulas) {
+            for (const QString &code : formula.accounts()) {
+                if (!accounts.contains(code)) accounts << code;
+            }
+        }
+
+        QMap<QDate, QVector<int>> formulaDates;     // дата -> индексы в due
+        for (int i = 0; i < due.size(); ++i) {
+            if (!due.at(i).hasFormula) continue;
+            for (const QDate &date : due.at(i).dates) {
+                formulaDates[date].append(i);
+            }
+        }
+
+        QSet<int> broken;
+        FormulaBalances balances;
+        for (auto it = formulaDates.constBegin(); it != formulaDates.constEnd(); ++it) {
+            const QDate date = it.key();
+            QString error;
+            if (!balances.prefetch(accounts, QDate(date.year(), date.month(), 1), date, &error)) {
+                db.rollbackTransaction();
+                result->errors << error;
+                return false;
+            }
+
+            QHash<QString, double> values;
+            QStringList errors;
+            AmountFormula::evaluateAll(formulas, fixedAmounts, balances, &values, &errors);
+            for (int i : it.value()) {
+                DueTemplate &t = due[i];
+                if (!values.contains(t.name)) {
+                    if (!broken.contains(i)) {
+                        result->errors << QString("Шаблон \"%1\": сумма на %2 не вычислена")
+                                          .arg(t.name, date.toString("dd.MM.yyyy"));
+                    }
+                    broken.insert(i);
+                    continue;
+                }
+                // Ноль или отрицательная сумма - в эту дату проводки нет
+                const int occurrence = t.dates.indexOf(date);
+                t.amounts[occurrence] = std::round(values.value(t.name) * 100.0) / 100.0;
+            }
+            for (const QString &message : errors) {
+                if (!result->errors.contains(message)) result->errors << message;
+            }
+        }
+
+        QVector<DueTemplate> evaluated;
+        for (int i = 0; i < due.size(); ++i) {
+            if (!broken.contains(i)) evaluated.append(due.at(i));
+        }
+        due = evaluated;
+    }
+
+    for (int i = due.size() - 1; i >= 0; --i) {
+        const DueTemplate &t = due.at(i);
+        double amount = 0.0;
+        for (double value : t.amounts) {
+            if (value > 0) {
+                amount = value;
+                break;
+            }
+        }
+        if (amount <= 0) {
+            // Ни одной проводки: last_executed не сдвигается, даты
+            // пересчитываются при следующем запуске
+            due.removeAt(i);
+            continue;
+        }
+
+        ValidationRules::TransactionValidation validation = ValidationRules::validateTransaction(
+            t.dates.first(), t.debitId, t.creditId, amount, t.description);
+        if (!validation.isValid) {
+            result->errors << QString("Шаблон \"%1\": %2").arg(t.name, validation.errorMessage);
+            due.removeAt(i);
+        }
+    }
+
+    if (due.isEmpty()) {
+        db.rollbackTransaction();
+        return true;
+    }
+
+    QSqlQuery insert(db.threadDatabase());
+    QSqlQuery update(db.threadDatabase());
+    if (!insert.prepare("INSERT INTO transactions ("
+                        "transaction_date, debit_account_id, credit_account_id, "
+                        "amount, description, document_number, document_date, "
+                        "counterparty_id) VALUES (?, ?, ?, ?, ?, ?, ?, ?)")
+        || !update.prepare("UPDATE transaction_templates SET last_executed = ? "
+                           "WHERE id = ? AND last_executed IS ?")) {
+        db.rollbackTransaction();
+        result->errors << "Ошибка запроса: " + insert.lastError().text() + update.lastError().text();
+        return false;
+    }
+
+    auto abort = [&](const DueTemplate &t, const QString &message) {
+        db.rollbackTransaction();
+        result->errors << QString("Шаблон \"%1\": %2").arg(t.name, message);
+        result->templates = 0;
+        result->inserted = 0;
+        return false;
+    };
+
+    for (const DueTemplate &t : due) {
+        QDate lastPosted;
+        for (int k = 0; k < t.dates.size(); ++k) {
+            if (t.amounts.at(k) <= 0) continue;
+            const QDate &date = t.dates.at(k);
+            const QString document = t.documentPrefix.isEmpty()
+                ? QString() : t.documentPrefix + "-" + date.toString("yyyyMMdd");
+            insert.bindValue(0, date);
+            insert.bindValue(1, t.debitId);
+            insert.bindValue(2, t.creditId);
+            insert.bindValue(3, t.amounts.at(k));
+            insert.bindValue(4, t.description);
+            insert.bindValue(5, document);
+            insert.bindValue(6, document.isEmpty() ? QVariant(QMetaType(QMetaType::QDate)) : QVariant(date));
+            insert.bindValue(7, t.counterpartyId);
+            if (!insert.exec()) {
+                return abort(t, "ошибка записи: " + insert.lastError().text());
+            }
+            ++result->inserted;
+            lastPosted = date;
+        }
+
+        // last_executed - последняя записанная проводка: даты с нулевой
+        // суммой по формуле в конце ряда пересчитываются при следующем запуске.
+        // Он меняется, только если его никто не поменял с момента
+        // чтения (второй экземпляр программы, ledgermini-cli): иначе проводки
+        // по этим датам уже записаны там, и весь пакет откатывается
+        update.bindValue(0, lastPosted);
+        update.bindValue(1, t.id);
+        update.bindValue(2, t.lastExecuted);
+        if (!update.exec()) {
+            return abort(t, "ошибка записи: " + update.lastError().text());
+        }
+        if (update.numRowsAffected() != 1) {
+            return abort(t, "шаблон одновременно выполнен в другом месте");
+        }
+
+        ++result->templates;
+    }
+
+    if (!db.commitTransaction()) {
+        db.rollbackTransaction();
+        result->errors << "Не удалось завершить транзакцию";
+        result->templates = 0;
+        result->inserted = 0;
+        return false;
+    }
+
+    qInfo() << "Executed" << result->templates << "templates," << result->inserted << "transactions";
+    LedgerEvents::instance().notifyBulkChanged(LedgerEvents::Transactions);
+    return true;
+}
@@ -0,0 +1,355 @@
+#include "core/transactionimport.h"
+#include "core/batchvalidator.h"
+#include "core/csvreader.h"
+#include "core/database.h"
+#include "core/ledgerevents.h"
+#include "core/validationrules.h"
+
+#include <QDate>
+#include <QHash>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QDebug>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+enum Column {
+    DateField,
+    DebitField,
+    CreditField,
+    AmountField,
+    DescriptionField,
+    DocumentField,
+    CounterpartyField,
+    FieldCount
+};
+
+enum CounterpartyColumn {
+    NameField,
+    InnField,
+    KppField
+};
+
+// Дата выгрузки журнала (ДД.ММ.ГГГГ) или ISO
+QDate parseDate(const QString &text)
+{
+    QDate date = QDate::fromString(text, "dd.MM.yyyy");
+    if (!date.isValid()) {
+        date = QDate::fromString(text, Qt::ISODate);
+    }
+    return date;
+}
+
+// Счет в выгрузке журнала записан как "код - наименование"; берется код
+QString accountCode(const QString &text)
+{
+    const int separator = text.indexOf(" - ");
+    return (separator < 0 ? text : text.left(separator)).trimmed();
+}
+
+QHash<QString, int> loadIds(const QString &sql)
+{
+    QHash<QString, int> ids;
+    QSqlQuery query = Database::instance().executeCursor(sql);
+    while (query.next()) {
+        ids.insert(query.value(0).toString(), query.value(1).toInt());
+    }
+    return ids;
+}
+
+}
+
+bool TransactionImport::importCsv(const QString &fileName, const Options &options, Result *result)
+{
+    *result = Result();
+
+    CsvReader reader;
+    if (!reader.open(fileName)) {
+        result->errors << "Не удалось открыть файл: " + reader.errorString();
+        return false;
+    }
+
+    // Справочники читаются один раз, а не запросом на каждую строку
+    const QHash<QString, int> accounts = loadIds("SELECT code, id FROM accounts");
+    const QHash<QString, int> counterparties = loadIds("SELECT name, id FROM counterparties");
+
+    BatchValidator validator;
+    QString loadError;
+    if (!validator.load(&loadError)) {
+        result->errors << loadError;
+        return false;
+    }
+
+    // Проверка без записи не открывает транзакцию: ни блокировки записи,
+    // ни срабатывания триггеров остатков ради отката
+    Database &db = Database::instance();
+    const bool writing = !options.dryRun;
+    if (writing && !db.beginTransaction()) {
+        result->errors << "Не удалось начать транзакцию";
+        return false;
+    }
+
+    QSqlQuery insert(db.threadDatabase());
+    if (writing && !insert.prepare("INSERT INTO transactions ("
+                                   "transaction_date, debit_account_id, credit_account_id, "
+                                   "amount, description, document_number, document_date, "
+                                   "counterparty_id) VALUES (?, ?, ?, ?, ?, ?, ?, ?)")) {
+        db.rollbackTransaction();
+        result->errors << "Ошибка запроса: " + insert.lastError().text();
+        return false;
+    }
+
+    // Все ошибочные строки считаются, перечисляются первые maxErrors
+    qint64 invalidRows = 0;
+    auto fail = [&](qint64 line, const QString &message) {
+        ++invalidRows;
+        if (result->errors.size() < options.maxErrors) {
+            result->errors << QString("Строка %1: %2").arg(line).arg(message);
+        }
+    };
+
+    // Строки копятся пачкой по столбцам и проверяются BatchValidator разом;
+    // пачка ограничена, память не зависит от размера файла
+    const int ChunkRows = 4096;
+    BatchValidator::Postings postings;
+    postings.reserve(ChunkRows);
+    QVector<qint64> lines;
+    QVector<QStringList> chunk;
+    lines.reserve(ChunkRows);
+    chunk.reserve(ChunkRows);
+
+    auto flush = [&]() {
+        const QVector<BatchValidator::Errors> errors = validator.validatePostings(postings);
+        for (int i = 0; i < chunk.size(); ++i) {
+            const QStringList &row = chunk.at(i);
+            BatchValidator::Errors rowErrors = errors.at(i);
+            if (rowErrors != BatchValidator::NoError) {
+                // Для ненайденных кодов и названий - само значение из файла
+                QStringList messages;
+                if (rowErrors & BatchValidator::UnknownDebit) {
+                    messages << "нет счета " + row.at(DebitField).trimmed();
+                }
+                if (rowErrors & BatchValidator::UnknownCredit) {
+                    messages << "нет счета " + row.at(CreditField).trimmed();
+                }
+                if ((rowErrors & BatchValidator::InvalidAmount) && std::isnan(postings.amounts.at(i))) {
+                    messages << "неверная сумма \"" + row.at(AmountField) + "\"";
+                    rowErrors &= ~BatchValidator::InvalidAmount;
+                }
+                if (rowErrors & BatchValidator::UnknownCounterparty) {
+                    messages << "нет контрагента \"" + row.value(CounterpartyField).trimmed() + "\"";
+                }
+                rowErrors &= ~(BatchValidator::UnknownDebit | BatchValidator::UnknownCredit
+                               | BatchValidator::UnknownCounterparty);
+                if (rowErrors != BatchValidator::NoError) {
+                    messages << BatchValidator::describe(rowErrors);
+                }
+                fail(lines.at(i), messages.join("; "));
+                continue;
+            }
+
+            // После первой ошибки строки только проверяются: транзакция все равно откатится
+            if (invalidRows > 0 || !writing) continue;
+
+            const int counterpartyId = postings.counterpartyIds.at(i);
+            const QString document = row.value(DocumentField).trimmed();
+            const QDate date = postings.dates.at(i);
+            insert.bindValue(0, date);
+            insert.bindValue(1, postings.debitIds.at(i));
+            insert.bindValue(2, postings.creditIds.at(i));
+            insert.bindValue(3, postings.amounts.at(i));
+            insert.bindValue(4, row.at(DescriptionField).trimmed());
+            insert.bindValue(5, document);
+            insert.bindValue(6, document.isEmpty() ? QVariant(QMetaType(QMetaType::QDate)) : QVariant(date));
+            insert.bindValue(7, counterpartyId > 0 ? QVariant(counterpartyId) : QVariant(QMetaType(QMetaType::Int)));
+            if (!insert.exec()) {
+                fail(lines.at(i), "ошибка записи: " + insert.lastError().text());
+                continue;
+            }
+            ++result->imported;
+        }
+        postings.clear();
+        lines.resize(0);
+        chunk.resize(0);
+    };
+
+    QStringList fields;
+    bool first = true;
+    while (reader.readRow(&fields)) {
+        if (fields.join(QString()).trimmed().isEmpty()) continue;
+
+        // Первая строка без даты - заголовки выгрузки
+        const QDate date = parseDate(fields.value(DateField).trimmed());
+        if (first) {
+            first = false;
+            if (!date.isValid()) continue;
+        }
+        ++result->rows;
+
+        if (fields.size() < CounterpartyField) {
+            fail(reader.lineNumber(),
+                 QString("ожидается %1 полей, получено %2").arg(FieldCount - 1).arg(fields.size()));
+            continue;
+        }
+
+        // Код не найден - id -1, пустой - 0: различает BatchValidator
+        const QString debitCode = accountCode(fields.at(DebitField));
+        const QString creditCode = accountCode(fields.at(CreditField));
+        const int debitId = debitCode.isEmpty() ? 0 : accounts.value(debitCode, -1);
+        const int creditId = creditCode.isEmpty() ? 0 : accounts.value(creditCode, -1);
+
+        bool amountOk = false;
+        double amount = ValidationRules::parseAmount(fields.at(AmountField), &amountOk);
+        if (!amountOk) amount = std::numeric_limits<double>::quiet_NaN();
+
+        const QString counterparty = fields.value(CounterpartyField).trimmed();
+        const int counterpartyId = counterparty.isEmpty() ? 0 : counterparties.value(counterparty, -1);
+
+        postings.append(date, debitId, creditId, amount, counterpartyId);
+        lines.append(reader.lineNumber());
+        chunk.append(fields);
+        if (chunk.size() == ChunkRows) flush();
+    }
+    flush();
+
+    if (reader.hasError()) {
+        result->errors << reader.errorString();
+    }
+    if (invalidRows > options.maxErrors) {
+        result->errors << QString("... всего ошибочных строк: %1").arg(invalidRows);
+    }
+
+    if (!writing) {
+        return result->errors.isEmpty();
+    }
+    if (!result->errors.isEmpty()) {
+        db.rollbackTransaction();
+        result->imported = 0;
+        return false;
+    }
+
+    if (!db.commitTransaction()) {
+        db.rollbackTransaction();
+        result->imported = 0;
+        result->errors << "Не удалось завершить транзакцию";
+        return false;
+    }
+
+    qInfo() << "Imported" << result->imported << "transactions from" << fileName;
+    if (result->imported > 0) {
+        LedgerEvents::instance().notifyBulkChanged(LedgerEvents::Transactions);
+    }
+    return true;
+}
+
+bool TransactionImport::importCounterpartiesCsv(const QString &fileName, const Options &options,
+                                                Result *result)
+{
+    *result = Result();
+
+    CsvReader reader;
+    if (!reader.open(fileName)) {
+        result->errors << "Не удалось открыть файл: " + reader.errorString();
+        return false;
+    }
+
+    BatchValidator validator;
+    QString loadError;
+    if (!validator.load(&loadError)) {
+        result->errors << loadError;
+        return false;
+    }
+
+    // Справочник контрагентов невелик: файл проверяется одной пачкой,
+    // повтор ИНН ловится по всему файлу, а не внутри куска
+    BatchValidator::Counterparties counterparties;
+    QVector<qint64> lines;
+    QVector<QString> kpps;
+    QStringList fields;
+    bool first = true;
+    while (reader.readRow(&fields)) {
+        if (fields.join(QString()).trimmed().isEmpty()) continue;
+
+        // Первая строка с "Наименование" - заголовки
+        const QString name = fields.value(NameField).trimmed();
+        if (first) {
+            first = false;
+            if (name.compare("Наименование", Qt::CaseInsensitive) == 0) continue;
+        }
+
+        counterparties.names.append(name);
+        counterparties.inns.append(fields.value(InnField).trimmed());
+        kpps.append(fields.value(KppField).trimmed());
+        lines.append(reader.lineNumber());
+    }
+    result->rows = counterparties.size();
+
+    if (reader.hasError()) {
+        result->errors << reader.errorString();
+        return false;
+    }
+
+    qint64 invalidRows = 0;
+    const QVector<BatchValidator::Errors> errors = validator.validateCounterparties(counterparties);
+    for (int i = 0; i < errors.size(); ++i) {
+        if (errors.at(i) == BatchValidator::NoError) continue;
+        ++invalidRows;
+        if (result->errors.size() < options.maxErrors) {
+            QString message = BatchValidator::describe(errors.at(i));
+            if (errors.at(i) & (BatchValidator::InvalidInn | BatchValidator::DuplicateInn)) {
+                message += " (" + counterparties.inns.at(i) + ")";
+            }
+            result->errors << QString("Строка %1: %2").arg(lines.at(i)).arg(message);
+        }
+    }
+    if (invalidRows > options.maxErrors) {
+        result->errors << QString("... всего ошибочных строк: %1").arg(invalidRows);
+    }
+    if (!result->errors.isEmpty() || options.dryRun) {
+        return result->errors.isEmpty();
+    }
+
+    Database &db = Database::instance();
+    if (!db.beginTransaction()) {
+        result->errors << "Не удалось начать транзакцию";
+        return false;
+    }
+
+    QSqlQuery insert(db.threadDatabase());
+    if (!insert.prepare("INSERT INTO counterparties (name, inn, kpp) VALUES (?, ?, ?)")) {
+        db.rollbackTransaction();
+        result->errors << "Ошибка запроса: " + insert.lastError().text();
+        return false;
+    }
+
+    for (int i = 0; i < counterparties.size(); ++i) {
+        const QString &inn = counterparties.inns.at(i);
+        insert.bindValue(0, counterparties.names.at(i));
+        // Пустой ИНН - NULL: уникальность столбца не мешает контрагентам без ИНН
+        insert.bindValue(1, inn.isEmpty() ? QVariant(QMetaType(QMetaType::QString)) : QVariant(inn));
+        insert.bindValue(2, kpps.at(i));
+        if (!insert.exec()) {
+            db.rollbackTransaction();
+            result->errors << QString("Строка %1: ошибка записи: %2")
+                              .arg(lines.at(i)).arg(insert.lastError().text());
+            result->imported = 0;
+            return false;
+        }
+        ++result->imported;
+    }
+
+    if (!db.commitTransaction()) {
+        db.rollbackTransaction();
+        result->imported = 0;
+        result->errors << "Не удалось завершить транзакцию";
+        return false;
+    }
+
+    qInfo() << "Imported" << result->imported << "counterparties from" << fileName;
+    if (result->imported > 0) {
+        LedgerEvents::instance().notifyBulkChanged(LedgerEvents::Counterparties);
+    }
+    return true;
+}
@@ -0,0 +1,244 @@
+#include "core/transactionquery.h"
+#include "core/database.h"
+#include "core/accounttree.h"
+
+#include <QStringList>
+#include <QCryptographicHash>
+
+namespace {
+
+// Экранирование символов шаблона LIKE, чтобы "%" и "_" в запросе искались буквально
+QString likePattern(const QString &text)
+{
+    QString escaped = text;
+    escaped.replace("\\", "\\\\");
+    escaped.replace("%", "\\%");
+    escaped.replace("_", "\\_");
+    return "%" + escaped + "%";
+}
+
+}
+
+TransactionQuery::TransactionQuery(const TransactionFilter &filter)
+    : filter_(filter)
+{
+    compile();
+}
+
+QString TransactionQuery::selectSql()
+{
+    return "SELECT t.id, t.transaction_date, "
+           "       d.code || ' - ' || d.name as debit, "
+           "       c.code || ' - ' || c.name as credit, "
+           "       t.amount, t.description, t.document_number, "
+           "       COALESCE(cp.name, '') as counterparty_name, "
+           "       t.debit_account_id, t.credit_account_id, "
+           "       COALESCE(t.counterparty_id, 0) "
+           "FROM transactions t "
+           "LEFT JOIN accounts d ON t.debit_account_id = d.id "
+           "LEFT JOIN accounts c ON t.credit_account_id = c.id "
+           "LEFT JOIN counterparties cp ON t.counterparty_id = cp.id ";
+}
+
+void TransactionQuery::compile()
+{
+    QStringList conditions;
+
+    if (filter_.dateFilterEnabled) {
+        conditions << "t.transaction_date BETWEEN ? AND ?";
+        whereParams_ << filter_.dateFrom << filter_.dateTo;
+    }
+
+    if (filter_.amountFilterEnabled) {
+        conditions << "t.amount BETWEEN ? AND ?";
+        whereParams_ << filter_.amountFrom << filter_.amountTo;
+    }
+
+    // С подсчетами счет раскрывается в поддерево по таблице замыкания
+    const QString accountMatch = filter_.includeSubaccounts
+        ? QString(" IN (%1)").arg(AccountTree::subtreeSql())
+        : QString(" = ?");
+
+    if (filter_.debitAccountId > 0) {
+        conditions << "t.debit_account_id" + accountMatch;
+        whereParams_ << filter_.debitAccountId;
+    }
+
+    if (filter_.creditAccountId > 0) {
+        conditions << "t.credit_account_id" + accountMatch;
+        whereParams_ << filter_.creditAccountId;
+    }
+
+    if (filter_.counterpartyId > 0) {
+        conditions << "t.counterparty_id = ?";
+        whereParams_ << filter_.counterpartyId;
+    }
+
+    QString text = filter_.textFilter.trimmed();
+    if (!text.isEmpty()) {
+        QString pattern = likePattern(text);
+
+        if (filter_.fieldFilter.isEmpty() || filter_.fieldFilter == "all") {
+            // Ищем во всех полях
+            QStringList fields = {"d.code", "d.name", "c.code", "c.name",
+                                  "t.description", "t.document_number", "cp.name"};
+            QStringList parts;
+            for (const QString &field : fields) {
+                parts << field + " LIKE ? ESCAPE '\\'";
+                whereParams_ << pattern;
+            }
+            conditions << "(" + parts.join(" OR ") + ")";
+            needsJoins_ = true;
+        } else if (filter_.fieldFilter == "description") {
+            conditions << "t.description LIKE ? ESCAPE '\\'";
+            whereParams_ << pattern;
+        } else if (filter_.fieldFilter == "comment") {
+            conditions << "(t.description LIKE ? ESCAPE '\\' OR t.document_number LIKE ? ESCAPE '\\')";
+            whereParams_ << pattern << pattern;
+        }
+    }
+
+    whereSql_ = conditions.isEmpty() ? QString("1=1") : conditions.join(" AND ");
+}
+
+QByteArray TransactionQuery::cacheKey() const
+{
+    // Условие WHERE уже нормализовано компиляцией: выключенные группы,
+    // пустой текст и "любой" счет в него не попадают
+    QByteArray canonical = whereSql_.toUtf8();
+    for (const QVariant &param : whereParams_) {
+        canonical += '\x1f';
+        if (param.typeId() == QMetaType::QDate) {
+            canonical += param.toDate().toString(Qt::ISODate).toUtf8();
+        } else if (param.typeId() == QMetaType::Double) {
+            canonical += QByteArray::number(param.toDouble(), 'g', 17);
+        } else {
+            canonical += param.toString().toUtf8();
+        }
+    }
+    return QCryptographicHash::hash(canonical, QCryptographicHash::Sha1);
+}
+
+QSqlQuery TransactionQuery::fetchPage(const PageKey *after, int limit) const
+{
+    QString sql = selectSql() + "WHERE " + whereSql_;
+    QVariantList params = whereParams_;
+
+    // Keyset-пагинация: продолжаем с последней показанной строки,
+    // а не пропускаем OFFSET строк на каждой странице
+    if (after) {
+        sql += " AND (t.transaction_date < ? OR (t.transaction_date = ? AND t.id < ?))";
+        params << after->date << after->date << after->id;
+    }
+
+    sql += " ORDER BY t.transaction_date DESC, t.id DESC LIMIT ?";
+    params << limit;
+
+    QSqlQuery query = Database::instance().executeQuery(sql, params);
+    return query;
+}
+
+QSqlQuery TransactionQuery::fetchAll() const
+{
+    QString sql = selectSql() + "WHERE " + whereSql_
+                + " ORDER BY t.transaction_date DESC, t.id DESC";
+    return Database::instance().executeCursor(sql, whereParams_);
+}
+
+QString TransactionQuery::fromSql() const
+{
+    // Соединения нужны только для текстового поиска по счетам и контрагенту
+    if (needsJoins_) {
+        return "FROM transactions t "
+               "LEFT JOIN accounts d ON t.debit_account_id = d.id "
+               "LEFT JOIN accounts c ON t.credit_account_id = c.id "
+               "LEFT JOIN counterparties cp ON t.counterparty_id = cp.id ";
+    }
+    return "FROM transactions t ";
+}
+
+QSqlQuery TransactionQuery::fetchIds(int limit) const
+{
+    QString sql = "SELECT t.id " + fromSql() + "WHERE " + whereSql_ +
+                  " ORDER BY t.transaction_date DESC, t.id DESC LIMIT ?";
+
+    QVariantList params = whereParams_;
+    params << limit;
+
+    return Database::instance().executeQuery(sql, params);
+}
+
+bool TransactionQuery::fetchTotals(TransactionTotals *totals) const
+{
+    QString sql = "SELECT COUNT(*), COALESCE(SUM(t.amount), 0), "
+                  "       COALESCE(MIN(t.amount), 0), COALESCE(MAX(t.amount), 0) " +
+                  fromSql() + "WHERE " + whereSql_;
+
+    QSqlQuery query = Database::instance().executeQuery(sql, whereParams_);
+    if (!query.next()) {
+        return false;
+    }
+
+    totals->count = query.value(0).toLongLong();
+    totals->sum = query.value(1).toDouble();
+    totals->minAmount = query.value(2).toDouble();
+    totals->maxAmount = query.value(3).toDouble();
+    return true;
+}
+
+QSqlQuery TransactionQuery::fetchMatching(const QVector<qint64> &ids) const
+{
+    QStringList placeholders;
+    QVariantList params = whereParams_;
+    for (qint64 id : ids) {
+        placeholders << "?";
+        params << id;
+    }
+
+    if (placeholders.isEmpty()) {
+        placeholders << "NULL";
+    }
+
+    QString sql = selectSql() + "WHERE (" + whereSql_ + ") "
+                  "AND t.id IN (" + placeholders.join(",") + ")";
+
+    return Database::instance().executeQuery(sql, params);
+}
+
+QSqlQuery TransactionQuery::fetchByIds(const QVector<qint64> &ids, int from, int count)
+{
+    QStringList placeholders;
+    QVariantList params;
+    int to = qMin(ids.size(), from + count);
+    for (int i = from; i < to; ++i) {
+        placeholders << "?";
+        params << ids.at(i);
+    }
+
+    if (placeholders.isEmpty()) {
+        placeholders << "NULL";
+    }
+
+    // Порядок id в списке совпадает с порядком сортировки списка проводок
+    QString sql = selectSql() + "WHERE t.id IN (" + placeholders.join(",") + ") "
+                  "ORDER BY t.transaction_date DESC, t.id DESC";
+
+    return Database::instance().executeQuery(sql, params);
+}
+
+TransactionRow TransactionQuery::readRow(const QSqlQuery &query)
+{
+    TransactionRow row;
+    row.id = query.value(0).toLongLong();
+    row.date = query.value(1).toDate();
+    row.debit = query.value(2).toString();
+    row.credit = query.value(3).toString();
+    row.amount = query.value(4).toDouble();
+    row.description = query.value(5).toString();
+    row.documentNumber = query.value(6).toString();
+    row.counterparty = query.value(7).toString();
+    row.debitAccountId = query.value(8).toInt();
+    row.creditAccountId = query.value(9).toInt();
+    row.counterpartyId = query.value(10).toInt();
+    return row;
+}
@@ -0,0 +1,233 @@
+#include "core/transactionsearch.h"
+#include "core/filterresultcache.h"
+#include "core/database.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThreadPool>
+#include <QMetaObject>
+#include <atomic>
+
+// Состояние, разделяемое с рабочими потоками. Переживает сам объект поиска,
+// поэтому поток, закончивший чтение после его удаления, просто ничего не доставит.
+struct TransactionSearch::Shared {
+    std::atomic<quint64> generation{0};
+    std::atomic<quint64> totalsSerial{0};  // доставляются только последние итоги
+    QMutex mutex;
+    TransactionSearch *owner = nullptr;   // защищен mutex
+};
+
+namespace {
+
+// Список id результата из кэша. nullptr - в кэше его нет (или результат
+// слишком велик для кэша), страницы читаются по ключу (дата, id).
+std::shared_ptr<const FilterResultCache::IdList> cachedIds(const TransactionQuery &query)
+{
+    qint64 version = Database::instance().ledgerVersion();
+    if (version < 0) return nullptr;
+
+    std::shared_ptr<const FilterResultCache::IdList> ids;
+    if (FilterResultCache::instance().lookup(query.cacheKey(), version, &ids)) {
+        return ids;
+    }
+    return nullptr;
+}
+
+// Строит список id результата и кладет его в кэш. Вызывается после
+// доставки первой страницы: время до первого экрана не зависит от размера
+// результата, а повторный поиск с тем же фильтром берет список из кэша.
+void cacheIds(const TransactionQuery &query, const std::atomic<quint64> &current, quint64 generation)
+{
+    qint64 version = Database::instance().ledgerVersion();
+    if (version < 0) return;
+
+    FilterResultCache &cache = FilterResultCache::instance();
+    QByteArray key = query.cacheKey();
+    std::shared_ptr<const FilterResultCache::IdList> ids;
+    if (cache.lookup(key, version, &ids)) return;
+
+    int maxIds = cache.maxIdsPerEntry();
+    auto list = std::make_shared<FilterResultCache::IdList>();
+
+    QSqlQuery sqlQuery = query.fetchIds(maxIds + 1);
+    while (sqlQuery.next()) {
+        if ((list->size() & 1023) == 0 && current.load() != generation) {
+            return;
+        }
+        list->append(sqlQuery.value(0).toLongLong());
+    }
+
+    if (list->size() > maxIds) {
+        cache.insertTooLarge(key, version);
+        return;
+    }
+
+    cache.insert(key, version, list);
+}
+
+}
+
+TransactionSearch::TransactionSearch(QObject *parent)
+    : QObject(parent)
+    , shared_(std::make_shared<Shared>())
+{
+    shared_->owner = this;
+}
+
+TransactionSearch::~TransactionSearch()
+{
+    QMutexLocker locker(&shared_->mutex);
+    shared_->owner = nullptr;
+    ++shared_->generation;
+}
+
+quint64 TransactionSearch::start(const TransactionFilter &filter, int firstPageSize)
+{
+    ++shared_->generation;
+    query_ = TransactionQuery(filter);
+    hasMore_ = false;
+    running_ = false;
+    ids_.reset();
+    offset_ = 0;
+
+    runPage(true, qMax(int(FirstPageSize), firstPageSize));
+    runTotals();
+    return generation();
+}
+
+void TransactionSearch::fetchMore()
+{
+    if (running_ || !hasMore_) return;
+    runPage(false, PageSize);
+}
+
+void TransactionSearch::cancel()
+{
+    ++shared_->generation;
+    running_ = false;
+    hasMore_ = false;
+}
+
+void TransactionSearch::refreshTotals()
+{
+    runTotals();
+}
+
+quint64 TransactionSearch::generation() const
+{
+    return shared_->generation.load();
+}
+
+void TransactionSearch::runPage(bool fromStart, int limit)
+{
+    running_ = true;
+
+    std::shared_ptr<Shared> shared = shared_;
+    quint64 generation = shared->generation.load();
+    TransactionQuery query = query_;
+    TransactionQuery::PageKey key = lastKey_;
+    std::shared_ptr<const IdList> ids = ids_;
+    int offset = offset_;
+
+    QThreadPool::globalInstance()->start([shared, generation, query, fromStart, key, ids, offset, limit]() {
+        if (shared->generation.load() != generation) return;
+
+        std::shared_ptr<const IdList> pageIds = fromStart ? cachedIds(query) : ids;
+
+        QVector<TransactionRow> rows;
+        rows.reserve(limit + 1);
+        bool hasMore = false;
+        int nextOffset = offset;
+
+        if (pageIds) {
+            // Страница по готовому списку id; большая страница (обновление
+            // с сохранением догруженных строк) - частями по MaxIdsPerQuery
+            nextOffset = qMin(pageIds->size(), offset + limit);
+            for (int from = offset; from < nextOffset; from += TransactionQuery::MaxIdsPerQuery) {
+                if (shared->generation.load() != generation) return;
+                QSqlQuery sqlQuery = TransactionQuery::fetchByIds(
+                    *pageIds, from, qMin(int(TransactionQuery::MaxIdsPerQuery), nextOffset - from));
+                while (sqlQuery.next()) {
+                    rows.append(TransactionQuery::readRow(sqlQuery));
+                }
+            }
+            hasMore = nextOffset < pageIds->size();
+        } else {
+            // Лишняя строка показывает, есть ли следующая страница
+            QSqlQuery sqlQuery = query.fetchPage(fromStart ? nullptr : &key, limit + 1);
+            while (sqlQuery.next()) {
+                // Новый фильтр отменяет текущее чтение
+                if ((rows.size() & 63) == 0 && shared->generation.load() != generation) {
+                    return;
+                }
+                rows.append(TransactionQuery::readRow(sqlQuery));
+            }
+
+            hasMore = rows.size() > limit;
+            if (hasMore) {
+                rows.removeLast();
+            }
+        }
+
+        {
+            QMutexLocker locker(&shared->mutex);
+            TransactionSearch *owner = shared->owner;
+            if (!owner || shared->generation.load() != generation) return;
+            QMetaObject::invokeMethod(owner, [owner, generation, rows, hasMore, pageIds, nextOffset]() {
+                owner->deliverPage(generation, rows, hasMore, pageIds, nextOffset);
+            }, Qt::QueuedConnection);
+        }
+
+        // Первая страница уже у получателя; список id - для следующих
+        // поисков с тем же фильтром. Текущий поиск дочитывает по ключу.
+        if (fromStart && !pageIds && hasMore) {
+            cacheIds(query, shared->generation, generation);
+        }
+    });
+}
+
+void TransactionSearch::runTotals()
+{
+    std::shared_ptr<Shared> shared = shared_;
+    quint64 generation = shared->generation.load();
+    quint64 serial = ++shared->totalsSerial;
+    TransactionQuery query = query_;
+
+    // Отдельная задача пула: агрегат идет через свое соединение потока
+    // одновременно с чтением первой страницы
+    QThreadPool::globalInstance()->start([shared, generation, serial, query]() {
+        if (shared->generation.load() != generation) return;
+
+        TransactionTotals totals;
+        if (!query.fetchTotals(&totals)) return;
+
+        QMutexLocker locker(&shared->mutex);
+        TransactionSearch *owner = shared->owner;
+        if (owner && shared->generation.load() == generation
+            && shared->totalsSerial.load() == serial) {
+            QMetaObject::invokeMethod(owner, [owner, generation, totals]() {
+                if (generation == owner->generation()) {
+                    emit owner->totalsReady(generation, totals);
+                }
+            }, Qt::QueuedConnection);
+        }
+    });
+}
+
+void TransactionSearch::deliverPage(quint64 generation, const QVector<TransactionRow> &rows,
+                                    bool hasMore, std::shared_ptr<const IdList> ids,
+                                    int nextOffset)
+{
+    if (generation != this->generation()) return;
+
+    running_ = false;
+    hasMore_ = hasMore;
+    ids_ = ids;
+    offset_ = nextOffset;
+    if (!rows.isEmpty()) {
+        lastKey_.date = rows.last().date;
+        lastKey_.id = rows.last().id;
+    }
+
+    emit pageReady(generation, rows, hasMore);
+}
@@ -1,7 +1,33 @@
 #include "core/validationrules.h"
-#include <QRegularExpression>
 #include <QDate>
 
+namespace {
+
+// Контрольные цифры ИНН: взвешенная сумма цифр по модулю 11, затем 10
+const int Weights10[] = {2, 4, 10, 3, 5, 9, 4, 6, 8};
+const int Weights11[] = {7, 2, 4, 10, 3, 5, 9, 4, 6, 8};
+const int Weights12[] = {3, 7, 2, 4, 10, 3, 5, 9, 4, 6, 8};
+
+int innCheckDigit(const int *digits, const int *weights, int count)
+{
+    int sum = 0;
+    for (int i = 0; i < count; ++i) sum += weights[i] * digits[i];
+    return sum % 11 % 10;
+}
+
+// Цифры строки в digits (не больше 12); false - есть не цифра
+bool innDigits(const QString &text, int *digits)
+{
+    for (int i = 0; i < text.length(); ++i) {
+        const QChar c = text.at(i);
+        if (c < QLatin1Char('0') || c > QLatin1Char('9')) return false;
+        digits[i] = c.unicode() - '0';
+    }
+    return true;
+}
+
+}
+
 ValidationRules::ValidationRules(QObject *parent)
     : QObject(parent)
 {
@@ -92,6 +118,14 @@ bool ValidationRules::validateAmount(double amount)
     return amount > 0 && amount <= 1000000000; // Ограничение на максимальную сумму
 }
 
+double ValidationRules::parseAmount(QString text, bool *ok)
+{
+    text.remove(' ');
+    text.remove(QChar(0x00A0));
+    text.replace(',', '.');
+    return text.toDouble(ok);
+}
+
 bool ValidationRules::validateDate(const QDate &date)
 {
     return date.isValid() && date <= QDate::currentDate();
@@ -100,14 +134,40 @@ bool ValidationRules::validateDate(const QDate &date)
 bool ValidationRules::isValidAccountCode(const QString &code)
 {
     // Код счета должен состоять только из цифр и точек
-    QRegularExpression regex("^[0-9.]*$");
-    return regex.match(code).hasMatch() && code.length() <= 20;
+    if (code.length() > 20) return false;
+    for (QChar c : code) {
+        if ((c < QLatin1Char('0') || c > QLatin1Char('9')) && c != QLatin1Char('.')) return false;
+    }
+    return true;
 }
 
 bool ValidationRules::isValidINN(const QString &inn)
 {
-    // Проверка ИНН (10 или 12 цифр)
-    QString cleanInn = inn.trimmed();
-    QRegularExpression regex("^[0-9]{10}$|^[0-9]{12}$");
-    return regex.match(cleanInn).hasMatch();
+    const QString cleanInn = inn.trimmed();
+    const int length = cleanInn.length();
+    if (length != 10 && length != 12) return false;
+
+    int digits[12];
+    if (!innDigits(cleanInn, digits)) return false;
+
+    if (length == 10) {
+        return innCheckDigit(digits, Weights10, 9) == digits[9];
+    }
+    return innCheckDigit(digits, Weights11, 10) == digits[10]
+           && innCheckDigit(digits, Weights12, 11) == digits[11];
+}
+
+QString ValidationRules::completeINN(const QString &body)
+{
+    const int length = body.length();
+    if (length != 9 && length != 10) return QString();
+
+    int digits[12];
+    if (!innDigits(body, digits)) return QString();
+
+    if (length == 9) {
+        return body + QChar('0' + innCheckDigit(digits, Weights10, 9));
+    }
+    digits[10] = innCheckDigit(digits, Weights11, 10);
+    return body + QChar('0' + digits[10]) + QChar('0' + innCheckDigit(digits, Weights12, 11));
 }
@@ -0,0 +1,406 @@
+#include "core/xlsxwriter.h"
+
+#include <QDebug>
+#include <cmath>
+
+namespace {
+
+const char *MainNamespace = "http://schemas.openxmlformats.org/spreadsheetml/2006/main";
+const char *RelNamespace = "http://schemas.openxmlformats.org/officeDocument/2006/relationships";
+const char *XmlProlog = "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n";
+
+// Предел строк листа Excel (вместе с заголовком)
+const qint64 MaxSheetRows = 1048576;
+
+// Сколько разных строк помнить для повторного использования. Дальше новые
+// строки просто дописываются в таблицу - память не растет с числом строк
+const int MaxIndexedStrings = 200000;
+
+const int FlushSize = 1 << 20;
+
+// Текст для XML: экранирование и удаление недопустимых в XML 1.0 символов
+QByteArray xmlText(const QString &text)
+{
+    QString escaped;
+    escaped.reserve(text.size());
+    for (QChar ch : text) {
+        const ushort code = ch.unicode();
+        switch (code) {
+        case '&': escaped += "&amp;"; break;
+        case '<': escaped += "&lt;"; break;
+        case '>': escaped += "&gt;"; break;
+        case '"': escaped += "&quot;"; break;
+        default:
+            if ((code < 0x20 && code != '\t' && code != '\n' && code != '\r')
+                || code == 0xFFFE || code == 0xFFFF) {
+                continue;
+            }
+            escaped += ch;
+        }
+    }
+    return escaped.toUtf8();
+}
+
+// Серийный номер даты Excel: дни от 30.12.1899
+qint64 excelDate(const QDate &date)
+{
+    return QDate(1899, 12, 30).daysTo(date);
+}
+
+}
+
+XlsxWriter::XlsxWriter() = default;
+
+XlsxWriter::~XlsxWriter() = default;
+
+bool XlsxWriter::open(const QString &fileName, const QString &sheetName,
+                      const QStringList &headers, const QVector<int> &columnWidths)
+{
+    rows_ = 0;
+    sheetCount_ = 0;
+    stringCount_ = 0;
+    stringRefs_ = 0;
+    stringIndex_.clear();
+    stringsBuffer_.clear();
+    failed_ = false;
+    error_.clear();
+
+    headers_ = headers;
+    columnWidths_ = columnWidths;
+    if (columnWidths_.isEmpty()) {
+        for (const QString &header : headers_) {
+            columnWidths_.append(qMax(10, int(header.size()) + 4));
+        }
+    }
+
+    // Имя листа - до 31 символа, без символов, запрещенных Excel
+    sheetName_ = sheetName;
+    for (QChar ch : QString("[]:*?/\\")) {
+        sheetName_.replace(ch, '_');
+    }
+    if (sheetName_.isEmpty()) sheetName_ = "Лист1";
+
+    if (!strings_.open()) {
+        error_ = "Не удалось создать временный файл: " + strings_.errorString();
+        return false;
+    }
+
+    if (!zip_.open(fileName)) {
+        error_ = "Не удалось создать файл: " + zip_.errorString();
+        return false;
+    }
+
+    sheet_.reserve(FlushSize + 64 * 1024);
+    beginSheet();
+    return !failed_;
+}
+
+int XlsxWriter::sharedString(const QString &text)
+{
+    ++stringRefs_;
+
+    auto it = stringIndex_.constFind(text);
+    if (it != stringIndex_.constEnd()) {
+        return it.value();
+    }
+
+    const int index = stringCount_++;
+    if (stringIndex_.size() < MaxIndexedStrings) {
+        stringIndex_.insert(text, index);
+    }
+
+    // Пробелы по краям Excel сохраняет только с xml:space="preserve"
+    const bool preserve = !text.isEmpty()
+        && (text.front().isSpace() || text.back().isSpace());
+    stringsBuffer_ += preserve ? "<si><t xml:space=\"preserve\">" : "<si><t>";
+    stringsBuffer_ += xmlText(text);
+    stringsBuffer_ += "</t></si>";
+
+    if (stringsBuffer_.size() >= FlushSize) {
+        flushStrings();
+    }
+    return index;
+}
+
+void XlsxWriter::beginSheet()
+{
+    ++sheetCount_;
+    if (!zip_.beginEntry(QString("xl/worksheets/sheet%1.xml").arg(sheetCount_))) {
+        failed_ = true;
+        error_ = zip_.errorString();
+        return;
+    }
+
+    sheet_ = XmlProlog;
+    sheet_ += QByteArray("<worksheet xmlns=\"") + MainNamespace + "\">";
+
+    // Закрепленная строка заголовков
+    sheet_ += "<sheetViews><sheetView workbookViewId=\"0\">"
+              "<pane ySplit=\"1\" topLeftCell=\"A2\" activePane=\"bottomLeft\" state=\"frozen\"/>"
+              "<selection pane=\"bottomLeft\" activeCell=\"A2\" sqref=\"A2\"/>"
+              "</sheetView></sheetViews>";
+
+    sheet_ += "<cols>";
+    for (int col = 0; col < columnWidths_.size(); ++col) {
+        sheet_ += QString("<col min=\"%1\" max=\"%1\" width=\"%2\" customWidth=\"1\"/>")
+                      .arg(col + 1).arg(columnWidths_.at(col)).toUtf8();
+    }
+    sheet_ += "</cols><sheetData>";
+
+    sheet_ += "<row r=\"1\">";
+    for (const QString &header : headers_) {
+        addStringCell(header, HeaderStyle);
+    }
+    sheet_ += "</row>";
+    sheetRows_ = 1;
+    rowOpen_ = false;
+}
+
+bool XlsxWriter::flushSheet()
+{
+    if (!failed_ && !sheet_.isEmpty() && !zip_.write(sheet_)) {
+        failed_ = true;
+        error_ = "Ошибка записи: " + zip_.errorString();
+    }
+    sheet_.resize(0);
+    return !failed_;
+}
+
+bool XlsxWriter::finishSheet()
+{
+    sheet_ += "</sheetData></worksheet>";
+    flushSheet();
+    if (!failed_ && !zip_.endEntry()) {
+        failed_ = true;
+        error_ = "Ошибка записи: " + zip_.errorString();
+    }
+    return !failed_;
+}
+
+bool XlsxWriter::flushStrings()
+{
+    if (!failed_ && !stringsBuffer_.isEmpty()
+        && strings_.write(stringsBuffer_) != stringsBuffer_.size()) {
+        failed_ = true;
+        error_ = "Ошибка записи временного файла: " + strings_.errorString();
+    }
+    stringsBuffer_.resize(0);
+    return !failed_;
+}
+
+void XlsxWriter::addStringCell(const QString &text, Style style)
+{
+    sheet_ += "<c t=\"s\"";
+    if (style != DefaultStyle) {
+        sheet_ += " s=\"" + QByteArray::number(int(style)) + "\"";
+    }
+    sheet_ += "><v>" + QByteArray::number(sharedString(text)) + "</v></c>";
+}
+
+void XlsxWriter::openRow()
+{
+    if (rowOpen_) return;
+
+    if (sheetRows_ >= MaxSheetRows) {
+        finishSheet();
+        beginSheet();
+    }
+
+    sheet_ += "<row r=\"" + QByteArray::number(sheetRows_ + 1) + "\">";
+    rowOpen_ = true;
+}
+
+void XlsxWriter::addString(const QString &text)
+{
+    if (text.isEmpty()) {
+        addEmpty();
+        return;
+    }
+
+    openRow();
+    addStringCell(text, DefaultStyle);
+}
+
+void XlsxWriter::addNumber(double value)
+{
+    if (!std::isfinite(value)) {
+        addEmpty();
+        return;
+    }
+
+    openRow();
+    sheet_ += "<c s=\"" + QByteArray::number(int(AmountStyle)) + "\"><v>"
+            + QByteArray::number(value, 'g', 15) + "</v></c>";
+}
+
+void XlsxWriter::addDate(const QDate &date)
+{
+    if (!date.isValid()) {
+        addEmpty();
+        return;
+    }
+
+    openRow();
+    sheet_ += "<c s=\"" + QByteArray::number(int(DateStyle)) + "\"><v>"
+            + QByteArray::number(excelDate(date)) + "</v></c>";
+}
+
+void XlsxWriter::addEmpty()
+{
+    // Ячейки без адреса занимают следующий столбец, поэтому пустая
+    // ячейка все равно пишется, иначе последующие сдвинутся влево
+    openRow();
+    sheet_ += "<c/>";
+}
+
+void XlsxWriter::endRow()
+{
+    openRow();
+    sheet_ += "</row>";
+    rowOpen_ = false;
+    ++sheetRows_;
+    ++rows_;
+
+    if (sheet_.size() >= FlushSize) {
+        flushSheet();
+    }
+}
+
+bool XlsxWriter::writeSharedStrings()
+{
+    if (!flushStrings()) return false;
+
+    if (!zip_.beginEntry("xl/sharedStrings.xml")) {
+        failed_ = true;
+        error_ = "Ошибка записи: " + zip_.errorString();
+        return false;
+    }
+
+    QByteArray header = XmlProlog;
+    header += QByteArray("<sst xmlns=\"") + MainNamespace + "\" count=\""
+            + QByteArray::number(stringRefs_) + "\" uniqueCount=\""
+            + QByteArray::number(stringCount_) + "\">";
+    bool ok = zip_.write(header);
+
+    // Таблица строк переписывается из временного файла блоками
+    strings_.seek(0);
+    QByteArray chunk;
+    while (ok && !strings_.atEnd()) {
+        chunk = strings_.read(FlushSize);
+        if (chunk.isEmpty()) break;
+        ok = zip_.write(chunk);
+    }
+
+    ok = ok && zip_.write(QByteArray("</sst>")) && zip_.endEntry();
+    if (!ok) {
+        failed_ = true;
+        error_ = "Ошибка записи: " + zip_.errorString();
+    }
+    return ok;
+}
+
+bool XlsxWriter::writeMetadata()
+{
+    auto entry = [this](const QString &name, const QByteArray &content) {
+        if (failed_) return false;
+        if (!zip_.beginEntry(name) || !zip_.write(content) || !zip_.endEntry()) {
+            failed_ = true;
+            error_ = "Ошибка записи: " + zip_.errorString();
+            return false;
+        }
+        return true;
+    };
+
+    QByteArray contentTypes = XmlProlog;
+    contentTypes += "<Types xmlns=\"http://schemas.openxmlformats.org/package/2006/content-types\">"
+                    "<Default Extension=\"rels\" ContentType=\"application/vnd.openxmlformats-package.relationships+xml\"/>"
+                    "<Default Extension=\"xml\" ContentType=\"application/xml\"/>"
+                    "<Override PartName=\"/xl/workbook.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.sheet.main+xml\"/>"
+                    "<Override PartName=\"/xl/styles.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.styles+xml\"/>"
+                    "<Override PartName=\"/xl/sharedStrings.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.sharedStrings+xml\"/>";
+    for (int sheet = 1; sheet <= sheetCount_; ++sheet) {
+        contentTypes += "<Override PartName=\"/xl/worksheets/sheet" + QByteArray::number(sheet)
+                      + ".xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.worksheet+xml\"/>";
+    }
+    contentTypes += "</Types>";
+
+    QByteArray rootRels = XmlProlog;
+    rootRels += "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">"
+                "<Relationship Id=\"rId1\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/officeDocument\" Target=\"xl/workbook.xml\"/>"
+                "</Relationships>";
+
+    QByteArray workbook = XmlProlog;
+    workbook += QByteArray("<workbook xmlns=\"") + MainNamespace + "\" xmlns:r=\"" + RelNamespace + "\"><sheets>";
+    for (int sheet = 1; sheet <= sheetCount_; ++sheet) {
+        QString name = sheetName_;
+        if (sheet > 1) {
+            const QString suffix = QString(" (%1)").arg(sheet);
+            name = name.left(31 - suffix.size()) + suffix;
+        } else {
+            name = name.left(31);
+        }
+        workbook += "<sheet name=\"" + xmlText(name) + "\" sheetId=\"" + QByteArray::number(sheet)
+                  + "\" r:id=\"rId" + QByteArray::number(sheet) + "\"/>";
+    }
+    workbook += "</sheets></workbook>";
+
+    QByteArray workbookRels = XmlProlog;
+    workbookRels += "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">";
+    for (int sheet = 1; sheet <= sheetCount_; ++sheet) {
+        workbookRels += "<Relationship Id=\"rId" + QByteArray::number(sheet)
+                      + "\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/worksheet\""
+                        " Target=\"worksheets/sheet" + QByteArray::number(sheet) + ".xml\"/>";
+    }
+    workbookRels += "<Relationship Id=\"rId" + QByteArray::number(sheetCount_ + 1)
+                  + "\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/styles\" Target=\"styles.xml\"/>";
+    workbookRels += "<Relationship Id=\"rId" + QByteArray::number(sheetCount_ + 2)
+                  + "\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/sharedStrings\" Target=\"sharedStrings.xml\"/>";
+    workbookRels += "</Relationships>";
+
+    // Стили в порядке enum Style: обычный, заголовок, дата, сумма
+    QByteArray styles = XmlProlog;
+    styles += QByteArray("<styleSheet xmlns=\"") + MainNamespace + "\">"
+              "<numFmts count=\"1\"><numFmt numFmtId=\"164\" formatCode=\"dd.mm.yyyy\"/></numFmts>"
+              "<fonts count=\"2\">"
+              "<font><sz val=\"11\"/><name val=\"Calibri\"/></font>"
+              "<font><b/><sz val=\"11\"/><name val=\"Calibri\"/></font>"
+              "</fonts>"
+              "<fills count=\"2\">"
+              "<fill><patternFill patternType=\"none\"/></fill>"
+              "<fill><patternFill patternType=\"gray125\"/></fill>"
+              "</fills>"
+              "<borders count=\"1\"><border><left/><right/><top/><bottom/><diagonal/></border></borders>"
+              "<cellStyleXfs count=\"1\"><xf numFmtId=\"0\" fontId=\"0\" fillId=\"0\" borderId=\"0\"/></cellStyleXfs>"
+              "<cellXfs count=\"4\">"
+              "<xf numFmtId=\"0\" fontId=\"0\" fillId=\"0\" borderId=\"0\" xfId=\"0\"/>"
+              "<xf numFmtId=\"0\" fontId=\"1\" fillId=\"0\" borderId=\"0\" xfId=\"0\" applyFont=\"1\"/>"
+              "<xf numFmtId=\"164\" fontId=\"0\" fillId=\"0\" borderId=\"0\" xfId=\"0\" applyNumberFormat=\"1\"/>"
+              "<xf numFmtId=\"4\" fontId=\"0\" fillId=\"0\" borderId=\"0\" xfId=\"0\" applyNumberFormat=\"1\"/>"
+              "</cellXfs>"
+              "<cellStyles count=\"1\"><cellStyle name=\"Normal\" xfId=\"0\" builtinId=\"0\"/></cellStyles>"
+              "</styleSheet>";
+
+    return entry("[Content_Types].xml", contentTypes)
+        && entry("_rels/.rels", rootRels)
+        && entry("xl/workbook.xml", workbook)
+        && entry("xl/_rels/workbook.xml.rels", workbookRels)
+        && entry("xl/styles.xml", styles);
+}
+
+bool XlsxWriter::close()
+{
+    if (rowOpen_) endRow();
+
+    if (!failed_) finishSheet();
+    if (!failed_) writeSharedStrings();
+    if (!failed_) writeMetadata();
+
+    if (!zip_.close() && !failed_) {
+        failed_ = true;
+        error_ = "Ошибка записи: " + zip_.errorString();
+    }
+
+    strings_.close();
+    stringIndex_.clear();
+    return !failed_;
+}
@@ -0,0 +1,247 @@
+#include "core/zipwriter.h"
+
+#include <QDateTime>
+#include <QtEndian>
+#include <QDebug>
+#include <zlib.h>
+
+namespace {
+
+const int DeflateChunk = 256 * 1024;
+
+// Флаги записи: 3 - размеры в дескрипторе после данных, 11 - имена в UTF-8
+const quint16 EntryFlags = (1 << 3) | (1 << 11);
+const quint16 MethodDeflate = 8;
+const quint16 VersionNeeded = 20;
+
+void put16(QByteArray &out, quint16 value)
+{
+    char bytes[2];
+    qToLittleEndian(value, bytes);
+    out.append(bytes, 2);
+}
+
+void put32(QByteArray &out, quint32 value)
+{
+    char bytes[4];
+    qToLittleEndian(value, bytes);
+    out.append(bytes, 4);
+}
+
+}
+
+struct ZipWriter::Deflate {
+    z_stream stream;
+    QByteArray out;
+};
+
+ZipWriter::ZipWriter() = default;
+
+ZipWriter::~ZipWriter()
+{
+    if (deflate_) {
+        deflateEnd(&deflate_->stream);
+    }
+}
+
+bool ZipWriter::fail(const QString &message)
+{
+    if (!failed_) {
+        failed_ = true;
+        error_ = message;
+        qWarning() << "Zip write failed:" << message;
+    }
+    return false;
+}
+
+bool ZipWriter::open(const QString &fileName)
+{
+    entries_.clear();
+    inEntry_ = false;
+    failed_ = false;
+    error_.clear();
+
+    file_.setFileName(fileName);
+    if (!file_.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return fail(file_.errorString());
+    }
+
+    // Время в формате MS-DOS: одно на все файлы архива
+    const QDateTime now = QDateTime::currentDateTime();
+    const QDate date = now.date();
+    const QTime time = now.time();
+    dosTime_ = quint16((time.hour() << 11) | (time.minute() << 5) | (time.second() / 2));
+    dosDate_ = quint16(((qMax(date.year(), 1980) - 1980) << 9) | (date.month() << 5) | date.day());
+
+    deflate_ = std::make_unique<Deflate>();
+    deflate_->stream = z_stream();
+    deflate_->out.resize(DeflateChunk);
+
+    // Отрицательное окно - "сырой" deflate без заголовка zlib, как требует zip
+    if (deflateInit2(&deflate_->stream, Z_BEST_SPEED, Z_DEFLATED, -15, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
+        deflate_.reset();
+        file_.close();
+        return fail("Не удалось инициализировать сжатие");
+    }
+    return true;
+}
+
+bool ZipWriter::writeRaw(const QByteArray &data)
+{
+    if (failed_) return false;
+    if (file_.write(data) != data.size()) {
+        return fail(file_.errorString());
+    }
+    return true;
+}
+
+bool ZipWriter::beginEntry(const QString &name)
+{
+    if (failed_ || !deflate_) return false;
+    if (inEntry_ && !endEntry()) return false;
+
+    if (file_.pos() > 0xFFFFFFFFLL) {
+        return fail("Архив больше 4 ГБ");
+    }
+
+    current_ = Entry();
+    current_.name = name.toUtf8();
+    current_.offset = quint32(file_.pos());
+    current_.crc = quint32(crc32(0L, Z_NULL, 0));
+
+    // Локальный заголовок: CRC и размеры нулевые, они будут в дескрипторе
+    QByteArray header;
+    put32(header, 0x04034b50);
+    put16(header, VersionNeeded);
+    put16(header, EntryFlags);
+    put16(header, MethodDeflate);
+    put16(header, dosTime_);
+    put16(header, dosDate_);
+    put32(header, 0);
+    put32(header, 0);
+    put32(header, 0);
+    put16(header, quint16(current_.name.size()));
+    put16(header, 0);
+    header.append(current_.name);
+
+    deflateReset(&deflate_->stream);
+    inEntry_ = true;
+    return writeRaw(header);
+}
+
+bool ZipWriter::deflateInput(const char *data, qint64 size, bool finish)
+{
+    z_stream &stream = deflate_->stream;
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+    stream.avail_in = uInt(size);
+
+    do {
+        stream.next_out = reinterpret_cast<Bytef *>(deflate_->out.data());
+        stream.avail_out = uInt(deflate_->out.size());
+        deflate(&stream, finish ? Z_FINISH : Z_NO_FLUSH);
+
+        const qint64 produced = deflate_->out.size() - stream.avail_out;
+        if (produced > 0) {
+            if (file_.write(deflate_->out.constData(), produced) != produced) {
+                return fail(file_.errorString());
+            }
+            current_.compressedSize += quint32(produced);
+        }
+    } while (stream.avail_out == 0);
+
+    return true;
+}
+
+bool ZipWriter::write(const char *data, qint64 size)
+{
+    if (failed_ || !inEntry_) return false;
+    if (size <= 0) return true;
+
+    if (quint64(current_.size) + quint64(size) > 0xFFFFFFFFULL) {
+        return fail("Файл в архиве больше 4 ГБ");
+    }
+
+    current_.crc = quint32(crc32(current_.crc, reinterpret_cast<const Bytef *>(data), uInt(size)));
+    current_.size += quint32(size);
+    return deflateInput(data, size, false);
+}
+
+bool ZipWriter::endEntry()
+{
+    if (failed_ || !inEntry_) return false;
+    inEntry_ = false;
+
+    if (!deflateInput(nullptr, 0, true)) return false;
+
+    QByteArray descriptor;
+    put32(descriptor, 0x08074b50);
+    put32(descriptor, current_.crc);
+    put32(descriptor, current_.compressedSize);
+    put32(descriptor, current_.size);
+
+    entries_.append(current_);
+    return writeRaw(descriptor);
+}
+
+bool ZipWriter::close()
+{
+    if (!file_.isOpen()) return !failed_;
+
+    if (inEntry_) {
+        endEntry();
+    }
+
+    if (!failed_) {
+        const qint64 directoryOffset = file_.pos();
+
+        QByteArray directory;
+        for (const Entry &entry : entries_) {
+            put32(directory, 0x02014b50);
+            put16(directory, VersionNeeded);    // создано: MS-DOS, версия 2.0
+            put16(directory, VersionNeeded);
+            put16(directory, EntryFlags);
+            put16(directory, MethodDeflate);
+            put16(directory, dosTime_);
+            put16(directory, dosDate_);
+            put32(directory, entry.crc);
+            put32(directory, entry.compressedSize);
+            put32(directory, entry.size);
+            put16(directory, quint16(entry.name.size()));
+            put16(directory, 0);                // дополнительное поле
+            put16(directory, 0);                // комментарий
+            put16(directory, 0);                // номер диска
+            put16(directory, 0);                // внутренние атрибуты
+            put32(directory, 0);                // внешние атрибуты
+            put32(directory, entry.offset);
+            directory.append(entry.name);
+        }
+
+        QByteArray end;
+        put32(end, 0x06054b50);
+        put16(end, 0);
+        put16(end, 0);
+        put16(end, quint16(entries_.size()));
+        put16(end, quint16(entries_.size()));
+        put32(end, quint32(directory.size()));
+        put32(end, quint32(directoryOffset));
+        put16(end, 0);
+
+        if (directoryOffset > 0xFFFFFFFFLL) {
+            fail("Архив больше 4 ГБ");
+        } else if (writeRaw(directory)) {
+            writeRaw(end);
+        }
+    }
+
+    if (deflate_) {
+        deflateEnd(&deflate_->stream);
+        deflate_.reset();
+    }
+
+    file_.close();
+    if (!failed_ && file_.error() != QFileDevice::NoError) {
+        fail(file_.errorString());
+    }
+    return !failed_;
+}
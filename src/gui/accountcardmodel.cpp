@@ -0,0 +1,241 @@
+#include "gui/accountcardmodel.h"
+#include "core/database.h"
+
+#include <QBrush>
+#include <QColor>
+#include <QFont>
+#include <QSet>
+#include <QStringList>
+#include <QDebug>
+
+// Начало каждой страницы - строка с ключом, страница читается без пропуска строк
+static_assert(AccountCardModel::PageSize % AccountCardQuery::KeyStride == 0,
+              "account card pages must start at key rows");
+
+AccountCardModel::AccountCardModel(QObject *parent)
+    : QAbstractTableModel(parent)
+{
+}
+
+bool AccountCardModel::setParams(const AccountCardParams &params)
+{
+    AccountCardSummary summary;
+    if (!AccountCardQuery(params).fetchSummary(&summary)) {
+        return false;
+    }
+
+    beginResetModel();
+    params_ = params;
+    summary_ = summary;
+    loaded_ = true;
+    pages_.clear();
+    pageOrder_.clear();
+    pageEnds_.clear();
+    counterpartyNames_.clear();
+
+    // Справочник счетов небольшой, читается целиком на каждый отчет
+    accountNames_.clear();
+    accountCodes_.clear();
+    QSqlQuery query = Database::instance().executeQuery("SELECT id, code, name FROM accounts");
+    while (query.next()) {
+        int id = query.value(0).toInt();
+        QString code = query.value(1).toString();
+        accountCodes_.insert(id, code);
+        accountNames_.insert(id, code + " - " + query.value(2).toString());
+    }
+    endResetModel();
+    return true;
+}
+
+void AccountCardModel::clear()
+{
+    beginResetModel();
+    loaded_ = false;
+    summary_ = AccountCardSummary();
+    pages_.clear();
+    pageOrder_.clear();
+    pageEnds_.clear();
+    counterpartyNames_.clear();
+    endResetModel();
+}
+
+int AccountCardModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid() || !loaded_) return 0;
+    return int(summary_.count) + 2;
+}
+
+int AccountCardModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+const AccountCardEntry *AccountCardModel::entryAt(qint64 position) const
+{
+    int page = int(position / PageSize);
+    if (!pages_.contains(page)) {
+        loadPage(page);
+    } else if (pageOrder_.last() != page) {
+        pageOrder_.removeOne(page);
+        pageOrder_.append(page);
+    }
+
+    const QVector<AccountCardEntry> &entries = pages_[page];
+    int offset = int(position % PageSize);
+    return offset < entries.size() ? &entries.at(offset) : nullptr;
+}
+
+void AccountCardModel::loadPage(int page) const
+{
+    AccountCardQuery query(params_);
+
+    // После предыдущей страницы продолжаем по ключу - это обычная прокрутка.
+    // При прыжке в середину - по смещению: fetchEntries находит ключ
+    // страницы в кэшированном списке ключей карточки.
+    QVector<AccountCardEntry> entries;
+    if (page > 0 && pageEnds_.contains(page - 1)) {
+        entries = query.fetchEntriesAfter(pageEnds_.value(page - 1), PageSize);
+    } else {
+        entries = query.fetchEntries(qint64(page) * PageSize, PageSize, summary_.opening);
+    }
+
+    if (!entries.isEmpty()) {
+        pageEnds_.insert(page, entries.last());
+    }
+    resolveCounterparties(entries);
+
+    pages_.insert(page, entries);
+    pageOrder_.append(page);
+
+    while (pageOrder_.size() > MaxCachedPages) {
+        pages_.remove(pageOrder_.takeFirst());
+    }
+}
+
+void AccountCardModel::resolveCounterparties(const QVector<AccountCardEntry> &entries) const
+{
+    QSet<int> missing;
+    for (const AccountCardEntry &entry : entries) {
+        if (entry.counterpartyId > 0 && !counterpartyNames_.contains(entry.counterpartyId)) {
+            missing.insert(entry.counterpartyId);
+        }
+    }
+    if (missing.isEmpty()) return;
+
+    QStringList placeholders;
+    QVariantList params;
+    for (int id : missing) {
+        placeholders << "?";
+        params << id;
+    }
+
+    QSqlQuery query = Database::instance().executeQuery(
+        "SELECT id, name FROM counterparties WHERE id IN (" + placeholders.join(",") + ")",
+        params);
+    while (query.next()) {
+        counterpartyNames_.insert(query.value(0).toInt(), query.value(1).toString());
+    }
+}
+
+QString AccountCardModel::amountText(double value)
+{
+    return qFuzzyIsNull(value) ? QString() : QString::number(value, 'f', 2);
+}
+
+QString AccountCardModel::balanceText(double value)
+{
+    if (qFuzzyIsNull(value)) return QString("0.00");
+    return QString("%1 %2").arg(value > 0 ? "Д" : "К")
+                           .arg(QString::number(qAbs(value), 'f', 2));
+}
+
+QVariant AccountCardModel::displayValue(int row, int column) const
+{
+    // Входящее сальдо
+    if (row == 0) {
+        switch (column) {
+        case DateColumn: return params_.dateFrom.toString("dd.MM.yyyy");
+        case OppositeColumn: return tr("Сальдо на начало");
+        case BalanceColumn: return balanceText(summary_.opening);
+        }
+        return QString();
+    }
+
+    // Обороты и сальдо на конец
+    if (row == rowCount() - 1) {
+        switch (column) {
+        case DateColumn: return tr("ИТОГО:");
+        case OppositeColumn: return tr("Обороты / сальдо на конец");
+        case DebitColumn: return QString::number(summary_.debit, 'f', 2);
+        case CreditColumn: return QString::number(summary_.credit, 'f', 2);
+        case BalanceColumn: return balanceText(summary_.closing());
+        }
+        return QString();
+    }
+
+    const AccountCardEntry *entry = entryAt(row - 1);
+    if (!entry) return QVariant();
+
+    switch (column) {
+    case DateColumn: return entry->date.toString("dd.MM.yyyy");
+    case AccountColumn: return accountCodes_.value(entry->accountId);
+    case DocumentColumn: return entry->documentNumber;
+    case CounterpartyColumn: return counterpartyNames_.value(entry->counterpartyId);
+    case OppositeColumn: return accountNames_.value(entry->oppositeId);
+    case DebitColumn: return amountText(entry->debit());
+    case CreditColumn: return amountText(entry->credit());
+    case BalanceColumn: return balanceText(entry->balance);
+    case DescriptionColumn: return entry->description;
+    }
+    return QVariant();
+}
+
+QVariant AccountCardModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= rowCount()) return QVariant();
+
+    const bool summaryRow = index.row() == 0 || index.row() == rowCount() - 1;
+
+    switch (role) {
+    case Qt::DisplayRole:
+        return displayValue(index.row(), index.column());
+    case Qt::TextAlignmentRole:
+        if (index.column() == DebitColumn || index.column() == CreditColumn
+            || index.column() == BalanceColumn) {
+            return QVariant(Qt::AlignRight | Qt::AlignVCenter);
+        }
+        break;
+    case Qt::FontRole:
+        if (summaryRow) {
+            QFont font;
+            font.setBold(true);
+            return font;
+        }
+        break;
+    case Qt::BackgroundRole:
+        // Входящее сальдо и итог выделяем
+        if (summaryRow) return QBrush(QColor(240, 240, 240));
+        break;
+    }
+    return QVariant();
+}
+
+QVariant AccountCardModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+
+    switch (section) {
+    case DateColumn: return tr("Дата");
+    case AccountColumn: return tr("Счет");
+    case DocumentColumn: return tr("Документ");
+    case CounterpartyColumn: return tr("Контрагент");
+    case OppositeColumn: return tr("Корр. счет");
+    case DebitColumn: return tr("Дебет");
+    case CreditColumn: return tr("Кредит");
+    case BalanceColumn: return tr("Сальдо");
+    case DescriptionColumn: return tr("Описание");
+    }
+    return QVariant();
+}
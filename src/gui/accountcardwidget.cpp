@@ -1,5 +1,9 @@
 #include "gui/accountcardwidget.h"
 #include "core/database.h"
+#include "gui/accountcardmodel.h"
+#include "core/exportmanager.h"
+#include "core/exportjobqueue.h"
+#include "gui/dialogs/batchaccountcardsdialog.h"
 
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -9,7 +13,7 @@
 #include <QDateEdit>           // ДОБАВИТЬ
 #include <QTableView>          // ДОБАВИТЬ
 #include <QPushButton>         // ДОБАВИТЬ
-#include <QStandardItemModel>  // ДОБАВИТЬ
+#include <QCheckBox>
 #include <QHeaderView>         // ДОБАВИТЬ
 #include <QMessageBox>
 #include <QFileDialog>
@@ -54,6 +58,10 @@ void AccountCardWidget::setupUI()
     dateEndEdit->setCalendarPopup(true);
     controlLayout->addWidget(dateEndEdit);
     
+    subaccountsCheck = new QCheckBox("С подсчетами");
+    subaccountsCheck->setToolTip("Проводки всех подсчетов выбранного счета одной лентой");
+    controlLayout->addWidget(subaccountsCheck);
+    
     updateButton = new QPushButton("Обновить");
     connect(updateButton, &QPushButton::clicked, this, &AccountCardWidget::updateReport);
     controlLayout->addWidget(updateButton);
@@ -62,6 +70,11 @@ void AccountCardWidget::setupUI()
     connect(exportButton, &QPushButton::clicked, this, &AccountCardWidget::exportToCsv);
     controlLayout->addWidget(exportButton);
     
+    batchButton = new QPushButton("Пакетная выгрузка...");
+    batchButton->setToolTip("Карточки нескольких счетов в отдельные CSV-файлы");
+    connect(batchButton, &QPushButton::clicked, this, &AccountCardWidget::openBatchExport);
+    controlLayout->addWidget(batchButton);
+    
     controlLayout->addStretch();
     mainLayout->addLayout(controlLayout);
     
@@ -77,14 +90,10 @@ void AccountCardWidget::setupUI()
 
 void AccountCardWidget::setupTable()
 {
-    model = new QStandardItemModel(this);
-    
-    QStringList headers;
-    headers << "Дата" << "Документ" << "Контрагент" 
-            << "Дебет" << "Кредит" << "Сумма" << "Описание";
-    
-    model->setHorizontalHeaderLabels(headers);
+    // Строки карточки читаются страницами по мере прокрутки
+    model = new AccountCardModel(this);
     tableView->setModel(model);
+    tableView->setColumnHidden(AccountCardModel::AccountColumn, true);
     
     // Настройка ширины столбцов
     tableView->horizontalHeader()->setStretchLastSection(true);
@@ -128,9 +137,6 @@ void AccountCardWidget::updateReport()
         return;
     }
     
-    // Очищаем таблицу
-    model->removeRows(0, model->rowCount());
-    
     // Получаем данные о счете
     QSqlQuery accountQuery = Database::instance().executeQuery(
         "SELECT code, name FROM accounts WHERE id = ?",
@@ -143,128 +149,51 @@ void AccountCardWidget::updateReport()
         accountName = accountQuery.value(1).toString();
     }
     
-    // Получаем проводки по счету
-    QString sql = 
-        "SELECT t.transaction_date, t.document_number, "
-        "       COALESCE(cp.name, '') as counterparty_name, "
-        "       CASE WHEN t.debit_account_id = ? THEN 'Дт' ELSE 'Кт' END as direction, "
-        "       a2.code as opposite_account_code, "
-        "       a2.name as opposite_account_name, "
-        "       t.amount, t.description "
-        "FROM transactions t "
-        "LEFT JOIN accounts a1 ON (t.debit_account_id = a1.id OR t.credit_account_id = a1.id) "
-        "LEFT JOIN accounts a2 ON "
-        "   (CASE WHEN t.debit_account_id = ? THEN t.credit_account_id ELSE t.debit_account_id END) = a2.id "
-        "LEFT JOIN counterparties cp ON t.counterparty_id = cp.id "
-        "WHERE (t.debit_account_id = ? OR t.credit_account_id = ?) "
-        "  AND t.transaction_date BETWEEN ? AND ? "
-        "ORDER BY t.transaction_date, t.id";
+    // Итоги считаются агрегатным запросом, движения модель читает страницами
+    AccountCardParams params;
+    params.accountId = accountId;
+    params.dateFrom = startDate;
+    params.dateTo = endDate;
+    params.includeSubaccounts = subaccountsCheck->isChecked();
     
-    QVariantList params = {accountId, accountId, accountId, accountId, startDate, endDate};
-    QSqlQuery query = Database::instance().executeQuery(sql, params);
-    
-    double totalDebit = 0.0;
-    double totalCredit = 0.0;
-    
-    while (query.next()) {
-        QList<QStandardItem*> rowItems;
-        
-        // Дата
-        rowItems << new QStandardItem(query.value(0).toDate().toString("dd.MM.yyyy"));
-        
-        // Документ
-        rowItems << new QStandardItem(query.value(1).toString());
-        
-        // Контрагент
-        rowItems << new QStandardItem(query.value(2).toString());
-        
-        // Дебет/Кредит
-        QString direction = query.value(3).toString();
-        QString oppositeAccount = QString("%1 - %2")
-            .arg(query.value(4).toString())
-            .arg(query.value(5).toString());
-        
-        if (direction == "Дт") {
-            rowItems << new QStandardItem(oppositeAccount);
-            rowItems << new QStandardItem("");
-            totalDebit += query.value(6).toDouble();
-        } else {
-            rowItems << new QStandardItem("");
-            rowItems << new QStandardItem(oppositeAccount);
-            totalCredit += query.value(6).toDouble();
-        }
-        
-        // Сумма
-        rowItems << new QStandardItem(QString::number(query.value(6).toDouble(), 'f', 2));
-        
-        // Описание
-        rowItems << new QStandardItem(query.value(7).toString());
-        
-        model->appendRow(rowItems);
+    if (!model->setParams(params)) {
+        model->clear();
+        QMessageBox::critical(this, "Ошибка", "Не удалось сформировать карточку счета.");
+        return;
     }
     
-    // Добавляем итоговую строку
-    if (model->rowCount() > 0) {
-        model->appendRow({
-            new QStandardItem("ИТОГО:"),
-            new QStandardItem(""),
-            new QStandardItem(""),
-            new QStandardItem(QString::number(totalDebit, 'f', 2)),
-            new QStandardItem(QString::number(totalCredit, 'f', 2)),
-            new QStandardItem(""),
-            new QStandardItem("")
-        });
-        
-        // Выделяем итоговую строку
-        int lastRow = model->rowCount() - 1;
-        for (int col = 0; col < model->columnCount(); ++col) {
-            QStandardItem *item = model->item(lastRow, col);
-            item->setBackground(QBrush(QColor(240, 240, 240)));
-            QFont font = item->font();
-            font.setBold(true);
-            item->setFont(font);
-        }
-    }
+    // Столбец "Счет" нужен, только когда в карточке несколько счетов
+    tableView->setColumnHidden(AccountCardModel::AccountColumn, !params.includeSubaccounts);
     
     // Обновляем заголовок
-    tableView->setWindowTitle(QString("Карточка счета %1 - %2")
-        .arg(accountCode).arg(accountName));
+    tableView->setWindowTitle(QString("Карточка счета %1 - %2%3")
+        .arg(accountCode).arg(accountName)
+        .arg(params.includeSubaccounts ? " (с подсчетами)" : ""));
 }
 
 void AccountCardWidget::exportToCsv()
 {
-    QString fileName = QFileDialog::getSaveFileName(
-        this, "Экспорт в CSV", "", "CSV Files (*.csv)");
-    
-    if (fileName.isEmpty()) return;
-    
-    QFile file(fileName);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QMessageBox::critical(this, "Ошибка", 
-            "Не удалось создать файл: " + file.errorString());
+    if (model->rowCount() == 0) {
+        QMessageBox::warning(this, "Ошибка", "Сначала сформируйте карточку счета.");
         return;
     }
     
-    QTextStream stream(&file);
-    stream.setEncoding(QStringConverter::Utf8);
-    
-    // Заголовки
-    for (int col = 0; col < model->columnCount(); ++col) {
-        stream << "\"" << model->headerData(col, Qt::Horizontal).toString() << "\"";
-        if (col < model->columnCount() - 1) stream << ";";
-    }
-    stream << "\n";
+    QString fileName = QFileDialog::getSaveFileName(
+        this, "Экспорт в CSV", "", "CSV Files (*.csv);;CSV, сжатый gzip (*.csv.gz)");
     
-    // Данные
-    for (int row = 0; row < model->rowCount(); ++row) {
-        for (int col = 0; col < model->columnCount(); ++col) {
-            QString value = model->index(row, col).data().toString();
-            stream << "\"" << value.replace("\"", "\"\"") << "\"";
-            if (col < model->columnCount() - 1) stream << ";";
-        }
-        stream << "\n";
-    }
+    if (fileName.isEmpty()) return;
     
-    file.close();
-    QMessageBox::information(this, "Экспорт", "Данные успешно экспортированы.");
-}
\ No newline at end of file
+    // Выгрузка идет запросом, а не обходом модели: в модели только часть страниц.
+    // Файл пишется в фоне, ход виден на панели "Выгрузки"
+    AccountCardParams params = model->params();
+    ExportJobQueue::instance().enqueue(tableView->windowTitle(), fileName,
+        [params, fileName](ExportProgress *progress, QString *error) {
+            return ExportManager::exportAccountCardToCsv(params, fileName, error, progress);
+        });
+}
+
+void AccountCardWidget::openBatchExport()
+{
+    BatchAccountCardsDialog dialog(dateStartEdit->date(), dateEndEdit->date(), this);
+    dialog.exec();
+}
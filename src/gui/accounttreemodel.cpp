@@ -0,0 +1,398 @@
+#include "gui/accounttreemodel.h"
+#include "core/database.h"
+
+#include <QStringList>
+#include <QTimer>
+#include <QDebug>
+
+#include <algorithm>
+
+AccountTreeModel::AccountTreeModel(QObject *parent)
+    : QAbstractItemModel(parent)
+{
+    LedgerEvents &events = LedgerEvents::instance();
+    connect(&events, &LedgerEvents::rowInserted, this, &AccountTreeModel::onRowInserted);
+    connect(&events, &LedgerEvents::rowUpdated, this, &AccountTreeModel::onRowUpdated);
+    connect(&events, &LedgerEvents::rowRemoved, this, &AccountTreeModel::onRowRemoved);
+    connect(&events, &LedgerEvents::bulkChanged, this, &AccountTreeModel::onBulkChanged);
+}
+
+AccountTreeModel::~AccountTreeModel()
+{
+    clearNode(&root_);
+}
+
+QString AccountTreeModel::nodeSql()
+{
+    // Число подсчетов и сальдо поддерева - индексные выборки по замыканию
+    // и готовому агрегату, без обхода проводок
+    return "SELECT a.id, COALESCE(a.parent_id, 0), a.code, a.name, a.type, "
+           "       (SELECT COUNT(*) FROM account_closure k "
+           "        WHERE k.ancestor = a.id AND k.depth = 1), "
+           "       (SELECT COALESCE(SUM(b.debit_total - b.credit_total), 0) "
+           "        FROM account_closure s "
+           "        JOIN account_balances b ON b.account_id = s.descendant "
+           "        WHERE s.ancestor = a.id) "
+           "FROM accounts a ";
+}
+
+QString AccountTreeModel::balanceText(double balance)
+{
+    if (qFuzzyIsNull(balance)) return QString("0.00");
+    return QString("%1 %2").arg(balance > 0 ? "Д" : "К")
+                           .arg(QString::number(qAbs(balance), 'f', 2));
+}
+
+void AccountTreeModel::reload()
+{
+    beginResetModel();
+    clearNode(&root_);
+    endResetModel();
+}
+
+QVector<AccountTreeModel::Node*> AccountTreeModel::loadChildren(int parentId) const
+{
+    if (!Database::instance().isInitialized()) return {};
+
+    QSqlQuery query = parentId > 0
+        ? Database::instance().executeQuery(
+              nodeSql() + "JOIN account_closure c ON c.descendant = a.id "
+                          "WHERE c.ancestor = ? AND c.depth = 1 ORDER BY a.code",
+              {parentId})
+        : Database::instance().executeQuery(
+              nodeSql() + "WHERE a.parent_id IS NULL ORDER BY a.code");
+
+    if (query.lastError().isValid()) {
+        qWarning() << "Failed to load accounts:" << query.lastError().text();
+    }
+
+    QVector<Node*> children;
+    while (query.next()) {
+        Node *node = new Node;
+        node->id = query.value(0).toInt();
+        node->parentId = query.value(1).toInt();
+        node->code = query.value(2).toString();
+        node->name = query.value(3).toString();
+        node->type = query.value(4).toInt();
+        node->childCount = query.value(5).toInt();
+        node->balance = query.value(6).toDouble();
+        children.append(node);
+    }
+    return children;
+}
+
+bool AccountTreeModel::loadNode(int accountId, Node *target) const
+{
+    QSqlQuery query = Database::instance().executeQuery(
+        nodeSql() + "WHERE a.id = ?", {accountId});
+    if (!query.next()) return false;
+
+    target->id = query.value(0).toInt();
+    target->parentId = query.value(1).toInt();
+    target->code = query.value(2).toString();
+    target->name = query.value(3).toString();
+    target->type = query.value(4).toInt();
+    target->childCount = query.value(5).toInt();
+    target->balance = query.value(6).toDouble();
+    return true;
+}
+
+void AccountTreeModel::refreshBalances()
+{
+    if (nodes_.isEmpty()) return;
+
+    // id - целые числа из базы, поэтому список подставляется в текст запроса:
+    // загруженных узлов может быть больше, чем допустимо параметров
+    QStringList ids;
+    ids.reserve(nodes_.size());
+    for (auto it = nodes_.cbegin(); it != nodes_.cend(); ++it) {
+        ids << QString::number(it.key());
+    }
+
+    QSqlQuery query = Database::instance().executeQuery(
+        nodeSql() + "WHERE a.id IN (" + ids.join(',') + ")");
+
+    while (query.next()) {
+        Node *node = nodes_.value(query.value(0).toInt());
+        if (!node) continue;
+
+        int childCount = query.value(5).toInt();
+        double balance = query.value(6).toDouble();
+
+        if (childCount != node->childCount) {
+            node->childCount = childCount;
+            QModelIndex index = indexFor(node);
+            emit dataChanged(index, index);
+        }
+        if (!qFuzzyCompare(1.0 + balance, 1.0 + node->balance)) {
+            node->balance = balance;
+            QModelIndex index = indexFor(node, BalanceColumn);
+            emit dataChanged(index, index);
+        }
+    }
+}
+
+QModelIndex AccountTreeModel::indexOf(int accountId) const
+{
+    Node *node = nodes_.value(accountId);
+    return node ? indexFor(node) : QModelIndex();
+}
+
+AccountTreeModel::Node *AccountTreeModel::nodeFor(const QModelIndex &index) const
+{
+    if (!index.isValid()) return const_cast<Node*>(&root_);
+    return static_cast<Node*>(index.internalPointer());
+}
+
+QModelIndex AccountTreeModel::indexFor(Node *node, int column) const
+{
+    if (!node || node == &root_ || !node->parent) return QModelIndex();
+    int row = node->parent->children.indexOf(node);
+    return row >= 0 ? createIndex(row, column, node) : QModelIndex();
+}
+
+QModelIndex AccountTreeModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (!hasIndex(row, column, parent)) return QModelIndex();
+
+    Node *parentNode = nodeFor(parent);
+    return createIndex(row, column, parentNode->children.at(row));
+}
+
+QModelIndex AccountTreeModel::parent(const QModelIndex &child) const
+{
+    if (!child.isValid()) return QModelIndex();
+    return indexFor(nodeFor(child)->parent);
+}
+
+int AccountTreeModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.column() > 0) return 0;
+    return nodeFor(parent)->children.size();
+}
+
+int AccountTreeModel::columnCount(const QModelIndex &) const
+{
+    return ColumnCount;
+}
+
+bool AccountTreeModel::hasChildren(const QModelIndex &parent) const
+{
+    if (parent.column() > 0) return false;
+
+    Node *node = nodeFor(parent);
+    if (node == &root_ && !node->fetched) return true;
+    return node->fetched ? !node->children.isEmpty() : node->childCount > 0;
+}
+
+bool AccountTreeModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (parent.column() > 0) return false;
+
+    Node *node = nodeFor(parent);
+    if (node->fetched) return false;
+    return node == &root_ || node->childCount > 0;
+}
+
+void AccountTreeModel::fetchMore(const QModelIndex &parent)
+{
+    Node *node = nodeFor(parent);
+    if (node->fetched) return;
+
+    QVector<Node*> children = loadChildren(node == &root_ ? 0 : node->id);
+    node->fetched = true;
+    node->childCount = children.size();
+    if (children.isEmpty()) return;
+
+    beginInsertRows(parent, 0, children.size() - 1);
+    for (Node *child : children) {
+        child->parent = node;
+        nodes_.insert(child->id, child);
+    }
+    node->children = children;
+    endInsertRows();
+}
+
+QVariant AccountTreeModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid()) return QVariant();
+
+    const Node *node = nodeFor(index);
+
+    if (role == Qt::UserRole) {
+        return node->id;
+    }
+
+    if (role == Qt::TextAlignmentRole && index.column() == BalanceColumn) {
+        return QVariant(Qt::AlignRight | Qt::AlignVCenter);
+    }
+
+    if (role != Qt::DisplayRole) return QVariant();
+
+    switch (index.column()) {
+    case CodeColumn:
+        return node->code;
+    case NameColumn:
+        return node->name;
+    case TypeColumn:
+        switch (node->type) {
+        case 0: return tr("Активный");
+        case 1: return tr("Пассивный");
+        case 2: return tr("Активно-пассивный");
+        }
+        return QVariant();
+    case BalanceColumn:
+        return balanceText(node->balance);
+    }
+    return QVariant();
+}
+
+QVariant AccountTreeModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) return QVariant();
+
+    switch (section) {
+    case CodeColumn: return tr("Код");
+    case NameColumn: return tr("Наименование");
+    case TypeColumn: return tr("Тип");
+    case BalanceColumn: return tr("Сальдо");
+    }
+    return QVariant();
+}
+
+void AccountTreeModel::insertNode(Node *node)
+{
+    Node *parentNode = node->parentId > 0 ? nodes_.value(node->parentId) : &root_;
+
+    // Родитель не загружен или еще не раскрыт: узел прочитается при раскрытии
+    if (!parentNode || !parentNode->fetched) {
+        if (parentNode && parentNode != &root_) {
+            parentNode->childCount++;
+            QModelIndex index = indexFor(parentNode);
+            emit dataChanged(index, index);
+        }
+        delete node;
+        return;
+    }
+
+    auto it = std::lower_bound(parentNode->children.begin(), parentNode->children.end(), node,
+                               [](const Node *a, const Node *b) { return a->code < b->code; });
+    int row = int(it - parentNode->children.begin());
+
+    beginInsertRows(indexFor(parentNode), row, row);
+    node->parent = parentNode;
+    parentNode->children.insert(row, node);
+    parentNode->childCount = parentNode->children.size();
+    nodes_.insert(node->id, node);
+    endInsertRows();
+}
+
+void AccountTreeModel::removeNode(Node *node)
+{
+    Node *parentNode = node->parent;
+    int row = parentNode->children.indexOf(node);
+    if (row < 0) return;
+
+    beginRemoveRows(indexFor(parentNode), row, row);
+    parentNode->children.removeAt(row);
+    parentNode->childCount = parentNode->children.size();
+    clearNode(node);
+    nodes_.remove(node->id);
+    delete node;
+    endRemoveRows();
+}
+
+void AccountTreeModel::clearNode(Node *node)
+{
+    for (Node *child : node->children) {
+        clearNode(child);
+        nodes_.remove(child->id);
+        delete child;
+    }
+    node->children.clear();
+    node->fetched = false;
+}
+
+void AccountTreeModel::scheduleBalanceRefresh()
+{
+    // Серия событий (например, пакетный импорт) дает одно обновление
+    if (balanceRefreshPending_) return;
+    balanceRefreshPending_ = true;
+
+    QTimer::singleShot(0, this, [this]() {
+        balanceRefreshPending_ = false;
+        refreshBalances();
+    });
+}
+
+void AccountTreeModel::onRowInserted(LedgerEvents::Table table, qint64 id)
+{
+    if (table == LedgerEvents::Transactions) {
+        scheduleBalanceRefresh();
+        return;
+    }
+    if (table != LedgerEvents::Accounts) return;
+
+    Node *node = new Node;
+    if (!loadNode(int(id), node)) {
+        delete node;
+        return;
+    }
+    insertNode(node);
+}
+
+void AccountTreeModel::onRowUpdated(LedgerEvents::Table table, qint64 id)
+{
+    if (table == LedgerEvents::Transactions) {
+        scheduleBalanceRefresh();
+        return;
+    }
+    if (table != LedgerEvents::Accounts) return;
+
+    Node *fresh = new Node;
+    if (!loadNode(int(id), fresh)) {
+        delete fresh;
+        onRowRemoved(table, id);
+        return;
+    }
+
+    Node *existing = nodes_.value(int(id));
+    if (existing && existing->parentId == fresh->parentId && existing->code == fresh->code) {
+        // Позиция в дереве не изменилась: обновляем строку на месте
+        existing->name = fresh->name;
+        existing->type = fresh->type;
+        delete fresh;
+        emit dataChanged(indexFor(existing, CodeColumn), indexFor(existing, BalanceColumn));
+        return;
+    }
+
+    // Перенос или смена кода: узел переставляется, сальдо предков меняется
+    if (existing) {
+        removeNode(existing);
+    }
+    insertNode(fresh);
+    scheduleBalanceRefresh();
+}
+
+void AccountTreeModel::onRowRemoved(LedgerEvents::Table table, qint64 id)
+{
+    if (table == LedgerEvents::Transactions) {
+        scheduleBalanceRefresh();
+        return;
+    }
+    if (table != LedgerEvents::Accounts) return;
+
+    if (Node *node = nodes_.value(int(id))) {
+        removeNode(node);
+    }
+    scheduleBalanceRefresh();
+}
+
+void AccountTreeModel::onBulkChanged(LedgerEvents::Table table)
+{
+    if (table == LedgerEvents::Accounts) {
+        reload();
+    } else if (table == LedgerEvents::Transactions) {
+        scheduleBalanceRefresh();
+    }
+}
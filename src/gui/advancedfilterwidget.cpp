@@ -1,4 +1,7 @@
 #include "gui/advancedfilterwidget.h"
+#include "gui/lookupcombobox.h"
+#include "core/lookupindex.h"
+#include "core/savedfilterstore.h"
 
 #include <QInputDialog>
 #include <QApplication>
@@ -14,10 +17,7 @@
 #include <QCheckBox>
 #include <QVBoxLayout>
 #include <QMessageBox>
-#include <QSettings>
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QJsonArray>
+#include <QTimer>
 
 AdvancedFilterWidget::AdvancedFilterWidget(QWidget *parent)
     : QWidget(parent)
@@ -29,9 +29,10 @@ AdvancedFilterWidget::AdvancedFilterWidget(QWidget *parent)
     , amountGroup(new QGroupBox(tr("Фильтр по сумме"), this))
     , amountFromSpin(new QDoubleSpinBox(this))
     , amountToSpin(new QDoubleSpinBox(this))
-    , debitAccountCombo(new QComboBox(this))
-    , creditAccountCombo(new QComboBox(this))
-    , counterpartyCombo(new QComboBox(this))
+    , debitAccountCombo(new LookupComboBox(this))
+    , creditAccountCombo(new LookupComboBox(this))
+    , subaccountsCheck(new QCheckBox(tr("Включая подсчета"), this))
+    , counterpartyCombo(new LookupComboBox(this))
     , savedFilterGroup(new QGroupBox(tr("Сохраненные фильтры"), this))
     , savedFilterCombo(new QComboBox(this))
     , saveFilterButton(new QPushButton(tr("Сохранить"), this))
@@ -39,7 +40,17 @@ AdvancedFilterWidget::AdvancedFilterWidget(QWidget *parent)
     , deleteFilterButton(new QPushButton(tr("Удалить"), this))
     , applyButton(new QPushButton(tr("Применить фильтр"), this))
     , clearButton(new QPushButton(tr("Сбросить"), this))
+    , debounceTimer(new QTimer(this))
 {
+    // Без флажка isChecked() всегда false, и фильтры по дате и сумме не применялись
+    dateGroup->setCheckable(true);
+    dateGroup->setChecked(false);
+    amountGroup->setCheckable(true);
+    amountGroup->setChecked(false);
+    
+    debounceTimer->setSingleShot(true);
+    debounceTimer->setInterval(DebounceInterval);
+    
     setupUI();
     initConnections();
     
@@ -64,11 +75,11 @@ AdvancedFilterWidget::AdvancedFilterWidget(QWidget *parent)
     fieldCombo->addItem(tr("Категория"), "category");
     fieldCombo->addItem(tr("Тег"), "tag");
     
-    debitAccountCombo->addItem(tr("Любой счет"), -1);
-    creditAccountCombo->addItem(tr("Любой счет"), -1);
-    counterpartyCombo->addItem(tr("Любой контрагент"), -1);
+    loadAccounts();
+    loadCounterparties();
     
-    // Загрузка сохраненных фильтров
+    // Загрузка сохраненных фильтров (с переносом старых из QSettings в базу)
+    SavedFilterStore::migrateFromSettings();
     loadSavedFiltersList();
     
     // Настройка валидации дат
@@ -78,6 +89,9 @@ AdvancedFilterWidget::AdvancedFilterWidget(QWidget *parent)
     applyButton->setStyleSheet("QPushButton { background-color: #4CAF50; color: white; }");
     clearButton->setStyleSheet("QPushButton { background-color: #f44336; color: white; }");
     saveFilterButton->setStyleSheet("QPushButton { background-color: #2196F3; color: white; }");
+    
+    // Начальная настройка полей не должна запускать поиск
+    debounceTimer->stop();
 }
 
 void AdvancedFilterWidget::setupUI()
@@ -108,6 +122,7 @@ void AdvancedFilterWidget::setupUI()
     QFormLayout *accountLayout = new QFormLayout(accountGroup);
     accountLayout->addRow(tr("Счет дебета:"), debitAccountCombo);
     accountLayout->addRow(tr("Счет кредита:"), creditAccountCombo);
+    accountLayout->addRow("", subaccountsCheck);
     accountLayout->addRow(tr("Контрагент:"), counterpartyCombo);
     mainLayout->addWidget(accountGroup);
     
@@ -147,6 +162,24 @@ void AdvancedFilterWidget::initConnections()
     connect(clearButton, &QPushButton::clicked, this, &AdvancedFilterWidget::onClearClicked);
     connect(saveFilterButton, &QPushButton::clicked, this, &AdvancedFilterWidget::onSaveClicked);
     connect(loadFilterButton, &QPushButton::clicked, this, &AdvancedFilterWidget::onLoadClicked);
+    
+    // Поиск по мере ввода: любое изменение условий перезапускает таймер,
+    // фильтр применяется после паузы во вводе
+    connect(debounceTimer, &QTimer::timeout, this, &AdvancedFilterWidget::onDebounceTimeout);
+    connect(searchEdit, &QLineEdit::textChanged, this, &AdvancedFilterWidget::scheduleApply);
+    connect(searchEdit, &QLineEdit::returnPressed, this, &AdvancedFilterWidget::onApplyClicked);
+    connect(fieldCombo, &QComboBox::currentIndexChanged, this, &AdvancedFilterWidget::scheduleApply);
+    connect(dateGroup, &QGroupBox::toggled, this, &AdvancedFilterWidget::scheduleApply);
+    connect(dateFromEdit, &QDateEdit::dateChanged, this, &AdvancedFilterWidget::scheduleApply);
+    connect(dateToEdit, &QDateEdit::dateChanged, this, &AdvancedFilterWidget::scheduleApply);
+    connect(amountGroup, &QGroupBox::toggled, this, &AdvancedFilterWidget::scheduleApply);
+    connect(amountFromSpin, &QDoubleSpinBox::valueChanged, this, &AdvancedFilterWidget::scheduleApply);
+    connect(amountToSpin, &QDoubleSpinBox::valueChanged, this, &AdvancedFilterWidget::scheduleApply);
+    connect(debitAccountCombo, &QComboBox::currentIndexChanged, this, &AdvancedFilterWidget::scheduleApply);
+    connect(creditAccountCombo, &QComboBox::currentIndexChanged, this, &AdvancedFilterWidget::scheduleApply);
+    connect(subaccountsCheck, &QCheckBox::toggled, this, &AdvancedFilterWidget::scheduleApply);
+    connect(counterpartyCombo, &QComboBox::currentIndexChanged, this, &AdvancedFilterWidget::scheduleApply);
+    
     connect(deleteFilterButton, &QPushButton::clicked, this, [this]() {
         QString filterName = savedFilterCombo->currentText();
         if (!filterName.isEmpty() && savedFilters.contains(filterName)) {
@@ -157,7 +190,11 @@ void AdvancedFilterWidget::initConnections()
             );
             
             if (reply == QMessageBox::Yes) {
-                savedFilters.remove(filterName);
+                if (!SavedFilterStore::remove(filterName)) {
+                    QMessageBox::warning(this, tr("Ошибка"),
+                        tr("Не удалось удалить фильтр '%1'.").arg(filterName));
+                    return;
+                }
                 loadSavedFiltersList();
                 QMessageBox::information(this, tr("Фильтр удален"),
                     tr("Фильтр '%1' был успешно удален.").arg(filterName));
@@ -168,38 +205,19 @@ void AdvancedFilterWidget::initConnections()
 
 void AdvancedFilterWidget::loadAccounts()
 {
-    // В реальном приложении здесь должна быть загрузка счетов из базы данных
-    // Для примера добавляем тестовые счета
-    debitAccountCombo->clear();
-    creditAccountCombo->clear();
-    
-    debitAccountCombo->addItem(tr("Любой счет"), -1);
-    creditAccountCombo->addItem(tr("Любой счет"), -1);
-    
-    debitAccountCombo->addItem(tr("Наличные"), 1);
-    creditAccountCombo->addItem(tr("Наличные"), 1);
+    debitAccountCombo->setPlaceholderItem(tr("Любой счет"), -1);
+    creditAccountCombo->setPlaceholderItem(tr("Любой счет"), -1);
     
-    debitAccountCombo->addItem(tr("Банковский счет"), 2);
-    creditAccountCombo->addItem(tr("Банковский счет"), 2);
-    
-    debitAccountCombo->addItem(tr("Кредитная карта"), 3);
-    creditAccountCombo->addItem(tr("Кредитная карта"), 3);
-    
-    debitAccountCombo->addItem(tr("Электронный кошелек"), 4);
-    creditAccountCombo->addItem(tr("Электронный кошелек"), 4);
+    // Общий префиксный индекс для дебета и кредита
+    std::shared_ptr<LookupIndex> accounts = LookupIndex::loadAccounts();
+    debitAccountCombo->setLookupIndex(accounts);
+    creditAccountCombo->setLookupIndex(accounts);
 }
 
 void AdvancedFilterWidget::loadCounterparties()
 {
-    // В реальном приложении здесь должна быть загрузка контрагентов из базы данных
-    // Для примера добавляем тестовых контрагентов
-    counterpartyCombo->clear();
-    counterpartyCombo->addItem(tr("Любой контрагент"), -1);
-    counterpartyCombo->addItem(tr("Магазин продуктов"), 1);
-    counterpartyCombo->addItem(tr("Аптека"), 2);
-    counterpartyCombo->addItem(tr("Транспорт"), 3);
-    counterpartyCombo->addItem(tr("Ресторан"), 4);
-    counterpartyCombo->addItem(tr("Интернет-магазин"), 5);
+    counterpartyCombo->setPlaceholderItem(tr("Любой контрагент"), -1);
+    counterpartyCombo->setLookupIndex(LookupIndex::loadCounterparties());
 }
 
 void AdvancedFilterWidget::loadSavedFiltersList()
@@ -207,31 +225,11 @@ void AdvancedFilterWidget::loadSavedFiltersList()
     savedFilterCombo->clear();
     savedFilterCombo->addItem(tr("-- Выберите фильтр --"), "");
     
-    // Загрузка из QSettings (в реальном приложении - из базы данных)
-    QSettings settings;
-    settings.beginGroup("SavedFilters");
-    
-    QStringList filterNames = settings.childGroups();
-    for (const QString &name : filterNames) {
-        savedFilterCombo->addItem(name, name);
-        
-        // Загружаем сам фильтр
-        FilterOptions options;
-        options.textFilter = settings.value(name + "/textFilter").toString();
-        options.fieldFilter = settings.value(name + "/fieldFilter").toString();
-        options.dateFrom = settings.value(name + "/dateFrom").toDate();
-        options.dateTo = settings.value(name + "/dateTo").toDate();
-        options.amountFrom = settings.value(name + "/amountFrom").toDouble();
-        options.amountTo = settings.value(name + "/amountTo").toDouble();
-        options.debitAccountId = settings.value(name + "/debitAccountId").toInt();
-        options.creditAccountId = settings.value(name + "/creditAccountId").toInt();
-        options.counterpartyId = settings.value(name + "/counterpartyId").toInt();
-        
-        savedFilters[name] = options;
+    savedFilters = SavedFilterStore::loadAll();
+    for (auto it = savedFilters.cbegin(); it != savedFilters.cend(); ++it) {
+        savedFilterCombo->addItem(it.key(), it.key());
     }
     
-    settings.endGroup();
-    
     if (savedFilters.isEmpty()) {
         savedFilterCombo->setEnabled(false);
         loadFilterButton->setEnabled(false);
@@ -256,6 +254,7 @@ AdvancedFilterWidget::FilterOptions AdvancedFilterWidget::getFilterOptions() con
     options.amountFilterEnabled = amountGroup->isChecked();
     options.debitAccountId = debitAccountCombo->currentData().toInt();
     options.creditAccountId = creditAccountCombo->currentData().toInt();
+    options.includeSubaccounts = subaccountsCheck->isChecked();
     options.counterpartyId = counterpartyCombo->currentData().toInt();
     options.useSavedFilter = !savedFilterCombo->currentData().toString().isEmpty();
     options.savedFilterName = savedFilterCombo->currentText();
@@ -280,20 +279,10 @@ void AdvancedFilterWidget::setFilterOptions(const FilterOptions &options)
     amountToSpin->setValue(options.amountTo);
     amountGroup->setChecked(options.amountFilterEnabled);
     
-    int debitIndex = debitAccountCombo->findData(options.debitAccountId);
-    if (debitIndex >= 0) {
-        debitAccountCombo->setCurrentIndex(debitIndex);
-    }
-    
-    int creditIndex = creditAccountCombo->findData(options.creditAccountId);
-    if (creditIndex >= 0) {
-        creditAccountCombo->setCurrentIndex(creditIndex);
-    }
-    
-    int counterpartyIndex = counterpartyCombo->findData(options.counterpartyId);
-    if (counterpartyIndex >= 0) {
-        counterpartyCombo->setCurrentIndex(counterpartyIndex);
-    }
+    debitAccountCombo->setCurrentId(options.debitAccountId);
+    creditAccountCombo->setCurrentId(options.creditAccountId);
+    subaccountsCheck->setChecked(options.includeSubaccounts);
+    counterpartyCombo->setCurrentId(options.counterpartyId);
     
     if (!options.savedFilterName.isEmpty()) {
         int savedIndex = savedFilterCombo->findText(options.savedFilterName);
@@ -317,9 +306,10 @@ void AdvancedFilterWidget::clearFilters()
     amountToSpin->setValue(10000.0);
     amountGroup->setChecked(false);
     
-    debitAccountCombo->setCurrentIndex(0);
-    creditAccountCombo->setCurrentIndex(0);
-    counterpartyCombo->setCurrentIndex(0);
+    debitAccountCombo->setCurrentId(-1);
+    creditAccountCombo->setCurrentId(-1);
+    subaccountsCheck->setChecked(false);
+    counterpartyCombo->setCurrentId(-1);
     
     savedFilterCombo->setCurrentIndex(0);
 }
@@ -335,31 +325,14 @@ void AdvancedFilterWidget::saveFilter(const QString &name)
     FilterOptions options = getFilterOptions();
     options.savedFilterName = name;
     
-    // Сохранение в QSettings
-    QSettings settings;
-    settings.beginGroup("SavedFilters/" + name);
-    
-    settings.setValue("textFilter", options.textFilter);
-    settings.setValue("fieldFilter", options.fieldFilter);
-    settings.setValue("dateFrom", options.dateFrom);
-    settings.setValue("dateTo", options.dateTo);
-    settings.setValue("amountFrom", options.amountFrom);
-    settings.setValue("amountTo", options.amountTo);
-    settings.setValue("debitAccountId", options.debitAccountId);
-    settings.setValue("creditAccountId", options.creditAccountId);
-    settings.setValue("counterpartyId", options.counterpartyId);
-    
-    settings.endGroup();
-    settings.sync();
-    
-    // Добавляем в список, если его там нет
-    if (!savedFilters.contains(name)) {
-        savedFilters[name] = options;
-        savedFilterCombo->addItem(name, name);
+    if (!SavedFilterStore::save(name, options)) {
+        QMessageBox::warning(this, tr("Ошибка"),
+            tr("Не удалось сохранить фильтр '%1'.").arg(name));
+        return;
     }
     
-    savedFilterCombo->setCurrentText(name);
     loadSavedFiltersList();
+    savedFilterCombo->setCurrentText(name);
     
     QMessageBox::information(this, tr("Фильтр сохранен"),
         tr("Фильтр '%1' успешно сохранен.").arg(name));
@@ -386,18 +359,47 @@ QStringList AdvancedFilterWidget::getSavedFilters() const
     return savedFilters.keys();
 }
 
-void AdvancedFilterWidget::onApplyClicked()
+void AdvancedFilterWidget::scheduleApply()
+{
+    debounceTimer->start();
+}
+
+bool AdvancedFilterWidget::validateFilters(bool showErrors)
 {
-    // Валидация фильтров
     if (dateGroup->isChecked() && dateFromEdit->date() > dateToEdit->date()) {
-        QMessageBox::warning(this, tr("Ошибка даты"),
-            tr("Дата 'С' не может быть позже даты 'По'."));
-        return;
+        if (showErrors) {
+            QMessageBox::warning(this, tr("Ошибка даты"),
+                tr("Дата 'С' не может быть позже даты 'По'."));
+        }
+        return false;
     }
     
     if (amountGroup->isChecked() && amountFromSpin->value() > amountToSpin->value()) {
-        QMessageBox::warning(this, tr("Ошибка суммы"),
-            tr("Сумма 'От' не может быть больше суммы 'До'."));
+        if (showErrors) {
+            QMessageBox::warning(this, tr("Ошибка суммы"),
+                tr("Сумма 'От' не может быть больше суммы 'До'."));
+        }
+        return false;
+    }
+    
+    return true;
+}
+
+void AdvancedFilterWidget::onApplyClicked()
+{
+    debounceTimer->stop();
+    
+    if (!validateFilters(true)) {
+        return;
+    }
+    
+    emit filterApplied();
+}
+
+void AdvancedFilterWidget::onDebounceTimeout()
+{
+    // При вводе некорректный диапазон просто не применяется, без диалогов
+    if (!validateFilters(false)) {
         return;
     }
     
@@ -407,6 +409,7 @@ void AdvancedFilterWidget::onApplyClicked()
 void AdvancedFilterWidget::onClearClicked()
 {
     clearFilters();
+    debounceTimer->stop();
     emit filterApplied(); // Сбрасываем фильтр, показывая все записи
 }
 
@@ -1,5 +1,7 @@
 #include "gui/dialogs/addcounterpartydialog.h"
+#include "core/batchvalidator.h"
 #include "core/database.h"
+#include "core/ledgerevents.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QLabel>
@@ -36,8 +38,20 @@ void AddCounterpartyDialog::setupUI() {
 }
 
 void AddCounterpartyDialog::saveCounterparty() {
-    if (nameEdit->text().trimmed().isEmpty()) {
-        QMessageBox::warning(this, "Ошибка", "Заполните наименование!");
+    // Те же правила, что у импорта контрагентов: наименование, контрольные
+    // цифры ИНН и ИНН, еще не занятый в справочнике
+    BatchValidator validator;
+    QString loadError;
+    if (!validator.load(&loadError)) {
+        QMessageBox::critical(this, "Ошибка", loadError);
+        return;
+    }
+    BatchValidator::Counterparties counterparty;
+    counterparty.names << nameEdit->text();
+    counterparty.inns << innEdit->text();
+    const BatchValidator::Errors errors = validator.validateCounterparties(counterparty).first();
+    if (errors != BatchValidator::NoError) {
+        QMessageBox::warning(this, "Ошибка", BatchValidator::describe(errors));
         return;
     }
     
@@ -52,7 +66,8 @@ void AddCounterpartyDialog::saveCounterparty() {
     
     QVariantList params;
     params << nameEdit->text().trimmed()  // name
-           << innEdit->text().trimmed()   // inn
+           << (innEdit->text().trimmed().isEmpty()   // inn: без ИНН - NULL
+               ? QVariant(QMetaType(QMetaType::QString)) : QVariant(innEdit->text().trimmed()))
            << QString("")                  // kpp
            << QString("")                  // address
            << QString("")                  // phone
@@ -78,6 +93,8 @@ void AddCounterpartyDialog::saveCounterparty() {
         }
     } else {
         qDebug() << "Контрагент успешно добавлен!";
+        LedgerEvents::instance().notifyInserted(LedgerEvents::Counterparties,
+                                                query.lastInsertId().toLongLong());
         QMessageBox::information(this, "Успех", "Контрагент добавлен!");
         accept();
     }
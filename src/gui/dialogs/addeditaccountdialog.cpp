@@ -1,5 +1,7 @@
 #include "gui/dialogs/addeditaccountdialog.h"
 #include "core/database.h"
+#include "core/ledgerevents.h"
+#include "core/accounttree.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QFormLayout>
@@ -196,12 +198,12 @@ void AddEditAccountDialog::validateForm()
         errors << "Наименование счета не может быть пустым";
     }
     
-    // Проверка: счет не может быть родителем самому себе
+    // Проверка: родителем не может быть сам счет или его подсчет
     if (isEditMode_ && accountId_ > 0) {
         int parentId = parentCombo_->currentData().toInt();
-        if (parentId == accountId_) {
+        if (parentId > 0 && AccountTree::isInSubtree(parentId, accountId_)) {
             isValid = false;
-            errors << "Счет не может быть родителем самому себе";
+            errors << "Счет не может быть родителем самому себе или своему подсчету";
         }
     }
     
@@ -230,8 +232,15 @@ void AddEditAccountDialog::saveAccount()
     
     QVariantList params;
     QString sql;
+    int oldParentId = 0;
     
     if (isEditMode_) {
+        QSqlQuery parentQuery = Database::instance().executeQuery(
+            "SELECT parent_id FROM accounts WHERE id = ?", {accountId_});
+        if (parentQuery.next()) {
+            oldParentId = parentQuery.value(0).toInt();
+        }
+        
         // Редактирование существующего счета
         sql = "UPDATE accounts SET code = ?, name = ?, type = ?, parent_id = ? WHERE id = ?";
         params << code << name << type;
@@ -255,10 +264,26 @@ void AddEditAccountDialog::saveAccount()
         }
     }
     
-    QSqlQuery query = Database::instance().executeQuery(sql, params);
+    // Счет и таблица замыкания меняются в одной транзакции
+    Database &db = Database::instance();
+    db.beginTransaction();
+    
+    QSqlQuery query = db.executeQuery(sql, params);
+    
+    bool treeUpdated = true;
+    if (!query.lastError().isValid()) {
+        if (!isEditMode_) {
+            treeUpdated = AccountTree::insertAccount(query.lastInsertId().toInt(), parentId);
+        } else if (parentId != oldParentId) {
+            treeUpdated = AccountTree::moveAccount(accountId_, parentId);
+        }
+    }
     
-    if (query.lastError().isValid()) {
-        QString errorMsg = query.lastError().text();
+    if (query.lastError().isValid() || !treeUpdated || !db.commitTransaction()) {
+        db.rollbackTransaction();
+        QString errorMsg = query.lastError().isValid()
+            ? query.lastError().text()
+            : QString("не удалось обновить дерево счетов");
         if (errorMsg.contains("UNIQUE")) {
             QMessageBox::critical(this, "Ошибка", 
                 "Счет с таким кодом уже существует!");
@@ -270,6 +295,12 @@ void AddEditAccountDialog::saveAccount()
                 "Не удалось сохранить счет:\n" + errorMsg);
         }
     } else {
+        if (isEditMode_) {
+            LedgerEvents::instance().notifyUpdated(LedgerEvents::Accounts, accountId_);
+        } else {
+            LedgerEvents::instance().notifyInserted(LedgerEvents::Accounts,
+                                                    query.lastInsertId().toLongLong());
+        }
         QMessageBox::information(this, "Успех", 
             isEditMode_ ? "Счет обновлен!" : "Счет добавлен!");
         accept();
@@ -1,6 +1,9 @@
 #include <QMetaType>
 #include "gui/dialogs/addtransactiondialog.h"
 #include "core/database.h"
+#include "core/ledgerevents.h"
+#include "core/lookupindex.h"
+#include "gui/lookupcombobox.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QFormLayout>
@@ -39,12 +42,12 @@ void AddTransactionDialog::setupUI() {
     formLayout->addRow("Дата проводки *:", dateEdit);
     
     // Дебетовый счет
-    debitAccountCombo = new QComboBox;
+    debitAccountCombo = new LookupComboBox;
     debitAccountCombo->setMinimumWidth(300);
     formLayout->addRow("Счет дебета *:", debitAccountCombo);
     
     // Кредитовый счет
-    creditAccountCombo = new QComboBox;
+    creditAccountCombo = new LookupComboBox;
     creditAccountCombo->setMinimumWidth(300);
     formLayout->addRow("Счет кредита *:", creditAccountCombo);
     
@@ -57,8 +60,8 @@ void AddTransactionDialog::setupUI() {
     formLayout->addRow("Сумма *:", amountSpin);
     
     // Контрагент (необязательно)
-    counterpartyCombo = new QComboBox;
-    counterpartyCombo->addItem("(не выбран)", QVariant());
+    counterpartyCombo = new LookupComboBox;
+    counterpartyCombo->setPlaceholderItem("(не выбран)");
     formLayout->addRow("Контрагент:", counterpartyCombo);
     
     // Номер документа
@@ -103,41 +106,22 @@ void AddTransactionDialog::setupUI() {
 }
 
 void AddTransactionDialog::loadAccounts() {
-    if (!Database::instance().isInitialized()) return;
-    
-    QSqlQuery query = Database::instance().executeQuery(
-        "SELECT id, code, name FROM accounts ORDER BY code"
-    );
+    debitAccountCombo->setPlaceholderItem("(выберите счет)");
+    creditAccountCombo->setPlaceholderItem("(выберите счет)");
     
-    debitAccountCombo->addItem("(выберите счет)", QVariant());
-    creditAccountCombo->addItem("(выберите счет)", QVariant());
+    if (!Database::instance().isInitialized()) return;
     
-    while (query.next()) {
-        int id = query.value(0).toInt();
-        QString code = query.value(1).toString();
-        QString name = query.value(2).toString();
-        QString displayText = QString("%1 - %2").arg(code).arg(name);
-        
-        debitAccountCombo->addItem(displayText, id);
-        creditAccountCombo->addItem(displayText, id);
-    }
+    // Один индекс на оба комбобокса: справочник загружается один раз,
+    // а поиск по коду/наименованию идет по префиксу в памяти
+    std::shared_ptr<LookupIndex> accounts = LookupIndex::loadAccounts();
+    debitAccountCombo->setLookupIndex(accounts);
+    creditAccountCombo->setLookupIndex(accounts);
 }
 
 void AddTransactionDialog::loadCounterparties() {
     if (!Database::instance().isInitialized()) return;
     
-    QSqlQuery query = Database::instance().executeQuery(
-        "SELECT id, name, inn FROM counterparties ORDER BY name"
-    );
-    
-    while (query.next()) {
-        int id = query.value(0).toInt();
-        QString name = query.value(1).toString();
-        QString inn = query.value(2).toString();
-        QString displayText = inn.isEmpty() ? name : QString("%1 (ИНН: %2)").arg(name).arg(inn);
-        
-        counterpartyCombo->addItem(displayText, id);
-    }
+    counterpartyCombo->setLookupIndex(LookupIndex::loadCounterparties());
 }
 
 void AddTransactionDialog::validateForm()
@@ -248,6 +232,8 @@ void AddTransactionDialog::saveTransaction() {
         QMessageBox::critical(this, "Ошибка", 
             "Не удалось сохранить проводку:\n" + query.lastError().text());
     } else {
+        LedgerEvents::instance().notifyInserted(LedgerEvents::Transactions,
+                                                query.lastInsertId().toLongLong());
         QMessageBox::information(this, "Успех", "Проводка успешно добавлена!");
         accept(); // Закрываем диалог с результатом Accepted
     }
@@ -0,0 +1,223 @@
+#include "gui/dialogs/batchaccountcardsdialog.h"
+#include "core/database.h"
+
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QFormLayout>
+#include <QRadioButton>
+#include <QListWidget>
+#include <QDateEdit>
+#include <QCheckBox>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QProgressBar>
+#include <QLabel>
+#include <QPlainTextEdit>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QDir>
+#include <QSqlQuery>
+
+BatchAccountCardsDialog::BatchAccountCardsDialog(const QDate &dateFrom, const QDate &dateTo,
+                                                 QWidget *parent)
+    : QDialog(parent)
+    , batch(new AccountCardBatch(this))
+{
+    setWindowTitle("Пакетная выгрузка карточек счетов");
+    setMinimumSize(600, 550);
+
+    setupUI();
+    loadAccounts();
+
+    dateFromEdit->setDate(dateFrom);
+    dateToEdit->setDate(dateTo);
+    directoryEdit->setText(QDir::homePath() + "/ledgermini/cards");
+
+    connect(batch, &AccountCardBatch::progress, this, &BatchAccountCardsDialog::onProgress);
+    connect(batch, &AccountCardBatch::finished, this, &BatchAccountCardsDialog::onFinished);
+}
+
+void BatchAccountCardsDialog::setupUI()
+{
+    QVBoxLayout *mainLayout = new QVBoxLayout(this);
+
+    // Выбор счетов
+    allAccountsRadio = new QRadioButton("Все счета плана");
+    selectedAccountsRadio = new QRadioButton("Только отмеченные счета:");
+    allAccountsRadio->setChecked(true);
+    mainLayout->addWidget(allAccountsRadio);
+    mainLayout->addWidget(selectedAccountsRadio);
+
+    accountList = new QListWidget;
+    accountList->setEnabled(false);
+    mainLayout->addWidget(accountList);
+
+    connect(selectedAccountsRadio, &QRadioButton::toggled, accountList, &QListWidget::setEnabled);
+
+    // Параметры карточек
+    QFormLayout *formLayout = new QFormLayout();
+
+    dateFromEdit = new QDateEdit;
+    dateFromEdit->setCalendarPopup(true);
+    formLayout->addRow("Период с:", dateFromEdit);
+
+    dateToEdit = new QDateEdit;
+    dateToEdit->setCalendarPopup(true);
+    formLayout->addRow("по:", dateToEdit);
+
+    subaccountsCheck = new QCheckBox("С подсчетами");
+    formLayout->addRow("", subaccountsCheck);
+
+    QHBoxLayout *directoryLayout = new QHBoxLayout();
+    directoryEdit = new QLineEdit;
+    browseButton = new QPushButton("Обзор...");
+    connect(browseButton, &QPushButton::clicked, this, &BatchAccountCardsDialog::chooseDirectory);
+    directoryLayout->addWidget(directoryEdit);
+    directoryLayout->addWidget(browseButton);
+    formLayout->addRow("Папка:", directoryLayout);
+
+    mainLayout->addLayout(formLayout);
+
+    // Ход выгрузки и отчет об ошибках
+    progressBar = new QProgressBar;
+    progressBar->setValue(0);
+    mainLayout->addWidget(progressBar);
+
+    statusLabel = new QLabel;
+    mainLayout->addWidget(statusLabel);
+
+    reportEdit = new QPlainTextEdit;
+    reportEdit->setReadOnly(true);
+    reportEdit->setPlaceholderText("Здесь появятся счета, карточки которых не удалось сформировать");
+    reportEdit->setMaximumHeight(120);
+    mainLayout->addWidget(reportEdit);
+
+    // Кнопки
+    QHBoxLayout *buttonLayout = new QHBoxLayout();
+    startButton = new QPushButton("Сформировать");
+    closeButton = new QPushButton("Закрыть");
+
+    connect(startButton, &QPushButton::clicked, this, &BatchAccountCardsDialog::startBatch);
+    connect(closeButton, &QPushButton::clicked, this, &BatchAccountCardsDialog::reject);
+
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(startButton);
+    buttonLayout->addWidget(closeButton);
+    mainLayout->addLayout(buttonLayout);
+}
+
+void BatchAccountCardsDialog::loadAccounts()
+{
+    if (!Database::instance().isInitialized()) return;
+
+    QSqlQuery query = Database::instance().executeQuery(
+        "SELECT id, code, name FROM accounts ORDER BY code"
+    );
+
+    while (query.next()) {
+        QListWidgetItem *item = new QListWidgetItem(
+            QString("%1 - %2").arg(query.value(1).toString(), query.value(2).toString()),
+            accountList);
+        item->setData(Qt::UserRole, query.value(0).toInt());
+        item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+        item->setCheckState(Qt::Unchecked);
+    }
+}
+
+void BatchAccountCardsDialog::chooseDirectory()
+{
+    QString directory = QFileDialog::getExistingDirectory(
+        this, "Папка для карточек", directoryEdit->text());
+    if (!directory.isEmpty()) {
+        directoryEdit->setText(directory);
+    }
+}
+
+void BatchAccountCardsDialog::startBatch()
+{
+    AccountCardBatch::Options options;
+    options.dateFrom = dateFromEdit->date();
+    options.dateTo = dateToEdit->date();
+    options.includeSubaccounts = subaccountsCheck->isChecked();
+    options.outputDir = directoryEdit->text().trimmed();
+
+    if (options.dateFrom > options.dateTo) {
+        QMessageBox::warning(this, "Ошибка", "Дата начала не может быть позже даты окончания!");
+        return;
+    }
+
+    if (options.outputDir.isEmpty()) {
+        QMessageBox::warning(this, "Ошибка", "Укажите папку для карточек.");
+        return;
+    }
+
+    if (selectedAccountsRadio->isChecked()) {
+        for (int i = 0; i < accountList->count(); ++i) {
+            QListWidgetItem *item = accountList->item(i);
+            if (item->checkState() == Qt::Checked) {
+                options.accountIds.append(item->data(Qt::UserRole).toInt());
+            }
+        }
+
+        if (options.accountIds.isEmpty()) {
+            QMessageBox::warning(this, "Ошибка", "Отметьте хотя бы один счет.");
+            return;
+        }
+    }
+
+    reportEdit->clear();
+    progressBar->setValue(0);
+    setRunning(true);
+
+    if (!batch->start(options)) {
+        setRunning(false);
+        QMessageBox::critical(this, "Ошибка",
+            "Не удалось начать выгрузку. Проверьте папку назначения.");
+    }
+}
+
+void BatchAccountCardsDialog::onProgress(int done, int total)
+{
+    progressBar->setMaximum(qMax(1, total));
+    progressBar->setValue(done);
+    statusLabel->setText(QString("Сформировано карточек: %1 из %2").arg(done).arg(total));
+}
+
+void BatchAccountCardsDialog::onFinished(int succeeded,
+                                         const QVector<AccountCardBatch::Failure> &failures,
+                                         bool cancelled)
+{
+    setRunning(false);
+
+    for (const AccountCardBatch::Failure &failure : failures) {
+        reportEdit->appendPlainText(QString("%1: %2").arg(failure.accountCode, failure.error));
+    }
+
+    QString summary = QString("Готово: %1 из %2 карточек").arg(succeeded).arg(batch->total());
+    if (!failures.isEmpty()) {
+        summary += QString(", ошибок: %1").arg(failures.size());
+    }
+    if (cancelled) {
+        summary += " (выгрузка прервана)";
+    }
+    statusLabel->setText(summary);
+}
+
+void BatchAccountCardsDialog::setRunning(bool running)
+{
+    startButton->setEnabled(!running);
+    browseButton->setEnabled(!running);
+    closeButton->setText(running ? "Остановить" : "Закрыть");
+}
+
+void BatchAccountCardsDialog::reject()
+{
+    // Во время выгрузки кнопка закрытия сначала останавливает ее
+    if (batch->isRunning()) {
+        batch->cancel();
+        statusLabel->setText("Остановка: дописываются уже начатые карточки...");
+        return;
+    }
+
+    QDialog::reject();
+}
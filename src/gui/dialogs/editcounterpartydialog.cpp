@@ -1,5 +1,6 @@
 #include "gui/dialogs/editcounterpartydialog.h"
 #include "core/database.h"
+#include "core/ledgerevents.h"
 #include <QVBoxLayout>
 #include <QFormLayout>
 #include <QLabel>
@@ -115,6 +116,7 @@ void EditCounterpartyDialog::saveCounterparty()
         QMessageBox::critical(this, "Ошибка", 
             "Не удалось обновить контрагента:\n" + query.lastError().text());
     } else {
+        LedgerEvents::instance().notifyUpdated(LedgerEvents::Counterparties, counterpartyId_);
         QMessageBox::information(this, "Успех", "Контрагент обновлен!");
         accept();
     }
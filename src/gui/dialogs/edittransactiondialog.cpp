@@ -1,5 +1,7 @@
 #include "gui/dialogs/edittransactiondialog.h"
 #include "core/database.h"
+#include "core/ledgerevents.h"
+#include "gui/lookupcombobox.h"
 
 #include <QMessageBox>
 #include <QSqlQuery>
@@ -37,19 +39,8 @@ void EditTransactionDialog::loadTransactionData()
         int debitId = query.value(1).toInt();
         int creditId = query.value(2).toInt();
         
-        for (int i = 0; i < debitAccountCombo->count(); i++) {
-            if (debitAccountCombo->itemData(i).toInt() == debitId) {
-                debitAccountCombo->setCurrentIndex(i);
-                break;
-            }
-        }
-        
-        for (int i = 0; i < creditAccountCombo->count(); i++) {
-            if (creditAccountCombo->itemData(i).toInt() == creditId) {
-                creditAccountCombo->setCurrentIndex(i);
-                break;
-            }
-        }
+        debitAccountCombo->setCurrentId(debitId);
+        creditAccountCombo->setCurrentId(creditId);
         
         amountSpin->setValue(query.value(3).toDouble());
         descriptionEdit->setText(query.value(4).toString());
@@ -61,12 +52,7 @@ void EditTransactionDialog::loadTransactionData()
         
         int counterpartyId = query.value(7).toInt();
         if (counterpartyId > 0) {
-            for (int i = 0; i < counterpartyCombo->count(); i++) {
-                if (counterpartyCombo->itemData(i).toInt() == counterpartyId) {
-                    counterpartyCombo->setCurrentIndex(i);
-                    break;
-                }
-            }
+            counterpartyCombo->setCurrentId(counterpartyId);
         }
     }
 }
@@ -121,6 +107,7 @@ void EditTransactionDialog::saveTransaction()
         QMessageBox::critical(this, "Ошибка", 
             "Не удалось обновить проводку:\n" + query.lastError().text());
     } else {
+        LedgerEvents::instance().notifyUpdated(LedgerEvents::Transactions, transactionId_);
         QMessageBox::information(this, "Успех", "Проводка обновлена!");
         accept();
     }
@@ -1,7 +1,9 @@
 #include "gui/dialogs/managetemplatesdialog.h"
 #include "gui/dialogs/edittemplatedialog.h"
 #include "gui/dialogs/addtransactiondialog.h"
+#include "gui/dialogs/masspostingdialog.h"
 #include "core/database.h"
+#include "core/amountformula.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QTableView>
@@ -10,6 +12,7 @@
 #include <QMessageBox>
 #include <QSqlQuery>
 #include <QInputDialog>
+#include <QLineEdit>
 
 ManageTemplatesDialog::ManageTemplatesDialog(QWidget *parent)
     : QDialog(parent)
@@ -52,6 +55,8 @@ void ManageTemplatesDialog::setupUI()
     editButton = new QPushButton("Редактировать");
     deleteButton = new QPushButton("Удалить");
     useButton = new QPushButton("Использовать");
+    postListButton = new QPushButton("Провести по списку...");
+    formulaButton = new QPushButton("Формула суммы...");
     refreshButton = new QPushButton("Обновить");
     closeButton = new QPushButton("Закрыть");
     
@@ -59,6 +64,8 @@ void ManageTemplatesDialog::setupUI()
     connect(editButton, &QPushButton::clicked, this, &ManageTemplatesDialog::editTemplate);
     connect(deleteButton, &QPushButton::clicked, this, &ManageTemplatesDialog::deleteTemplate);
     connect(useButton, &QPushButton::clicked, this, &ManageTemplatesDialog::useTemplate);
+    connect(postListButton, &QPushButton::clicked, this, &ManageTemplatesDialog::postList);
+    connect(formulaButton, &QPushButton::clicked, this, &ManageTemplatesDialog::editFormula);
     connect(refreshButton, &QPushButton::clicked, this, &ManageTemplatesDialog::refreshTable);
     connect(closeButton, &QPushButton::clicked, this, &QDialog::reject);
     connect(tableView, &QTableView::doubleClicked, this, &ManageTemplatesDialog::onDoubleClick);
@@ -67,6 +74,8 @@ void ManageTemplatesDialog::setupUI()
     buttonLayout->addWidget(editButton);
     buttonLayout->addWidget(deleteButton);
     buttonLayout->addWidget(useButton);
+    buttonLayout->addWidget(postListButton);
+    buttonLayout->addWidget(formulaButton);
     buttonLayout->addWidget(refreshButton);
     buttonLayout->addStretch();
     buttonLayout->addWidget(closeButton);
@@ -84,7 +93,7 @@ void ManageTemplatesDialog::loadTemplates()
         "SELECT t.id, t.name, t.description, "
         "       d.code || ' - ' || d.name as debit_account, "
         "       c.code || ' - ' || c.name as credit_account, "
-        "       t.amount, t.frequency, t.last_executed "
+        "       t.amount, t.frequency, t.last_executed, t.amount_formula "
         "FROM transaction_templates t "
         "LEFT JOIN accounts d ON t.debit_account_id = d.id "
         "LEFT JOIN accounts c ON t.credit_account_id = c.id "
@@ -100,11 +109,14 @@ void ManageTemplatesDialog::loadTemplates()
         rowItems << new QStandardItem(query.value(3).toString()); // Дебет
         rowItems << new QStandardItem(query.value(4).toString()); // Кредит
         
-        // Сумма
+        // Сумма: формула, если задана, иначе постоянная сумма
         double amount = query.value(5).toDouble();
-        QString amountStr = (amount > 0) ? 
-            QString::number(amount, 'f', 2) : "(вводится)";
-        rowItems << new QStandardItem(amountStr);
+        QString formula = query.value(8).toString();
+        QString amountStr = !formula.isEmpty() ? "= " + formula
+            : (amount > 0) ? QString::number(amount, 'f', 2) : "(вводится)";
+        QStandardItem *amountItem = new QStandardItem(amountStr);
+        amountItem->setData(formula, Qt::UserRole);
+        rowItems << amountItem;
         
         // Частота
         QString freq = query.value(6).toString();
@@ -195,6 +207,54 @@ void ManageTemplatesDialog::useTemplate()
         QString("Использование шаблона '%1' будет реализовано в следующей версии").arg(templateName));
 }
 
+void ManageTemplatesDialog::postList()
+{
+    // Выбранный шаблон подставляется, но в окне его можно сменить
+    QModelIndex index = tableView->currentIndex();
+    int id = index.isValid() ? model->item(index.row(), 0)->text().toInt() : -1;
+    
+    MassPostingDialog dialog(id, this);
+    dialog.exec();
+}
+
+void ManageTemplatesDialog::editFormula()
+{
+    QModelIndex index = tableView->currentIndex();
+    if (!index.isValid()) {
+        QMessageBox::warning(this, "Ошибка", "Выберите шаблон");
+        return;
+    }
+    
+    int id = model->item(index.row(), 0)->text().toInt();
+    QString text = model->item(index.row(), 5)->data(Qt::UserRole).toString();
+    
+    // Пустая формула - снова постоянная сумма шаблона
+    while (true) {
+        bool ok = false;
+        text = QInputDialog::getText(this, "Формула суммы",
+            "Например: balance(70) * 0.13, round(credit(70.01) * 0.13, 2),\n"
+            "template(\"Начисление зарплаты\") * 0.3. Пусто - постоянная сумма.",
+            QLineEdit::Normal, text, &ok).trimmed();
+        if (!ok) return;
+        
+        QString error;
+        AmountFormula formula;
+        if (text.isEmpty() || formula.compile(text, &error)) break;
+        QMessageBox::warning(this, "Ошибка", "Формула не разобрана:\n" + error);
+    }
+    
+    QSqlQuery query = Database::instance().executeQuery(
+        "UPDATE transaction_templates SET amount_formula = ? WHERE id = ?",
+        {text.isEmpty() ? QVariant() : QVariant(text), id}
+    );
+    if (query.lastError().isValid()) {
+        QMessageBox::critical(this, "Ошибка",
+            "Не удалось сохранить формулу:\n" + query.lastError().text());
+        return;
+    }
+    loadTemplates();
+}
+
 void ManageTemplatesDialog::refreshTable()
 {
     loadTemplates();
@@ -0,0 +1,303 @@
+#include "gui/dialogs/masspostingdialog.h"
+#include "core/database.h"
+#include "core/validationrules.h"
+
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QFormLayout>
+#include <QComboBox>
+#include <QDateEdit>
+#include <QTableWidget>
+#include <QHeaderView>
+#include <QPushButton>
+#include <QLabel>
+#include <QPlainTextEdit>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QSqlQuery>
+#include <algorithm>
+#include <functional>
+
+namespace {
+
+enum RowColumn {
+    CounterpartyColumn,
+    AmountColumn,
+    DocumentColumn,
+    ColumnCount
+};
+
+// Сумма шаблона в данных элемента списка шаблонов
+const int TemplateAmountRole = Qt::UserRole + 1;
+
+// Сумма из ячейки; пустая ячейка - сумма шаблона (*empty).
+// false - в ячейке не число
+bool cellAmount(const QTableWidgetItem *item, double *amount, bool *empty)
+{
+    *amount = 0.0;
+    const QString text = item ? item->text().trimmed() : QString();
+    *empty = text.isEmpty();
+    if (*empty) return true;
+
+    bool ok = false;
+    *amount = ValidationRules::parseAmount(text, &ok);
+    return ok;
+}
+
+}
+
+MassPostingDialog::MassPostingDialog(int templateId, QWidget *parent)
+    : QDialog(parent)
+{
+    setWindowTitle("Проведение шаблона по списку");
+    setMinimumSize(700, 550);
+
+    setupUI();
+    loadTemplates(templateId);
+}
+
+void MassPostingDialog::setupUI()
+{
+    QVBoxLayout *mainLayout = new QVBoxLayout(this);
+
+    QFormLayout *formLayout = new QFormLayout();
+    templateCombo = new QComboBox;
+    formLayout->addRow("Шаблон:", templateCombo);
+
+    dateEdit = new QDateEdit(QDate::currentDate());
+    dateEdit->setCalendarPopup(true);
+    formLayout->addRow("Дата проводок:", dateEdit);
+    mainLayout->addLayout(formLayout);
+
+    // Строки: контрагент (наименование или ИНН), сумма, номер документа
+    rowsTable = new QTableWidget(0, ColumnCount);
+    rowsTable->setHorizontalHeaderLabels({"Контрагент (наименование или ИНН)", "Сумма", "Документ"});
+    rowsTable->horizontalHeader()->setSectionResizeMode(CounterpartyColumn, QHeaderView::Stretch);
+    rowsTable->verticalHeader()->setDefaultSectionSize(24);
+    rowsTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    connect(rowsTable, &QTableWidget::itemChanged, this, &MassPostingDialog::updateTotals);
+    mainLayout->addWidget(rowsTable);
+
+    totalsLabel = new QLabel;
+    mainLayout->addWidget(totalsLabel);
+
+    reportEdit = new QPlainTextEdit;
+    reportEdit->setReadOnly(true);
+    reportEdit->setPlaceholderText("Здесь появятся ошибочные строки");
+    reportEdit->setMaximumHeight(120);
+    mainLayout->addWidget(reportEdit);
+
+    // Кнопки
+    QHBoxLayout *buttonLayout = new QHBoxLayout();
+    loadButton = new QPushButton("Загрузить из CSV...");
+    addButton = new QPushButton("Добавить строку");
+    removeButton = new QPushButton("Удалить строки");
+    checkButton = new QPushButton("Проверить");
+    postButton = new QPushButton("Провести");
+    closeButton = new QPushButton("Закрыть");
+
+    connect(loadButton, &QPushButton::clicked, this, &MassPostingDialog::loadCsv);
+    connect(addButton, &QPushButton::clicked, this, &MassPostingDialog::addRow);
+    connect(removeButton, &QPushButton::clicked, this, &MassPostingDialog::removeRows);
+    connect(checkButton, &QPushButton::clicked, this, &MassPostingDialog::check);
+    connect(postButton, &QPushButton::clicked, this, &MassPostingDialog::post);
+    connect(closeButton, &QPushButton::clicked, this, &QDialog::reject);
+
+    buttonLayout->addWidget(loadButton);
+    buttonLayout->addWidget(addButton);
+    buttonLayout->addWidget(removeButton);
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(checkButton);
+    buttonLayout->addWidget(postButton);
+    buttonLayout->addWidget(closeButton);
+    mainLayout->addLayout(buttonLayout);
+
+    // Пустые суммы в итоге - сумма выбранного шаблона
+    connect(templateCombo, &QComboBox::currentIndexChanged, this, &MassPostingDialog::updateTotals);
+    updateTotals();
+}
+
+void MassPostingDialog::loadTemplates(int templateId)
+{
+    if (!Database::instance().isInitialized()) return;
+
+    QSqlQuery query = Database::instance().executeQuery(
+        "SELECT t.id, t.name, d.code, c.code, t.amount "
+        "FROM transaction_templates t "
+        "LEFT JOIN accounts d ON t.debit_account_id = d.id "
+        "LEFT JOIN accounts c ON t.credit_account_id = c.id "
+        "ORDER BY t.name"
+    );
+
+    while (query.next()) {
+        templateCombo->addItem(QString("%1 (Дт %2 Кт %3)")
+                               .arg(query.value(1).toString(), query.value(2).toString(),
+                                    query.value(3).toString()),
+                               query.value(0).toInt());
+        templateCombo->setItemData(templateCombo->count() - 1, query.value(4).toDouble(),
+                                   TemplateAmountRole);
+    }
+
+    const int index = templateCombo->findData(templateId);
+    if (index >= 0) templateCombo->setCurrentIndex(index);
+}
+
+void MassPostingDialog::loadCsv()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, "Строки для проведения", QString(),
+                                                    "CSV (*.csv *.csv.gz)");
+    if (fileName.isEmpty()) return;
+
+    QVector<TemplatePosting::Row> loaded;
+    QStringList errors;
+    if (!TemplatePosting::readCsv(fileName, &loaded, &errors)) {
+        reportEdit->setPlainText(errors.join('\n'));
+        QMessageBox::warning(this, "Ошибка", "Файл прочитан с ошибками, строки не загружены");
+        return;
+    }
+
+    // Тысячи строк: без пересчета итогов на каждую ячейку
+    rowsTable->blockSignals(true);
+    rowsTable->setRowCount(loaded.size());
+    for (int row = 0; row < loaded.size(); ++row) {
+        const TemplatePosting::Row &r = loaded.at(row);
+        rowsTable->setItem(row, CounterpartyColumn, new QTableWidgetItem(r.counterparty));
+        rowsTable->setItem(row, AmountColumn, new QTableWidgetItem(
+            r.hasAmount ? QString::number(r.amount, 'f', 2) : QString()));
+        rowsTable->setItem(row, DocumentColumn, new QTableWidgetItem(r.documentNumber));
+    }
+    rowsTable->blockSignals(false);
+
+    reportEdit->clear();
+    updateTotals();
+}
+
+void MassPostingDialog::addRow()
+{
+    const int row = rowsTable->rowCount();
+    rowsTable->insertRow(row);
+    for (int column = 0; column < ColumnCount; ++column) {
+        rowsTable->setItem(row, column, new QTableWidgetItem);
+    }
+    rowsTable->setCurrentCell(row, CounterpartyColumn);
+    rowsTable->editItem(rowsTable->item(row, CounterpartyColumn));
+}
+
+void MassPostingDialog::removeRows()
+{
+    const QModelIndexList selected = rowsTable->selectionModel()->selectedRows();
+    QList<int> rowNumbers;
+    for (const QModelIndex &index : selected) {
+        rowNumbers << index.row();
+    }
+    std::sort(rowNumbers.begin(), rowNumbers.end(), std::greater<int>());
+    for (int row : rowNumbers) {
+        rowsTable->removeRow(row);
+    }
+    updateTotals();
+}
+
+QVector<TemplatePosting::Row> MassPostingDialog::rows(QStringList *errors) const
+{
+    QVector<TemplatePosting::Row> result;
+    result.reserve(rowsTable->rowCount());
+    for (int row = 0; row < rowsTable->rowCount(); ++row) {
+        const QTableWidgetItem *counterparty = rowsTable->item(row, CounterpartyColumn);
+        const QTableWidgetItem *amount = rowsTable->item(row, AmountColumn);
+        const QTableWidgetItem *document = rowsTable->item(row, DocumentColumn);
+
+        TemplatePosting::Row r;
+        r.counterparty = counterparty ? counterparty->text() : QString();
+        bool empty = true;
+        if (!cellAmount(amount, &r.amount, &empty)) {
+            *errors << QString("Строка %1: неверная сумма \"%2\"").arg(row + 1).arg(amount->text());
+        }
+        r.hasAmount = !empty;
+        r.documentNumber = document ? document->text() : QString();
+        result.append(r);
+    }
+    return result;
+}
+
+void MassPostingDialog::updateTotals()
+{
+    // Как при проведении: пустая ячейка - сумма шаблона
+    const double templateAmount = templateCombo->currentData(TemplateAmountRole).toDouble();
+    double total = 0.0;
+    int invalid = 0;
+    for (int row = 0; row < rowsTable->rowCount(); ++row) {
+        double amount = 0.0;
+        bool empty = true;
+        if (cellAmount(rowsTable->item(row, AmountColumn), &amount, &empty)) {
+            total += empty ? templateAmount : amount;
+        } else {
+            ++invalid;
+        }
+    }
+    QString text = QString("Строк: %1, сумма: %2")
+                   .arg(rowsTable->rowCount())
+                   .arg(QString::number(total, 'f', 2));
+    if (invalid > 0) {
+        text += QString(", неверных сумм: %1").arg(invalid);
+    }
+    totalsLabel->setText(text);
+}
+
+void MassPostingDialog::showResult(const TemplatePosting::Result &result)
+{
+    reportEdit->setPlainText(result.errors.join('\n'));
+}
+
+void MassPostingDialog::check()
+{
+    if (templateCombo->currentIndex() < 0) return;
+
+    TemplatePosting::Result result;
+    const QVector<TemplatePosting::Row> postingRows = rows(&result.errors);
+    if (!result.errors.isEmpty()) {
+        showResult(result);
+        return;
+    }
+    bool ok = TemplatePosting::post(templateCombo->currentData().toInt(), dateEdit->date(),
+                                    postingRows, true, &result);
+    showResult(result);
+    if (ok) {
+        QMessageBox::information(this, "Проверка",
+            QString("Ошибок нет, строк к проведению: %1").arg(rowsTable->rowCount()));
+    }
+}
+
+void MassPostingDialog::post()
+{
+    if (templateCombo->currentIndex() < 0 || rowsTable->rowCount() == 0) return;
+
+    // Нечисловая сумма - ошибка строки, а не сумма шаблона
+    TemplatePosting::Result result;
+    const QVector<TemplatePosting::Row> postingRows = rows(&result.errors);
+    if (!result.errors.isEmpty()) {
+        showResult(result);
+        QMessageBox::warning(this, "Ошибка",
+            QString("Проводки не записаны: ошибок %1").arg(result.errors.size()));
+        return;
+    }
+
+    QMessageBox::StandardButton reply = QMessageBox::question(
+        this, "Подтверждение",
+        QString("Провести %1 проводок по шаблону \"%2\" датой %3?")
+            .arg(rowsTable->rowCount())
+            .arg(templateCombo->currentText(), dateEdit->date().toString("dd.MM.yyyy")),
+        QMessageBox::Yes | QMessageBox::No);
+    if (reply != QMessageBox::Yes) return;
+
+    bool ok = TemplatePosting::post(templateCombo->currentData().toInt(), dateEdit->date(),
+                                    postingRows, false, &result);
+    showResult(result);
+    if (!ok) {
+        QMessageBox::warning(this, "Ошибка",
+            QString("Проводки не записаны: ошибок %1").arg(result.errors.size()));
+        return;
+    }
+
+    QMessageBox::information(this, "Успех", QString("Проведено: %1").arg(result.posted));
+    accept();
+}
@@ -0,0 +1,181 @@
+#include "gui/exportjobspanel.h"
+#include "core/exportjobqueue.h"
+
+#include <QDesktopServices>
+#include <QFileInfo>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLocale>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QUrl>
+#include <QVBoxLayout>
+
+namespace {
+
+QString stateText(const ExportJobQueue::JobInfo &info)
+{
+    switch (info.state) {
+    case ExportJobQueue::Queued:
+        return "В очереди";
+    case ExportJobQueue::Running:
+        return "Выполняется";
+    case ExportJobQueue::Finished:
+        return "Готово";
+    case ExportJobQueue::Failed:
+        return "Ошибка: " + info.error;
+    case ExportJobQueue::Cancelled:
+        return "Отменена";
+    }
+    return QString();
+}
+
+}
+
+ExportJobsPanel::ExportJobsPanel(QWidget *parent)
+    : QWidget(parent)
+    , table(new QTableWidget(0, ColumnCount, this))
+    , cancelButton(new QPushButton("Отменить", this))
+    , openFolderButton(new QPushButton("Открыть папку", this))
+    , clearButton(new QPushButton("Убрать завершенные", this))
+{
+    table->setHorizontalHeaderLabels({"Выгрузка", "Файл", "Ход", "Состояние"});
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table->setSelectionMode(QAbstractItemView::SingleSelection);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->verticalHeader()->setVisible(false);
+    table->horizontalHeader()->setSectionResizeMode(FileColumn, QHeaderView::Stretch);
+    table->setColumnWidth(ProgressColumn, 160);
+
+    QHBoxLayout *buttons = new QHBoxLayout;
+    buttons->addWidget(cancelButton);
+    buttons->addWidget(openFolderButton);
+    buttons->addStretch();
+    buttons->addWidget(clearButton);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(4, 4, 4, 4);
+    layout->addWidget(table);
+    layout->addLayout(buttons);
+
+    ExportJobQueue &queue = ExportJobQueue::instance();
+    connect(&queue, &ExportJobQueue::jobAdded, this, &ExportJobsPanel::addJob);
+    connect(&queue, &ExportJobQueue::jobChanged, this, &ExportJobsPanel::updateJob);
+    connect(&queue, &ExportJobQueue::jobsRemoved, this, &ExportJobsPanel::reloadJobs);
+
+    connect(cancelButton, &QPushButton::clicked, this, &ExportJobsPanel::cancelSelected);
+    connect(openFolderButton, &QPushButton::clicked, this, &ExportJobsPanel::openFolder);
+    connect(clearButton, &QPushButton::clicked, &queue, &ExportJobQueue::removeFinished);
+    connect(table, &QTableWidget::itemSelectionChanged, this, &ExportJobsPanel::updateButtons);
+    connect(table, &QTableWidget::cellDoubleClicked, this, &ExportJobsPanel::openFolder);
+
+    reloadJobs();
+}
+
+void ExportJobsPanel::addJob(int id)
+{
+    const ExportJobQueue::JobInfo info = ExportJobQueue::instance().job(id);
+
+    int row = table->rowCount();
+    table->insertRow(row);
+
+    QTableWidgetItem *titleItem = new QTableWidgetItem(info.title);
+    titleItem->setData(Qt::UserRole, id);
+    table->setItem(row, TitleColumn, titleItem);
+
+    QTableWidgetItem *fileItem = new QTableWidgetItem(QFileInfo(info.fileName).fileName());
+    fileItem->setToolTip(info.fileName);
+    table->setItem(row, FileColumn, fileItem);
+
+    table->setCellWidget(row, ProgressColumn, new QProgressBar(table));
+    table->setItem(row, StateColumn, new QTableWidgetItem);
+
+    updateJob(id);
+}
+
+void ExportJobsPanel::updateJob(int id)
+{
+    int row = rowOf(id);
+    if (row < 0) return;
+
+    const ExportJobQueue::JobInfo info = ExportJobQueue::instance().job(id);
+
+    QProgressBar *bar = qobject_cast<QProgressBar *>(table->cellWidget(row, ProgressColumn));
+    if (bar) {
+        if (info.state == ExportJobQueue::Finished) {
+            bar->setRange(0, 1);
+            bar->setValue(1);
+        } else if (info.total > 0) {
+            // Проценты: число строк может не влезть в int
+            bar->setRange(0, 100);
+            bar->setValue(int(qMin<qint64>(100, info.done * 100 / info.total)));
+        } else if (info.state == ExportJobQueue::Running) {
+            bar->setRange(0, 0);    // объем неизвестен - бегущий индикатор
+        } else {
+            bar->setRange(0, 1);
+            bar->setValue(0);
+        }
+        bar->setFormat(info.done > 0 ? QLocale().toString(info.done) + " стр." : QString());
+    }
+
+    QTableWidgetItem *stateItem = table->item(row, StateColumn);
+    stateItem->setText(stateText(info));
+    stateItem->setToolTip(info.error);
+
+    updateButtons();
+}
+
+void ExportJobsPanel::reloadJobs()
+{
+    table->setRowCount(0);
+    for (const ExportJobQueue::JobInfo &info : ExportJobQueue::instance().jobs()) {
+        addJob(info.id);
+    }
+    updateButtons();
+}
+
+void ExportJobsPanel::cancelSelected()
+{
+    int id = selectedJob();
+    if (id > 0) {
+        ExportJobQueue::instance().cancel(id);
+    }
+}
+
+void ExportJobsPanel::openFolder()
+{
+    int id = selectedJob();
+    if (id <= 0) return;
+
+    const QString fileName = ExportJobQueue::instance().job(id).fileName;
+    QDesktopServices::openUrl(QUrl::fromLocalFile(QFileInfo(fileName).absolutePath()));
+}
+
+void ExportJobsPanel::updateButtons()
+{
+    int id = selectedJob();
+    ExportJobQueue::State state = ExportJobQueue::instance().job(id).state;
+
+    cancelButton->setEnabled(id > 0 && (state == ExportJobQueue::Queued
+                                        || state == ExportJobQueue::Running));
+    openFolderButton->setEnabled(id > 0);
+    clearButton->setEnabled(table->rowCount() > ExportJobQueue::instance().activeCount());
+}
+
+int ExportJobsPanel::rowOf(int id) const
+{
+    for (int row = 0; row < table->rowCount(); ++row) {
+        if (table->item(row, TitleColumn)->data(Qt::UserRole).toInt() == id) {
+            return row;
+        }
+    }
+    return -1;
+}
+
+int ExportJobsPanel::selectedJob() const
+{
+    int row = table->currentRow();
+    if (row < 0 || !table->item(row, TitleColumn)) return 0;
+    return table->item(row, TitleColumn)->data(Qt::UserRole).toInt();
+}
@@ -0,0 +1,217 @@
+#include "gui/lookupcombobox.h"
+#include "core/lookupindex.h"
+
+#include <QAbstractListModel>
+#include <QCompleter>
+#include <QLineEdit>
+#include <QSignalBlocker>
+
+namespace {
+const int PlaceholderPosition = -1;
+const int FetchBatchSize = 20;
+}
+
+// Модель результатов поиска для всплывающего списка. Хранит только позиции
+// найденных элементов; текст формируется при отрисовке, а строки отдаются
+// представлению порциями через canFetchMore()/fetchMore().
+class LookupResultModel : public QAbstractListModel
+{
+public:
+    explicit LookupResultModel(QObject *parent = nullptr)
+        : QAbstractListModel(parent) {}
+
+    void setResults(std::shared_ptr<const LookupIndex> index,
+                    const QString &placeholder, QVector<int> positions)
+    {
+        beginResetModel();
+        index_ = std::move(index);
+        placeholder_ = placeholder;
+        positions_ = std::move(positions);
+        loaded_ = qMin(FetchBatchSize, positions_.size());
+        endResetModel();
+    }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override
+    {
+        return parent.isValid() ? 0 : loaded_;
+    }
+
+    QVariant data(const QModelIndex &index, int role) const override
+    {
+        if (!index.isValid() || index.row() >= loaded_) return QVariant();
+
+        int position = positions_[index.row()];
+        if (role == Qt::UserRole) return position;
+        if (role != Qt::DisplayRole && role != Qt::EditRole) return QVariant();
+
+        if (position == PlaceholderPosition) return placeholder_;
+        return index_ ? index_->item(position).displayText() : QString();
+    }
+
+    bool canFetchMore(const QModelIndex &parent) const override
+    {
+        return !parent.isValid() && loaded_ < positions_.size();
+    }
+
+    void fetchMore(const QModelIndex &parent) override
+    {
+        if (parent.isValid()) return;
+        int count = qMin(FetchBatchSize, positions_.size() - loaded_);
+        if (count <= 0) return;
+        beginInsertRows(QModelIndex(), loaded_, loaded_ + count - 1);
+        loaded_ += count;
+        endInsertRows();
+    }
+
+private:
+    std::shared_ptr<const LookupIndex> index_;
+    QString placeholder_;
+    QVector<int> positions_;
+    int loaded_ = 0;
+};
+
+LookupComboBox::LookupComboBox(QWidget *parent)
+    : QComboBox(parent)
+    , resultModel_(new LookupResultModel(this))
+    , completer_(new QCompleter(this))
+{
+    setEditable(true);
+    setInsertPolicy(QComboBox::NoInsert);
+
+    // Комплитер ставим напрямую в QLineEdit, чтобы QComboBox не пытался
+    // искать выбранный текст в собственном списке
+    completer_->setModel(resultModel_);
+    completer_->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+    completer_->setCaseSensitivity(Qt::CaseInsensitive);
+    completer_->setMaxVisibleItems(15);
+    lineEdit()->setCompleter(completer_);
+
+    connect(lineEdit(), &QLineEdit::textEdited, this, &LookupComboBox::onTextEdited);
+    connect(lineEdit(), &QLineEdit::editingFinished, this, &LookupComboBox::onEditingFinished);
+    connect(completer_, QOverload<const QModelIndex &>::of(&QCompleter::activated),
+            this, &LookupComboBox::onCompletionActivated);
+}
+
+void LookupComboBox::setLookupIndex(std::shared_ptr<const LookupIndex> index)
+{
+    int previousId = currentId();
+    index_ = std::move(index);
+    setCurrentId(previousId);
+}
+
+void LookupComboBox::setPlaceholderItem(const QString &text, const QVariant &data)
+{
+    if (count() == 0) {
+        addItem(text, data);
+    } else {
+        setItemText(0, text);
+        setItemData(0, data);
+    }
+    if (currentIndex() == 0) {
+        setEditText(text);
+    }
+}
+
+void LookupComboBox::setMaxResults(int count)
+{
+    maxResults_ = qMax(1, count);
+}
+
+bool LookupComboBox::setCurrentId(int id)
+{
+    int position = index_ ? index_->positionOf(id) : -1;
+    if (position < 0) {
+        selectPosition(PlaceholderPosition);
+        return false;
+    }
+    selectPosition(position);
+    return true;
+}
+
+int LookupComboBox::currentId() const
+{
+    return currentData().toInt();
+}
+
+void LookupComboBox::showPopup()
+{
+    // Вместо полного списка показываем первые совпадения по введенному тексту
+    QString text = lineEdit()->text();
+    if (currentIndex() >= 0 && text == itemText(currentIndex())) {
+        text.clear();
+    }
+    updateMatches(text);
+    completer_->complete();
+}
+
+void LookupComboBox::onTextEdited(const QString &text)
+{
+    updateMatches(text);
+    completer_->complete();
+}
+
+void LookupComboBox::onCompletionActivated(const QModelIndex &index)
+{
+    QVariant position = index.data(Qt::UserRole);
+    if (position.isValid()) {
+        selectPosition(position.toInt());
+    }
+}
+
+void LookupComboBox::onEditingFinished()
+{
+    // Незавершенный ввод не меняет выбор - возвращаем текст выбранного элемента
+    if (currentIndex() >= 0 && lineEdit()->text() != itemText(currentIndex())) {
+        setEditText(itemText(currentIndex()));
+    }
+}
+
+void LookupComboBox::selectPosition(int position)
+{
+    const QVariant previousData = currentIndex() >= 0 ? currentData() : QVariant();
+    const int previousIndex = currentIndex();
+    const QString previousText = currentText();
+
+    {
+        // Пересборка списка сама переключает текущий элемент: без блокировки
+        // один выбор пользователя давал бы два currentIndexChanged
+        QSignalBlocker blocker(this);
+
+        if (count() == 0) {
+            addItem(QString());
+        }
+
+        // В списке комбобокса остаются только заглушка и выбранный элемент
+        while (count() > 1) {
+            removeItem(count() - 1);
+        }
+
+        if (position == PlaceholderPosition || !index_) {
+            setCurrentIndex(0);
+            setEditText(itemText(0));
+        } else {
+            const LookupIndex::Item &item = index_->item(position);
+            addItem(item.displayText(), item.id);
+            setCurrentIndex(1);
+        }
+    }
+
+    if (currentIndex() != previousIndex || currentData() != previousData) {
+        emit currentIndexChanged(currentIndex());
+    }
+    if (currentText() != previousText) {
+        emit currentTextChanged(currentText());
+    }
+}
+
+void LookupComboBox::updateMatches(const QString &prefix)
+{
+    QVector<int> positions;
+    if (index_) {
+        positions = index_->search(prefix, maxResults_);
+    }
+    if (prefix.trimmed().isEmpty() && count() > 0) {
+        positions.prepend(PlaceholderPosition);
+    }
+    resultModel_->setResults(index_, count() > 0 ? itemText(0) : QString(), positions);
+}
@@ -3,6 +3,8 @@
 #include "gui/dialogs/addcounterpartydialog.h"
 #include "gui/reportwidget.h"
 #include "core/database.h"
+#include "core/ledgerevents.h"
+#include "core/accounttree.h"
 #include "gui/tableactions.h"
 #include "gui/dialogs/edittransactiondialog.h"
 #include "gui/dialogs/editcounterpartydialog.h"
@@ -10,20 +12,31 @@
 #include "gui/dialogs/addeditaccountdialog.h"
 #include "gui/operationsjournalwidget.h"
 #include "gui/advancedfilterwidget.h"
+#include "gui/transactiontablemodel.h"
+#include "gui/totalsfooterwidget.h"
+#include "gui/sqlrowmodel.h"
+#include "gui/accounttreemodel.h"
+#include "gui/exportjobspanel.h"
+#include "gui/dialogs/masspostingdialog.h"
+#include "core/exportjobqueue.h"
 #include "core/exportmanager.h"  // Добавлено для экспорта в PDF
+#include "core/ledgersnapshot.h"
+#include "core/templatescheduler.h"
 
 #include <QApplication>
 #include <QMenuBar>
 #include <QToolBar>
+#include <QDockWidget>
 #include <QStatusBar>
 #include <QMessageBox>
 #include <QFileDialog>
 #include <QVBoxLayout>
 #include <QHeaderView>
+#include <QTableView>
+#include <QTreeView>
 #include <QSqlRecord>
 #include <QDebug>
 #include <QSqlQueryModel>  // Добавлено для QSqlQueryModel
-#include <QSqlTableModel>  // Добавлено для QSqlTableModel
 #include <QSqlError>       // Добавлено для работы с ошибками SQL
 
 MainWindow::MainWindow(QWidget *parent)
@@ -44,6 +57,12 @@ MainWindow::MainWindow(QWidget *parent)
     
     // Загрузка данных
     showTransactions();
+    showAccounts();
+    showCounterparties();
+    
+    // Повторяющиеся шаблоны: пропущенные даты дописываются при запуске,
+    // дальше проверка раз в час
+    templateScheduler->start();
 }
 
 MainWindow::~MainWindow()
@@ -96,7 +115,7 @@ void MainWindow::setupUi()
 
     // Создание таблиц
     transactionsTable = new QTableView;
-    accountsTable = new QTableView;
+    accountsTree = new QTreeView;
     counterpartiesTable = new QTableView;
     
     // Настройка отображения таблиц
@@ -104,6 +123,55 @@ void MainWindow::setupUi()
     transactionsTable->setSelectionMode(QAbstractItemView::SingleSelection);
     transactionsTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
     
+    // Модель проводок создается один раз и догружает строки при прокрутке
+    transactionsModel = new TransactionTableModel(this);
+    transactionsTable->setModel(transactionsModel);
+    transactionsTable->hideColumn(TransactionTableModel::IdColumn);
+    
+    // Настраиваем адаптивные размеры столбцов
+    transactionsTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Interactive);
+    transactionsTable->setColumnWidth(TransactionTableModel::DateColumn, 80);
+    transactionsTable->setColumnWidth(TransactionTableModel::DebitColumn, 150);
+    transactionsTable->setColumnWidth(TransactionTableModel::CreditColumn, 150);
+    transactionsTable->setColumnWidth(TransactionTableModel::AmountColumn, 80);
+    transactionsTable->setColumnWidth(TransactionTableModel::DescriptionColumn, 200);
+    transactionsTable->setColumnWidth(TransactionTableModel::DocumentColumn, 100);
+    transactionsTable->setColumnWidth(TransactionTableModel::CounterpartyColumn, 150);
+    
+    // Столбец "Описание" растягивается
+    transactionsTable->horizontalHeader()->setSectionResizeMode(
+        TransactionTableModel::DescriptionColumn, QHeaderView::Stretch);
+    
+    // План счетов - дерево: подсчета читаются при раскрытии узла
+    accountsModel = new AccountTreeModel(this);
+    accountsTree->setModel(accountsModel);
+    accountsTree->setSelectionBehavior(QAbstractItemView::SelectRows);
+    accountsTree->setSelectionMode(QAbstractItemView::SingleSelection);
+    accountsTree->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    accountsTree->setAlternatingRowColors(true);
+    accountsTree->setUniformRowHeights(true);
+    accountsTree->header()->setStretchLastSection(false);
+    accountsTree->header()->setSectionResizeMode(AccountTreeModel::CodeColumn,
+                                                 QHeaderView::ResizeToContents);
+    accountsTree->header()->setSectionResizeMode(AccountTreeModel::NameColumn,
+                                                 QHeaderView::Stretch);
+    
+    const QString counterpartyColumns =
+        "SELECT id, name, inn, kpp, address, phone, email, created_at FROM counterparties ";
+    counterpartiesModel = new SqlRowModel(LedgerEvents::Counterparties,
+        counterpartyColumns + "ORDER BY id",
+        counterpartyColumns + "WHERE id IN (%1)",
+        0, this);
+    counterpartiesModel->setHeaderData(1, Qt::Horizontal, tr("Наименование"));
+    counterpartiesModel->setHeaderData(2, Qt::Horizontal, tr("ИНН"));
+    counterpartiesModel->setHeaderData(3, Qt::Horizontal, tr("КПП"));
+    counterpartiesModel->setHeaderData(4, Qt::Horizontal, tr("Адрес"));
+    counterpartiesModel->setHeaderData(5, Qt::Horizontal, tr("Телефон"));
+    counterpartiesModel->setHeaderData(6, Qt::Horizontal, tr("Email"));
+    counterpartiesModel->setHeaderData(7, Qt::Horizontal, tr("Создан"));
+    counterpartiesTable->setModel(counterpartiesModel);
+    counterpartiesTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    
     // 1. Создаем виджет поиска для проводок с использованием AdvancedFilterWidget
     transactionsSearchWidget = new AdvancedFilterWidget();
 
@@ -114,6 +182,11 @@ void MainWindow::setupUi()
     // 3. Добавляем виджет поиска и таблицу в контейнер
     transactionsLayout->addWidget(transactionsSearchWidget);
     transactionsLayout->addWidget(transactionsTable);
+    
+    // Итоги по всему результату поиска считаются в SQL, без загрузки всех строк
+    TotalsFooterWidget *transactionsTotals = new TotalsFooterWidget;
+    transactionsTotals->setModel(transactionsModel);
+    transactionsLayout->addWidget(transactionsTotals);
 
     // 4. Добавляем контейнер на вкладку
     tabWidget->addTab(transactionsContainer, tr("Проводки"));
@@ -123,7 +196,7 @@ void MainWindow::setupUi()
     // Создаем контейнеры и для других вкладок для единообразия
     QWidget *accountsContainer = new QWidget;
     QVBoxLayout *accountsLayout = new QVBoxLayout(accountsContainer);
-    accountsLayout->addWidget(accountsTable);
+    accountsLayout->addWidget(accountsTree);
     tabWidget->addTab(accountsContainer, tr("План счетов"));
 
     QWidget *counterpartiesContainer = new QWidget;
@@ -131,8 +204,17 @@ void MainWindow::setupUi()
     counterpartiesLayout->addWidget(counterpartiesTable);
     tabWidget->addTab(counterpartiesContainer, tr("Контрагенты"));
 
-    OperationsJournalWidget *operationsJournal = new OperationsJournalWidget(this);
-    tabWidget->addTab(operationsJournal, tr("Журнал операций"));
+    operationsJournalWidget = new OperationsJournalWidget(this);
+    tabWidget->addTab(operationsJournalWidget, tr("Журнал операций"));
+    
+    // Фоновые выгрузки: панель появляется, когда запущена первая
+    exportsDock = new QDockWidget(tr("Выгрузки"), this);
+    exportsDock->setObjectName("exportsDock");
+    exportsDock->setWidget(new ExportJobsPanel(exportsDock));
+    addDockWidget(Qt::BottomDockWidgetArea, exportsDock);
+    exportsDock->hide();
+    
+    templateScheduler = new TemplateScheduler(this);
     
     // Настройка строки состояния
     statusBar()->showMessage(tr("Готово"));
@@ -159,6 +241,10 @@ void MainWindow::setupUi()
     actionBalanceReport = new QAction(tr("&Оборотно-сальдовая ведомость"), this);
     fileMenu->addAction(actionBalanceReport);
     
+    actionLedgerSnapshot = new QAction(tr("Снимок журнала..."), this);
+    fileMenu->addAction(actionLedgerSnapshot);
+    fileMenu->addAction(exportsDock->toggleViewAction());
+    
     fileMenu->addSeparator();
     
     actionExit = new QAction(tr("&Выход"), this);
@@ -176,13 +262,16 @@ void MainWindow::setupUi()
     QAction *actionCreateFromTemplate = new QAction(tr("Создать проводку из шаблона"), this);
     operationsMenu->addAction(actionCreateFromTemplate);
     
+    QAction *actionMassPosting = new QAction(tr("Провести шаблон по списку..."), this);
+    operationsMenu->addAction(actionMassPosting);
+    connect(actionMassPosting, &QAction::triggered, this, [this]() {
+        MassPostingDialog dialog(-1, this);
+        dialog.exec();
+    });
+    
     // Подключаем сигналы
     connect(actionAddAccount, &QAction::triggered, this, &MainWindow::addAccount);
 
-    // 4. Добавляем журнал операций
-    OperationsJournalWidget *operationsJournal = new OperationsJournalWidget(this);
-    tabWidget->addTab(operationsJournal, tr("Журнал операций"));
-    
     // Настраиваем политику размеров для tabWidget
     tabWidget->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
     
@@ -221,6 +310,7 @@ void MainWindow::setupConnections()
     connect(actionAddTransaction, &QAction::triggered, this, &MainWindow::addTransaction);
     connect(actionAddCounterparty, &QAction::triggered, this, &MainWindow::addCounterparty);
     connect(actionBalanceReport, &QAction::triggered, this, &MainWindow::generateBalanceReport);
+    connect(actionLedgerSnapshot, &QAction::triggered, this, &MainWindow::exportLedgerSnapshot);
     connect(actionExit, &QAction::triggered, qApp, &QApplication::quit);
     connect(actionAbout, &QAction::triggered, this, &MainWindow::about);
     
@@ -229,158 +319,45 @@ void MainWindow::setupConnections()
         connect(transactionsSearchWidget, &AdvancedFilterWidget::filterApplied,
                 this, &MainWindow::onSearchTransactions);
     }
+    connect(transactionsModel, &TransactionTableModel::pageLoaded,
+            this, &MainWindow::onTransactionsPageLoaded);
     
-    // Подключение смены вкладок
-    connect(tabWidget, &QTabWidget::currentChanged, [this](int index) {
-        switch (index) {
-            case 0: showTransactions(); break;
-            case 1: showAccounts(); break;
-            case 2: showCounterparties(); break;
-        }
+    ExportJobQueue &exports = ExportJobQueue::instance();
+    connect(&exports, &ExportJobQueue::jobAdded, exportsDock, &QDockWidget::show);
+    connect(&exports, &ExportJobQueue::jobFinished, this, &MainWindow::onExportFinished);
+    
+    connect(templateScheduler, &TemplateScheduler::executed,
+            this, &MainWindow::onTemplatesExecuted);
+    connect(templateScheduler, &TemplateScheduler::failed, this, [this](const QString &error) {
+        statusBar()->showMessage(tr("Шаблоны проводок не выполнены: %1").arg(error), 10000);
     });
 }
 
 void MainWindow::showTransactions() {
-    if (!Database::instance().isInitialized()) return;
-    
-    // Получаем параметры фильтра из AdvancedFilterWidget
-    AdvancedFilterWidget::FilterOptions options;
-    if (transactionsSearchWidget) {
-        options = transactionsSearchWidget->getFilterOptions();
-    }
-    
-    // Если есть активный фильтр, применяем его
-    if (!options.textFilter.isEmpty() || 
-        options.dateFilterEnabled || 
-        options.amountFilterEnabled ||
-        options.debitAccountId != -1 ||
-        options.creditAccountId != -1 ||
-        options.counterpartyId != -1) {
-        
-        onSearchTransactions();
-    } else {
-        // Иначе показываем все проводки
-        QSqlQueryModel *model = new QSqlQueryModel(this);
-        QString query = 
-            "SELECT t.id, t.transaction_date, "
-            "       d.code || ' - ' || d.name as debit, "
-            "       c.code || ' - ' || c.name as credit, "
-            "       t.amount, t.description, t.document_number, "
-            "       COALESCE(cp.name, '') as counterparty_name "
-            "FROM transactions t "
-            "LEFT JOIN accounts d ON t.debit_account_id = d.id "
-            "LEFT JOIN accounts c ON t.credit_account_id = c.id "
-            "LEFT JOIN counterparties cp ON t.counterparty_id = cp.id "
-            "ORDER BY t.transaction_date DESC, t.id DESC";
-        
-        model->setQuery(query);
-        model->setHeaderData(0, Qt::Horizontal, tr("ID"));
-        model->setHeaderData(1, Qt::Horizontal, tr("Дата"));
-        model->setHeaderData(2, Qt::Horizontal, tr("Дебет"));
-        model->setHeaderData(3, Qt::Horizontal, tr("Кредит"));
-        model->setHeaderData(4, Qt::Horizontal, tr("Сумма"));
-        model->setHeaderData(5, Qt::Horizontal, tr("Описание"));
-        model->setHeaderData(6, Qt::Horizontal, tr("Документ"));
-        model->setHeaderData(7, Qt::Horizontal, tr("Контрагент"));
-        
-        // Устанавливаем модель
-        QSqlQueryModel *oldModel = qobject_cast<QSqlQueryModel*>(transactionsTable->model());
-        transactionsTable->setModel(model);
-        
-        if (oldModel) {
-            oldModel->deleteLater();
-        }
-        
-        transactionsTable->hideColumn(0);
-        
-        // Настраиваем адаптивные размеры столбцов
-        transactionsTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Interactive);
-        transactionsTable->setColumnWidth(1, 80);   // Дата
-        transactionsTable->setColumnWidth(2, 150);  // Дебет
-        transactionsTable->setColumnWidth(3, 150);  // Кредит
-        transactionsTable->setColumnWidth(4, 80);   // Сумма
-        transactionsTable->setColumnWidth(5, 200);  // Описание (растягивается)
-        transactionsTable->setColumnWidth(6, 100);  // Документ
-        transactionsTable->setColumnWidth(7, 150);  // Контрагент
-        
-        // Столбец "Описание" растягивается
-        transactionsTable->horizontalHeader()->setSectionResizeMode(5, QHeaderView::Stretch);
-        
-        // Показываем количество записей
-        int rowCount = model->rowCount();
-        statusBar()->showMessage(QString("Всего проводок: %1").arg(rowCount), 3000);
-    }
+    // Перечитываем проводки с текущим фильтром
+    onSearchTransactions();
 }
 
 void MainWindow::showAccounts()
 {
     if (!Database::instance().isInitialized()) return;
     
-    // Используем QSqlQueryModel с иерархическим запросом
-    QSqlQueryModel *model = new QSqlQueryModel(this);
-    
-    // Рекурсивный запрос для иерархического отображения
-    QString query = 
-        "WITH RECURSIVE account_tree AS ("
-        "  SELECT id, code, name, type, parent_id, 0 as level, "
-        "         code as sort_key "
-        "  FROM accounts WHERE parent_id IS NULL "
-        "  UNION ALL "
-        "  SELECT a.id, a.code, a.name, a.type, a.parent_id, at.level + 1, "
-        "         at.sort_key || '.' || a.code "
-        "  FROM accounts a "
-        "  JOIN account_tree at ON a.parent_id = at.id"
-        ") "
-        "SELECT id, "
-        "       printf('%*s%s', level * 2, '', code) as code_display, "
-        "       name, "
-        "       CASE type "
-        "         WHEN 0 THEN 'Активный' "
-        "         WHEN 1 THEN 'Пассивный' "
-        "         WHEN 2 THEN 'Активно-пассивный' "
-        "       END as type_name "
-        "FROM account_tree "
-        "ORDER BY sort_key";
-    
-    model->setQuery(query);
-    
-    model->setHeaderData(0, Qt::Horizontal, tr("ID"));
-    model->setHeaderData(1, Qt::Horizontal, tr("Код"));
-    model->setHeaderData(2, Qt::Horizontal, tr("Наименование"));
-    model->setHeaderData(3, Qt::Horizontal, tr("Тип"));
-    
-    accountsTable->setModel(model);
-    accountsTable->hideColumn(0); // Скрываем ID
-    
-    // Настройка отображения
-    accountsTable->setAlternatingRowColors(true);
-    accountsTable->verticalHeader()->setDefaultSectionSize(24);
-    accountsTable->horizontalHeader()->setStretchLastSection(true);
-    
-    // Настраиваем выравнивание для кода
-    accountsTable->horizontalHeader()->setSectionResizeMode(1, QHeaderView::ResizeToContents);
+    // Полная перезагрузка: дерево сворачивается до корневых счетов,
+    // после правок модель обновляется построчно
+    accountsModel->reload();
 }
 
 void MainWindow::showCounterparties()
 {
     if (!Database::instance().isInitialized()) return;
     
-    counterpartiesModel = new QSqlTableModel(this, Database::instance().database());
-    counterpartiesModel->setTable("counterparties");
-    
-    counterpartiesModel->setHeaderData(1, Qt::Horizontal, tr("Наименование"));
-    counterpartiesModel->setHeaderData(2, Qt::Horizontal, tr("ИНН"));
-    counterpartiesModel->setHeaderData(3, Qt::Horizontal, tr("КПП"));
-    
     counterpartiesModel->select();
-    counterpartiesTable->setModel(counterpartiesModel);
     counterpartiesTable->hideColumn(0); // Скрываем ID
 }
 
 void MainWindow::addTransaction() {
     AddTransactionDialog dialog(this);
     if (dialog.exec() == QDialog::Accepted) {
-        showTransactions(); // Обновляем таблицу проводок
         statusBar()->showMessage("Проводка добавлена", 3000);
     }
 }
@@ -427,7 +404,6 @@ void MainWindow::about()
 void MainWindow::addCounterparty() {
     AddCounterpartyDialog dialog(this);
     if (dialog.exec() == QDialog::Accepted) {
-        showCounterparties(); // Обновляем таблицу
         statusBar()->showMessage("Контрагент добавлен", 3000);
     }
 }
@@ -453,7 +429,7 @@ void MainWindow::setupTableActions()
             this, &MainWindow::showCounterparties);
     
     // Действия для таблицы счетов
-    accountsActions = new TableActions(accountsTable, this);
+    accountsActions = new TableActions(accountsTree, this);
     connect(accountsActions, &TableActions::addRequested,
             this, &MainWindow::addAccount);
     connect(accountsActions, &TableActions::editRequested,
@@ -476,7 +452,6 @@ void MainWindow::addAccount()
 {
     AddEditAccountDialog dialog(this);
     if (dialog.exec() == QDialog::Accepted) {
-        showAccounts();
         statusBar()->showMessage("Счет добавлен", 3000);
     }
 }
@@ -485,16 +460,15 @@ void MainWindow::editAccount(int id)
 {
     AddEditAccountDialog dialog(id, this);
     if (dialog.exec() == QDialog::Accepted) {
-        showAccounts();
         statusBar()->showMessage("Счет обновлен", 3000);
     }
 }
 
 void MainWindow::editTransaction(int id)
 {
+    // Модели обновят строку сами по уведомлению LedgerEvents
     EditTransactionDialog dialog(id, this);
     if (dialog.exec() == QDialog::Accepted) {
-        showTransactions();
         statusBar()->showMessage("Проводка обновлена", 3000);
     }
 }
@@ -517,7 +491,7 @@ void MainWindow::deleteTransaction(int id)
             QMessageBox::critical(this, "Ошибка",
                 "Не удалось удалить проводку:\n" + query.lastError().text());
         } else {
-            showTransactions();
+            LedgerEvents::instance().notifyRemoved(LedgerEvents::Transactions, id);
             statusBar()->showMessage("Проводка удалена", 3000);
         }
     }
@@ -527,7 +501,6 @@ void MainWindow::editCounterparty(int id)
 {
     EditCounterpartyDialog dialog(id, this);
     if (dialog.exec() == QDialog::Accepted) {
-        showCounterparties();
         statusBar()->showMessage("Контрагент обновлен", 3000);
     }
 }
@@ -562,7 +535,7 @@ void MainWindow::deleteCounterparty(int id)
             QMessageBox::critical(this, "Ошибка",
                 "Не удалось удалить контрагента:\n" + query.lastError().text());
         } else {
-            showCounterparties();
+            LedgerEvents::instance().notifyRemoved(LedgerEvents::Counterparties, id);
             statusBar()->showMessage("Контрагент удален", 3000);
         }
     }
@@ -584,7 +557,7 @@ void MainWindow::deleteAccount(int id)
     
     // Проверяем, есть ли дочерние счета
     checkQuery = Database::instance().executeQuery(
-        "SELECT COUNT(*) FROM accounts WHERE parent_id = ?",
+        "SELECT COUNT(*) FROM account_closure WHERE ancestor = ? AND depth = 1",
         {id}
     );
     
@@ -601,16 +574,28 @@ void MainWindow::deleteAccount(int id)
     );
     
     if (reply == QMessageBox::Yes) {
-        QSqlQuery query = Database::instance().executeQuery(
+        // Счет и его строки замыкания удаляются вместе
+        Database &db = Database::instance();
+        db.beginTransaction();
+        
+        QSqlQuery query = db.executeQuery(
             "DELETE FROM accounts WHERE id = ?",
             {id}
         );
         
+        QString error;
         if (query.lastError().isValid()) {
+            error = query.lastError().text();
+        } else if (!AccountTree::removeAccount(id)) {
+            error = "не удалось обновить дерево счетов";
+        }
+        
+        if (!error.isEmpty() || !db.commitTransaction()) {
+            db.rollbackTransaction();
             QMessageBox::critical(this, "Ошибка",
-                "Не удалось удалить счет:\n" + query.lastError().text());
+                "Не удалось удалить счет:\n" + error);
         } else {
-            showAccounts();
+            LedgerEvents::instance().notifyRemoved(LedgerEvents::Accounts, id);
             statusBar()->showMessage("Счет удален", 3000);
         }
     }
@@ -618,11 +603,14 @@ void MainWindow::deleteAccount(int id)
 
 void MainWindow::refreshTable()
 {
-    int currentTab = tabWidget->currentIndex();
-    switch (currentTab) {
-        case 0: showTransactions(); break;
-        case 1: showAccounts(); break;
-        case 2: showCounterparties(); break;
+    // Вкладки определяем по виджету, а не по индексу: порядок вкладок менялся
+    QWidget *current = tabWidget->currentWidget();
+    if (current == transactionsTable->parentWidget()) {
+        showTransactions();
+    } else if (current == accountsTree->parentWidget()) {
+        showAccounts();
+    } else if (current == counterpartiesTable->parentWidget()) {
+        showCounterparties();
     }
 }
 
@@ -651,108 +639,8 @@ void MainWindow::checkDatabaseTables()
 
 void MainWindow::createTablesManually()
 {
-    qDebug() << "=== Создание таблиц ===";
-    
-    // Создаем таблицу контрагентов
-    QString createCounterparties = 
-        "CREATE TABLE IF NOT EXISTS counterparties ("
-        "    id INTEGER PRIMARY KEY AUTOINCREMENT,"
-        "    name TEXT NOT NULL,"
-        "    inn TEXT UNIQUE,"
-        "    kpp TEXT DEFAULT '',"
-        "    address TEXT DEFAULT '',"
-        "    phone TEXT DEFAULT '',"
-        "    email TEXT DEFAULT '',"
-        "    created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP"
-        ")";
-    
-    QSqlQuery query1 = Database::instance().executeQuery(createCounterparties);
-    if (query1.lastError().isValid()) {
-        qCritical() << "Ошибка создания таблицы counterparties:" << query1.lastError().text();
-    } else {
-        qDebug() << "✓ Таблица counterparties проверена/создана";
-    }
-    
-    // Создаем таблицу счетов
-    QString createAccounts = 
-        "CREATE TABLE IF NOT EXISTS accounts ("
-        "    id INTEGER PRIMARY KEY AUTOINCREMENT,"
-        "    code TEXT NOT NULL UNIQUE,"
-        "    name TEXT NOT NULL,"
-        "    type INTEGER NOT NULL,"
-        "    parent_id INTEGER,"
-        "    created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,"
-        "    FOREIGN KEY (parent_id) REFERENCES accounts(id) ON DELETE CASCADE"
-        ")";
-    
-    QSqlQuery query2 = Database::instance().executeQuery(createAccounts);
-    if (query2.lastError().isValid()) {
-        qCritical() << "Ошибка создания таблицы accounts:" << query2.lastError().text();
-    } else {
-        qDebug() << "✓ Таблица accounts проверена/создана";
-        
-        // Вставляем базовые счета, если их нет
-        QString insertAccounts = 
-            "INSERT OR IGNORE INTO accounts (code, name, type) VALUES "
-            "('50', 'Касса', 0),"
-            "('51', 'Расчетные счета', 0),"
-            "('52', 'Валютные счета', 0),"
-            "('60', 'Расчеты с поставщиками и подрядчиками', 2),"
-            "('62', 'Расчеты с покупателями и заказчиками', 2),"
-            "('70', 'Расчеты с персоналом по оплате труда', 2),"
-            "('80', 'Уставный капитал', 1),"
-            "('90', 'Продажи', 1),"
-            "('91', 'Прочие доходы и расходы', 2)";
-        
-        QSqlQuery query3 = Database::instance().executeQuery(insertAccounts);
-        if (query3.lastError().isValid()) {
-            qWarning() << "Ошибка вставки базовых счетов:" << query3.lastError().text();
-        } else {
-            qDebug() << "✓ Базовые счета проверены/добавлены";
-        }
-    }
-    
-    // Создаем таблицу проводок
-    QString createTransactions = 
-        "CREATE TABLE IF NOT EXISTS transactions ("
-        "    id INTEGER PRIMARY KEY AUTOINCREMENT,"
-        "    transaction_date DATE NOT NULL,"
-        "    debit_account_id INTEGER NOT NULL,"
-        "    credit_account_id INTEGER NOT NULL,"
-        "    amount DECIMAL(15,2) NOT NULL,"
-        "    description TEXT,"
-        "    document_number TEXT,"
-        "    document_date DATE,"
-        "    counterparty_id INTEGER,"
-        "    created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,"
-        "    FOREIGN KEY (debit_account_id) REFERENCES accounts(id),"
-        "    FOREIGN KEY (credit_account_id) REFERENCES accounts(id),"
-        "    FOREIGN KEY (counterparty_id) REFERENCES counterparties(id),"
-        "    CHECK (amount > 0)"
-        ")";
-    
-    QSqlQuery query4 = Database::instance().executeQuery(createTransactions);
-    if (query4.lastError().isValid()) {
-        qCritical() << "Ошибка создания таблицы transactions:" << query4.lastError().text();
-    } else {
-        qDebug() << "✓ Таблица transactions проверена/создана";
-    }
-    
-    // Создаем индексы, если не существуют
-    QStringList indexes = {
-        "CREATE INDEX IF NOT EXISTS idx_transactions_date ON transactions(transaction_date)",
-        "CREATE INDEX IF NOT EXISTS idx_transactions_debit ON transactions(debit_account_id)",
-        "CREATE INDEX IF NOT EXISTS idx_transactions_credit ON transactions(credit_account_id)"
-    };
-    
-    for (const QString &index : indexes) {
-        QSqlQuery query = Database::instance().executeQuery(index);
-        if (query.lastError().isValid()) {
-            qWarning() << "Ошибка создания индекса:" << query.lastError().text();
-        }
-    }
-    
-    qDebug() << "=== Все таблицы проверены/созданы ===";
+    // Схема создается в ядре: той же базой пользуется ledgermini-cli
+    Database::instance().ensureSchema();
 }
 
 void MainWindow::onSearchTransactions()
@@ -765,109 +653,22 @@ void MainWindow::onSearchTransactions()
         options = transactionsSearchWidget->getFilterOptions();
     }
     
-    // Строим базовый запрос
-    QString query = 
-        "SELECT t.id, t.transaction_date, "
-        "       d.code || ' - ' || d.name as debit, "
-        "       c.code || ' - ' || c.name as credit, "
-        "       t.amount, t.description, t.document_number, "
-        "       COALESCE(cp.name, '') as counterparty_name "
-        "FROM transactions t "
-        "LEFT JOIN accounts d ON t.debit_account_id = d.id "
-        "LEFT JOIN accounts c ON t.credit_account_id = c.id "
-        "LEFT JOIN counterparties cp ON t.counterparty_id = cp.id "
-        "WHERE 1=1";  // Всегда истинное условие для удобства добавления других
-    
-    // Добавляем фильтр по дате, если включен
-    if (options.dateFilterEnabled) {
-        query += " AND t.transaction_date BETWEEN '" + options.dateFrom.toString("yyyy-MM-dd") + 
-                 "' AND '" + options.dateTo.toString("yyyy-MM-dd") + "'";
-    }
-    
-    // Добавляем фильтр по сумме, если включен
-    if (options.amountFilterEnabled) {
-        query += " AND t.amount BETWEEN " + QString::number(options.amountFrom) +
-                 " AND " + QString::number(options.amountTo);
-    }
-    
-    // Добавляем фильтр по счету дебета, если выбран
-    if (options.debitAccountId != -1) {
-        query += " AND t.debit_account_id = " + QString::number(options.debitAccountId);
-    }
-    
-    // Добавляем фильтр по счету кредита, если выбран
-    if (options.creditAccountId != -1) {
-        query += " AND t.credit_account_id = " + QString::number(options.creditAccountId);
-    }
-    
-    // Добавляем фильтр по контрагенту, если выбран
-    if (options.counterpartyId != -1) {
-        query += " AND t.counterparty_id = " + QString::number(options.counterpartyId);
-    }
-    
-    // Добавляем текстовый фильтр, если есть
-    if (!options.textFilter.isEmpty()) {
-        QString likePattern = "%" + options.textFilter + "%";
-        
-        if (options.fieldFilter.isEmpty() || options.fieldFilter == "all") {
-            // Ищем во всех полях
-            query += " AND ("
-                     "  d.code LIKE '" + likePattern + "' OR "
-                     "  d.name LIKE '" + likePattern + "' OR "
-                     "  c.code LIKE '" + likePattern + "' OR "
-                     "  c.name LIKE '" + likePattern + "' OR "
-                     "  t.description LIKE '" + likePattern + "' OR "
-                     "  t.document_number LIKE '" + likePattern + "' OR "
-                     "  cp.name LIKE '" + likePattern + "'"
-                     ")";
-        } else if (options.fieldFilter == "description") {
-            query += " AND t.description LIKE '" + likePattern + "'";
-        } else if (options.fieldFilter == "comment") {
-            query += " AND (t.description LIKE '" + likePattern + "' OR t.document_number LIKE '" + likePattern + "')";
-        }
-    }
-    
-    query += " ORDER BY t.transaction_date DESC, t.id DESC";
-    
-    // Выполняем запрос
-    QSqlQueryModel *model = new QSqlQueryModel(this);
-    model->setQuery(query);
-    
-    if (model->lastError().isValid()) {
-        qWarning() << "Ошибка выполнения поискового запроса:" << model->lastError().text();
-        delete model;
-        return;
-    }
-    
-    // Устанавливаем заголовки
-    model->setHeaderData(0, Qt::Horizontal, tr("ID"));
-    model->setHeaderData(1, Qt::Horizontal, tr("Дата"));
-    model->setHeaderData(2, Qt::Horizontal, tr("Дебет"));
-    model->setHeaderData(3, Qt::Horizontal, tr("Кредит"));
-    model->setHeaderData(4, Qt::Horizontal, tr("Сумма"));
-    model->setHeaderData(5, Qt::Horizontal, tr("Описание"));
-    model->setHeaderData(6, Qt::Horizontal, tr("Документ"));
-    model->setHeaderData(7, Qt::Horizontal, tr("Контрагент"));
-    
-    // Устанавливаем модель в таблицу
-    QSqlQueryModel *oldModel = qobject_cast<QSqlQueryModel*>(transactionsTable->model());
-    transactionsTable->setModel(model);
-    
-    // Удаляем старую модель
-    if (oldModel) {
-        oldModel->deleteLater();
-    }
-    
-    // Настраиваем отображение
-    transactionsTable->hideColumn(0);  // Скрываем ID
-    transactionsTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+    // Запрос выполняется в фоне, результат придет в onTransactionsPageLoaded.
+    // Незавершенный предыдущий поиск отменяется.
+    transactionsModel->setFilter(options);
+    statusBar()->showMessage(tr("Поиск проводок..."));
+}
+
+void MainWindow::onTransactionsPageLoaded(int loadedRows, bool hasMore)
+{
+    const AdvancedFilterWidget::FilterOptions &options = transactionsModel->filter();
     
-    // Показываем количество найденных записей
-    int rowCount = model->rowCount();
-    QString message = QString("Найдено проводок: %1").arg(rowCount);
+    QString message = hasMore
+        ? tr("Загружено проводок: %1 (прокрутите для загрузки остальных)").arg(loadedRows)
+        : tr("Найдено проводок: %1").arg(loadedRows);
     
     if (!options.textFilter.isEmpty()) {
-        message += QString(" по запросу: \"%1\"").arg(options.textFilter);
+        message += tr(" по запросу: \"%1\"").arg(options.textFilter);
     }
     
     statusBar()->showMessage(message, 5000);
@@ -885,9 +686,35 @@ void MainWindow::exportTransactionsToPdf()
     QString title = "Журнал проводок\n"
                    "Сформировано: " + QDateTime::currentDateTime().toString("dd.MM.yyyy HH:mm");
     
-    if (ExportManager::exportTableToPdf(transactionsTable, title, fileName, this)) {
-        statusBar()->showMessage("Проводки экспортированы в PDF", 3000);
+    QStringList headers;
+    for (int col = TransactionTableModel::DateColumn; col < TransactionTableModel::ColumnCount; ++col) {
+        headers << transactionsModel->headerData(col, Qt::Horizontal).toString();
     }
+    
+    // Все проводки по фильтру, а не только подгруженные в таблицу;
+    // выгрузка идет в фоне, ход виден на панели "Выгрузки"
+    TransactionFilter filter = transactionsModel->filter();
+    ExportJobQueue::instance().enqueue("Проводки в PDF", fileName,
+        [filter, headers, title, fileName](ExportProgress *progress, QString *error) {
+            return ExportManager::exportTransactionsToPdf(filter, headers, title, fileName,
+                                                          error, progress);
+        });
+}
+
+void MainWindow::exportLedgerSnapshot()
+{
+    QString defaultName = QString("Журнал_%1.lmsnap")
+                         .arg(QDate::currentDate().toString("yyyy-MM-dd"));
+    
+    QString fileName = QFileDialog::getSaveFileName(this, "Снимок журнала",
+                                                   defaultName, "Снимок журнала (*.lmsnap)");
+    if (fileName.isEmpty()) return;
+    
+    // Весь журнал одним файлом; пишется в фоне, как выгрузки
+    ExportJobQueue::instance().enqueue("Снимок журнала", fileName,
+        [fileName](ExportProgress *progress, QString *error) {
+            return LedgerSnapshot::write(fileName, error, progress);
+        });
 }
 
 void MainWindow::exportAccountsToPdf()
@@ -902,9 +729,48 @@ void MainWindow::exportAccountsToPdf()
     QString title = "План счетов РСБУ\n"
                    "Сформировано: " + QDateTime::currentDateTime().toString("dd.MM.yyyy HH:mm");
     
-    if (ExportManager::exportTableToPdf(accountsTable, title, fileName, this)) {
-        statusBar()->showMessage("План счетов экспортирован в PDF", 3000);
-    }
+    // В дереве загружены только раскрытые узлы, поэтому для отчета план
+    // читается целиком: отступ и порядок берутся из таблицы замыкания.
+    // Запрос и печать идут в фоновой задаче
+    auto task = [title, fileName](ExportProgress *progress, QString *error) {
+        QSqlQuery query = Database::instance().executeQuery(
+            "SELECT printf('%*s%s', "
+            "              (SELECT MAX(depth) FROM account_closure WHERE descendant = a.id) * 2, "
+            "              '', a.code), "
+            "       a.name, "
+            "       CASE a.type "
+            "         WHEN 0 THEN 'Активный' "
+            "         WHEN 1 THEN 'Пассивный' "
+            "         WHEN 2 THEN 'Активно-пассивный' "
+            "       END, "
+            "       (SELECT COALESCE(SUM(b.debit_total - b.credit_total), 0) "
+            "        FROM account_closure s "
+            "        JOIN account_balances b ON b.account_id = s.descendant "
+            "        WHERE s.ancestor = a.id), "
+            "       (SELECT group_concat(code, '.') FROM ("
+            "          SELECT p.code FROM account_closure c "
+            "          JOIN accounts p ON p.id = c.ancestor "
+            "          WHERE c.descendant = a.id ORDER BY c.depth DESC)) AS sort_key "
+            "FROM accounts a ORDER BY sort_key");
+        if (query.lastError().isValid()) {
+            *error = "Ошибка запроса: " + query.lastError().text();
+            return false;
+        }
+        
+        QVector<QVariantList> data;
+        while (query.next()) {
+            double balance = query.value(3).toDouble();
+            QString balanceText = qFuzzyIsNull(balance)
+                ? QString("0.00")
+                : QString("%1 %2").arg(balance > 0 ? "Д" : "К")
+                                  .arg(QString::number(qAbs(balance), 'f', 2));
+            data.append({query.value(0), query.value(1), query.value(2), balanceText});
+        }
+        
+        QStringList headers = {"Код", "Наименование", "Тип", "Сальдо"};
+        return ExportManager::exportRowsToPdf(data, headers, title, fileName, error, progress);
+    };
+    ExportJobQueue::instance().enqueue("План счетов в PDF", fileName, task);
 }
 
 void MainWindow::exportCounterpartiesToPdf()
@@ -919,7 +785,47 @@ void MainWindow::exportCounterpartiesToPdf()
     QString title = "Справочник контрагентов\n"
                    "Сформировано: " + QDateTime::currentDateTime().toString("dd.MM.yyyy HH:mm");
     
-    if (ExportManager::exportTableToPdf(counterpartiesTable, title, fileName, this)) {
-        statusBar()->showMessage("Контрагенты экспортированы в PDF", 3000);
+    // Справочник печатается как показан: только видимые столбцы
+    QAbstractItemModel *model = counterpartiesTable->model();
+    QVector<int> columns;
+    QStringList headers;
+    for (int col = 0; col < model->columnCount(); ++col) {
+        if (!counterpartiesTable->isColumnHidden(col)) {
+            columns.append(col);
+            headers << model->headerData(col, Qt::Horizontal).toString();
+        }
+    }
+    
+    QVector<QVariantList> data;
+    for (int row = 0; row < model->rowCount(); ++row) {
+        QVariantList values;
+        for (int col : columns) {
+            values << model->index(row, col).data();
+        }
+        data.append(values);
     }
-}
\ No newline at end of file
+    
+    QString error;
+    if (!ExportManager::exportRowsToPdf(data, headers, title, fileName, &error)) {
+        QMessageBox::critical(this, "Ошибка", error);
+        return;
+    }
+    statusBar()->showMessage("Контрагенты экспортированы в PDF", 3000);
+}
+
+void MainWindow::onExportFinished(int id, bool ok)
+{
+    const ExportJobQueue::JobInfo job = ExportJobQueue::instance().job(id);
+    if (ok) {
+        statusBar()->showMessage(tr("Выгрузка завершена: %1").arg(job.fileName), 5000);
+    } else if (job.state == ExportJobQueue::Failed) {
+        statusBar()->showMessage(tr("Ошибка выгрузки \"%1\": %2").arg(job.title, job.error), 5000);
+    }
+}
+
+void MainWindow::onTemplatesExecuted(int templates, qint64 inserted)
+{
+    // Журнал перечитают модели по LedgerEvents::bulkChanged
+    statusBar()->showMessage(tr("По шаблонам (%1) создано проводок: %2")
+                             .arg(templates).arg(inserted), 10000);
+}
@@ -2,6 +2,7 @@
 #include "gui/reportwidget.h"
 #include "core/report_generator.h"
 #include "core/exportmanager.h"
+#include "core/exportjobqueue.h"
 
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -106,10 +107,12 @@ void ReportWidget::updateReport()
     
     // Очищаем таблицу
     model->removeRows(0, model->rowCount());
+    currentReport.clear();
     
     // Получаем данные из ReportGenerator
     ReportGenerator reportGen;
     QVector<BalanceRecord> report = reportGen.generateBalanceReport(startDate, endDate);
+    currentReport = report;
     
     if (report.isEmpty()) {
         QMessageBox::information(this, "Информация", "Нет данных для отображения за выбранный период.");
@@ -145,37 +148,26 @@ void ReportWidget::updateReport()
 
 void ReportWidget::exportToCsv()
 {
-    QString fileName = QFileDialog::getSaveFileName(this, "Экспорт в CSV", "", "CSV Files (*.csv)");
-    if (fileName.isEmpty()) return;
-    
-    QFile file(fileName);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QMessageBox::critical(this, "Ошибка", "Не удалось создать файл: " + file.errorString());
+    if (currentReport.isEmpty()) {
+        QMessageBox::warning(this, "Ошибка", "Сначала сформируйте ведомость.");
         return;
     }
     
-    QTextStream stream(&file);
-    stream.setEncoding(QStringConverter::Utf8);
+    QString fileName = QFileDialog::getSaveFileName(this, "Экспорт в CSV", "",
+                                                    "CSV Files (*.csv);;CSV, сжатый gzip (*.csv.gz)");
+    if (fileName.isEmpty()) return;
     
-    // Заголовки
+    QStringList headers;
     for (int col = 0; col < model->columnCount(); ++col) {
-        stream << "\"" << model->headerData(col, Qt::Horizontal).toString() << "\"";
-        if (col < model->columnCount() - 1) stream << ",";
-    }
-    stream << "\n";
-    
-    // Данные
-    for (int row = 0; row < model->rowCount(); ++row) {
-        for (int col = 0; col < model->columnCount(); ++col) {
-            QString value = model->index(row, col).data().toString();
-            stream << "\"" << value.replace("\"", "\"\"") << "\"";
-            if (col < model->columnCount() - 1) stream << ",";
-        }
-        stream << "\n";
+        headers << model->headerData(col, Qt::Horizontal).toString();
     }
     
-    file.close();
-    QMessageBox::information(this, "Экспорт", "Данные успешно экспортированы в файл.");
+    // Пишем из записей отчета, а не из ячеек таблицы; файл пишется в фоне
+    QVector<BalanceRecord> records = currentReport;
+    ExportJobQueue::instance().enqueue("ОСВ в CSV", fileName,
+        [records, headers, fileName](ExportProgress *, QString *error) {
+            return ExportManager::exportBalanceReportToCsv(records, headers, fileName, error);
+        });
 }
 
 void ReportWidget::exportToPdf()
@@ -211,8 +203,9 @@ void ReportWidget::exportToPdf()
                    .arg(dateStartEdit->date().toString("dd.MM.yyyy"))
                    .arg(dateEndEdit->date().toString("dd.MM.yyyy"));
     
-    if (ExportManager::exportBalanceReportToPdf(data, headers, title, fileName, this)) {
-        QMessageBox::information(this, "Экспорт", 
-                                "Отчет успешно экспортирован в PDF!");
-    }
+    // Строки сняты с модели здесь, в фоне только печать
+    ExportJobQueue::instance().enqueue("ОСВ в PDF", fileName,
+        [data, headers, title, fileName](ExportProgress *progress, QString *error) {
+            return ExportManager::exportRowsToPdf(data, headers, title, fileName, error, progress);
+        });
 }
@@ -0,0 +1,233 @@
+#include "gui/sqlrowmodel.h"
+#include "core/database.h"
+
+#include <QSqlRecord>
+#include <QSet>
+#include <QStringList>
+#include <QDebug>
+
+#include <algorithm>
+
+SqlRowModel::SqlRowModel(LedgerEvents::Table table, const QString &selectSql,
+                         const QString &rowsSql, int sortColumn, QObject *parent)
+    : QAbstractTableModel(parent)
+    , table_(table)
+    , selectSql_(selectSql)
+    , rowsSql_(rowsSql)
+    , sortColumn_(sortColumn)
+{
+    LedgerEvents &events = LedgerEvents::instance();
+    connect(&events, &LedgerEvents::rowInserted, this, &SqlRowModel::onRowInserted);
+    connect(&events, &LedgerEvents::rowUpdated, this, &SqlRowModel::onRowUpdated);
+    connect(&events, &LedgerEvents::rowRemoved, this, &SqlRowModel::onRowRemoved);
+    connect(&events, &LedgerEvents::bulkChanged, this, &SqlRowModel::onBulkChanged);
+}
+
+bool SqlRowModel::select()
+{
+    QSqlQuery query = Database::instance().executeQuery(selectSql_);
+    if (query.lastError().isValid()) {
+        qWarning() << "Failed to load rows:" << query.lastError().text();
+        return false;
+    }
+
+    QVector<Row> rows;
+    int columns = query.record().count();
+    while (query.next()) {
+        Row row(columns);
+        for (int col = 0; col < columns; ++col) {
+            row[col] = query.value(col);
+        }
+        rows.append(row);
+    }
+
+    beginResetModel();
+    rows_ = rows;
+    columnCount_ = columns;
+    endResetModel();
+    return true;
+}
+
+void SqlRowModel::refreshRows(const QVector<qint64> &ids)
+{
+    if (ids.isEmpty()) return;
+
+    QStringList placeholders;
+    QVariantList params;
+    for (qint64 id : ids) {
+        placeholders << "?";
+        params << id;
+    }
+
+    // Параметры id подставляются столько раз, сколько %1 в запросе
+    QString sql = rowsSql_;
+    QVariantList allParams;
+    int uses = sql.count("%1");
+    for (int i = 0; i < uses; ++i) {
+        allParams += params;
+    }
+    sql.replace("%1", placeholders.join(","));
+
+    QSqlQuery query = Database::instance().executeQuery(sql, allParams);
+    if (query.lastError().isValid()) {
+        qWarning() << "Failed to refresh rows:" << query.lastError().text();
+        return;
+    }
+
+    QSet<qint64> seen;
+    int columns = query.record().count();
+    if (columnCount_ == 0) {
+        beginResetModel();
+        columnCount_ = columns;
+        endResetModel();
+    }
+
+    while (query.next()) {
+        Row value(columns);
+        for (int col = 0; col < columns; ++col) {
+            value[col] = query.value(col);
+        }
+
+        qint64 id = value.at(0).toLongLong();
+        seen.insert(id);
+
+        int current = rowOf(id);
+        if (current >= 0) {
+            bool inPlace = (current == 0 || !comesBefore(value, rows_.at(current - 1)))
+                           && (current == rows_.size() - 1 || !comesBefore(rows_.at(current + 1), value));
+            if (inPlace) {
+                rows_[current] = value;
+                emit dataChanged(index(current, 0), index(current, columnCount_ - 1));
+                continue;
+            }
+            removeRowAt(current);
+        }
+
+        insertRowAt(insertPosition(value), value);
+    }
+
+    // Запрошенные строки, которых больше нет в базе
+    for (qint64 id : ids) {
+        if (seen.contains(id)) continue;
+
+        int current = rowOf(id);
+        if (current >= 0) {
+            removeRowAt(current);
+        }
+    }
+}
+
+int SqlRowModel::rowOf(qint64 id) const
+{
+    for (int i = 0; i < rows_.size(); ++i) {
+        if (rows_.at(i).at(0).toLongLong() == id) return i;
+    }
+    return -1;
+}
+
+qint64 SqlRowModel::idAt(int row) const
+{
+    return rows_.at(row).at(0).toLongLong();
+}
+
+QVariant SqlRowModel::valueAt(int row, int column) const
+{
+    return rows_.at(row).value(column);
+}
+
+int SqlRowModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : rows_.size();
+}
+
+int SqlRowModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : columnCount_;
+}
+
+QVariant SqlRowModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= rows_.size()) return QVariant();
+
+    if (role == Qt::DisplayRole || role == Qt::EditRole) {
+        return rows_.at(index.row()).value(index.column());
+    }
+    return QVariant();
+}
+
+QVariant SqlRowModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation == Qt::Horizontal && role == Qt::DisplayRole && headers_.contains(section)) {
+        return headers_.value(section);
+    }
+    return QAbstractTableModel::headerData(section, orientation, role);
+}
+
+bool SqlRowModel::setHeaderData(int section, Qt::Orientation orientation, const QVariant &value,
+                                int role)
+{
+    if (orientation != Qt::Horizontal || (role != Qt::DisplayRole && role != Qt::EditRole)) {
+        return false;
+    }
+
+    headers_[section] = value;
+    emit headerDataChanged(orientation, section, section);
+    return true;
+}
+
+void SqlRowModel::onRowInserted(LedgerEvents::Table table, qint64 id)
+{
+    if (table == table_) refreshRows({id});
+}
+
+void SqlRowModel::onRowUpdated(LedgerEvents::Table table, qint64 id)
+{
+    if (table == table_) refreshRows({id});
+}
+
+void SqlRowModel::onRowRemoved(LedgerEvents::Table table, qint64 id)
+{
+    if (table != table_) return;
+
+    int row = rowOf(id);
+    if (row >= 0) {
+        removeRowAt(row);
+    }
+}
+
+void SqlRowModel::onBulkChanged(LedgerEvents::Table table)
+{
+    if (table == table_) select();
+}
+
+bool SqlRowModel::comesBefore(const Row &a, const Row &b) const
+{
+    const QVariant &left = a.at(sortColumn_);
+    const QVariant &right = b.at(sortColumn_);
+
+    QPartialOrdering order = QVariant::compare(left, right);
+    if (order == QPartialOrdering::Less) return true;
+    if (order == QPartialOrdering::Greater) return false;
+    return a.at(0).toLongLong() < b.at(0).toLongLong();
+}
+
+int SqlRowModel::insertPosition(const Row &row) const
+{
+    auto it = std::lower_bound(rows_.cbegin(), rows_.cend(), row,
+                               [this](const Row &a, const Row &b) { return comesBefore(a, b); });
+    return int(it - rows_.cbegin());
+}
+
+void SqlRowModel::removeRowAt(int row)
+{
+    beginRemoveRows(QModelIndex(), row, row);
+    rows_.removeAt(row);
+    endRemoveRows();
+}
+
+void SqlRowModel::insertRowAt(int row, const Row &value)
+{
+    beginInsertRows(QModelIndex(), row, row);
+    rows_.insert(row, value);
+    endInsertRows();
+}
@@ -5,7 +5,7 @@
 #include <QAction>
 #include <QKeySequence>
 
-TableActions::TableActions(QTableView *tableView, QObject *parent)
+TableActions::TableActions(QAbstractItemView *tableView, QObject *parent)
     : QObject(parent), tableView_(tableView)
 {
     setupContextMenu();
@@ -14,7 +14,7 @@ TableActions::TableActions(QTableView *tableView, QObject *parent)
 void TableActions::setupContextMenu()
 {
     tableView_->setContextMenuPolicy(Qt::CustomContextMenu);
-    connect(tableView_, &QTableView::customContextMenuRequested,
+    connect(tableView_, &QAbstractItemView::customContextMenuRequested,
             this, &TableActions::onContextMenu);
     
     contextMenu_ = new QMenu(tableView_);
@@ -53,8 +53,12 @@ int TableActions::getSelectedId() const
     QModelIndex index = tableView_->currentIndex();
     if (!index.isValid()) return -1;
     
+    QModelIndex idIndex = index.siblingAtColumn(0);
+    QVariant id = idIndex.data(Qt::UserRole);
+    if (id.isValid()) return id.toInt();
+    
     // ID обычно в скрытой первой колонке
-    return tableView_->model()->index(index.row(), 0).data().toInt();
+    return idIndex.data().toInt();
 }
 
 void TableActions::onAddAction()
@@ -0,0 +1,61 @@
+#include "gui/totalsfooterwidget.h"
+#include "gui/transactiontablemodel.h"
+
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QLocale>
+
+TotalsFooterWidget::TotalsFooterWidget(QWidget *parent)
+    : QWidget(parent)
+    , countLabel(new QLabel(this))
+    , sumLabel(new QLabel(this))
+    , minLabel(new QLabel(this))
+    , maxLabel(new QLabel(this))
+{
+    QHBoxLayout *layout = new QHBoxLayout(this);
+    layout->setContentsMargins(4, 2, 4, 2);
+    layout->addWidget(countLabel);
+    layout->addSpacing(16);
+    layout->addWidget(sumLabel);
+    layout->addSpacing(16);
+    layout->addWidget(minLabel);
+    layout->addSpacing(16);
+    layout->addWidget(maxLabel);
+    layout->addStretch();
+
+    setStyleSheet("QLabel { font-weight: bold; }");
+    setLoading();
+}
+
+void TotalsFooterWidget::setModel(TransactionTableModel *model)
+{
+    connect(model, &TransactionTableModel::totalsChanged, this, &TotalsFooterWidget::setTotals);
+    connect(model, &TransactionTableModel::searchStarted, this, &TotalsFooterWidget::setLoading);
+
+    if (model->hasTotals()) {
+        setTotals(model->totals());
+    }
+}
+
+void TotalsFooterWidget::setTotals(const TransactionTotals &totals)
+{
+    QLocale locale;
+    countLabel->setText(tr("Проводок: %1").arg(locale.toString(totals.count)));
+    sumLabel->setText(tr("Сумма: %1").arg(locale.toString(totals.sum, 'f', 2)));
+
+    if (totals.count > 0) {
+        minLabel->setText(tr("Мин.: %1").arg(locale.toString(totals.minAmount, 'f', 2)));
+        maxLabel->setText(tr("Макс.: %1").arg(locale.toString(totals.maxAmount, 'f', 2)));
+    } else {
+        minLabel->setText(tr("Мин.: -"));
+        maxLabel->setText(tr("Макс.: -"));
+    }
+}
+
+void TotalsFooterWidget::setLoading()
+{
+    countLabel->setText(tr("Проводок: ..."));
+    sumLabel->setText(tr("Сумма: ..."));
+    minLabel->setText(tr("Мин.: ..."));
+    maxLabel->setText(tr("Макс.: ..."));
+}
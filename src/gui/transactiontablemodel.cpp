@@ -0,0 +1,290 @@
+#include "gui/transactiontablemodel.h"
+#include "core/transactionsearch.h"
+
+#include <QHash>
+#include <algorithm>
+#include <functional>
+
+namespace {
+
+// Порядок списка: дата по убыванию, затем id по убыванию
+bool comesBefore(const TransactionRow &a, const TransactionRow &b)
+{
+    if (a.date != b.date) return a.date > b.date;
+    return a.id > b.id;
+}
+
+}
+
+TransactionTableModel::TransactionTableModel(QObject *parent)
+    : QAbstractTableModel(parent)
+    , search_(new TransactionSearch(this))
+{
+    connect(search_, &TransactionSearch::pageReady,
+            this, &TransactionTableModel::onPageReady);
+    connect(search_, &TransactionSearch::totalsReady,
+            this, &TransactionTableModel::onTotalsReady);
+
+    LedgerEvents &events = LedgerEvents::instance();
+    connect(&events, &LedgerEvents::rowInserted, this, &TransactionTableModel::onRowInserted);
+    connect(&events, &LedgerEvents::rowUpdated, this, &TransactionTableModel::onRowUpdated);
+    connect(&events, &LedgerEvents::rowRemoved, this, &TransactionTableModel::onRowRemoved);
+    connect(&events, &LedgerEvents::bulkChanged, this, &TransactionTableModel::onBulkChanged);
+}
+
+void TransactionTableModel::setFilter(const TransactionFilter &filter)
+{
+    filter_ = filter;
+    startSearch(0);
+}
+
+void TransactionTableModel::refresh()
+{
+    // Тот же фильтр: перечитываются все догруженные строки, а не только
+    // первая страница, чтобы прокрутка не теряла строки после изменения
+    startSearch(rows_.size());
+}
+
+void TransactionTableModel::startSearch(int keepRows)
+{
+    // Старые строки остаются на экране, пока не придет первая страница нового поиска
+    replacePending_ = true;
+    hasTotals_ = false;
+    search_->start(filter_, keepRows);
+    emit searchStarted();
+}
+
+bool TransactionTableModel::isLoading() const
+{
+    return search_->isRunning();
+}
+
+int TransactionTableModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : rows_.size();
+}
+
+int TransactionTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant TransactionTableModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= rows_.size()) return QVariant();
+
+    const TransactionRow &row = rows_.at(index.row());
+
+    if (role == Qt::DisplayRole) {
+        switch (index.column()) {
+            case IdColumn: return row.id;
+            case DateColumn: return row.date;
+            case DebitColumn: return row.debit;
+            case CreditColumn: return row.credit;
+            case AmountColumn: return row.amount;
+            case DescriptionColumn: return row.description;
+            case DocumentColumn: return row.documentNumber;
+            case CounterpartyColumn: return row.counterparty;
+        }
+    } else if (role == Qt::TextAlignmentRole && index.column() == AmountColumn) {
+        return int(Qt::AlignRight | Qt::AlignVCenter);
+    }
+
+    return QVariant();
+}
+
+QVariant TransactionTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+
+    switch (section) {
+        case IdColumn: return tr("ID");
+        case DateColumn: return tr("Дата");
+        case DebitColumn: return tr("Дебет");
+        case CreditColumn: return tr("Кредит");
+        case AmountColumn: return tr("Сумма");
+        case DescriptionColumn: return tr("Описание");
+        case DocumentColumn: return tr("Документ");
+        case CounterpartyColumn: return tr("Контрагент");
+    }
+    return QVariant();
+}
+
+bool TransactionTableModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && search_->hasMore() && !search_->isRunning();
+}
+
+void TransactionTableModel::fetchMore(const QModelIndex &parent)
+{
+    if (parent.isValid()) return;
+    search_->fetchMore();
+}
+
+void TransactionTableModel::onPageReady(quint64 generation, const QVector<TransactionRow> &rows,
+                                        bool hasMore)
+{
+    Q_UNUSED(generation);
+
+    if (replacePending_) {
+        // Первая страница нового поиска заменяет прежний результат целиком
+        replacePending_ = false;
+        beginResetModel();
+        rows_ = rows;
+        endResetModel();
+    } else if (!rows.isEmpty()) {
+        beginInsertRows(QModelIndex(), rows_.size(), rows_.size() + rows.size() - 1);
+        rows_ += rows;
+        endInsertRows();
+    }
+
+    emit pageLoaded(rows_.size(), hasMore);
+}
+
+void TransactionTableModel::onTotalsReady(quint64 generation, const TransactionTotals &totals)
+{
+    Q_UNUSED(generation);
+
+    totals_ = totals;
+    hasTotals_ = true;
+    emit totalsChanged(totals_);
+}
+
+void TransactionTableModel::onRowInserted(LedgerEvents::Table table, qint64 id)
+{
+    // Новый счет или контрагент без проводок список не меняет
+    if (table != LedgerEvents::Transactions) return;
+
+    reloadRows({id});
+    search_->refreshTotals();
+}
+
+void TransactionTableModel::onRowUpdated(LedgerEvents::Table table, qint64 id)
+{
+    if (table == LedgerEvents::Transactions) {
+        reloadRows({id});
+    } else {
+        // Изменились наименования счета или контрагента - перечитываем
+        // только загруженные строки, которые на него ссылаются
+        QVector<qint64> ids;
+        for (const TransactionRow &row : rows_) {
+            bool affected = table == LedgerEvents::Accounts
+                ? (row.debitAccountId == id || row.creditAccountId == id)
+                : row.counterpartyId == id;
+            if (affected) ids.append(row.id);
+        }
+        reloadRows(ids);
+    }
+
+    search_->refreshTotals();
+}
+
+void TransactionTableModel::onRowRemoved(LedgerEvents::Table table, qint64 id)
+{
+    // Счета и контрагентов с проводками удалить нельзя
+    if (table != LedgerEvents::Transactions) return;
+
+    int row = rowOf(id);
+    if (row >= 0) {
+        removeRowAt(row);
+    }
+    search_->refreshTotals();
+}
+
+void TransactionTableModel::onBulkChanged(LedgerEvents::Table table)
+{
+    Q_UNUSED(table);
+    refresh();
+}
+
+int TransactionTableModel::rowOf(qint64 id) const
+{
+    for (int i = 0; i < rows_.size(); ++i) {
+        if (rows_.at(i).id == id) return i;
+    }
+    return -1;
+}
+
+int TransactionTableModel::insertPosition(const TransactionRow &row) const
+{
+    auto it = std::lower_bound(rows_.cbegin(), rows_.cend(), row, comesBefore);
+    return int(it - rows_.cbegin());
+}
+
+void TransactionTableModel::reloadRows(const QVector<qint64> &ids)
+{
+    if (ids.isEmpty()) return;
+
+    // Перечитываем только затронутые строки с тем же фильтром:
+    // строка могла перестать подходить под него или сменить позицию
+    QHash<qint64, TransactionRow> fresh;
+    for (int from = 0; from < ids.size(); from += TransactionQuery::MaxIdsPerQuery) {
+        QSqlQuery query = search_->query().fetchMatching(ids.mid(from, TransactionQuery::MaxIdsPerQuery));
+        while (query.next()) {
+            TransactionRow row = TransactionQuery::readRow(query);
+            fresh.insert(row.id, row);
+        }
+    }
+
+    QHash<qint64, int> positions;
+    positions.reserve(rows_.size());
+    for (int i = 0; i < rows_.size(); ++i) {
+        positions.insert(rows_.at(i).id, i);
+    }
+
+    // Сначала замены на месте, затем удаления с конца (номера строк выше
+    // удаляемой не сдвигаются) и вставки сместившихся строк
+    QVector<int> removed;
+    QVector<TransactionRow> moved;
+    for (qint64 id : ids) {
+        int current = positions.value(id, -1);
+        auto found = fresh.constFind(id);
+
+        if (found == fresh.constEnd()) {
+            if (current >= 0) removed.append(current);
+            continue;
+        }
+
+        const TransactionRow &value = found.value();
+        if (current >= 0) {
+            bool inPlace = (current == 0 || comesBefore(rows_.at(current - 1), value))
+                           && (current == rows_.size() - 1 || comesBefore(value, rows_.at(current + 1)));
+            if (inPlace) {
+                rows_[current] = value;
+                emit dataChanged(index(current, 0), index(current, ColumnCount - 1));
+                continue;
+            }
+            removed.append(current);
+        }
+        moved.append(value);
+    }
+
+    std::sort(removed.begin(), removed.end(), std::greater<int>());
+    for (int row : removed) {
+        removeRowAt(row);
+    }
+
+    for (const TransactionRow &value : moved) {
+        // Строка за концом загруженной части придет со следующими страницами
+        int position = insertPosition(value);
+        if (position == rows_.size() && search_->hasMore()) continue;
+
+        insertRowAt(position, value);
+    }
+}
+
+void TransactionTableModel::removeRowAt(int row)
+{
+    beginRemoveRows(QModelIndex(), row, row);
+    rows_.removeAt(row);
+    endRemoveRows();
+}
+
+void TransactionTableModel::insertRowAt(int row, const TransactionRow &value)
+{
+    beginInsertRows(QModelIndex(), row, row);
+    rows_.insert(row, value);
+    endInsertRows();
+}
@@ -0,0 +1,230 @@
+#include "corebenchmark.h"
+#include "core/accountcard.h"
+#include "core/database.h"
+#include "core/exportmanager.h"
+#include "core/report_generator.h"
+#include "core/reportcache.h"
+#include "core/transactionquery.h"
+#include "core/transactionsearch.h"
+
+#include <QSqlQuery>
+#include <QTest>
+
+Q_DECLARE_METATYPE(TransactionFilter)
+
+namespace {
+
+int singleInt(const QString &sql)
+{
+    QSqlQuery query = Database::instance().executeQuery(sql);
+    return query.next() ? query.value(0).toInt() : -1;
+}
+
+// Журнал за последний месяц базы: выгрузки меряются на объеме,
+// который реально выгружают, а не на всей базе
+TransactionFilter lastMonth(const QDate &lastDate)
+{
+    TransactionFilter filter;
+    filter.dateFilterEnabled = true;
+    filter.dateFrom = lastDate.addMonths(-1).addDays(1);
+    filter.dateTo = lastDate;
+    return filter;
+}
+
+}
+
+void CoreBenchmark::initTestCase()
+{
+    QVERIFY(Database::instance().isInitialized());
+    QVERIFY(outputDir_.isValid());
+    ReportCache::instance().setEnabled(false);
+
+    QSqlQuery last = Database::instance().executeQuery("SELECT MAX(transaction_date) FROM transactions");
+    QVERIFY(last.next());
+    lastDate_ = last.value(0).toDate();
+    QVERIFY2(lastDate_.isValid(), "в базе нет проводок");
+
+    busiestAccountId_ = singleInt(
+        "SELECT debit_account_id FROM transactions "
+        "GROUP BY debit_account_id ORDER BY COUNT(*) DESC LIMIT 1");
+    subtreeAccountId_ = singleInt(
+        "SELECT parent_id FROM accounts WHERE parent_id IS NOT NULL "
+        "GROUP BY parent_id ORDER BY COUNT(*) DESC LIMIT 1");
+    counterpartyId_ = singleInt(
+        "SELECT counterparty_id FROM transactions WHERE counterparty_id IS NOT NULL "
+        "GROUP BY counterparty_id ORDER BY COUNT(*) DESC LIMIT 1");
+    QVERIFY(busiestAccountId_ > 0);
+}
+
+void CoreBenchmark::balanceReport_data()
+{
+    QTest::addColumn<QDate>("from");
+
+    QTest::newRow("month") << lastDate_.addMonths(-1).addDays(1);
+    QTest::newRow("year") << lastDate_.addYears(-1).addDays(1);
+}
+
+void CoreBenchmark::balanceReport()
+{
+    QFETCH(QDate, from);
+
+    ReportGenerator generator;
+    QVector<BalanceRecord> records;
+    QBENCHMARK {
+        records = generator.generateBalanceReport(from, lastDate_);
+    }
+    QVERIFY(!records.isEmpty());
+}
+
+void CoreBenchmark::accountBalance()
+{
+    ReportGenerator generator;
+    double balance = 0.0;
+    QBENCHMARK {
+        balance = generator.calculateAccountBalance(busiestAccountId_, lastDate_);
+    }
+    Q_UNUSED(balance);
+}
+
+void CoreBenchmark::accountCard_data()
+{
+    QTest::addColumn<bool>("subaccounts");
+
+    QTest::newRow("leaf") << false;
+    QTest::newRow("subtree") << true;
+}
+
+void CoreBenchmark::accountCard()
+{
+    QFETCH(bool, subaccounts);
+
+    AccountCardParams params;
+    params.accountId = subaccounts && subtreeAccountId_ > 0 ? subtreeAccountId_ : busiestAccountId_;
+    params.includeSubaccounts = subaccounts;
+    params.dateFrom = lastDate_.addMonths(-3).addDays(1);
+    params.dateTo = lastDate_;
+
+    AccountCardQuery card(params);
+    qint64 rows = 0;
+    QBENCHMARK {
+        rows = 0;
+        QSqlQuery query = card.execute();
+        while (query.next()) {
+            AccountCardQuery::readRow(query);
+            ++rows;
+        }
+    }
+    QVERIFY(rows > 0);
+}
+
+void CoreBenchmark::accountCardPage()
+{
+    // Первая страница окна карточки: итоги и 500 строк с начала периода
+    AccountCardParams params;
+    params.accountId = busiestAccountId_;
+    params.dateFrom = lastDate_.addYears(-1).addDays(1);
+    params.dateTo = lastDate_;
+
+    AccountCardQuery card(params);
+    QVector<AccountCardEntry> entries;
+    QBENCHMARK {
+        AccountCardSummary summary;
+        QVERIFY(card.fetchSummary(&summary));
+        entries = card.fetchEntries(0, TransactionSearch::PageSize, summary.opening);
+    }
+    QVERIFY(!entries.isEmpty());
+}
+
+void CoreBenchmark::transactionSearch_data()
+{
+    QTest::addColumn<TransactionFilter>("filter");
+
+    TransactionFilter text;
+    text.textFilter = "зарплат";
+    QTest::newRow("text") << text;
+
+    TransactionFilter subtree;
+    subtree.debitAccountId = subtreeAccountId_;
+    subtree.includeSubaccounts = true;
+    QTest::newRow("debit subtree") << subtree;
+
+    TransactionFilter amount;
+    amount.amountFilterEnabled = true;
+    amount.amountFrom = 100000;
+    amount.amountTo = 200000;
+    QTest::newRow("amount range") << amount;
+
+    TransactionFilter counterparty;
+    counterparty.counterpartyId = counterpartyId_;
+    QTest::newRow("counterparty") << counterparty;
+}
+
+void CoreBenchmark::transactionSearch()
+{
+    QFETCH(TransactionFilter, filter);
+
+    // То же, что делает рабочий поток TransactionSearch для первой
+    // страницы и итогов, но синхронно: без затрат на планирование потоков
+    TransactionQuery query(filter);
+    TransactionTotals totals;
+    QBENCHMARK {
+        QSqlQuery page = query.fetchPage(nullptr, TransactionSearch::FirstPageSize);
+        while (page.next()) {
+            TransactionQuery::readRow(page);
+        }
+        QVERIFY(query.fetchTotals(&totals));
+    }
+}
+
+void CoreBenchmark::exportCsv()
+{
+    const TransactionFilter filter = lastMonth(lastDate_);
+    const QString fileName = outputDir_.filePath("journal.csv");
+    QBENCHMARK {
+        QString error;
+        QVERIFY2(ExportManager::exportTransactionsToCsv(filter, ExportManager::journalHeaders(), fileName, &error),
+                 qPrintable(error));
+    }
+}
+
+void CoreBenchmark::exportPdf()
+{
+    const TransactionFilter filter = lastMonth(lastDate_);
+    const QString fileName = outputDir_.filePath("journal.pdf");
+    QBENCHMARK {
+        QString error;
+        QVERIFY2(ExportManager::exportTransactionsToPdf(filter, ExportManager::journalHeaders(), "Журнал проводок",
+                                                        fileName, &error),
+                 qPrintable(error));
+    }
+}
+
+void CoreBenchmark::executeQuery_data()
+{
+    QTest::addColumn<bool>("throughDatabase");
+
+    // Разница двух строк - цена Database::executeQuery поверх QSqlQuery
+    QTest::newRow("executeQuery") << true;
+    QTest::newRow("prepared QSqlQuery") << false;
+}
+
+void CoreBenchmark::executeQuery()
+{
+    QFETCH(bool, throughDatabase);
+
+    const QString sql = "SELECT name FROM accounts WHERE id = ?";
+    if (throughDatabase) {
+        QBENCHMARK {
+            QSqlQuery query = Database::instance().executeQuery(sql, {busiestAccountId_});
+            QVERIFY(query.next());
+        }
+    } else {
+        QSqlQuery query(Database::instance().threadDatabase());
+        QVERIFY(query.prepare(sql));
+        QBENCHMARK {
+            query.bindValue(0, busiestAccountId_);
+            QVERIFY(query.exec());
+            QVERIFY(query.next());
+        }
+    }
+}
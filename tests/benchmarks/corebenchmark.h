@@ -0,0 +1,39 @@
+#ifndef COREBENCHMARK_H
+#define COREBENCHMARK_H
+
+#include <QDate>
+#include <QObject>
+#include <QTemporaryDir>
+
+// Замеры горячих путей ядра на одной базе (QBENCHMARK). База открыта
+// и заполнена до запуска (см. main.cpp); кэш отчетов выключен, чтобы
+// мерить сами запросы, а не чтение готового результата с диска.
+class CoreBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void balanceReport_data();
+    void balanceReport();
+    void accountBalance();
+    void accountCard_data();
+    void accountCard();
+    void accountCardPage();
+    void transactionSearch_data();
+    void transactionSearch();
+    void exportCsv();
+    void exportPdf();
+    void executeQuery_data();
+    void executeQuery();
+
+private:
+    QDate lastDate_;
+    int busiestAccountId_ = -1;     // лист с наибольшим числом проводок
+    int subtreeAccountId_ = -1;     // счет плана с подсчетами
+    int counterpartyId_ = -1;
+    QTemporaryDir outputDir_;
+};
+
+#endif // COREBENCHMARK_H
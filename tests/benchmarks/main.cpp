@@ -0,0 +1,284 @@
+#include "corebenchmark.h"
+#include "core/database.h"
+#include "core/ledgergenerator.h"
+
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QGuiApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLoggingCategory>
+#include <QProcess>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QXmlStreamReader>
+#include <cstdio>
+
+// ledgermini-bench: CoreBenchmark на базах нескольких размеров.
+// Database - одиночка на процесс, поэтому каждый размер замеряется в
+// дочернем процессе (--child) со своей базой. Базы создаются
+// LedgerGenerator::generateFile с фиксированным периодом и seed в
+// отдельном дочернем процессе (--generate) и остаются в --work-dir.
+// В имени - отпечаток генератора и параметров: повторный запуск и запуск
+// другой версии меряют на той же базе, а после изменения генератора
+// база создается заново.
+// Итог - JSON со всеми замерами (--out), для сравнения версий.
+//
+//   ledgermini-bench --sizes 10000,100000,1000000 --out bench.json
+//   ledgermini-bench --sizes 100000 -- balanceReport exportCsv
+
+namespace {
+
+const int ResultFormat = 1;
+
+// Размер справочников растет вместе с журналом, период фиксирован:
+// одинаковые аргументы - одинаковая база в любой день
+LedgerGenerator::Options ledgerOptions(qint64 postings, quint32 seed)
+{
+    LedgerGenerator::Options options;
+    options.postings = postings;
+    options.accounts = int(qMin<qint64>(200 + postings / 5000, 5000));
+    options.counterparties = int(qMin<qint64>(1000 + postings / 100, 100000));
+    options.seed = seed;
+    options.from = QDate(2023, 1, 1);
+    options.to = QDate(2025, 12, 31);
+    return options;
+}
+
+QString databasePath(const QString &workDir, qint64 postings, quint32 seed)
+{
+    return QDir(workDir).filePath(QString("ledger-%1-seed%2-%3.db").arg(postings).arg(seed)
+                                  .arg(LedgerGenerator::fingerprint(ledgerOptions(postings, seed))));
+}
+
+// Дочерний процесс --generate: база --db целиком (LedgerGenerator::generateFile)
+int runGenerate(const QCommandLineParser &parser)
+{
+    const qint64 postings = parser.value("postings").toLongLong();
+    const quint32 seed = parser.value("seed").toUInt();
+    const QString dbPath = parser.value("db");
+
+    std::fprintf(stderr, "Генерация базы: %lld проводок...\n", static_cast<long long>(postings));
+    LedgerGenerator::Result result;
+    QString error;
+    if (!LedgerGenerator::generateFile(dbPath, ledgerOptions(postings, seed), &result, &error)) {
+        std::fprintf(stderr, "Ошибка генерации: %s\n", qPrintable(error));
+        return 1;
+    }
+    return 0;
+}
+
+// Готовая база размера: есть - как есть, нет - генерация в дочернем процессе
+bool ensureDatabase(const QString &dbPath, qint64 postings, quint32 seed, bool verbose)
+{
+    if (QFile::exists(dbPath)) return true;
+
+    QStringList args = {"--child", "--generate",
+                        "--postings", QString::number(postings),
+                        "--seed", QString::number(seed),
+                        "--db", dbPath};
+    if (verbose) args << "--verbose";
+
+    QProcess child;
+    child.setProcessChannelMode(QProcess::ForwardedChannels);
+    child.start(QCoreApplication::applicationFilePath(), args);
+    return child.waitForFinished(-1) && child.exitStatus() == QProcess::NormalExit
+           && child.exitCode() == 0;
+}
+
+int runChild(const QCommandLineParser &parser, const QStringList &testArgs)
+{
+    if (parser.isSet("generate")) return runGenerate(parser);
+
+    const QString dbPath = parser.value("db");
+    if (!QFile::exists(dbPath) || !Database::instance().initialize(dbPath.toStdString())) {
+        std::fprintf(stderr, "Не удалось открыть базу %s\n", qPrintable(dbPath));
+        return 1;
+    }
+    Database::instance().ensureSchema();
+
+    // Протокол QTest - в XML для сборки JSON и текстом в консоль
+    QStringList args = {QCoreApplication::applicationFilePath(),
+                        "-o", parser.value("xml") + ",xml",
+                        "-o", "-,txt"};
+    args << testArgs;
+
+    CoreBenchmark benchmark;
+    return QTest::qExec(&benchmark, args);
+}
+
+// Замеры и сбои одного размера из XML-протокола QTest
+void readResults(const QString &xmlPath, qint64 postings, QJsonArray *results, QJsonArray *failures)
+{
+    QFile file(xmlPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        QJsonObject failure;
+        failure["postings"] = postings;
+        failure["message"] = "нет протокола " + xmlPath;
+        failures->append(failure);
+        return;
+    }
+
+    QXmlStreamReader xml(&file);
+    QString function;
+    while (!xml.atEnd()) {
+        if (!xml.readNextStartElement()) continue;
+
+        const QXmlStreamAttributes attributes = xml.attributes();
+        if (xml.name() == QLatin1String("TestFunction")) {
+            function = attributes.value("name").toString();
+        } else if (xml.name() == QLatin1String("BenchmarkResult")) {
+            QJsonObject result;
+            result["postings"] = postings;
+            result["function"] = function;
+            result["tag"] = attributes.value("tag").toString();
+            result["metric"] = attributes.value("metric").toString();
+            result["value"] = attributes.value("value").toDouble();
+            result["iterations"] = attributes.value("iterations").toInt();
+            results->append(result);
+        } else if (xml.name() == QLatin1String("Incident")) {
+            const QString type = attributes.value("type").toString();
+            if (type != "fail" && type != "xpass") continue;
+
+            QJsonObject failure;
+            failure["postings"] = postings;
+            failure["function"] = function;
+            while (xml.readNextStartElement()) {
+                if (xml.name() == QLatin1String("DataTag")) failure["tag"] = xml.readElementText();
+                else if (xml.name() == QLatin1String("Description")) failure["message"] = xml.readElementText();
+                else xml.skipCurrentElement();
+            }
+            failures->append(failure);
+        }
+    }
+}
+
+int runParent(const QCommandLineParser &parser, const QStringList &testArgs)
+{
+    const quint32 seed = parser.value("seed").toUInt();
+    const QString workDir = parser.value("work-dir");
+    if (!QDir().mkpath(workDir)) {
+        std::fprintf(stderr, "Не удалось создать каталог %s\n", qPrintable(workDir));
+        return 1;
+    }
+
+    QTemporaryDir logs;
+    QJsonArray results;
+    QJsonArray failures;
+    bool ok = true;
+
+    for (const QString &size : parser.value("sizes").split(',', Qt::SkipEmptyParts)) {
+        bool sizeOk = false;
+        const qint64 postings = size.trimmed().toLongLong(&sizeOk);
+        if (!sizeOk || postings <= 0) {
+            std::fprintf(stderr, "Неверный размер: %s\n", qPrintable(size));
+            return 2;
+        }
+
+        std::fprintf(stderr, "=== %lld проводок ===\n", static_cast<long long>(postings));
+        const QString dbPath = databasePath(workDir, postings, seed);
+        if (!ensureDatabase(dbPath, postings, seed, parser.isSet("verbose"))) {
+            QJsonObject failure;
+            failure["postings"] = postings;
+            failure["message"] = "не удалось создать базу " + dbPath;
+            failures.append(failure);
+            ok = false;
+            continue;
+        }
+
+        const QString xmlPath = logs.filePath(QString("bench-%1.xml").arg(postings));
+        QStringList args = {"--child",
+                            "--db", dbPath,
+                            "--xml", xmlPath};
+        if (parser.isSet("verbose")) args << "--verbose";
+        if (!testArgs.isEmpty()) args << "--" << testArgs;
+
+        QProcess child;
+        child.setProcessChannelMode(QProcess::ForwardedChannels);
+        child.start(QCoreApplication::applicationFilePath(), args);
+        if (!child.waitForFinished(-1) || child.exitStatus() != QProcess::NormalExit
+            || child.exitCode() != 0) {
+            ok = false;
+        }
+        readResults(xmlPath, postings, &results, &failures);
+    }
+
+    QJsonObject report;
+    report["format"] = ResultFormat;
+    report["suite"] = "ledgermini-bench";
+    report["version"] = QCoreApplication::applicationVersion();
+    report["qt"] = QString(qVersion());
+    report["cpu"] = QSysInfo::currentCpuArchitecture();
+    report["os"] = QSysInfo::prettyProductName();
+    report["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    report["seed"] = qint64(seed);
+    report["results"] = results;
+    report["failures"] = failures;
+
+    const QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+    const QString out = parser.value("out");
+    if (out == "-") {
+        std::fwrite(json.constData(), 1, size_t(json.size()), stdout);
+    } else {
+        QFile file(out);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(json) != json.size()) {
+            std::fprintf(stderr, "Не удалось записать %s\n", qPrintable(out));
+            return 1;
+        }
+        std::fprintf(stderr, "Результаты: %s\n", qPrintable(out));
+    }
+
+    return ok && failures.isEmpty() ? 0 : 1;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    // Выгрузка в PDF рисует шрифтами: нужен QGuiApplication, дисплей - нет
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QGuiApplication app(argc, argv);
+    app.setApplicationName("ledgermini-bench");
+    app.setApplicationVersion("0.1.0");
+
+    // Аргументы после "--" передаются QTest: имена функций, -iterations и т.п.
+    QStringList arguments = app.arguments();
+    QStringList testArgs;
+    const int separator = arguments.indexOf("--");
+    if (separator >= 0) {
+        testArgs = arguments.mid(separator + 1);
+        arguments = arguments.mid(0, separator);
+    }
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Замеры горячих путей ядра LedgerMini на синтетических базах.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addOptions({
+        {"sizes", "Размеры журнала через запятую (по умолчанию 10000,100000,1000000).",
+         "n,...", "10000,100000,1000000"},
+        {"seed", "Начальное значение генератора базы (по умолчанию 1).", "n", "1"},
+        {"work-dir", "Каталог для сгенерированных баз (по умолчанию bench-data).", "dir", "bench-data"},
+        {"out", "Файл JSON с результатами; - в stdout.", "file", "bench-results.json"},
+        {"verbose", "Отладочный вывод (запросы к базе)."},
+        {"child", "Служебный: замеры одного размера."},
+        {"generate", "Служебный: создать базу размера --postings в --db."},
+        {"postings", "Служебный: размер журнала.", "n"},
+        {"db", "Служебный: файл базы.", "file"},
+        {"xml", "Служебный: протокол QTest.", "file"}
+    });
+    parser.process(arguments);
+
+    // Каждый запрос ядра пишется в qDebug; без фильтра замерялся бы вывод
+    if (!parser.isSet("verbose")) {
+        QLoggingCategory::setFilterRules("*.debug=false");
+    }
+
+    return parser.isSet("child") ? runChild(parser, testArgs) : runParent(parser, testArgs);
+}
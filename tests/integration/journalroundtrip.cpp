@@ -0,0 +1,68 @@
+#include "core/database.h"
+#include "core/exportmanager.h"
+#include "core/ledgergenerator.h"
+#include "core/transactionimport.h"
+#include "core/transactionquery.h"
+
+#include <QLoggingCategory>
+#include <QTemporaryDir>
+#include <QTest>
+
+// Выгрузка журнала в CSV читается импортом обратно без ошибок:
+// счета в выгрузке записаны как "код - наименование", импорт берет код.
+class JournalRoundTrip : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void exportThenImport();
+
+private:
+    QTemporaryDir dir_;
+    qint64 postings_ = 0;
+};
+
+void JournalRoundTrip::initTestCase()
+{
+    QLoggingCategory::setFilterRules("*.debug=false");
+
+    QVERIFY(dir_.isValid());
+    QVERIFY(Database::instance().initialize(dir_.filePath("ledger.db").toStdString()));
+    Database::instance().ensureSchema();
+
+    LedgerGenerator::Options options;
+    options.accounts = 60;
+    options.counterparties = 50;
+    options.postings = 2000;
+    options.from = QDate(2024, 1, 1);
+    options.to = QDate(2024, 12, 31);
+
+    LedgerGenerator::Result result;
+    QString error;
+    QVERIFY2(LedgerGenerator::generate(options, &result, &error), qPrintable(error));
+    postings_ = result.postings;
+    QVERIFY(postings_ > 0);
+}
+
+void JournalRoundTrip::exportThenImport()
+{
+    const QString fileName = dir_.filePath("journal.csv");
+    QString error;
+    QVERIFY2(ExportManager::exportTransactionsToCsv(TransactionFilter(),
+                                                    ExportManager::journalHeaders(),
+                                                    fileName, &error),
+             qPrintable(error));
+
+    TransactionImport::Options options;
+    options.dryRun = true;
+    TransactionImport::Result result;
+    const bool ok = TransactionImport::importCsv(fileName, options, &result);
+    QVERIFY2(ok, qPrintable(result.errors.mid(0, 5).join("\n")));
+    QCOMPARE(result.rows, postings_);
+    QCOMPARE(result.imported, qint64(0));
+}
+
+QTEST_GUILESS_MAIN(JournalRoundTrip)
+
+#include "journalroundtrip.moc"
@@ -0,0 +1,407 @@
+#include "core/accountcard.h"
+#include "core/database.h"
+#include "core/exportmanager.h"
+#include "core/filterresultcache.h"
+#include "core/ledgergenerator.h"
+#include "core/report_generator.h"
+#include "core/reportcache.h"
+#include "core/transactionsearch.h"
+
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QGuiApplication>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLoggingCategory>
+#include <QSaveFile>
+#include <QSqlQuery>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QTimer>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// ledgermini-perfgate: сквозные сценарии (ОСВ, карточка, поиск, выгрузки)
+// на сгенерированной базе с проверкой бюджетов времени и пикового RSS из
+// baseline.json. Каждый сценарий - отдельный тест ctest и отдельный
+// процесс, поэтому пиковый RSS процесса - это пик сценария.
+//
+//   ledgermini-perfgate --baseline baseline.json --generate
+//   ledgermini-perfgate --baseline baseline.json --scenario osv
+//   ledgermini-perfgate --baseline baseline.json --scenario osv --update-baseline
+
+namespace {
+
+enum ExitCode {
+    Success = 0,
+    Failure = 1,
+    UsageError = 2,
+    NoBudget = 77       // SKIP_RETURN_CODE в CMakeLists.txt
+};
+
+const int BaselineFormat = 1;
+
+// Пиковый RSS процесса, МБ
+double peakRssMb()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0.0;
+    return counters.PeakWorkingSetSize / 1048576.0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0.0;
+#if defined(Q_OS_MACOS)
+    return usage.ru_maxrss / 1048576.0;     // байты
+#else
+    return usage.ru_maxrss / 1024.0;        // килобайты
+#endif
+#endif
+}
+
+// Что сценарии берут из базы; читается один раз и не входит в замер
+struct Context {
+    QDate lastDate;
+    int busiestAccountId = -1;
+    QTemporaryDir outputDir;
+
+    QDate yearStart() const { return lastDate.addYears(-1).addDays(1); }
+};
+
+using Scenario = std::function<bool(const Context &context, QString *error)>;
+
+bool runOsv(const Context &context, QString *error)
+{
+    ReportGenerator generator;
+    const QVector<BalanceRecord> records = generator.generateBalanceReport(context.yearStart(),
+                                                                           context.lastDate);
+    if (records.isEmpty()) *error = "пустая ОСВ";
+    return !records.isEmpty();
+}
+
+bool runCard(const Context &context, QString *error)
+{
+    AccountCardParams params;
+    params.accountId = context.busiestAccountId;
+    params.dateFrom = context.yearStart();
+    params.dateTo = context.lastDate;
+
+    qint64 rows = 0;
+    QSqlQuery query = AccountCardQuery(params).execute();
+    while (query.next()) {
+        AccountCardQuery::readRow(query);
+        ++rows;
+    }
+    if (rows == 0) *error = "пустая карточка";
+    return rows > 0;
+}
+
+bool runSearch(const Context &context, QString *error)
+{
+    Q_UNUSED(context);
+
+    // Как в журнале операций: первая страница и итоги через TransactionSearch
+    TransactionFilter filter;
+    filter.textFilter = "зарплат";
+
+    TransactionSearch search;
+    QEventLoop loop;
+    bool page = false;
+    bool totals = false;
+    QObject::connect(&search, &TransactionSearch::pageReady, &loop, [&]() {
+        page = true;
+        if (totals) loop.quit();
+    });
+    QObject::connect(&search, &TransactionSearch::totalsReady, &loop, [&]() {
+        totals = true;
+        if (page) loop.quit();
+    });
+    QTimer::singleShot(120000, &loop, &QEventLoop::quit);
+
+    search.start(filter);
+    loop.exec();
+    if (!page || !totals) *error = "поиск не завершился за 2 минуты";
+    return page && totals;
+}
+
+bool runExportCsv(const Context &context, QString *error)
+{
+    TransactionFilter filter;
+    filter.dateFilterEnabled = true;
+    filter.dateFrom = context.lastDate.addMonths(-3).addDays(1);
+    filter.dateTo = context.lastDate;
+    return ExportManager::exportTransactionsToCsv(filter, ExportManager::journalHeaders(),
+                                                  context.outputDir.filePath("journal.csv"), error);
+}
+
+bool runExportPdf(const Context &context, QString *error)
+{
+    ReportGenerator generator;
+    const QVector<BalanceRecord> records = generator.generateBalanceReport(context.yearStart(),
+                                                                           context.lastDate);
+    return ExportManager::exportBalanceReportToPdf(records, ExportManager::balanceHeaders(), "Оборотно-сальдовая ведомость",
+                                                   context.outputDir.filePath("osv.pdf"), error);
+}
+
+Scenario findScenario(const QString &name)
+{
+    if (name == "osv") return runOsv;
+    if (name == "card") return runCard;
+    if (name == "search") return runSearch;
+    if (name == "export-csv") return runExportCsv;
+    if (name == "export-pdf") return runExportPdf;
+    return nullptr;
+}
+
+bool readBaseline(const QString &fileName, QJsonObject *baseline)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        std::fprintf(stderr, "Нет файла бюджетов %s\n", qPrintable(fileName));
+        return false;
+    }
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (!document.isObject()) {
+        std::fprintf(stderr, "%s: %s\n", qPrintable(fileName), qPrintable(parseError.errorString()));
+        return false;
+    }
+    *baseline = document.object();
+    if (baseline->value("format").toInt() != BaselineFormat) {
+        std::fprintf(stderr, "%s: ожидается format %d\n", qPrintable(fileName), BaselineFormat);
+        return false;
+    }
+    return true;
+}
+
+LedgerGenerator::Options ledgerOptions(const QJsonObject &baseline)
+{
+    const QJsonObject ledger = baseline.value("ledger").toObject();
+    LedgerGenerator::Options options;
+    options.postings = ledger.value("postings").toInteger(200000);
+    options.accounts = ledger.value("accounts").toInt(options.accounts);
+    options.counterparties = ledger.value("counterparties").toInt(options.counterparties);
+    options.seed = quint32(ledger.value("seed").toInt(1));
+    options.from = QDate::fromString(ledger.value("from").toString("2023-01-01"), Qt::ISODate);
+    options.to = QDate::fromString(ledger.value("to").toString("2025-12-31"), Qt::ISODate);
+    return options;
+}
+
+// В имени - отпечаток версии генератора и всех параметров ledger:
+// правка блока ledger в baseline.json дает новую базу, а не старую
+QString databasePath(const QString &workDir, const LedgerGenerator::Options &options)
+{
+    return QDir(workDir).filePath(QString("perf-ledger-%1-seed%2-%3.db")
+                                  .arg(options.postings).arg(options.seed)
+                                  .arg(LedgerGenerator::fingerprint(options)));
+}
+
+int generate(const QString &dbPath, const LedgerGenerator::Options &options)
+{
+    if (QFile::exists(dbPath)) {
+        std::printf("База уже есть: %s\n", qPrintable(dbPath));
+        return Success;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    LedgerGenerator::Result result;
+    QString error;
+    if (!LedgerGenerator::generateFile(dbPath, options, &result, &error)) {
+        std::fprintf(stderr, "Ошибка генерации: %s\n", qPrintable(error));
+        return Failure;
+    }
+
+    std::printf("База %s: %lld проводок за %.1f с\n", qPrintable(dbPath),
+                static_cast<long long>(result.postings), timer.elapsed() / 1000.0);
+    return Success;
+}
+
+// Строка сравнения с базовым значением; false - бюджет превышен.
+// Бюджет задан (base > 0) - проверяется в runScenario до сравнения
+bool compare(const char *what, const char *unit, double measured, double base, double tolerance)
+{
+    const double delta = (measured - base) / base * 100.0;
+    const double limit = base * (1.0 + tolerance);
+    const bool ok = measured <= limit;
+    std::printf("  %-6s %10.3f %s  база %10.3f %s  %+7.1f%%  допуск +%.0f%%%s\n",
+                what, measured, unit, base, unit, delta, tolerance * 100.0,
+                ok ? (measured < base * (1.0 - tolerance) ? "  (быстрее базы: обновите baseline)" : "")
+                   : "  ПРЕВЫШЕН БЮДЖЕТ");
+    return ok;
+}
+
+bool updateBaseline(const QString &fileName, QJsonObject baseline, const QString &name,
+                    double seconds, double rssMb)
+{
+    QJsonObject scenarios = baseline.value("scenarios").toObject();
+    QJsonObject scenario = scenarios.value(name).toObject();
+    scenario["seconds"] = std::ceil(seconds * 1000.0) / 1000.0;
+    scenario["peakRssMb"] = std::ceil(rssMb);
+    scenarios[name] = scenario;
+    baseline["scenarios"] = scenarios;
+    baseline["version"] = QCoreApplication::applicationVersion();
+    baseline["machine"] = QString("%1, %2, %3").arg(QSysInfo::machineHostName(),
+                                                    QSysInfo::prettyProductName(),
+                                                    QSysInfo::currentCpuArchitecture());
+    baseline["updated"] = QDate::currentDate().toString(Qt::ISODate);
+
+    // Через временный файл: прерванная запись не портит бюджеты
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    if (file.write(QJsonDocument(baseline).toJson(QJsonDocument::Indented)) <= 0) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+int runScenario(const QCommandLineParser &parser, const QJsonObject &baseline, const QString &dbPath)
+{
+    const QString name = parser.value("scenario");
+    const Scenario scenario = findScenario(name);
+    if (!scenario) {
+        std::fprintf(stderr, "Неизвестный сценарий: %s\n", qPrintable(name));
+        return UsageError;
+    }
+    if (!QFile::exists(dbPath)) {
+        std::fprintf(stderr, "Нет базы %s: сначала --generate (тест perf.ledger)\n", qPrintable(dbPath));
+        return Failure;
+    }
+    if (!Database::instance().initialize(dbPath.toStdString())) {
+        std::fprintf(stderr, "Не удалось открыть базу %s\n", qPrintable(dbPath));
+        return Failure;
+    }
+    Database::instance().ensureSchema();
+
+    // Меряется работа, а не чтение готового результата из кэшей
+    ReportCache::instance().setEnabled(false);
+
+    Context context;
+    QSqlQuery last = Database::instance().executeQuery("SELECT MAX(transaction_date) FROM transactions");
+    if (last.next()) context.lastDate = last.value(0).toDate();
+    QSqlQuery busiest = Database::instance().executeQuery(
+        "SELECT debit_account_id FROM transactions "
+        "GROUP BY debit_account_id ORDER BY COUNT(*) DESC LIMIT 1");
+    if (busiest.next()) context.busiestAccountId = busiest.value(0).toInt();
+    if (!context.lastDate.isValid() || context.busiestAccountId <= 0 || !context.outputDir.isValid()) {
+        std::fprintf(stderr, "В базе %s нет проводок\n", qPrintable(dbPath));
+        return Failure;
+    }
+
+    // Прогрев, затем лучшее из repeat: шум планировщика только увеличивает время
+    const int repeat = qMax(1, parser.value("repeat").toInt());
+    double best = 0.0;
+    for (int i = 0; i <= repeat; ++i) {
+        FilterResultCache::instance().clear();
+        QElapsedTimer timer;
+        timer.start();
+        QString error;
+        if (!scenario(context, &error)) {
+            std::fprintf(stderr, "%s: ошибка: %s\n", qPrintable(name), qPrintable(error));
+            return Failure;
+        }
+        const double seconds = timer.nsecsElapsed() / 1e9;
+        if (i == 1 || (i > 1 && seconds < best)) best = seconds;
+    }
+    const double rss = peakRssMb();
+
+    if (parser.isSet("update-baseline")) {
+        if (!updateBaseline(parser.value("baseline"), baseline, name, best, rss)) {
+            std::fprintf(stderr, "Не удалось записать %s\n", qPrintable(parser.value("baseline")));
+            return Failure;
+        }
+        std::printf("%s: %.3f с, %.1f МБ записаны в %s\n", qPrintable(name), best, rss,
+                    qPrintable(parser.value("baseline")));
+        return Success;
+    }
+
+    const QJsonObject budget = baseline.value("scenarios").toObject().value(name).toObject();
+    const double tolerance = budget.value("tolerance").toDouble(baseline.value("tolerance").toDouble(0.25));
+    const double rssTolerance = budget.value("rssTolerance").toDouble(
+        baseline.value("rssTolerance").toDouble(tolerance));
+
+    const double seconds = budget.value("seconds").toDouble();
+    const double rssMb = budget.value("peakRssMb").toDouble();
+
+    // Без бюджета проверять нечего: тест пропущен, а не пройден
+    if (seconds <= 0 || rssMb <= 0) {
+        std::printf("%s: %.3f с, %.1f МБ; бюджет не задан - запишите его на эталонной машине:\n"
+                    "  ledgermini-perfgate --baseline %s --scenario %s --update-baseline\n",
+                    qPrintable(name), best, rss, qPrintable(parser.value("baseline")),
+                    qPrintable(name));
+        return NoBudget;
+    }
+
+    const QString machine = baseline.value("machine").toString();
+    std::printf("%s (baseline %s, %s):\n", qPrintable(name),
+                qPrintable(baseline.value("version").toString()),
+                qPrintable(machine.isEmpty() ? QString("не записан") : machine));
+    bool ok = compare("время", "с ", best, seconds, tolerance);
+    ok = compare("RSS", "МБ", rss, rssMb, rssTolerance) && ok;
+    return ok ? Success : Failure;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    // Выгрузка в PDF рисует шрифтами: нужен QGuiApplication, дисплей - нет
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QGuiApplication app(argc, argv);
+    app.setApplicationName("ledgermini-perfgate");
+    app.setApplicationVersion("0.1.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Сквозные сценарии LedgerMini с бюджетами времени и памяти.\n"
+        "Сценарии: osv, card, search, export-csv, export-pdf.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addOptions({
+        {"baseline", "Файл бюджетов (baseline.json).", "file"},
+        {"work-dir", "Каталог сгенерированной базы (по умолчанию perf-data).", "dir", "perf-data"},
+        {"generate", "Создать базу из параметров ledger файла бюджетов."},
+        {"scenario", "Выполнить сценарий и сравнить с бюджетом.", "name"},
+        {"repeat", "Замеров после прогрева (по умолчанию 3); берется лучший.", "n", "3"},
+        {"update-baseline", "Записать замер сценария в файл бюджетов вместо проверки."},
+        {"verbose", "Отладочный вывод (запросы к базе)."}
+    });
+    parser.process(app);
+
+    if (!parser.isSet("verbose")) {
+        QLoggingCategory::setFilterRules("*.debug=false");
+    }
+
+    QJsonObject baseline;
+    if (!parser.isSet("baseline") || !readBaseline(parser.value("baseline"), &baseline)) {
+        return UsageError;
+    }
+
+    const LedgerGenerator::Options options = ledgerOptions(baseline);
+    const QString workDir = parser.value("work-dir");
+    if (!QDir().mkpath(workDir)) {
+        std::fprintf(stderr, "Не удалось создать каталог %s\n", qPrintable(workDir));
+        return Failure;
+    }
+    const QString dbPath = databasePath(workDir, options);
+
+    if (parser.isSet("generate")) return generate(dbPath, options);
+    if (parser.isSet("scenario")) return runScenario(parser, baseline, dbPath);
+
+    std::fprintf(stderr, "Укажите --generate или --scenario\n");
+    return UsageError;
+}
@@ -0,0 +1,203 @@
+#include "core/amountformula.h"
+
+#include <QTest>
+
+// Разбор и вычисление формул суммы шаблона без базы: формулы без
+// balance/debit/credit вычисляются по пустому FormulaBalances.
+class AmountFormulaTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void evaluate_data();
+    void evaluate();
+    void divisionByZero();
+    void references();
+    void malformed_data();
+    void malformed();
+    void nesting();
+    void evaluateAll();
+    void evaluateAllCycle();
+};
+
+void AmountFormulaTest::evaluate_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<double>("expected");
+
+    QTest::newRow("precedence") << "2 + 3 * 4" << 14.0;
+    QTest::newRow("parentheses") << "(2 + 3) * 4" << 20.0;
+    QTest::newRow("left associative minus") << "10 - 4 - 3" << 3.0;
+    QTest::newRow("left associative division") << "12 / 3 / 2" << 2.0;
+    QTest::newRow("fraction") << "1000 * 0.13" << 130.0;
+    QTest::newRow("unary minus") << "-2 * 3" << -6.0;
+    QTest::newRow("unary minus after operator") << "2 * -3" << -6.0;
+    QTest::newRow("double unary minus") << "--2" << 2.0;
+    QTest::newRow("unary minus of group") << "-(1 + 2)" << -3.0;
+    QTest::newRow("unary plus") << "+5" << 5.0;
+    QTest::newRow("min") << "min(3, 1 + 1)" << 2.0;
+    QTest::newRow("max") << "max(-1, -2)" << -1.0;
+    QTest::newRow("abs") << "abs(-4.5)" << 4.5;
+    QTest::newRow("round") << "round(1234.5678, 2)" << 1234.57;
+    QTest::newRow("round to integer") << "round(2.5, 0)" << 3.0;
+    QTest::newRow("round digits capped") << "round(0.1234567891, 20)" << 0.123457;
+    QTest::newRow("case insensitive functions") << "MAX(1, ROUND(1.26, 1))" << 1.3;
+    QTest::newRow("spaces") << "  ( 1+2 )*  3 " << 9.0;
+}
+
+void AmountFormulaTest::evaluate()
+{
+    QFETCH(QString, text);
+    QFETCH(double, expected);
+
+    AmountFormula formula;
+    QString error;
+    QVERIFY2(formula.compile(text, &error), qPrintable(error));
+    QVERIFY(formula.isValid());
+
+    double value = 0.0;
+    QVERIFY2(formula.evaluate(FormulaBalances(), {}, &value, &error), qPrintable(error));
+    QCOMPARE(value, expected);
+}
+
+void AmountFormulaTest::divisionByZero()
+{
+    for (const QString &text : {QString("1 / 0"), QString("5 / (2 - 2)"), QString("min(1, 2 / 0)")}) {
+        AmountFormula formula;
+        QVERIFY(formula.compile(text));
+
+        double value = 0.0;
+        QString error;
+        QVERIFY(!formula.evaluate(FormulaBalances(), {}, &value, &error));
+        QVERIFY2(error.contains("Деление на ноль"), qPrintable(text + ": " + error));
+    }
+}
+
+void AmountFormulaTest::references()
+{
+    AmountFormula formula;
+    QString error;
+    QVERIFY2(formula.compile("round(credit(70.01) * 0.13, 2) + balance(70) - balance(\"70\")"
+                             " + template(\"Зарплата\") * 0", &error),
+             qPrintable(error));
+    QCOMPARE(formula.accounts(), QStringList({"70.01", "70"}));
+    QCOMPARE(formula.templates(), QStringList({"Зарплата"}));
+
+    // Счета нет в выборке остатков - ошибка вычисления, а не ноль
+    double value = 0.0;
+    QVERIFY(!formula.evaluate(FormulaBalances(), {{"Зарплата", 100.0}}, &value, &error));
+    QVERIFY(error.contains("70.01"));
+
+    AmountFormula share;
+    QVERIFY(share.compile("template(\"Зарплата\") * 0.3"));
+    QVERIFY(share.evaluate(FormulaBalances(), {{"Зарплата", 1000.0}}, &value, &error));
+    QCOMPARE(value, 300.0);
+    QVERIFY(!share.evaluate(FormulaBalances(), {}, &value, &error));
+}
+
+void AmountFormulaTest::malformed_data()
+{
+    QTest::addColumn<QString>("text");
+
+    QTest::newRow("empty") << "";
+    QTest::newRow("spaces only") << "   ";
+    QTest::newRow("dangling operator") << "1 +";
+    QTest::newRow("unclosed parenthesis") << "(1 + 2";
+    QTest::newRow("extra parenthesis") << "1 + 2)";
+    QTest::newRow("two numbers") << "2 3";
+    QTest::newRow("bad number") << "1..2";
+    QTest::newRow("unknown function") << "sqrt(4)";
+    QTest::newRow("function without parenthesis") << "abs 4";
+    QTest::newRow("missing argument") << "min(1)";
+    QTest::newRow("extra argument") << "abs(1, 2)";
+    QTest::newRow("empty account") << "balance()";
+    QTest::newRow("empty template name") << "template(\"\")";
+    QTest::newRow("unclosed quote") << "template(\"Зарплата)";
+    QTest::newRow("template without quotes") << "template(Зарплата)";
+    QTest::newRow("unexpected character") << "1 # 2";
+}
+
+void AmountFormulaTest::malformed()
+{
+    QFETCH(QString, text);
+
+    AmountFormula formula;
+    QString error;
+    QVERIFY(!formula.compile(text, &error));
+    QVERIFY(!error.isEmpty());
+    QVERIFY(!formula.isValid());
+
+    double value = 0.0;
+    QVERIFY(!formula.evaluate(FormulaBalances(), {}, &value));
+}
+
+void AmountFormulaTest::nesting()
+{
+    AmountFormula formula;
+    QString error;
+
+    const int depth = 30;
+    QVERIFY2(formula.compile(QString(depth, '(') + "1" + QString(depth, ')'), &error),
+             qPrintable(error));
+    QVERIFY2(formula.compile(QString(depth, '-') + "1", &error), qPrintable(error));
+
+    // Глубже предела - ошибка разбора, а не переполнение стека
+    const int deep = 100000;
+    QVERIFY(!formula.compile(QString(deep, '(') + "1" + QString(deep, ')'), &error));
+    QVERIFY(error.contains("вложенность"));
+    QVERIFY(!formula.compile(QString(deep, '-') + "1", &error));
+    QVERIFY(!formula.compile(QString(deep / 4, ' ').replace(" ", "abs(") + "1"
+                             + QString(deep / 4, ')'), &error));
+}
+
+void AmountFormulaTest::evaluateAll()
+{
+    QHash<QString, AmountFormula> formulas;
+    QVERIFY(formulas["НДФЛ"].compile("template(\"Начисление\") * 0.13"));
+    QVERIFY(formulas["Взносы"].compile("round(template(\"Начисление\") * 0.3 + template(\"НДФЛ\") * 0, 2)"));
+    QVERIFY(formulas["Итого"].compile("template(\"НДФЛ\") + template(\"Взносы\")"));
+
+    QHash<QString, double> values;
+    QStringList errors;
+    QVERIFY2(AmountFormula::evaluateAll(formulas, {{"Начисление", 1000.0}}, FormulaBalances(),
+                                        &values, &errors),
+             qPrintable(errors.join("\n")));
+    QVERIFY(errors.isEmpty());
+    QCOMPARE(values.value("Начисление"), 1000.0);
+    QCOMPARE(values.value("НДФЛ"), 130.0);
+    QCOMPARE(values.value("Взносы"), 300.0);
+    QCOMPARE(values.value("Итого"), 430.0);
+}
+
+void AmountFormulaTest::evaluateAllCycle()
+{
+    QHash<QString, AmountFormula> formulas;
+    QVERIFY(formulas["А"].compile("template(\"Б\") + 1"));
+    QVERIFY(formulas["Б"].compile("template(\"А\") * 2"));
+    QVERIFY(formulas["Сам"].compile("template(\"Сам\")"));
+    QVERIFY(formulas["Зависит от цикла"].compile("template(\"А\")"));
+    QVERIFY(formulas["Отдельный"].compile("template(\"Постоянный\") / 2"));
+    QVERIFY(formulas["Без шаблона"].compile("template(\"Нет такого\")"));
+
+    QHash<QString, double> values;
+    QStringList errors;
+    QVERIFY(!AmountFormula::evaluateAll(formulas, {{"Постоянный", 50.0}}, FormulaBalances(),
+                                        &values, &errors));
+
+    // Цикл не мешает независимым формулам
+    QCOMPARE(values.value("Отдельный"), 25.0);
+    QVERIFY(!values.contains("А"));
+    QVERIFY(!values.contains("Б"));
+    QVERIFY(!values.contains("Сам"));
+    QVERIFY(!values.contains("Зависит от цикла"));
+    QVERIFY(!values.contains("Без шаблона"));
+
+    const QString messages = errors.join("\n");
+    QVERIFY2(messages.contains("ссылаются друг на друга"), qPrintable(messages));
+    QVERIFY2(messages.contains("Шаблон \"Сам\""), qPrintable(messages));
+    QVERIFY2(messages.contains("Нет шаблона \"Нет такого\""), qPrintable(messages));
+}
+
+QTEST_GUILESS_MAIN(AmountFormulaTest)
+
+#include "amountformulatest.moc"
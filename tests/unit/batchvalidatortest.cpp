@@ -0,0 +1,207 @@
+#include "core/batchvalidator.h"
+#include "core/validationrules.h"
+
+#include <QTest>
+#include <limits>
+
+// Контрольные цифры ИНН и коды ошибок BatchValidator по строкам; справочники
+// задаются без базы (setAccounts, setCounterparties, setInns).
+class BatchValidatorTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void inn_data();
+    void inn();
+    void completeInn_data();
+    void completeInn();
+    void postings_data();
+    void postings();
+    void allRowsChecked();
+    void counterparties();
+};
+
+void BatchValidatorTest::inn_data()
+{
+    QTest::addColumn<QString>("inn");
+    QTest::addColumn<bool>("valid");
+
+    QTest::newRow("10 digits") << "7707083893" << true;
+    QTest::newRow("10 digits, second") << "7830002293" << true;
+    QTest::newRow("10 digits, sum mod 11 is 10") << "7707083830" << true;
+    QTest::newRow("10 digits, third") << "7736207543" << true;
+    QTest::newRow("10 digits, zeros") << "0000000000" << true;
+    QTest::newRow("10 digits, spaces around") << " 7707083893 " << true;
+    QTest::newRow("12 digits") << "500100732259" << true;
+    QTest::newRow("12 digits, second") << "773370857141" << true;
+
+    QTest::newRow("10 digits, wrong check digit") << "7707083894" << false;
+    QTest::newRow("10 digits, swapped digits") << "7707083839" << false;
+    QTest::newRow("12 digits, wrong last digit") << "500100732258" << false;
+    QTest::newRow("12 digits, wrong 11th digit") << "500100732269" << false;
+    QTest::newRow("12 digits, wrong both") << "366316608213" << false;
+    QTest::newRow("9 digits") << "770708389" << false;
+    QTest::newRow("11 digits") << "77070838930" << false;
+    QTest::newRow("13 digits") << "5001007322590" << false;
+    QTest::newRow("letter") << "77070838A3" << false;
+    QTest::newRow("inner space") << "7707 83893" << false;
+    QTest::newRow("empty") << "" << false;
+}
+
+void BatchValidatorTest::inn()
+{
+    QFETCH(QString, inn);
+    QFETCH(bool, valid);
+
+    QCOMPARE(ValidationRules::isValidINN(inn), valid);
+}
+
+void BatchValidatorTest::completeInn_data()
+{
+    QTest::addColumn<QString>("body");
+    QTest::addColumn<QString>("expected");
+
+    QTest::newRow("organization") << "770708389" << "7707083893";
+    QTest::newRow("individual") << "5001007322" << "500100732259";
+    QTest::newRow("short") << "77070838" << "";
+    QTest::newRow("full inn") << "7707083893" << "770708389324";
+    QTest::newRow("not digits") << "77070838A" << "";
+}
+
+void BatchValidatorTest::completeInn()
+{
+    QFETCH(QString, body);
+    QFETCH(QString, expected);
+
+    const QString inn = ValidationRules::completeINN(body);
+    QCOMPARE(inn, expected);
+    if (!inn.isEmpty()) QVERIFY(ValidationRules::isValidINN(inn));
+}
+
+void BatchValidatorTest::postings_data()
+{
+    QTest::addColumn<QDate>("date");
+    QTest::addColumn<int>("debitId");
+    QTest::addColumn<int>("creditId");
+    QTest::addColumn<double>("amount");
+    QTest::addColumn<int>("counterpartyId");
+    QTest::addColumn<uint>("expected");
+
+    const QDate day(2025, 3, 10);
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+
+    QTest::newRow("valid") << day << 1 << 2 << 100.0 << 0 << uint(BatchValidator::NoError);
+    QTest::newRow("valid with counterparty") << day << 1 << 2 << 100.0 << 5 << uint(BatchValidator::NoError);
+    QTest::newRow("today") << QDate(2025, 3, 31) << 1 << 2 << 1.0 << 0 << uint(BatchValidator::NoError);
+    QTest::newRow("invalid date") << QDate() << 1 << 2 << 100.0 << 0 << uint(BatchValidator::InvalidDate);
+    QTest::newRow("future date") << QDate(2025, 4, 1) << 1 << 2 << 100.0 << 0 << uint(BatchValidator::FutureDate);
+    QTest::newRow("missing debit") << day << 0 << 2 << 100.0 << 0 << uint(BatchValidator::MissingDebit);
+    QTest::newRow("missing credit") << day << 1 << 0 << 100.0 << 0 << uint(BatchValidator::MissingCredit);
+    QTest::newRow("code not found") << day << -1 << 2 << 100.0 << 0 << uint(BatchValidator::UnknownDebit);
+    QTest::newRow("unknown credit id") << day << 1 << 3 << 100.0 << 0 << uint(BatchValidator::UnknownCredit);
+    QTest::newRow("id beyond bitmap") << day << 100000 << 2 << 100.0 << 0 << uint(BatchValidator::UnknownDebit);
+    QTest::newRow("same accounts") << day << 2 << 2 << 100.0 << 0 << uint(BatchValidator::SameAccounts);
+    QTest::newRow("zero amount") << day << 1 << 2 << 0.0 << 0 << uint(BatchValidator::InvalidAmount);
+    QTest::newRow("negative amount") << day << 1 << 2 << -5.0 << 0 << uint(BatchValidator::InvalidAmount);
+    QTest::newRow("not a number") << day << 1 << 2 << nan << 0 << uint(BatchValidator::InvalidAmount);
+    QTest::newRow("too large") << day << 1 << 2 << 2e9 << 0 << uint(BatchValidator::InvalidAmount);
+    QTest::newRow("code not found counterparty") << day << 1 << 2 << 100.0 << -1
+                                                 << uint(BatchValidator::UnknownCounterparty);
+    QTest::newRow("unknown counterparty") << day << 1 << 2 << 100.0 << 6
+                                          << uint(BatchValidator::UnknownCounterparty);
+
+    // Все ошибки строки сразу, а не первая
+    QTest::newRow("everything wrong")
+        << QDate() << 0 << -1 << nan << 6
+        << uint(BatchValidator::InvalidDate | BatchValidator::MissingDebit | BatchValidator::UnknownCredit
+                | BatchValidator::InvalidAmount | BatchValidator::UnknownCounterparty);
+    QTest::newRow("future, unknown, same")
+        << QDate(2026, 1, 1) << 3 << 3 << 100.0 << 0
+        << uint(BatchValidator::FutureDate | BatchValidator::UnknownDebit | BatchValidator::UnknownCredit
+                | BatchValidator::SameAccounts);
+}
+
+void BatchValidatorTest::postings()
+{
+    QFETCH(QDate, date);
+    QFETCH(int, debitId);
+    QFETCH(int, creditId);
+    QFETCH(double, amount);
+    QFETCH(int, counterpartyId);
+    QFETCH(uint, expected);
+
+    BatchValidator validator;
+    validator.setAccounts({1, 2, 4});
+    validator.setCounterparties({5, 7});
+    validator.setToday(QDate(2025, 3, 31));
+
+    BatchValidator::Postings batch;
+    batch.append(date, debitId, creditId, amount, counterpartyId);
+    const QVector<BatchValidator::Errors> errors = validator.validatePostings(batch);
+    QCOMPARE(errors.size(), 1);
+    QCOMPARE(uint(errors.first()), expected);
+    QCOMPARE(BatchValidator::describe(errors.first()).isEmpty(), expected == BatchValidator::NoError);
+}
+
+void BatchValidatorTest::allRowsChecked()
+{
+    BatchValidator validator;
+    validator.setAccounts({1, 2});
+    validator.setToday(QDate(2025, 3, 31));
+
+    // Ошибки в начале, в середине и в конце пачки
+    const int rows = 10000;
+    BatchValidator::Postings batch;
+    batch.reserve(rows);
+    for (int i = 0; i < rows; ++i) {
+        const bool bad = i == 0 || i == rows / 2 || i == rows - 1;
+        batch.append(QDate(2025, 1, 1), 1, 2, bad ? 0.0 : 10.0);
+    }
+
+    const QVector<BatchValidator::Errors> errors = validator.validatePostings(batch);
+    QCOMPARE(errors.size(), rows);
+    int invalid = 0;
+    for (int i = 0; i < rows; ++i) {
+        if (errors.at(i) != BatchValidator::NoError) {
+            QCOMPARE(errors.at(i), BatchValidator::Errors(BatchValidator::InvalidAmount));
+            ++invalid;
+        }
+    }
+    QCOMPARE(invalid, 3);
+    QCOMPARE(errors.at(rows / 2), BatchValidator::Errors(BatchValidator::InvalidAmount));
+
+    batch.clear();
+    QCOMPARE(batch.size(), 0);
+    QVERIFY(validator.validatePostings(batch).isEmpty());
+}
+
+void BatchValidatorTest::counterparties()
+{
+    BatchValidator validator;
+    validator.setInns({"7707083893", " 7830002293 "});
+
+    BatchValidator::Counterparties batch;
+    batch.names = {"ООО Ромашка", "", "ИП Иванов", "ООО Дубль", "ООО Повтор", "ООО Повтор 2", "  ",
+                   "Без ИНН", "Без ИНН 2"};
+    batch.inns = {"500100732259", "773370857141", "500100732258", "7707083893", "7736207543",
+                  "7736207543", "12345", "", ""};
+
+    const QVector<BatchValidator::Errors> errors = validator.validateCounterparties(batch);
+    const QVector<BatchValidator::Errors> expected = {
+        BatchValidator::NoError,
+        BatchValidator::EmptyName,
+        BatchValidator::InvalidInn,
+        BatchValidator::DuplicateInn,       // уже в базе
+        BatchValidator::NoError,
+        BatchValidator::DuplicateInn,       // выше в той же пачке
+        BatchValidator::EmptyName | BatchValidator::InvalidInn,
+        BatchValidator::NoError,            // без ИНН повторы не проверяются
+        BatchValidator::NoError
+    };
+    QCOMPARE(errors, expected);
+    QCOMPARE(BatchValidator::describe(errors.at(6)), QString("не указано наименование; неверный ИНН"));
+}
+
+QTEST_GUILESS_MAIN(BatchValidatorTest)
+
+#include "batchvalidatortest.moc"
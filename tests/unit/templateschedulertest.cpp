@@ -0,0 +1,104 @@
+#include "core/templatescheduler.h"
+
+#include <QTest>
+
+// Ряд дат повторяющегося шаблона: каждая дата считается от даты создания,
+// last_executed только отсекает выполненные, за запуск - не больше limit.
+class TemplateSchedulerTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void dueDates_data();
+    void dueDates();
+    void occurrenceCap();
+};
+
+void TemplateSchedulerTest::dueDates_data()
+{
+    QTest::addColumn<QString>("frequency");
+    QTest::addColumn<QDate>("anchor");
+    QTest::addColumn<QDate>("after");
+    QTest::addColumn<QDate>("today");
+    QTest::addColumn<QList<QDate>>("expected");
+
+    QTest::newRow("monthly from 31st through February")
+        << "monthly" << QDate(2025, 1, 31) << QDate() << QDate(2025, 4, 30)
+        << QList<QDate>{QDate(2025, 1, 31), QDate(2025, 2, 28), QDate(2025, 3, 31), QDate(2025, 4, 30)};
+    QTest::newRow("monthly from 31st through leap February")
+        << "monthly" << QDate(2024, 1, 31) << QDate() << QDate(2024, 3, 31)
+        << QList<QDate>{QDate(2024, 1, 31), QDate(2024, 2, 29), QDate(2024, 3, 31)};
+    QTest::newRow("monthly from 31st after February")
+        << "monthly" << QDate(2025, 1, 31) << QDate(2025, 2, 28) << QDate(2025, 5, 31)
+        << QList<QDate>{QDate(2025, 3, 31), QDate(2025, 4, 30), QDate(2025, 5, 31)};
+    QTest::newRow("yearly from February 29th")
+        << "yearly" << QDate(2024, 2, 29) << QDate(2024, 2, 29) << QDate(2028, 3, 1)
+        << QList<QDate>{QDate(2025, 2, 28), QDate(2026, 2, 28), QDate(2027, 2, 28), QDate(2028, 2, 29)};
+
+    QTest::newRow("last before anchor")
+        << "monthly" << QDate(2025, 1, 10) << QDate(2024, 12, 15) << QDate(2025, 3, 9)
+        << QList<QDate>{QDate(2025, 1, 10), QDate(2025, 2, 10)};
+    QTest::newRow("last on a series date")
+        << "monthly" << QDate(2025, 1, 10) << QDate(2025, 2, 10) << QDate(2025, 4, 10)
+        << QList<QDate>{QDate(2025, 3, 10), QDate(2025, 4, 10)};
+    QTest::newRow("last between series dates")
+        << "weekly" << QDate(2025, 1, 6) << QDate(2025, 1, 15) << QDate(2025, 2, 3)
+        << QList<QDate>{QDate(2025, 1, 20), QDate(2025, 1, 27), QDate(2025, 2, 3)};
+    QTest::newRow("last is today")
+        << "daily" << QDate(2025, 1, 1) << QDate(2025, 3, 1) << QDate(2025, 3, 1)
+        << QList<QDate>{};
+
+    // Ни разу не выполненный шаблон: after - вчера, прошлое не дописывается
+    QTest::newRow("never run, today is a series date")
+        << "monthly" << QDate(2024, 6, 15) << QDate(2025, 3, 14) << QDate(2025, 3, 15)
+        << QList<QDate>{QDate(2025, 3, 15)};
+    QTest::newRow("never run, today is not a series date")
+        << "monthly" << QDate(2024, 6, 15) << QDate(2025, 3, 19) << QDate(2025, 3, 20)
+        << QList<QDate>{};
+
+    QTest::newRow("anchor after today")
+        << "daily" << QDate(2025, 5, 1) << QDate() << QDate(2025, 4, 30)
+        << QList<QDate>{};
+    QTest::newRow("unknown frequency")
+        << "hourly" << QDate(2025, 1, 1) << QDate() << QDate(2025, 1, 31)
+        << QList<QDate>{};
+    QTest::newRow("invalid anchor")
+        << "daily" << QDate() << QDate() << QDate(2025, 1, 31)
+        << QList<QDate>{};
+}
+
+void TemplateSchedulerTest::dueDates()
+{
+    QFETCH(QString, frequency);
+    QFETCH(QDate, anchor);
+    QFETCH(QDate, after);
+    QFETCH(QDate, today);
+    QFETCH(QList<QDate>, expected);
+
+    QCOMPARE(TemplateScheduler::dueDates(frequency, anchor, after, today,
+                                         TemplateScheduler::MaxOccurrences),
+             expected);
+}
+
+void TemplateSchedulerTest::occurrenceCap()
+{
+    const int limit = TemplateScheduler::MaxOccurrences;
+    const QDate anchor(2000, 1, 1);
+    const QDate today(2040, 1, 1);      // больше двух запусков дат
+
+    const QList<QDate> first = TemplateScheduler::dueDates("daily", anchor, QDate(), today, limit);
+    QCOMPARE(first.size(), limit);
+    QCOMPARE(first.first(), anchor);
+    QCOMPARE(first.last(), anchor.addDays(limit - 1));
+
+    // Следующий запуск продолжает с последней записанной даты
+    const QList<QDate> second = TemplateScheduler::dueDates("daily", anchor, first.last(), today, limit);
+    QCOMPARE(second.size(), limit);
+    QCOMPARE(second.first(), anchor.addDays(limit));
+
+    QCOMPARE(TemplateScheduler::dueDates("daily", anchor, QDate(), anchor.addDays(9), limit).size(), 10);
+}
+
+QTEST_GUILESS_MAIN(TemplateSchedulerTest)
+
+#include "templateschedulertest.moc"